@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+
+from __future__ import print_function
+
+import argparse
+import json
+import os
+import re
+import statistics
+import sys
+import time
+from os.path import basename, dirname, isfile, join, realpath, splitext
+
+# Runs the benchmarks and compares them with a baseline.
+BENCH_DIR = dirname(realpath(__file__))
+REPO_DIR = dirname(BENCH_DIR)
+
+OUTPUT_EXPECT = re.compile(r'// Expected: ?(.*)')
+
+
+def color_text(text, color):
+  """Converts text to a string and wraps it in the ANSI escape sequence for
+  color, if supported."""
+
+  # No ANSI escapes on Windows or when piped.
+  if sys.platform == 'win32' or not sys.stdout.isatty():
+    return str(text)
+
+  return color + str(text) + '\033[0m'
+
+
+def green(text):  return color_text(text, '\033[32m')
+def red(text):    return color_text(text, '\033[31m')
+def gray(text):   return color_text(text, '\033[1;30m')
+
+
+class Benchmark:
+  def __init__(self, path):
+    self.path = path
+    self.name = splitext(basename(path))[0]
+    self.output = []
+    self.times = []
+    self.rss = 0
+
+    with open(path, 'r') as file:
+      for line in file:
+        match = OUTPUT_EXPECT.search(line)
+        if match:
+          self.output.append(match.group(1))
+
+
+  def run_once(self, lit):
+    """Runs the benchmark in a child process, returns its wall time in seconds
+    and its peak RSS in kilobytes, or raises if it didn't print the expected
+    output."""
+
+    read, write = os.pipe()
+    start = time.perf_counter()
+    pid = os.fork()
+
+    if pid == 0:
+      os.close(read)
+      os.dup2(write, 1)
+
+      try:
+        os.execv(lit, [lit, self.path])
+      finally:
+        os._exit(127)
+
+    os.close(write)
+
+    with os.fdopen(read, 'r') as pipe:
+      out = pipe.read()
+
+    _, status, usage = os.wait4(pid, 0)
+    elapsed = time.perf_counter() - start
+
+    if status != 0:
+      raise RuntimeError('exited with status {}'.format(status >> 8 if os.WIFEXITED(status) else status))
+
+    lines = out.replace('\r\n', '\n').split('\n')
+    if lines[-1] == '':
+      del lines[-1]
+
+    if lines != self.output:
+      raise RuntimeError('expected output {} and got {}'.format(self.output, lines))
+
+    return elapsed, usage.ru_maxrss
+
+
+  def run(self, lit, warmups, runs):
+    for _ in range(warmups):
+      self.run_once(lit)
+
+    for _ in range(runs):
+      elapsed, rss = self.run_once(lit)
+
+      self.times.append(elapsed)
+      self.rss = max(self.rss, rss)
+
+
+  def median(self):
+    return statistics.median(self.times)
+
+
+  def stddev(self):
+    return statistics.stdev(self.times) if len(self.times) > 1 else 0.0
+
+
+  def to_json(self):
+    return {
+      'median': self.median(),
+      'stddev': self.stddev(),
+      'rss': self.rss,
+      'runs': len(self.times)
+    }
+
+
+def find_lit():
+  for path in [join(REPO_DIR, 'lit'), join(REPO_DIR, 'build', 'lit')]:
+    if isfile(path) and os.access(path, os.X_OK):
+      return path
+
+  return None
+
+
+def compare(benchmark, baseline, threshold):
+  """Returns the change of the median against the baseline in percent and
+  whether it counts as a regression. Changes, that are within the noise of
+  either run, don't."""
+
+  if baseline is None:
+    return None, False
+
+  median = benchmark.median()
+  change = (median - baseline['median']) * 100.0 / baseline['median']
+  noise = 2 * max(benchmark.stddev(), baseline.get('stddev', 0.0))
+
+  return change, change > threshold and median - baseline['median'] > noise
+
+
+def main():
+  parser = argparse.ArgumentParser(description='Runs the lit benchmarks.')
+  parser.add_argument('benchmarks', nargs='*', help='names of the benchmarks to run (all by default)')
+  parser.add_argument('--lit', help='path to the lit executable (./lit by default)')
+  parser.add_argument('--runs', type=int, default=10, help='timed runs of every benchmark (10)')
+  parser.add_argument('--warmups', type=int, default=2, help='untimed runs before them (2)')
+  parser.add_argument('--baseline', help='JSON file written by --save to compare with')
+  parser.add_argument('--threshold', type=float, default=5.0, help='slowdown in percent, that counts as a regression (5)')
+  parser.add_argument('--save', help='writes the results into this JSON file')
+  args = parser.parse_args()
+
+  lit = realpath(args.lit) if args.lit else find_lit()
+
+  if lit is None or not isfile(lit):
+    print('Could not find the lit executable, build it or pass --lit.')
+    sys.exit(2)
+
+  paths = sorted(join(BENCH_DIR, file) for file in os.listdir(BENCH_DIR) if splitext(file)[1] == '.lit')
+  benchmarks = [Benchmark(path) for path in paths if not args.benchmarks or splitext(basename(path))[0] in args.benchmarks]
+
+  if not benchmarks:
+    print('No benchmarks to run.')
+    sys.exit(2)
+
+  baseline = {}
+
+  if args.baseline:
+    with open(args.baseline, 'r') as file:
+      baseline = json.load(file)['benchmarks']
+
+  print('{:<16} {:>10} {:>10} {:>10} {:>10}'.format('Benchmark', 'Median', 'Stddev', 'Peak RSS', 'Baseline'))
+
+  failed = False
+  regressions = 0
+
+  for benchmark in benchmarks:
+    try:
+      benchmark.run(lit, args.warmups, args.runs)
+    except RuntimeError as error:
+      print('{:<16} {}'.format(benchmark.name, red('FAIL: ' + str(error))))
+      failed = True
+      continue
+
+    change, regressed = compare(benchmark, baseline.get(benchmark.name), args.threshold)
+
+    # Padded before coloring, the escapes would count as width
+    if change is None:
+      change_text = gray('{:>10}'.format('-'))
+    elif regressed:
+      change_text = red('{:>+9.1f}%'.format(change))
+      regressions += 1
+    else:
+      change_text = '{:>+9.1f}%'.format(change)
+      change_text = green(change_text) if change < 0 else change_text
+
+    print('{:<16} {:>8.1f}ms {:>8.1f}ms {:>8.1f}MB {}'.format(benchmark.name, benchmark.median() * 1000,
+      benchmark.stddev() * 1000, benchmark.rss / 1024.0, change_text))
+
+  if args.save:
+    results = {
+      'lit': lit,
+      'benchmarks': dict((benchmark.name, benchmark.to_json()) for benchmark in benchmarks if benchmark.times)
+    }
+
+    with open(args.save, 'w') as file:
+      json.dump(results, file, indent=2, sort_keys=True)
+      file.write('\n')
+
+  if regressions > 0:
+    print(red('{} benchmark(s) regressed by more than {}%'.format(regressions, args.threshold)))
+
+  if failed or regressions > 0:
+    sys.exit(1)
+
+
+if __name__ == '__main__':
+  main()
\ No newline at end of file
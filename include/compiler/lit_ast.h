@@ -12,7 +12,7 @@ typedef struct LitParameter {
 	const char* type;
 } LitParameter;
 
-DECLARE_ARRAY(LitParameters, LitParameter, parameters)
+DECLARE_ARENA_ARRAY(LitParameters, LitParameter, parameters)
 
 typedef enum {
 	BINARY_EXPRESSION = 0,
@@ -34,9 +34,16 @@ typedef enum {
 typedef struct LitExpression {
 	LitExpresionType type;
 	uint64_t line;
+	const char* resolved_type; // Set by the resolver, owned by it
 } LitExpression;
 
-DECLARE_ARRAY(LitExpressions, LitExpression*, expressions)
+DECLARE_ARENA_ARRAY(LitExpressions, LitExpression*, expressions)
+
+typedef enum {
+	ANY_OPERANDS,
+	INT_OPERANDS,
+	DOUBLE_OPERANDS // At least one of the operands is a double, the other is a number
+} LitOperandsType;
 
 typedef struct {
 	LitExpression expression;
@@ -46,6 +53,7 @@ typedef struct {
 
 	bool ignore_left; // If true the left expression wont be freed
 	LitTokenType operator;
+	LitOperandsType operands; // Set by the resolver
 } LitBinaryExpression;
 
 LitBinaryExpression* lit_make_binary_expression(LitCompiler* compiler, LitExpression* left, LitExpression* right, LitTokenType operator);
@@ -112,6 +120,7 @@ typedef struct {
 	LitExpression* object;
 	bool emit_static_init;
 	const char* property;
+	int slot; // Instance field slot, if known at compile time
 } LitGetExpression;
 
 LitGetExpression* lit_make_get_expression(LitCompiler* compiler, LitExpression* object, const char* property);
@@ -123,6 +132,7 @@ typedef struct {
 	LitExpression* value;
 	bool emit_static_init;
 	const char* property;
+	int slot;
 } LitSetExpression;
 
 LitSetExpression* lit_make_set_expression(LitCompiler* compiler, LitExpression* object, LitExpression* value, const char* property);
@@ -164,7 +174,9 @@ typedef enum {
 	CLASS_STATEMENT,
 	FIELD_STATEMENT,
 	BREAK_STATEMENT,
-	CONTINUE_STATEMENT
+	CONTINUE_STATEMENT,
+	TRY_STATEMENT,
+	THROW_STATEMENT
 } LitStatementType;
 
 typedef struct {
@@ -172,7 +184,7 @@ typedef struct {
 	uint64_t line;
 }	LitStatement;
 
-DECLARE_ARRAY(LitStatements, LitStatement*, statements)
+DECLARE_ARENA_ARRAY(LitStatements, LitStatement*, statements)
 
 typedef struct {
 	LitExpression expression;
@@ -296,7 +308,7 @@ typedef struct {
 LitMethodStatement* lit_make_method_statement(LitCompiler* compiler, const char* name, LitParameters* parameters, LitStatement* body, LitParameter return_type,
 	bool overriden, bool is_static, bool abstract, LitAccessType access);
 
-DECLARE_ARRAY(LitMethods, LitMethodStatement*, methods)
+DECLARE_ARENA_ARRAY(LitMethods, LitMethodStatement*, methods)
 
 typedef struct {
 	LitStatement statement;
@@ -324,7 +336,21 @@ typedef struct {
 
 LitContinueStatement* lit_make_continue_statement(LitCompiler* compiler);
 
-void lit_free_statement(LitCompiler* compiler, LitStatement* statement);
-void lit_free_expression(LitCompiler* compiler, LitExpression* expression);
+typedef struct {
+	LitStatement statement;
+
+	LitStatement* body;
+	const char* name; // Of the caught error, NULL for catch without a variable
+	LitStatement* catch_body;
+} LitTryStatement;
+
+LitTryStatement* lit_make_try_statement(LitCompiler* compiler, LitStatement* body, const char* name, LitStatement* catch_body);
+
+typedef struct {
+	LitStatement statement;
+	LitExpression* value;
+} LitThrowStatement;
+
+LitThrowStatement* lit_make_throw_statement(LitCompiler* compiler, LitExpression* value);
 
 #endif
\ No newline at end of file
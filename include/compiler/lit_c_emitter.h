@@ -0,0 +1,26 @@
+#ifndef LIT_C_EMITTER_H
+#define LIT_C_EMITTER_H
+
+/*
+ * Ahead of time backend, translates a resolved AST into C source, that links
+ * against the runtime (lit_runtime in CMake). Values, that the resolver typed
+ * as int, double or bool, are unboxed into int32_t, double and bool, everything
+ * else stays a LitValue. Classes, instances, lambdas and closures are runtime
+ * objects, that the collector manages like the VM's. Static members, getters,
+ * setters, nested functions and classes, and try/throw are reported as errors.
+ *
+ * The generated file defines int lit_aot_main(void), and main() calling it,
+ * unless LIT_AOT_SHARED is defined.
+ */
+
+#include <stdio.h>
+
+#include <lit_common.h>
+#include <lit_predefines.h>
+
+#include <compiler/lit_ast.h>
+
+// Returns false, if the statements use something, that the C backend does not support
+bool lit_emit_c(LitCompiler* compiler, LitStatements* statements, FILE* out);
+
+#endif
\ No newline at end of file
@@ -1,7 +1,10 @@
 #ifndef LIT_COMPILER_H
 #define LIT_COMPILER_H
 
+#include <stdio.h>
+
 #include <lit_mem_manager.h>
+#include <util/lit_arena.h>
 
 #include <compiler/lit_resolver.h>
 #include <compiler/lit_lexer.h>
@@ -11,14 +14,62 @@
 #include <vm/lit_chunk.h>
 #include <vm/lit_memory.h>
 
+typedef enum {
+	PHASE_LEX,
+	PHASE_PARSE,
+	PHASE_RESOLVE,
+	PHASE_EMIT, // Includes the optimizer
+
+	PHASE_COUNT
+} LitCompilePhase;
+
+typedef struct {
+	// In nanoseconds
+	uint64_t time;
+	uint32_t tokens;
+	// AST expressions and statements
+	uint32_t nodes;
+	// Everything the phase allocated, frees don't count
+	size_t bytes_allocated;
+	// Most memory the compiler held at once during the phase
+	size_t peak_bytes;
+} LitPhaseStats;
+
+/*
+ * Filled in by every lit_compile() call. Lexing is interleaved with parsing,
+ * its time is only measured on its own with time_phases set (timing every token
+ * isn't free), otherwise it is a part of the parse time.
+ */
+typedef struct {
+	LitPhaseStats phases[PHASE_COUNT];
+} LitCompileStats;
+
+typedef struct {
+	// Times the lexer separately and prints the LitCompileStats to stderr, once the compiler is freed
+	bool time_phases;
+} LitCompilerOptions;
+
+// Copied into every compiler by lit_init_compiler()
+extern LitCompilerOptions lit_compiler_options;
+
 struct sLitCompiler {
 	LitMemManager mem_manager;
+	LitCompilerOptions options;
 
 	LitResolver resolver;
 	LitLexer lexer;
 	LitEmitter emitter;
 	LitString* init_string;
-} sLitCompiler;
+
+	// Global name -> dense global index, lives as long as the bytecode
+	LitTable globals;
+	// AST, parameter arrays and resolver scopes of the current lit_compile() call
+	LitArena arena;
+
+	LitCompileStats stats;
+	// The one, that allocated AST nodes are counted for
+	LitCompilePhase phase;
+};
 
 void lit_init_compiler(LitCompiler* compiler);
 void lit_compiler_define_native(LitCompiler* compiler, LitNativeRegistry* native);
@@ -31,5 +82,7 @@ void lit_free_compiler(LitCompiler* compiler);
  */
 void lit_free_bytecode_objects(LitCompiler* compiler);
 LitFunction* lit_compile(LitCompiler* compiler, const char* source_code);
+// Translates the source into C (see lit_c_emitter.h), returns false on errors
+bool lit_compile_c(LitCompiler* compiler, const char* source_code, FILE* out);
 
 #endif
\ No newline at end of file
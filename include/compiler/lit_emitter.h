@@ -28,6 +28,8 @@ typedef struct LitEmitterFunction {
 
 	int local_count;
 	int depth;
+	// Values the enclosing statements left on the stack under the locals, like if conditions
+	int leftovers;
 
 	LitLocal locals[UINT8_COUNT];
 	LitEmvalue upvalues[UINT8_COUNT];
@@ -42,11 +44,16 @@ typedef struct LitEmitter {
 	LitInts breaks;
 
 	int loop_start;
+	int field_cache_count;
 	bool had_error;
+	// The next expression statement leaves its value, a loop body pops it
+	bool no_pop;
 } LitEmitter;
 
 void lit_init_emitter(LitCompiler* compiler, LitEmitter* emitter);
 void lit_free_emitter(LitEmitter* emitter);
 LitFunction* lit_emit(LitEmitter* emitter, LitStatements* statements);
+// Returns the dense index of the global, assigning a new one if needed
+int lit_emitter_global(LitEmitter* emitter, const char* name);
 
 #endif
\ No newline at end of file
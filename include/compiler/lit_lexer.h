@@ -31,6 +31,7 @@ typedef enum {
 	TOKEN_OVERRIDE, TOKEN_STATIC, TOKEN_PRIVATE,
 	TOKEN_PUBLIC, TOKEN_PROTECTED, TOKEN_FINAL,
 	TOKEN_VAL, TOKEN_IS,
+	TOKEN_TRY, TOKEN_CATCH, TOKEN_THROW,
 
 	TOKEN_ERROR,
 	TOKEN_EOF
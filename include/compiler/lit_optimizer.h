@@ -0,0 +1,17 @@
+#ifndef LIT_OPTIMIZER_H
+#define LIT_OPTIMIZER_H
+
+/*
+ * Runs over the emitted bytecode and replaces common
+ * instruction pairs with superinstructions
+ */
+
+#include <lit_common.h>
+#include <lit_predefines.h>
+
+#include <vm/lit_object.h>
+
+// Fuses the function chunk and all the functions defined in it
+void lit_optimize_function(LitCompiler* compiler, LitFunction* function);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,18 @@
+#ifndef LIT_REGISTER_EMITTER_H
+#define LIT_REGISTER_EMITTER_H
+
+/*
+ * Emits register VM code for functions, that only do math on their
+ * arguments, locals and globals (no calls, closures or objects).
+ * Only used with LIT_MATH_KERNELS, the stack code is always emitted too.
+ */
+
+#include <lit_common.h>
+#include <lit_predefines.h>
+
+#include <compiler/lit_emitter.h>
+
+// Fills function->registers, returns false (and leaves it empty) if the function is not supported
+bool lit_emit_registers(LitEmitter* emitter, LitFunction* function, LitParameters* parameters, LitStatement* body);
+
+#endif
\ No newline at end of file
@@ -28,6 +28,7 @@ typedef struct LitResolverField {
 	bool is_final;
 	LitAccessType access;
 	const char* type;
+	int slot; // -1 for static fields
 } LitResolverField;
 
 void lit_free_resolver_field(LitCompiler* compiler, LitResolverField* resource);
@@ -53,6 +54,7 @@ typedef struct sLitType {
 	bool abstract;
 	bool inited;
 	struct sLitType* super;
+	int field_count;
 	LitResolverMethods methods;
 	LitResolverMethods static_methods;
 	LitResolverFields fields;
@@ -83,7 +85,11 @@ typedef struct LitResolver {
 	bool had_return;
 	bool had_error;
 
-	LitFunctionStatement* function;
+	LitParameter* return_type; // Of the function, method or lambda being resolved
+
+	// Where tok() continues splitting a Function<> type and whether it hit the closing '>'
+	char* last_string;
+	bool had_template;
 } LitResolver;
 
 void lit_init_resolver(LitResolver* resolver);
@@ -3,6 +3,9 @@
 
 #include <compiler/lit_compiler.h>
 #include <vm/lit_vm.h>
+#include <vm/lit_bytecode.h>
+#include <vm/lit_pool.h>
+#include <vm/lit_script.h>
 #include <util/lit_table.h>
 
 #endif
\ No newline at end of file
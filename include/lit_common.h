@@ -9,4 +9,19 @@
 #define UNREACHABLE() assert(false);
 #define UINT8_COUNT UINT8_MAX + 1
 
+// Runs math kernels, leaf functions, that only do math on their locals, on the register VM (see lit_register_emitter.c)
+#ifndef LIT_MATH_KERNELS
+#define LIT_MATH_KERNELS false
+#endif
+
+// Compiles hot functions to x86-64 machine code (see lit_jit.c)
+#ifndef LIT_JIT
+#define LIT_JIT false
+#endif
+
+// Size of the young generation in bytes (see lit_memory.c)
+#ifndef LIT_NURSERY_SIZE
+#define LIT_NURSERY_SIZE (256 * 1024)
+#endif
+
 #endif
\ No newline at end of file
@@ -1,10 +1,13 @@
 #ifndef LIT_DEBUG_H
 #define LIT_DEBUG_H
 
+#include <stdio.h>
+
 #include <lit_mem_manager.h>
 
 #include <vm/lit_chunk.h>
 #include <compiler/lit_ast.h>
+#include <vm/lit_vm.h>
 
 void lit_trace_statement(LitMemManager* manager, LitStatement* statement, int depth);
 void lit_trace_expression(LitMemManager* manager, LitExpression* expression, int depth);
@@ -12,11 +15,22 @@ void lit_trace_expression(LitMemManager* manager, LitExpression* expression, int
 void lit_trace_chunk(LitMemManager* manager, LitChunk* chunk, const char* name);
 int lit_disassemble_instruction(LitMemManager* manager, LitChunk* chunk, int offset);
 
+const char* lit_opcode_name(uint8_t opcode);
+// Prints the most frequently executed opcode pairs, the data behind the superinstruction set
+void lit_print_opcode_pairs(uint64_t pairs[OP_TOTAL + 1][OP_TOTAL + 1], int count);
+// Opcode, pair and per function counts, sorted from the most executed ones
+void lit_write_opcode_stats(LitOpcodeStats* stats, FILE* out);
+
+void lit_trace_register_chunk(LitMemManager* manager, LitRegisterChunk* chunk, LitChunk* constants, const char* name);
+// Prints how many register instructions of each kind were executed (see DEBUG_COUNT_REGISTER_OPCODES)
+void lit_print_register_opcodes(uint64_t counts[OP_R_TOTAL]);
+
 #define DEBUG_TRACE_AST false
 #define DEBUG_TRACE_EXECUTION false
 #define DEBUG_TRACE_CODE false
 #define DEBUG_TRACE_GC false
 #define DEBUG_TRACE_MEMORY_LEAKS false
 #define DEBUG_NO_EXECUTE false
+#define DEBUG_COUNT_REGISTER_OPCODES false
 
 #endif
\ No newline at end of file
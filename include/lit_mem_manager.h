@@ -15,8 +15,12 @@ typedef enum {
 struct sLitMemManager {
 	LitMemManagerType type;
 	size_t bytes_allocated;
+	// Only counted by compilers (see LitCompileStats): everything allocated so far, frees don't subtract,
+	// and the most bytes_allocated has been since the compiler reset it
+	size_t bytes_total;
+	size_t peak_bytes;
 	LitObject* objects;
 	LitTable strings;
-} sLitMemManager;
+};
 
 #endif
\ No newline at end of file
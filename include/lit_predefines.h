@@ -11,5 +11,6 @@ typedef struct sLitCompiler LitCompiler;
 typedef struct sLitVm LitVm;
 typedef struct sLitObject LitObject;
 typedef struct sLitString LitString;
+typedef struct sLitJitCode LitJitCode;
 
 #endif
\ No newline at end of file
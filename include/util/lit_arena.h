@@ -0,0 +1,36 @@
+#ifndef LIT_ARENA_H
+#define LIT_ARENA_H
+
+/*
+ * Bump allocator for data, that dies all at once. The compiler allocates the AST, its strings
+ * and arrays and the resolver scopes from one, and drops it at the end of lit_compile().
+ */
+
+#include <lit_common.h>
+
+#define LIT_ARENA_CHUNK_SIZE (64 * 1024)
+#define ARENA_ALLOCATE(arena, type, count) (type*) lit_arena_allocate(arena, sizeof(type) * (count))
+
+typedef struct sLitArenaChunk {
+	struct sLitArenaChunk* next;
+	uint8_t data[];
+} LitArenaChunk;
+
+typedef struct {
+	LitArenaChunk* chunks;
+	uint8_t* top;
+	uint8_t* end;
+	// The last allocation, it can grow in place
+	uint8_t* last;
+	// Handed out so far, including memory, that was left behind by lit_arena_grow()
+	size_t bytes;
+} LitArena;
+
+void lit_init_arena(LitArena* arena);
+void* lit_arena_allocate(LitArena* arena, size_t size);
+// Like realloc, but the old memory stays in the arena
+void* lit_arena_grow(LitArena* arena, void* previous, size_t old_size, size_t new_size);
+char* lit_arena_copy_string(LitArena* arena, const char* chars, size_t length);
+void lit_free_arena(LitArena* arena);
+
+#endif
\ No newline at end of file
@@ -1,6 +1,8 @@
 #ifndef LIT_ARRAY_H
 #define LIT_ARRAY_H
 
+#include <util/lit_arena.h>
+
 #define DECLARE_ARRAY(name, type, shr) \
 	typedef struct { \
 		int capacity; \
@@ -34,4 +36,32 @@
 		array->count++; \
 	}
 
+// Arrays, that live in an arena (see lit_arena.h), and go away with it
+#define DECLARE_ARENA_ARRAY(name, type, shr) \
+	typedef struct { \
+		int capacity; \
+		int count; \
+		type* values; \
+	} name; \
+	void lit_init_##shr(name* array); \
+	void lit_##shr##_write(LitArena* arena, name* array, type value);
+
+#define DEFINE_ARENA_ARRAY(name, type, shr) \
+	void lit_init_##shr(name* array) { \
+		array->values = NULL; \
+		array->capacity = 0; \
+		array->count = 0; \
+	} \
+	\
+	void lit_##shr##_write(LitArena* arena, name* array, type value) { \
+		if (array->capacity < array->count + 1) { \
+			int old_capacity = array->capacity; \
+			array->capacity = GROW_CAPACITY(old_capacity); \
+			array->values = (type*) lit_arena_grow(arena, array->values, sizeof(type) * old_capacity, sizeof(type) * array->capacity); \
+		} \
+		\
+		array->values[array->count] = value; \
+		array->count++; \
+	}
+
 #endif
\ No newline at end of file
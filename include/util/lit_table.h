@@ -194,7 +194,7 @@ DECLARE_TABLE(LitTable, LitValue, table, LitValue*)
 		for (int i = 0; i <= table->capacity_mask; i++) { \
 			name##Entry* entry = &table->entries[i]; \
 	\
-			if (entry->key != NULL && !entry->key->object.dark) { \
+			if (entry->key != NULL && !lit_is_marked(&entry->key->object)) { \
 				lit_##shr##_delete(manager, table, entry->key); \
 			} \
 		} \
@@ -0,0 +1,48 @@
+#ifndef LIT_BYTECODE_H
+#define LIT_BYTECODE_H
+
+/*
+ * Binary format for a compiled LitFunction tree, so that scripts can skip
+ * lexing, parsing, resolving and emitting. The file holds the strings, the
+ * global indexes and then every function (nested ones before the functions,
+ * that use them, the top level code is the last one) with its constants,
+ * line table, exception handlers, register code and bytecode.
+ *
+ * Loaded files are mapped into memory, and the code, line and handler arrays point
+ * straight into the mapping. The loader checks the structure of the file and every
+ * operand, that can be checked without running the code: opcodes, constant, global and
+ * upvalue indexes, jump targets, handlers and registers. What the instructions do to the
+ * stack, local slots and field slots is not verified, so .litc files are trusted input,
+ * like shared libraries. Values are stored in the byte order of the machine, that wrote them.
+ */
+
+#include <stdio.h>
+
+#include <lit_common.h>
+#include <lit_predefines.h>
+#include <lit_mem_manager.h>
+
+#include <vm/lit_object.h>
+#include <util/lit_table.h>
+
+#define LIT_BYTECODE_MAGIC "LITB"
+// Bump it with every change to the format, the opcodes or the value representation
+#define LIT_BYTECODE_VERSION 2
+
+typedef struct {
+	LitMemManager mem_manager; // Owns the functions and strings
+	LitTable globals; // Global name -> dense global index, like the compiler ones
+	LitFunction* function; // Top level code
+
+	void* mapping;
+	size_t size;
+} LitBytecode;
+
+bool lit_write_bytecode(LitMemManager* manager, LitFunction* function, LitTable* globals, FILE* out);
+// Returns true, if the file starts with the bytecode magic
+bool lit_is_bytecode_file(const char* path);
+// Prints the error and returns false, if the file can't be loaded
+bool lit_load_bytecode(LitBytecode* bytecode, const char* path);
+void lit_free_bytecode(LitBytecode* bytecode);
+
+#endif
\ No newline at end of file
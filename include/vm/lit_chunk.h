@@ -59,10 +59,71 @@ typedef enum {
 	OP_SQUARE = 44,
 	OP_ROOT = 45,
 	OP_IS = 46,
+	OP_GET_FIELD_SLOT = 47,
+	OP_SET_FIELD_SLOT = 48,
+	// Fused compare + OP_JUMP_IF_FALSE, the result is left on the stack
+	OP_EQUAL_JUMP_IF_FALSE = 49,
+	OP_NOT_EQUAL_JUMP_IF_FALSE = 50,
+	OP_LESS_JUMP_IF_FALSE = 51,
+	OP_LESS_EQUAL_JUMP_IF_FALSE = 52,
+	OP_GREATER_JUMP_IF_FALSE = 53,
+	OP_GREATER_EQUAL_JUMP_IF_FALSE = 54,
+	// For operands, that the resolver typed as int, 32 bit math, that wraps around and checks nothing
+	OP_ADD_INT = 55,
+	OP_SUBTRACT_INT = 56,
+	OP_MULTIPLY_INT = 57,
+	// Superinstructions, only produced by lit_optimize_function()
+	OP_GET_LOCAL_2 = 58,
+	OP_GET_LOCAL_FIELD_SLOT = 59,
+	OP_SET_LOCAL_POP = 60,
+	OP_SET_GLOBAL_POP = 61,
+	OP_ADD_CONSTANT = 62,
+	OP_SUBTRACT_CONSTANT = 63,
+	OP_POP_2 = 64,
+	OP_POP_LOOP = 65,
+	// Pop the condition only if it was true, just like JUMP_IF_FALSE + POP
+	OP_JUMP_IF_FALSE_POP = 66,
+	OP_EQUAL_JUMP_IF_FALSE_POP = 67,
+	OP_NOT_EQUAL_JUMP_IF_FALSE_POP = 68,
+	OP_LESS_JUMP_IF_FALSE_POP = 69,
+	OP_LESS_EQUAL_JUMP_IF_FALSE_POP = 70,
+	OP_GREATER_JUMP_IF_FALSE_POP = 71,
+	OP_GREATER_EQUAL_JUMP_IF_FALSE_POP = 72,
+	OP_THROW = 73,
+	OP_NEGATE_INT = 74,
+	// Superinstructions of OP_CONSTANT and the int opcodes above
+	OP_ADD_INT_CONSTANT = 75,
+	OP_SUBTRACT_INT_CONSTANT = 76,
+	// Same as the fused compares above, for operands, that the resolver typed as int
+	OP_EQUAL_INT_JUMP_IF_FALSE = 77,
+	OP_NOT_EQUAL_INT_JUMP_IF_FALSE = 78,
+	OP_LESS_INT_JUMP_IF_FALSE = 79,
+	OP_LESS_EQUAL_INT_JUMP_IF_FALSE = 80,
+	OP_GREATER_INT_JUMP_IF_FALSE = 81,
+	OP_GREATER_EQUAL_INT_JUMP_IF_FALSE = 82,
+	// Superinstructions of them and OP_POP
+	OP_EQUAL_INT_JUMP_IF_FALSE_POP = 83,
+	OP_NOT_EQUAL_INT_JUMP_IF_FALSE_POP = 84,
+	OP_LESS_INT_JUMP_IF_FALSE_POP = 85,
+	OP_LESS_EQUAL_INT_JUMP_IF_FALSE_POP = 86,
+	OP_GREATER_INT_JUMP_IF_FALSE_POP = 87,
+	OP_GREATER_EQUAL_INT_JUMP_IF_FALSE_POP = 88,
 
-	OP_TOTAL = 47
+	OP_TOTAL = 89
 } LitOpCode;
 
+/*
+ * Errors raised by the code in [start, end) continue at the handler offset,
+ * with the stack cut down to depth slots of the frame and the error pushed on top of it.
+ * Inner try blocks come before the ones around them.
+ */
+typedef struct {
+	uint32_t start;
+	uint32_t end;
+	uint32_t handler;
+	uint32_t depth;
+} LitHandler;
+
 typedef struct {
 	uint64_t count;
 	uint64_t capacity;
@@ -70,6 +131,9 @@ typedef struct {
 	uint64_t* lines;
 	uint64_t line_count;
 	uint64_t line_capacity;
+	LitHandler* handlers;
+	uint64_t handler_count;
+	uint64_t handler_capacity;
 
 	LitArray constants;
 } LitChunk;
@@ -79,6 +143,67 @@ void lit_free_chunk(LitMemManager* manager, LitChunk* chunk);
 
 void lit_chunk_write(LitMemManager* manager, LitChunk* chunk, uint8_t byte, uint64_t line);
 int lit_chunk_add_constant(LitMemManager* manager, LitChunk* chunk, LitValue constant);
+void lit_chunk_add_handler(LitMemManager* manager, LitChunk* chunk, LitHandler handler);
 uint64_t lit_chunk_get_line(LitChunk* chunk, uint64_t offset);
+// Size of the instruction at the offset in bytes, including its operands
+int lit_chunk_instruction_size(LitChunk* chunk, uint64_t offset);
+
+/*
+ * Register VM instructions are 32 bit words: opcode, A, B, C (a byte each),
+ * or opcode, A and a signed 16 bit jump offset / unsigned index in place of B and C
+ */
+typedef enum {
+	OP_R_RETURN = 0, // return R[A]
+	OP_R_RETURN_NIL = 1,
+	OP_R_CONSTANT = 2, // R[A] = K[BX]
+	OP_R_MOVE = 3, // R[A] = R[B]
+	OP_R_NIL = 4,
+	OP_R_GET_GLOBAL = 5, // R[A] = G[BX]
+	OP_R_SET_GLOBAL = 6, // G[BX] = R[A]
+	OP_R_ADD = 7, // R[A] = R[B] + R[C]
+	OP_R_SUBTRACT = 8,
+	OP_R_MULTIPLY = 9,
+	OP_R_DIVIDE = 10,
+	OP_R_NEGATE = 11, // R[A] = -R[B]
+	OP_R_NOT = 12,
+	OP_R_EQUAL = 13, // R[A] = R[B] == R[C]
+	OP_R_NOT_EQUAL = 14,
+	OP_R_LESS = 15,
+	OP_R_LESS_EQUAL = 16,
+	OP_R_GREATER = 17,
+	OP_R_GREATER_EQUAL = 18,
+	OP_R_JUMP = 19, // ip += SBX
+	OP_R_JUMP_IF_FALSE = 20, // if R[A] is false, ip += SBX
+	OP_R_JUMP_IF_TRUE = 21,
+	OP_R_ADD_INT = 22, // Like OP_ADD_INT, for operands typed as int
+	OP_R_SUBTRACT_INT = 23,
+	OP_R_MULTIPLY_INT = 24,
+	OP_R_NEGATE_INT = 25,
+
+	OP_R_TOTAL = 26
+} LitRegisterOpCode;
+
+#define REGISTER_OP(instruction) ((instruction) & 0xff)
+#define REGISTER_A(instruction) (((instruction) >> 8) & 0xff)
+#define REGISTER_B(instruction) (((instruction) >> 16) & 0xff)
+#define REGISTER_C(instruction) ((instruction) >> 24)
+#define REGISTER_BX(instruction) ((instruction) >> 16)
+#define REGISTER_SBX(instruction) ((int16_t) ((instruction) >> 16))
+
+#define MAKE_REGISTER_ABC(op, a, b, c) ((uint32_t) (op) | ((uint32_t) (a) << 8) | ((uint32_t) (b) << 16) | ((uint32_t) (c) << 24))
+#define MAKE_REGISTER_ABX(op, a, bx) ((uint32_t) (op) | ((uint32_t) (a) << 8) | ((uint32_t) (uint16_t) (bx) << 16))
+
+typedef struct {
+	uint64_t count;
+	uint64_t capacity;
+	uint32_t* code;
+
+	// Registers live in the frame slots, the arguments are the first ones
+	int register_count;
+} LitRegisterChunk;
+
+void lit_init_register_chunk(LitRegisterChunk* chunk);
+void lit_free_register_chunk(LitMemManager* manager, LitRegisterChunk* chunk);
+void lit_register_chunk_write(LitMemManager* manager, LitRegisterChunk* chunk, uint32_t instruction);
 
 #endif
\ No newline at end of file
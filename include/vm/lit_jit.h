@@ -0,0 +1,37 @@
+#ifndef LIT_JIT_H
+#define LIT_JIT_H
+
+/*
+ * Baseline JIT for x86-64 Linux, translates the stack chunk of a function
+ * into machine code, an opcode at a time, from fixed templates. Opcodes
+ * without a template (calls, returns, objects...) exit back to interpret(),
+ * that carries on from the same instruction and enters the machine code again
+ * after calls, returns and loop back edges.
+ */
+
+#include <lit_common.h>
+#include <lit_predefines.h>
+
+#include <vm/lit_vm.h>
+
+// Calls and loop back edges, after which a function gets compiled
+#define LIT_JIT_THRESHOLD 1000
+
+typedef void (*LitJitEntry)(LitVm* vm, LitFrame* frame, uint8_t* target);
+
+struct sLitJitCode {
+	uint8_t* code;
+	size_t size;
+
+	// Machine code offset of each instruction, indexed by its bytecode offset
+	uint32_t* offsets;
+	LitJitEntry entry;
+};
+
+// Returns false, if the JIT is not available on this platform or failed
+bool lit_jit_compile(LitVm* vm, LitFunction* function);
+// Runs the compiled function from frame->ip, till it hits an instruction without a template
+void lit_jit_run(LitVm* vm, LitFrame* frame);
+void lit_jit_free(LitFunction* function);
+
+#endif
\ No newline at end of file
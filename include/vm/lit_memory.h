@@ -17,8 +17,24 @@ void* reallocate(LitMemManager* manager, void* previous, size_t old_size, size_t
 // VM only stuff
 void lit_gray_object(LitVm* vm, LitObject* object);
 void lit_gray_value(LitVm* vm, LitValue value);
+// Allocates an old object, small VM objects go to the pages, the rest to the object list of the manager
+LitObject* lit_allocate_object(LitMemManager* manager, size_t size);
+// Returns NULL and asks for a minor collection, once the nursery is full
+void* lit_allocate_young(LitVm* vm, size_t size);
+void lit_remember(LitVm* vm, LitObject* object);
+// Grays objects, that are allocated in the old space during the mark phase
+void lit_color_new_object(LitVm* vm, LitObject* object);
+// Runs the requested collections, every live object has to be reachable from the roots
+void lit_gc_safepoint(LitVm* vm);
+// Copies the live young objects into the old space
+void lit_collect_young(LitVm* vm);
+// Finishes the current collection (or runs a new one) without a pause budget
 void lit_collect_garbage(LitVm* vm);
 void lit_free_object(LitMemManager* manager, LitObject* object);
 void lit_free_objects(LitMemManager* manager);
+// Makes the objects of the compiler or bytecode off limits for the collectors of the VMs, that run them
+void lit_share_objects(LitMemManager* manager);
+// Monotonic clock in nanoseconds, for collection pauses and compile phases
+uint64_t lit_time_ns();
 
 #endif
\ No newline at end of file
@@ -6,6 +6,7 @@
 
 #include <vm/lit_value.h>
 #include <vm/lit_chunk.h>
+#include <vm/lit_page.h>
 #include <util/lit_table.h>
 #include <compiler/lit_ast.h>
 
@@ -39,18 +40,47 @@ typedef enum {
 	OBJECT_INSTANCE
 } LitObjectType;
 
+/*
+ * Objects outside of the pages are chained into the object list of their manager
+ * through a pointer, that is allocated right in front of them (see LIT_OBJECT_NEXT)
+ */
 struct sLitObject {
 	LitObjectType type;
-	bool dark;
-	struct sLitObject* next;
+	bool dark; // Marked, unless the object is paged. In the nursery: copied to the old space
+	bool remembered; // Old object in the remembered set of the VM
+	bool paged; // Lives in a LitPage, marked in its bitmap
+	bool shared; // Owned by the compiler or bytecode, that VMs run, their collectors never touch it (see lit_share_objects())
 };
 
+#define LIT_OBJECT_NEXT(object) (((LitObject**) (object))[-1])
+
+// A young object, that was copied out of the nursery, the copy pointer overwrites its first field
+typedef struct {
+	LitObject object;
+	LitObject* copy;
+} LitForwarded;
+
+static inline bool lit_is_marked(LitObject* object) {
+	if (object->shared) {
+		return true;
+	}
+
+	if (object->paged) {
+		LitPage* page = lit_page_of(object);
+		uint32_t slot = lit_page_slot(page, object);
+
+		return (page->marks[slot / 64] >> (slot % 64)) & 1;
+	}
+
+	return object->dark;
+}
+
 struct sLitString {
 	LitObject object;
 
 	int length;
-	char* chars;
 	uint32_t hash;
+	char* chars;
 };
 
 LitString* lit_make_string(LitMemManager* manager, char* chars, int length);
@@ -75,7 +105,17 @@ typedef struct {
 	int upvalue_count;
 
 	LitChunk chunk;
+	// Empty, unless LIT_MATH_KERNELS is on and the function body can run on registers
+	LitRegisterChunk registers;
 	LitString* name;
+
+	// Calls and loop back edges, the JIT compiles the function once it gets hot
+	uint32_t hotness;
+	LitJitCode* jit;
+	// Instructions interpret() ran, only counted with opcode stats on
+	uint64_t executed;
+	// C code of programs, that lit --emit-c translated, called with the closure or bound method first
+	void* aot;
 } LitFunction;
 
 LitFunction* lit_new_function(LitMemManager* manager);
@@ -99,8 +139,8 @@ typedef struct {
 	LitObject object;
 
 	LitFunction* function;
-	LitUpvalue** upvalues;
 	int upvalue_count;
+	LitUpvalue* upvalues[];
 } LitClosure;
 
 LitClosure* lit_new_closure(LitMemManager* manager, LitFunction* function);
@@ -112,8 +152,9 @@ typedef struct sLitClass {
 	struct sLitClass* super;
 	LitTable methods;
 	LitTable static_methods;
-	LitTable fields;
+	LitTable fields; // Field name -> slot in LitInstance.fields
 	LitTable static_fields;
+	LitArray field_defaults;
 } LitClass;
 
 LitClass* lit_new_class(LitMemManager* manager, LitString* name, LitClass* super);
@@ -122,7 +163,8 @@ typedef struct {
 	LitObject object;
 
 	LitClass* type;
-	LitTable fields;
+	int field_count;
+	LitValue fields[];
 } LitInstance;
 
 LitInstance* lit_new_instance(LitMemManager* manager, LitClass* class);
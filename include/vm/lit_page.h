@@ -0,0 +1,72 @@
+#ifndef LIT_PAGE_H
+#define LIT_PAGE_H
+
+/*
+ * Old space of the VM for small objects. Every page is aligned to its size and holds slots
+ * of one size class, so the page of an object is found by masking its address. Which slots are
+ * taken and which are marked lives in bitmaps in the page header, not in the objects, so
+ * sweeping a page is a scan over its bitmaps, that only touches the dead objects.
+ *
+ * The background sweeper (see lit_memory.c) frees slots, while the program allocates new ones
+ * in the same pages, so the used bits and the live counts are only changed atomically.
+ */
+
+#include <lit_common.h>
+#include <lit_predefines.h>
+
+#define LIT_PAGE_SIZE (64 * 1024)
+#define LIT_PAGE_GRANULE 8
+// Bigger objects are malloc'ed one by one
+#define LIT_PAGE_MAX_OBJECT 256
+#define LIT_PAGE_CLASSES (LIT_PAGE_MAX_OBJECT / LIT_PAGE_GRANULE)
+// Enough bits for the smallest objects (a header and a pointer)
+#define LIT_PAGE_WORDS (LIT_PAGE_SIZE / 16 / 64)
+
+typedef struct sLitPage {
+	struct sLitPage* next; // Next page of the same size class
+	uint32_t object_size;
+	uint32_t capacity;
+	// Slot index is ((object - slots) * inverse) >> 32, the offset is always a multiple of the size
+	uint64_t inverse;
+	uint32_t live;
+	uint32_t cursor; // Word, that the next allocation starts looking at
+	uint8_t* slots;
+
+	uint64_t used[LIT_PAGE_WORDS]; // The bits after the capacity are always set
+	uint64_t marks[LIT_PAGE_WORDS];
+	// Unmarked slots at the end of the last mark phase, waiting for the sweeper
+	uint64_t dead[LIT_PAGE_WORDS];
+} LitPage;
+
+typedef struct {
+	LitPage* pages[LIT_PAGE_CLASSES];
+	LitPage* current[LIT_PAGE_CLASSES];
+
+	// The page lists, as they were at the end of marking (new pages only get prepended)
+	LitPage* sweeping[LIT_PAGE_CLASSES];
+	int sweep_class;
+	LitPage* sweep_page;
+} LitPageHeap;
+
+static inline LitPage* lit_page_of(void* object) {
+	return (LitPage*) ((uintptr_t) object & ~((uintptr_t) LIT_PAGE_SIZE - 1));
+}
+
+static inline uint32_t lit_page_slot(LitPage* page, void* object) {
+	return (uint32_t) (((uint64_t) ((uint8_t*) object - page->slots) * page->inverse) >> 32);
+}
+
+void lit_init_pages(LitPageHeap* heap);
+// Bits of the bitmap word, that stand for actual slots
+uint64_t lit_page_slot_bits(LitPage* page, int word);
+// Returns a zeroed out slot for an object of that size (at most LIT_PAGE_MAX_OBJECT)
+void* lit_page_allocate(LitPageHeap* heap, size_t size);
+// Moves the unmarked slots to the dead bitmaps, clears the marks and takes the page lists to sweep
+void lit_pages_start_sweep(LitPageHeap* heap);
+// Frees the given dead slots of one bitmap word
+void lit_page_release(LitPage* page, int word, uint64_t bits);
+// Gives pages without live objects back to the system, the sweep has to be done
+void lit_release_empty_pages(LitPageHeap* heap);
+void lit_free_pages(LitPageHeap* heap);
+
+#endif
\ No newline at end of file
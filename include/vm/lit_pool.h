@@ -0,0 +1,50 @@
+#ifndef LIT_POOL_H
+#define LIT_POOL_H
+
+/*
+ * Runs one compiled program many times in parallel. Every run gets a new VM of its own on one
+ * of the worker threads, so runs never see each other's globals or objects. The VMs share the
+ * program itself (the functions, constants and strings of the compiler or bytecode), that none
+ * of them writes: lit_init_vm_pool() flags its objects as shared, so the collectors leave them
+ * alone, and the JIT compiles its functions one thread at a time.
+ *
+ * The program has to outlive the pool. Opcode stats and the profiler only work with a single VM,
+ * so they are turned off for the runs.
+ */
+
+#include <pthread.h>
+
+#include <lit_common.h>
+#include <lit_predefines.h>
+
+#include <vm/lit_vm.h>
+
+typedef struct {
+	LitMemManager* owner; // Compiler or bytecode, that the program belongs to
+	LitTable* globals;
+	LitFunction* function;
+	// Copied into the VM of every run
+	LitVmOptions options;
+
+	pthread_t* threads;
+	int thread_count;
+
+	pthread_mutex_t lock;
+	pthread_cond_t wake; // Workers wait on it for runs or the shutdown
+	pthread_cond_t idle; // lit_wait_vm_pool() waits on it for the last run
+	uint64_t queued; // Runs, that no worker took yet
+	uint64_t running;
+	uint64_t failed; // Runs, that ended with a runtime error
+	bool stopping;
+} LitVmPool;
+
+// Starts thread_count workers, 0 starts one per core
+bool lit_init_vm_pool(LitVmPool* pool, LitMemManager* owner, LitTable* globals, LitFunction* function, int thread_count);
+// Queues count runs of the program and returns right away
+void lit_vm_pool_run(LitVmPool* pool, uint64_t count);
+// Waits for every queued run, returns how many of them failed since the last wait
+uint64_t lit_wait_vm_pool(LitVmPool* pool);
+// Finishes the queued runs and stops the workers
+void lit_free_vm_pool(LitVmPool* pool);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,68 @@
+#ifndef LIT_PROFILER_H
+#define LIT_PROFILER_H
+
+/*
+ * Sampling profiler of the VM. A SIGPROF timer interrupts the program every interval of
+ * CPU time, and the signal handler walks vm->frames, so the program itself runs unchanged.
+ * The handler can't allocate, so samples go straight into fixed tables: a calling context
+ * tree of functions (the folded stacks for flamegraphs) and a hash of the bytecode offsets,
+ * the program was at (the hotspot lines). Samples, that don't fit any more, are counted as dropped.
+ *
+ * Only one VM can be profiled at a time. Samples, that hit the GC threads, show up as [gc thread].
+ * Register VM and JIT frames keep their ip in a local, so they only get attributed to the function.
+ */
+
+#include <stdio.h>
+#include <pthread.h>
+
+#include <lit_common.h>
+#include <lit_predefines.h>
+
+#include <vm/lit_object.h>
+
+#define LIT_PROFILER_INTERVAL 1000 // Microseconds
+#define LIT_PROFILER_NODES (64 * 1024)
+#define LIT_PROFILER_SITES (64 * 1024) // Has to be a power of two
+
+typedef struct {
+	LitFunction* function;
+	uint32_t parent;
+	uint32_t child; // First one, the rest are its siblings, 0 is none
+	uint32_t sibling;
+	// Samples, where this was the innermost frame
+	uint64_t samples;
+} LitProfileNode;
+
+typedef struct {
+	LitFunction* function;
+	uint32_t offset;
+	uint64_t samples;
+} LitProfileSite;
+
+typedef struct {
+	LitVm* vm;
+	pthread_t thread;
+	bool running;
+
+	// Node 0 is the root, above the top level code
+	LitProfileNode* nodes;
+	uint32_t node_count;
+	LitProfileSite* sites;
+	uint32_t site_count;
+
+	uint64_t samples;
+	uint64_t dropped;
+	uint64_t other_threads;
+} LitProfiler;
+
+void lit_init_profiler(LitProfiler* profiler);
+// Starts sampling the VM on the calling thread every interval microseconds of CPU time
+bool lit_start_profiler(LitProfiler* profiler, LitVm* vm, uint32_t interval);
+void lit_stop_profiler(LitProfiler* profiler);
+// One line per stack, that was sampled, like "$main;fib;fib 42", the format flamegraph.pl takes
+void lit_write_folded_stacks(LitProfiler* profiler, FILE* out);
+// Self and total samples of the functions and the count hottest lines
+void lit_write_profile_report(LitProfiler* profiler, FILE* out, int count);
+void lit_free_profiler(LitProfiler* profiler);
+
+#endif
\ No newline at end of file
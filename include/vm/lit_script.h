@@ -0,0 +1,57 @@
+#ifndef LIT_SCRIPT_H
+#define LIT_SCRIPT_H
+
+/*
+ * Compiled program, that embedders keep around, instead of compiling it for every run.
+ * Any number of VMs can load it, one after another or at the same time on different
+ * threads (see lit_pool.h), its objects are shared by them and never collected.
+ * Loading runs the top level code once, after that lit_get_global() finds the functions
+ * it defined and lit_call() calls them as often as needed:
+ *
+ *   LitScript script;
+ *   LitVm vm;
+ *   LitValue rule, result;
+ *
+ *   lit_compile_script(&script, source_code);
+ *   lit_load_script(&vm, &script);
+ *   lit_get_global(&vm, "rule", &rule);
+ *
+ *   LitValue args[] = { MAKE_INT_VALUE(42) };
+ *   lit_call(&vm, rule, args, 1, &result);
+ *
+ *   lit_free_vm(&vm);
+ *   lit_free_script(&script);
+ */
+
+#include <lit_common.h>
+#include <lit_predefines.h>
+
+#include <compiler/lit_compiler.h>
+#include <vm/lit_bytecode.h>
+#include <vm/lit_vm.h>
+
+typedef struct {
+	bool bytecode; // Loaded from a file written by lit_eval_to_bytecode(), not compiled
+
+	union {
+		LitCompiler compiler;
+		LitBytecode file;
+	} as;
+
+	LitFunction* function; // Top level code
+} LitScript;
+
+// Prints the errors and returns false, if the source doesn't compile
+bool lit_compile_script(LitScript* script, const char* source_code);
+// The same for a bytecode file
+bool lit_read_script(LitScript* script, const char* path);
+// Must outlive every VM, that loaded it
+void lit_free_script(LitScript* script);
+
+/*
+ * Initializes the VM and runs the top level code of the script in it,
+ * returns false on runtime errors (the VM still has to be freed)
+ */
+bool lit_load_script(LitVm* vm, LitScript* script);
+
+#endif
\ No newline at end of file
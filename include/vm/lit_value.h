@@ -14,17 +14,25 @@
 #define TAG_NIL 1
 #define TAG_FALSE 2
 #define TAG_TRUE 3
-#define TAG_CHAR 4
+// Chars and ints keep their payload in the low 32 bits,
+// object pointers never reach those bits, so there is no need to check the sign
+
+#define TAG_CHAR ((uint64_t) 1 << 48)
+#define TAG_INT ((uint64_t) 1 << 49)
 
 typedef uint64_t LitValue;
 
-#define IS_BOOL(v) (((v) & (QNAN | TAG_FALSE)) == (QNAN | TAG_FALSE))
+#define IS_BOOL(v) (((v) | 1) == TRUE_VALUE)
 #define IS_NIL(v) ((v) == NIL_VALUE)
-#define IS_NUMBER(v) (((v) & QNAN) != QNAN)
+#define IS_DOUBLE(v) (((v) & QNAN) != QNAN)
+#define IS_INT(v) (((v) & (QNAN | TAG_INT)) == (QNAN | TAG_INT))
+#define ARE_INTS(a, b) IS_INT((a) & (b))
+#define IS_NUMBER(v) (IS_DOUBLE(v) || IS_INT(v))
 #define IS_OBJECT(v) (((v) & (QNAN | SIGN_BIT)) == (QNAN | SIGN_BIT))
-#define IS_CHAR(v) (((v) & (QNAN | TAG_CHAR)) == (QNAN | TAG_CHAR))
+#define IS_CHAR(v) (((v) & (QNAN | TAG_INT | TAG_CHAR)) == (QNAN | TAG_CHAR))
 
 #define AS_BOOL(v) ((v) == TRUE_VALUE)
+#define AS_INT(v) ((int32_t) (uint32_t) (v))
 #define AS_NUMBER(v) lit_value_to_num(v)
 #define AS_OBJECT(v) ((LitObject*)(uintptr_t)((v) & ~(SIGN_BIT | QNAN)))
 
@@ -32,6 +40,8 @@ typedef uint64_t LitValue;
 #define FALSE_VALUE ((LitValue) (uint64_t) (QNAN | TAG_FALSE))
 #define TRUE_VALUE ((LitValue) (uint64_t) (QNAN | TAG_TRUE))
 #define NIL_VALUE ((LitValue) (uint64_t) (QNAN | TAG_NIL))
+// Ints are 32 bit, int typed arithmetic wraps around, like int32_t in C, untyped one goes on in doubles
+#define MAKE_INT_VALUE(num) ((LitValue) (QNAN | TAG_INT | (uint64_t) (uint32_t) (int32_t) (num)))
 #define MAKE_NUMBER_VALUE(num) lit_num_to_value(num)
 #define MAKE_CHAR_VALUE(num) lit_char_to_value(num)
 
@@ -46,27 +56,38 @@ typedef union {
 } DoubleUnion;
 
 static inline LitValue lit_char_to_value(unsigned char ch) {
-	DoubleUnion data;
-	data.bits16[0] = (uint16_t) ch;
-
-	data.bits64 |= QNAN;
-	data.bits64 |= TAG_CHAR;
-
-	return data.bits64;
+	return QNAN | TAG_CHAR | (uint64_t) ch;
 }
 
-static inline double lit_value_to_num(LitValue value) {
+static inline double lit_value_to_double(LitValue value) {
 	DoubleUnion data;
 	data.bits64 = value;
 	return data.num;
 }
 
+static inline double lit_value_to_num(LitValue value) {
+	if (IS_INT(value)) {
+		return (double) AS_INT(value);
+	}
+
+	return lit_value_to_double(value);
+}
+
 static inline LitValue lit_num_to_value(double num) {
 	DoubleUnion data;
 	data.num = num;
 	return data.bits64;
 }
 
+// Keeps the number an int, if it fits into one without losing anything
+static inline LitValue lit_int_to_value(int64_t num) {
+	if (num >= INT32_MIN && num <= INT32_MAX) {
+		return MAKE_INT_VALUE(num);
+	}
+
+	return MAKE_NUMBER_VALUE((double) num);
+}
+
 bool lit_is_false(LitValue value);
 char *lit_to_string(LitVm* vm, LitValue value);
 
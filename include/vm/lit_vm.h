@@ -6,6 +6,9 @@
  * Runs bytecode chunks
  */
 
+#include <stdio.h>
+#include <pthread.h>
+
 #include <lit_common.h>
 #include <lit_predefines.h>
 #include <lit_mem_manager.h>
@@ -13,10 +16,36 @@
 #include <vm/lit_chunk.h>
 #include <vm/lit_object.h>
 #include <vm/lit_memory.h>
+#include <vm/lit_profiler.h>
 
 #define FRAMES_MAX 64
 #define STACK_MAX (FRAMES_MAX * UINT8_COUNT)
 #define VM_STACK_MAX 256
+#define FIELD_CACHE_WAYS 4
+
+typedef enum {
+	CACHE_FIELD, // Slot in the instance
+	CACHE_METHOD,
+	CACHE_STATIC_FIELD,
+	CACHE_STATIC_METHOD
+} LitFieldCacheKind;
+
+typedef struct {
+	LitClass* class;
+	LitString* name;
+	LitFieldCacheKind kind;
+	int index;
+} LitFieldCacheEntry;
+
+/*
+ * Inline cache of a single OP_GET_FIELD / OP_SET_FIELD site,
+ * remembers table slots, where the property was found for the last few receiver classes
+ */
+typedef struct {
+	LitFieldCacheEntry entries[FIELD_CACHE_WAYS];
+	uint8_t count;
+	uint8_t next;
+} LitFieldCache;
 
 typedef struct {
 	LitClosure* closure;
@@ -24,34 +53,236 @@ typedef struct {
 	LitValue* slots;
 } LitFrame;
 
-typedef struct sLitVm {
+// Records of a lit_call_batch(), that runs the same function for each of them
+typedef struct {
+	LitValue* args; // arg_count values per record
+	int arg_count;
+	size_t count;
+	size_t done; // Results written so far
+	LitValue* results;
+} LitBatch;
+
+typedef enum {
+	GC_IDLE,
+	GC_MARK,
+	GC_SWEEP
+} LitGcState;
+
+typedef struct {
+	uint32_t minor_collections;
+	uint32_t full_collections;
+	uint32_t pauses;
+	// In nanoseconds, a pause is everything one safe point did
+	uint64_t longest_pause;
+	uint64_t total_pause;
+	// The parts of the pauses, that gc_pause doesn't bound (lit_collect_young() also runs outside of them)
+	uint64_t longest_minor;
+	uint64_t total_minor;
+	uint64_t longest_final_mark;
+	uint64_t total_final_mark;
+} LitGcStats;
+
+/*
+ * Filled in by interpret(), while it dispatches through its counting table (see options.opcode_stats),
+ * the instructions per function are counted in LitFunction.executed. Code, that runs on the register VM
+ * or the JIT, isn't counted.
+ */
+typedef struct {
+	// One more for unknown opcodes, so counting doesn't have to check
+	uint64_t opcodes[OP_TOTAL + 1];
+	// Opcode executed right after another one, the data behind the superinstructions
+	uint64_t pairs[OP_TOTAL + 1][OP_TOTAL + 1];
+	uint8_t last_opcode;
+
+	// Top level code, the other functions are found in its constants
+	LitFunction* function;
+} LitOpcodeStats;
+
+typedef struct {
+	// Target length of the incremental mark and sweep slices in microseconds, 0 collects the whole heap at once.
+	// It is not a bound on the pauses: slices run over it, when the program grays objects faster, than
+	// they get marked, and the minor collection before every slice and the atomic end of marking run
+	// to completion (LitGcStats reports them separately)
+	uint32_t gc_pause;
+	// Prints the LitGcStats to stderr, once the VM is freed
+	bool gc_stats;
+	// Frees garbage on a separate thread, so the program continues right after marking
+	bool gc_sweep_thread;
+	// Threads, that mark the heap, whenever the program is stopped for the rest of the mark phase
+	uint32_t gc_mark_threads;
+	// Samples the running program (see lit_profiler.h) and prints a report to stderr, once the VM is freed
+	bool profile;
+	// Microseconds of CPU time between samples, 0 is LIT_PROFILER_INTERVAL
+	uint32_t profile_interval;
+	// File for the folded stacks, NULL only prints the report
+	const char* profile_output;
+	// Counts the executed opcodes and writes the LitOpcodeStats there as JSON, once the VM is freed
+	const char* opcode_stats;
+} LitVmOptions;
+
+// Copied into every VM by lit_init_vm()
+extern LitVmOptions lit_vm_options;
+
+struct sLitVm {
 	LitMemManager mem_manager;
+	LitVmOptions options;
 
 	LitValue stack[VM_STACK_MAX];
 	LitValue* stack_top;
+
+	// Globals are accessed by the index the emitter gave them,
+	// the name table is only used to define natives and for debugging
 	LitTable globals;
+	LitArray global_values;
+
 	LitString *init_string;
 
 	LitFrame frames[FRAMES_MAX];
 	int frame_count;
 	bool abort;
+	// Set by call_value(), the native or class without init() already left its result
+	bool last_native;
+	// Set by call_value(), the frame runs init(), its return leaves the instance
+	bool last_init;
+	// The running lit_call_batch(), its arguments and results are roots
+	LitBatch* batch;
+	// Set with abort, when a try block in that frame catches the error, interpret() continues in its handler
+	LitHandler* handler;
+	int handler_frame;
+	LitValue caught;
 
 	LitUpvalue* open_upvalues;
+	LitFieldCache* field_caches;
+	int field_cache_capacity;
+
 	size_t next_gc;
+	// Allocations only ask for collections, they run at the safe points of the interpreter
+	bool gc_requested;
+
+	// Young generation, objects are bump allocated and copied out by minor collections
+	uint8_t* nursery;
+	uint8_t* nursery_top;
+
+	// Old objects, that might point into the nursery (see lit_write_barrier())
+	LitObject** remembered;
+	int remembered_count;
+	int remembered_capacity;
+	// The same for all globals at once
+	bool young_globals;
+
+	// Old space for small objects, bigger ones are on the object list
+	LitPageHeap pages;
+	// Copies of the current minor collection, that still have to be scanned
+	LitObject** promoted;
+	int promoted_count;
+	int promoted_capacity;
+
+	LitGcState gc_state;
+	// Old object list, that is being swept
+	LitObject* sweeping;
+	// Background sweep (see lit_memory.c), the thread hands the survivors back once done is set
+	pthread_t sweeper;
+	bool sweeper_running;
+	bool sweeper_done;
+	LitObject* swept;
+	LitObject* swept_tail;
+	size_t swept_bytes;
+	LitGcStats gc_stats;
+	LitProfiler profiler;
+	// Only allocated with options.opcode_stats
+	LitOpcodeStats* opcode_stats;
+	// Only filled with DEBUG_COUNT_REGISTER_OPCODES
+	uint64_t register_opcodes[OP_R_TOTAL];
 
 	int gray_count;
 	int gray_capacity;
+	// Gray objects, that the last mark slice left, the ones above it came from the program
+	int gray_left;
 
 	LitObject** gray_stack;
-} sLitVm;
+};
+
+static inline bool lit_is_young(LitVm* vm, LitObject* object) {
+	return (uintptr_t) object - (uintptr_t) vm->nursery < LIT_NURSERY_SIZE;
+}
+
+/*
+ * Must follow every store of a value into an object, that might be old,
+ * minor collections only find young objects through the roots and the remembered set,
+ * and incremental marking has to see values, that got stored into already black objects
+ */
+static inline void lit_write_barrier(LitVm* vm, LitObject* object, LitValue value) {
+	if (!IS_OBJECT(value)) {
+		return;
+	}
+
+	LitObject* target = AS_OBJECT(value);
+
+	if (lit_is_young(vm, target)) {
+		if (!object->remembered && !lit_is_young(vm, object)) {
+			lit_remember(vm, object);
+		}
+	} else if (vm->gc_state == GC_MARK && !lit_is_marked(target)) {
+		lit_gray_object(vm, target);
+	}
+}
+
+// Globals are roots, the end of the mark phase scans them again anyway
+static inline void lit_global_barrier(LitVm* vm, LitValue value) {
+	if (IS_OBJECT(value) && lit_is_young(vm, AS_OBJECT(value))) {
+		vm->young_globals = true;
+	}
+}
 
 void lit_init_vm(LitVm* vm);
 void lit_vm_define_native(LitVm* vm, LitNativeRegistry* native);
 void lit_vm_define_natives(LitVm* vm, LitNativeRegistry* natives);
+// Takes over global indexes from the compiler, must be called before defining natives
+void lit_vm_link_globals(LitVm* vm, LitTable* globals);
+// Links the strings and globals of the compiler or bytecode, that owns a program, and defines the standard natives
+void lit_vm_load_program(LitVm* vm, LitMemManager* owner, LitTable* globals);
+// time(), print() and error(), that lit_vm_load_program() defines, compilers need them declared too
+extern LitNativeRegistry lit_std_natives[];
 void lit_free_vm(LitVm* vm);
 
 bool lit_eval(const char* source_code);
+// Compiles the source once and runs it that many times on threads VMs at once (0 is one per core, see lit_pool.h)
+bool lit_eval_parallel(const char* source_code, uint64_t runs, int threads);
+// Translates the source into C instead of running it
+bool lit_eval_to_c(const char* source_code, FILE* out);
+// Runs a file written by lit_eval_to_bytecode()
+bool lit_eval_bytecode(const char* path);
+bool lit_eval_bytecode_parallel(const char* path, uint64_t runs, int threads);
+// Compiles the source and writes it in the format from lit_bytecode.h
+bool lit_eval_to_bytecode(const char* source_code, FILE* out);
 bool lit_execute(LitVm* vm, LitFunction* function);
+/*
+ * Returns false, if no global has that name (natives and globals of the loaded program have one).
+ * Young objects get promoted first, so the function or object stays valid, as long as the global holds it.
+ */
+bool lit_get_global(LitVm* vm, const char* name, LitValue* value);
+/*
+ * Calls a function, native or class with the arguments and stores what it returned in result.
+ * Only works between runs, not from natives. A runtime error prints its stack trace
+ * and returns false, the VM stays usable. A young object in the result gets promoted,
+ * so it does not move, but it is only safe from the collector until the VM runs again.
+ * Arguments for int params have to be MAKE_INT_VALUE(), the int opcodes don't check them.
+ */
+bool lit_call(LitVm* vm, LitValue callee, LitValue* args, int arg_count, LitValue* result);
+/*
+ * Calls the function once for every record in args (arg_count values each), like lit_call(),
+ * and writes the results into results. A lit function is entered only once, every return
+ * sets its frame up again for the next record. Returns how many records were done,
+ * fewer than count means, that the next one failed with a runtime error.
+ * Both arrays are roots, while the batch runs, the collector updates the objects in them.
+ * Young results get promoted before it returns, after that they are kept like the one of lit_call().
+ */
+size_t lit_call_batch(LitVm* vm, LitValue callee, LitValue* args, int arg_count, size_t count, LitValue* results);
+
+// Number semantics shared by the interpreter, the register VM and the JIT
+LitValue lit_number_arithmetic(LitOpCode instruction, LitValue a, LitValue b);
+LitValue lit_negate(LitValue value);
+LitValue lit_divide(LitValue a, LitValue b);
 
 void lit_push(LitVm* vm, LitValue value);
 LitValue lit_pop(LitVm* vm);
@@ -33,6 +33,18 @@ void show_help() {
 	printf("lit - powerful and fast static-typed language\n");
 	printf("\tlit [file]\tRun the file\n");
 	printf("\t-e --exec [code string]\tExecutes a string of code\n");
+	printf("\t-c --compile [file] [-o out.litc]\tCompiles the file into bytecode, that lit [file] runs without recompiling\n");
+	printf("\t--emit-c [file] [-o out.c]\tTranslates the file into C, instead of running it\n");
+	printf("\t--gc-pause [microseconds]\tMarks and sweeps incrementally, in slices of about that length\n");
+	printf("\t--gc-stats\tPrints the collection count and pause times after running\n");
+	printf("\t--gc-mark-threads [count]\tMarks the heap with that many threads, while the program is stopped\n");
+	printf("\t--time-phases\tPrints the time and memory every compiler phase took\n");
+	printf("\t--profile\tSamples the program and prints the hottest functions and lines\n");
+	printf("\t--profile-out [file]\tAlso writes the sampled stacks there, folded for flamegraph.pl\n");
+	printf("\t--profile-interval [microseconds]\tCPU time between samples (1000 by default)\n");
+	printf("\t--opcode-stats [file]\tCounts the executed opcodes, opcode pairs and instructions per function into a JSON file\n");
+	printf("\t--parallel [runs]\tCompiles the file once and runs it that many times, in VMs on worker threads\n");
+	printf("\t--threads [count]\tWorker threads for --parallel (one per core by default)\n");
 	printf("\t-h --help\tShows this hint\n");
 }
 
@@ -68,7 +80,37 @@ static char* read_file(const char* path) {
 	return buffer;
 }
 
+/*
+ * Translates the file with lit_eval_to_c() or lit_eval_to_bytecode(),
+ * into the output file, or stdout, if it is NULL
+ */
+static int write_output(const char* path, const char* output, bool (*translate)(const char*, FILE*)) {
+	FILE* out = output == NULL ? stdout : fopen(output, "wb");
+
+	if (out == NULL) {
+		fprintf(stderr, "Could not open file \"%s\"\n", output);
+		exit(74);
+	}
+
+	const char* source_code = read_file(path);
+	bool had_error = !translate(source_code, out);
+	free((void*) source_code);
+
+	if (out != stdout) {
+		fclose(out);
+
+		if (had_error) {
+			remove(output);
+		}
+	}
+
+	return had_error ? 2 : 0;
+}
+
 int main(int argc, char** argv) {
+  uint64_t runs = 1;
+  int threads = 0;
+
   if (argc == 1) {
   	show_repl();
   } else {
@@ -82,15 +124,99 @@ int main(int argc, char** argv) {
 				  } else {
 					  return lit_eval(argv[i + 1]) ? 0 : 2;
 				  }
+			  } else if (strcmp(arg, "-c") == 0 || strcmp(arg, "--compile") == 0 || strcmp(arg, "--emit-c") == 0) {
+				  bool bytecode = strcmp(arg, "--emit-c") != 0;
+
+				  if (i == argc - 1 || (i + 2 < argc && (strcmp(argv[i + 2], "-o") != 0 || i + 3 == argc))) {
+					  printf(bytecode ? "Usage: lit -c [file] [-o out.litc]" : "Usage: lit --emit-c [file] [-o out.c]");
+					  return -1;
+				  }
+
+				  const char* path = argv[i + 1];
+				  const char* output = i + 3 < argc ? argv[i + 3] : NULL;
+
+				  if (!bytecode) {
+					  return write_output(path, output, lit_eval_to_c);
+				  }
+
+				  if (output != NULL) {
+					  return write_output(path, output, lit_eval_to_bytecode);
+				  }
+
+				  // file.lit -> file.litc
+				  char* default_output = (char*) malloc(strlen(path) + 2);
+				  sprintf(default_output, "%sc", path);
+
+				  int result = write_output(path, default_output, lit_eval_to_bytecode);
+				  free(default_output);
+
+				  return result;
+			  } else if (strcmp(arg, "--gc-pause") == 0) {
+				  if (i == argc - 1) {
+					  printf("Usage: lit --gc-pause [microseconds] [file]");
+					  return -1;
+				  }
+
+				  lit_vm_options.gc_pause = (uint32_t) strtoul(argv[++i], NULL, 10);
+			  } else if (strcmp(arg, "--gc-stats") == 0) {
+				  lit_vm_options.gc_stats = true;
+			  } else if (strcmp(arg, "--gc-mark-threads") == 0) {
+				  if (i == argc - 1) {
+					  printf("Usage: lit --gc-mark-threads [count] [file]");
+					  return -1;
+				  }
+
+				  lit_vm_options.gc_mark_threads = (uint32_t) strtoul(argv[++i], NULL, 10);
+			  } else if (strcmp(arg, "--time-phases") == 0) {
+				  lit_compiler_options.time_phases = true;
+			  } else if (strcmp(arg, "--opcode-stats") == 0) {
+				  if (i == argc - 1) {
+					  printf("Usage: lit --opcode-stats [out.json] [file]");
+					  return -1;
+				  }
+
+				  lit_vm_options.opcode_stats = argv[++i];
+			  } else if (strcmp(arg, "--profile") == 0) {
+				  lit_vm_options.profile = true;
+			  } else if (strcmp(arg, "--profile-out") == 0 || strcmp(arg, "--profile-interval") == 0) {
+				  bool output = strcmp(arg, "--profile-out") == 0;
+
+				  if (i == argc - 1) {
+					  printf(output ? "Usage: lit --profile-out [file] [file]" : "Usage: lit --profile-interval [microseconds] [file]");
+					  return -1;
+				  }
+
+				  if (output) {
+					  lit_vm_options.profile_output = argv[++i];
+				  } else {
+					  lit_vm_options.profile_interval = (uint32_t) strtoul(argv[++i], NULL, 10);
+				  }
+
+				  lit_vm_options.profile = true;
+			  } else if (strcmp(arg, "--parallel") == 0 || strcmp(arg, "--threads") == 0) {
+				  bool parallel = strcmp(arg, "--parallel") == 0;
+
+				  if (i == argc - 1) {
+					  printf(parallel ? "Usage: lit --parallel [runs] [file]" : "Usage: lit --threads [count] [file]");
+					  return -1;
+				  }
+
+				  if (parallel) {
+					  runs = strtoull(argv[++i], NULL, 10);
+				  } else {
+					  threads = (int) strtol(argv[++i], NULL, 10);
+				  }
 			  } else if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
 					show_help();
 			  } else {
 			  	printf("Unknown option %s! Run with -h for help.", arg);
 			  	return -1;
 			  }
+		  } else if (lit_is_bytecode_file(arg)) {
+			  return lit_eval_bytecode_parallel(arg, runs, threads) ? 0 : 2;
 		  } else {
 			  const char* source_code = read_file(arg);
-			  bool had_error = !lit_eval(source_code);
+			  bool had_error = !lit_eval_parallel(source_code, runs, threads);
 			  free((void*) source_code);
 
 			  return had_error ? 2 : 0;
@@ -7,21 +7,23 @@
 #include <vm/lit_object.h>
 #include <util/lit_array.h>
 
-DEFINE_ARRAY(LitParameters, LitParameter, parameters)
-DEFINE_ARRAY(LitExpressions, LitExpression*, expressions)
-DEFINE_ARRAY(LitStatements, LitStatement*, statements)
+DEFINE_ARENA_ARRAY(LitParameters, LitParameter, parameters)
+DEFINE_ARENA_ARRAY(LitExpressions, LitExpression*, expressions)
+DEFINE_ARENA_ARRAY(LitStatements, LitStatement*, statements)
 DEFINE_ARRAY(LitFunctions, LitFunctionStatement*, functions)
-DEFINE_ARRAY(LitMethods, LitMethodStatement*, methods)
+DEFINE_ARENA_ARRAY(LitMethods, LitMethodStatement*, methods)
 DEFINE_TABLE(LitFields, LitField, fields, LitField*, (LitField) {}, &entry->value);
 
 #define ALLOCATE_EXPRESSION(compiler, type, object_type) \
     (type*) allocate_expression(compiler, sizeof(type), object_type)
 
 static LitExpression* allocate_expression(LitCompiler* compiler, size_t size, LitExpresionType type) {
-	LitExpression* object = (LitExpression*) reallocate(compiler, NULL, 0, size);
+	LitExpression* object = (LitExpression*) lit_arena_allocate(&compiler->arena, size);
+	compiler->stats.phases[compiler->phase].nodes++;
 
 	object->type = type;
 	object->line = compiler->lexer.line;
+	object->resolved_type = NULL;
 
 	return object;
 }
@@ -30,7 +32,8 @@ static LitExpression* allocate_expression(LitCompiler* compiler, size_t size, Li
     (type*) allocate_statement(compiler, sizeof(type), object_type)
 
 static LitStatement* allocate_statement(LitCompiler* compiler, size_t size, LitStatementType type) {
-	LitStatement* object = (LitStatement*) reallocate(compiler, NULL, 0, size);
+	LitStatement* object = (LitStatement*) lit_arena_allocate(&compiler->arena, size);
+	compiler->stats.phases[compiler->phase].nodes++;
 
 	object->type = type;
 	object->line = compiler->lexer.line;
@@ -45,6 +48,7 @@ LitBinaryExpression* lit_make_binary_expression(LitCompiler* compiler, LitExpres
 	expression->right = right;
 	expression->ignore_left = false;
 	expression->operator = operator;
+	expression->operands = ANY_OPERANDS;
 
 	return expression;
 }
@@ -116,6 +120,7 @@ LitGetExpression* lit_make_get_expression(LitCompiler* compiler, LitExpression*
 	expression->object = object;
 	expression->property = property;
 	expression->emit_static_init = false;
+	expression->slot = -1;
 
 	return expression;
 }
@@ -127,6 +132,7 @@ LitSetExpression* lit_make_set_expression(LitCompiler* compiler, LitExpression*
 	expression->value = value;
 	expression->property = property;
 	expression->emit_static_init = false;
+	expression->slot = -1;
 
 	return expression;
 }
@@ -290,370 +296,20 @@ LitContinueStatement* lit_make_continue_statement(LitCompiler* compiler) {
 	return ALLOCATE_STATEMENT(compiler, LitContinueStatement, CONTINUE_STATEMENT);
 }
 
-void lit_free_statement(LitCompiler* compiler, LitStatement* statement) {
-	switch (statement->type) {
-		case VAR_STATEMENT: {
-			LitVarStatement* stmt = (LitVarStatement*) statement;
-			reallocate(compiler, (void*) stmt->name, strlen(stmt->name) + 1, 0);
-
-			if (stmt->type != NULL) {
-				reallocate(compiler, (void*) stmt->type, strlen(stmt->type) + 1, 0);
-			}
-
-			if (stmt->init != NULL) {
-				lit_free_expression(compiler, stmt->init);
-			}
-
-			reallocate(compiler, (void*) statement, sizeof(LitVarStatement), 0);
-			break;
-		}
-		case FIELD_STATEMENT: {
-			LitFieldStatement* stmt = (LitFieldStatement*) statement;
-			reallocate(compiler, (void*) stmt->name, strlen(stmt->name) + 1, 0);
-
-			/*if (stmt->type != NULL) {
-				reallocate(compiler, (void*) stmt->type, strlen(stmt->type) + 1, 0);
-			}*/ // Not sure if thats needed, crashes here, FIXME
-
-			if (stmt->init != NULL) {
-				lit_free_expression(compiler, stmt->init);
-			}
-
-			if (stmt->getter != NULL) {
-				lit_free_statement(compiler, stmt->getter);
-			}
-
-			if (stmt->setter != NULL) {
-				lit_free_statement(compiler, stmt->setter);
-			}
-
-			reallocate(compiler, (void*) statement, sizeof(LitFieldStatement), 0);
-			break;
-		}
-		case EXPRESSION_STATEMENT: {
-			lit_free_expression(compiler, ((LitExpressionStatement*) statement)->expr);
-			reallocate(compiler, (void*) statement, sizeof(LitExpressionStatement), 0);
-
-			break;
-		}
-		case IF_STATEMENT: {
-			LitIfStatement* stmt = (LitIfStatement*) statement;
-
-			lit_free_expression(compiler, stmt->condition);
-			lit_free_statement(compiler, stmt->if_branch);
-
-			if (stmt->else_if_branches != NULL) {
-				for (int i = 0; i < stmt->else_if_branches->count; i++) {
-					lit_free_expression(compiler, stmt->else_if_conditions->values[i]);
-					lit_free_statement(compiler, stmt->else_if_branches->values[i]);
-				}
-
-				lit_free_expressions(compiler, stmt->else_if_conditions);
-				lit_free_statements(compiler, stmt->else_if_branches);
-
-				reallocate(compiler, (void*) stmt->else_if_conditions, sizeof(LitExpressions), 0);
-				reallocate(compiler, (void*) stmt->else_if_branches, sizeof(LitStatements), 0);
-			}
-
-			if (stmt->else_branch != NULL) {
-				lit_free_statement(compiler, stmt->else_branch);
-			}
-
-			reallocate(compiler, (void*) statement, sizeof(LitIfStatement), 0);
-			break;
-		}
-		case BLOCK_STATEMENT: {
-			LitBlockStatement* stmt = (LitBlockStatement*) statement;
-
-			if (stmt->statements != NULL) {
-				for (int i = 0; i < stmt->statements->count; i++) {
-					lit_free_statement(compiler, stmt->statements->values[i]);
-				}
-
-				lit_free_statements(compiler, stmt->statements);
-				reallocate(compiler, (void*) stmt->statements, sizeof(LitStatements), 0);
-			}
-
-			reallocate(compiler, (void*) statement, sizeof(LitBlockStatement), 0);
-
-			break;
-		}
-		case WHILE_STATEMENT: {
-			LitWhileStatement* stmt = (LitWhileStatement*) statement;
-
-			lit_free_expression(compiler, stmt->condition);
-			lit_free_statement(compiler, stmt->body);
-			reallocate(compiler, (void*) statement, sizeof(LitWhileStatement), 0);
-
-			break;
-		}
-		case FUNCTION_STATEMENT: {
-			LitFunctionStatement* stmt = (LitFunctionStatement*) statement;
-			reallocate(compiler, (void*) stmt->name, strlen(stmt->name) + 1, 0);
-
-			if (strcmp(stmt->return_type.type, "void") != 0) {
-				reallocate(compiler, (void*) stmt->return_type.type, strlen(stmt->return_type.type) + 1, 0);
-			}
-
-			lit_free_statement(compiler, stmt->body);
-
-			if (stmt->parameters != NULL) {
-				for (int i = 0; i  < stmt->parameters->count; i++) {
-					LitParameter parameter = stmt->parameters->values[i];
-
-					reallocate(compiler, (void*) parameter.name, strlen(parameter.name) + 1, 0);
-					reallocate(compiler, (void*) parameter.type, strlen(parameter.type) + 1, 0);
-				}
-
-				lit_free_parameters(compiler, stmt->parameters);
-				reallocate(compiler, (void*) stmt->parameters, sizeof(LitParameters), 0);
-			}
-
-			reallocate(compiler, (void*) statement, sizeof(LitFunctionStatement), 0);
-			break;
-		}
-		case METHOD_STATEMENT: {
-			LitMethodStatement* stmt = (LitMethodStatement*) statement;
-			reallocate(compiler, (void*) stmt->name, strlen(stmt->name) + 1, 0);
-
-			if (strcmp(stmt->return_type.type, "void") != 0) {
-				reallocate(compiler, (void*) stmt->return_type.type, strlen(stmt->return_type.type) + 1, 0);
-			}
-
-			if (stmt->body != NULL) {
-				lit_free_statement(compiler, stmt->body);
-			}
-
-			if (stmt->parameters != NULL) {
-				for (int i = 0; i  < stmt->parameters->count; i++) {
-					LitParameter parameter = stmt->parameters->values[i];
-
-					reallocate(compiler, (void*) parameter.name, strlen(parameter.name) + 1, 0);
-					reallocate(compiler, (void*) parameter.type, strlen(parameter.type) + 1, 0);
-				}
-
-				lit_free_parameters(compiler, stmt->parameters);
-				reallocate(compiler, (void*) stmt->parameters, sizeof(LitParameters), 0);
-			}
-
-			reallocate(compiler, (void*) statement, sizeof(LitMethodStatement), 0);
-			break;
-		}
-		case RETURN_STATEMENT: {
-			LitReturnStatement* stmt = (LitReturnStatement*) statement;
-
-			if (stmt->value != NULL) {
-				lit_free_expression(compiler, stmt->value);
-			}
-
-			reallocate(compiler, (void*) statement, sizeof(LitReturnStatement), 0);
-			break;
-		}
-		case CLASS_STATEMENT: {
-			LitClassStatement* stmt = (LitClassStatement*) statement;
-			reallocate(compiler, (void*) stmt->name, strlen(stmt->name) + 1, 0);
-
-			if (stmt->fields != NULL) {
-				for (int i = 0; i < stmt->fields->count; i++) {
-					lit_free_statement(compiler, stmt->fields->values[i]);
-				}
-
-				lit_free_statements(compiler, stmt->fields);
-				reallocate(compiler, (void*) stmt->fields, sizeof(LitStatements), 0);
-			}
-
-			if (stmt->methods != NULL) {
-				for (int i = 0; i < stmt->methods->count; i++) {
-					lit_free_statement(compiler, (LitStatement*) stmt->methods->values[i]);
-				}
-
-				lit_free_methods(compiler, stmt->methods);
-				reallocate(compiler, (void*) stmt->methods, sizeof(LitFunctions), 0);
-			}
-
-			if (stmt->super != NULL) {
-				lit_free_expression(compiler, (LitExpression*) stmt->super);
-			}
-
-			reallocate(compiler, (void*) statement, sizeof(LitClassStatement), 0);
-			break;
-		}
-		case BREAK_STATEMENT:
-		case CONTINUE_STATEMENT: {
-			break;
-		}
-		default: {
-			fflush(stdin);
-			fprintf(stderr, "Statement with id %i has no freeing case!\n", statement->type);
-			fflush(stdout);
-
-			break;
-		}
-	}
+LitTryStatement* lit_make_try_statement(LitCompiler* compiler, LitStatement* body, const char* name, LitStatement* catch_body) {
+	LitTryStatement* statement = ALLOCATE_STATEMENT(compiler, LitTryStatement, TRY_STATEMENT);
+
+	statement->body = body;
+	statement->name = name;
+	statement->catch_body = catch_body;
+
+	return statement;
 }
 
-void lit_free_expression(LitCompiler* compiler, LitExpression* expression) {
-	switch (expression->type) {
-		case BINARY_EXPRESSION: {
-			LitBinaryExpression* expr = (LitBinaryExpression*) expression;
-
-			if (!expr->ignore_left) {
-				lit_free_expression(compiler, expr->left);
-			}
-
-			lit_free_expression(compiler, expr->right);
-			reallocate(compiler, (void*) expression, sizeof(LitBinaryExpression), 0);
-
-			break;
-		}
-		case LITERAL_EXPRESSION: {
-			reallocate(compiler, (void*) expression, sizeof(LitLiteralExpression), 0);
-			break;
-		}
-		case UNARY_EXPRESSION: {
-			LitUnaryExpression* expr = (LitUnaryExpression*) expression;
-
-			lit_free_expression(compiler, expr->right);
-			reallocate(compiler, (void*) expression, sizeof(LitUnaryExpression), 0);
-
-			break;
-		}
-		case GROUPING_EXPRESSION: {
-			LitGroupingExpression* expr = (LitGroupingExpression*) expression;
-
-			lit_free_expression(compiler, expr->expr);
-			reallocate(compiler, (void*) expression, sizeof(LitGroupingExpression), 0);
-
-			break;
-		}
-		case VAR_EXPRESSION: {
-			LitVarExpression* expr = (LitVarExpression*) expression;
-
-			reallocate(compiler, (void*) expr->name, strlen(expr->name) + 1, 0);
-			reallocate(compiler, (void*) expression, sizeof(LitVarExpression), 0);
-
-			break;
-		}
-		case ASSIGN_EXPRESSION: {
-			LitAssignExpression* expr = (LitAssignExpression*) expression;
-
-			lit_free_expression(compiler, expr->value);
-			lit_free_expression(compiler, expr->to);
-			reallocate(compiler, (void*) expression, sizeof(LitAssignExpression), 0);
-
-			break;
-		}
-		case LOGICAL_EXPRESSION: {
-			LitLogicalExpression* expr = (LitLogicalExpression*) expression;
-
-			lit_free_expression(compiler, expr->left);
-			lit_free_expression(compiler, expr->right);
-			reallocate(compiler, (void*) expression, sizeof(LitLogicalExpression), 0);
-
-			break;
-		}
-		case CALL_EXPRESSION: {
-			LitCallExpression* expr = (LitCallExpression*) expression;
-			lit_free_expression(compiler, expr->callee);
-
-			for (int i = 0; i < expr->args->count; i++) {
-				lit_free_expression(compiler, expr->args->values[i]);
-			}
-
-			lit_free_expressions(compiler, expr->args);
-			reallocate(compiler, (void*) expr->args, sizeof(LitExpressions), 0);
-			reallocate(compiler, (void*) expression, sizeof(LitCallExpression), 0);
-
-			break;
-		}
-		case LAMBDA_EXPRESSION: {
-			LitLambdaExpression* expr = (LitLambdaExpression*) expression;
-
-			if (strcmp(expr->return_type.type, "void") != 0) {
-				reallocate(compiler, (void*) expr->return_type.type, strlen(expr->return_type.type) + 1, 0);
-			}
-
-			lit_free_statement(compiler, expr->body);
-
-			if (expr->parameters != NULL) {
-				for (int i = 0; i  < expr->parameters->count; i++) {
-					LitParameter parameter = expr->parameters->values[i];
-
-					reallocate(compiler, (void*) parameter.name, strlen(parameter.name) + 1, 0);
-					reallocate(compiler, (void*) parameter.type, strlen(parameter.type) + 1, 0);
-				}
-
-				lit_free_parameters(compiler, expr->parameters);
-				reallocate(compiler, (void*) expr->parameters, sizeof(LitParameters), 0);
-			}
-
-			reallocate(compiler, (void*) expression, sizeof(LitLambdaExpression), 0);
-			break;
-		}
-		case GET_EXPRESSION: {
-			LitGetExpression* expr = (LitGetExpression*) expression;
-
-			lit_free_expression(compiler, expr->object);
-			reallocate(compiler, (void*) expr->property, strlen(expr->property) + 1, 0);
-			reallocate(compiler, (void*) expression, sizeof(LitGetExpression), 0);
-
-			break;
-		}
-		case SET_EXPRESSION: {
-			LitSetExpression* expr = (LitSetExpression*) expression;
-
-			lit_free_expression(compiler, expr->object);
-			lit_free_expression(compiler, expr->value);
-			reallocate(compiler, (void*) expr->property, strlen(expr->property) + 1, 0);
-			reallocate(compiler, (void*) expression, sizeof(LitSetExpression), 0);
-
-			break;
-		}
-		case THIS_EXPRESSION: {
-			reallocate(compiler, (void*) expression, sizeof(LitThisExpression), 0);
-
-			break;
-		}
-		case SUPER_EXPRESSION: {
-			LitSuperExpression* expr = (LitSuperExpression*) expression;
-
-			reallocate(compiler, (void*) expr->method, strlen(expr->method) + 1, 0);
-			reallocate(compiler, (void*) expression, sizeof(LitSuperExpression), 0);
-
-			break;
-		}
-		case IF_EXPRESSION: {
-			LitIfExpression* expr = (LitIfExpression*) expression;
-
-			lit_free_expression(compiler, expr->condition);
-			lit_free_expression(compiler, expr->if_branch);
-
-			if (expr->else_if_branches != NULL) {
-				for (int i = 0; i < expr->else_if_branches->count; i++) {
-					lit_free_expression(compiler, expr->else_if_conditions->values[i]);
-					lit_free_expression(compiler, expr->else_if_branches->values[i]);
-				}
-
-				lit_free_expressions(compiler, expr->else_if_conditions);
-				lit_free_expressions(compiler, expr->else_if_branches);
-
-				reallocate(compiler, (void*) expr->else_if_conditions, sizeof(LitExpressions), 0);
-				reallocate(compiler, (void*) expr->else_if_branches, sizeof(LitExpressions), 0);
-			}
-
-			if (expr->else_branch != NULL) {
-				lit_free_expression(compiler, expr->else_branch);
-			}
-
-			reallocate(compiler, (void*) expr, sizeof(LitIfExpression), 0);
-			break;
-		}
-		default: {
-			fflush(stdin);
-			fprintf(stderr, "Expression with id %i has no freeing case!\n", expression->type);
-			fflush(stdout);
-
-			break;
-		}
-	}
+LitThrowStatement* lit_make_throw_statement(LitCompiler* compiler, LitExpression* value) {
+	LitThrowStatement* statement = ALLOCATE_STATEMENT(compiler, LitThrowStatement, THROW_STATEMENT);
+
+	statement->value = value;
+
+	return statement;
 }
\ No newline at end of file
@@ -0,0 +1,2381 @@
+#include <stdarg.h>
+#include <string.h>
+
+#include <compiler/lit_c_emitter.h>
+#include <compiler/lit_compiler.h>
+#include <vm/lit_memory.h>
+#include <vm/lit_object.h>
+
+/*
+ * Locals keep their lit names with a v_ prefix, so C block scoping shadows
+ * them the same way, as the resolver does. Top level functions become f_
+ * prefixed static functions, lambdas l_ ones, classes c_ statics with
+ * m_Class_method methods and n_Class constructors, and string literals k_
+ * constants, that are created before the top level code runs.
+ *
+ * Objects move, when the collector runs, so every function keeps its values
+ * in a frame of slots s[] on vm.stack, that the collector updates, and it only
+ * runs at the safe points on function entries and loop back edges, like in the
+ * interpreter. Values of top level vars live in vm.global_values. Operands,
+ * that are still needed after a later operand of the same call or operator
+ * calls something, go to a slot (unboxed ones to a C temporary) first, that
+ * also keeps the lit evaluation order. Vars, that lambdas capture, live in
+ * upvalue cells, that their closures point to.
+ */
+
+#define MAX_UPVALUES 256
+#define MAX_FIELDS 256
+
+typedef enum {
+	C_VOID,
+	C_INT,
+	C_NUMBER,
+	C_BOOL,
+	C_VALUE,
+	C_UNSUPPORTED
+} LitCType;
+
+typedef struct {
+	char* chars;
+	int count;
+	int capacity;
+} LitCBuffer;
+
+typedef struct {
+	const char* name;
+	const void* declaration; // Var statement or parameter, NULL for this
+	LitCType type;
+	int function; // Depth of the function, that declared it, 0 for the top level code
+	int slot; // Frame slot of values and captured vars, -1 for C locals
+	int global; // vm.global_values index of top level values, -1 otherwise
+	bool top_level;
+	bool captured; // The slot holds the upvalue cell, that closures share
+} LitCVariable;
+
+DECLARE_ARRAY(LitCVariables, LitCVariable, c_variables)
+DEFINE_ARRAY(LitCVariables, LitCVariable, c_variables)
+
+typedef struct {
+	const void* key;
+	const char* name;
+	int global;
+} LitCSymbol;
+
+DECLARE_ARRAY(LitCSymbols, LitCSymbol, c_symbols)
+DEFINE_ARRAY(LitCSymbols, LitCSymbol, c_symbols)
+
+typedef struct LitCFunction {
+	struct LitCFunction* enclosing;
+	LitClassStatement* class; // Methods have this in slot 0
+	LitCType return_type;
+	bool lambda; // Lambdas have their closure in slot 0
+	int depth; // 0 for the top level code
+
+	int slots; // In use, the frame has max_slots of them
+	int max_slots;
+	int temps[3]; // Spilled int, double and bool operands
+	int max_temps[3];
+
+	const void* upvalues[MAX_UPVALUES]; // Declarations of the vars, that a lambda captures
+	int upvalue_count;
+} LitCFunction;
+
+typedef struct {
+	LitExpression* expression; // NULL, if it is already in the slot
+	LitCType type;
+	bool reused; // Read twice, so it has to be in a slot
+	int slot;
+	int temp;
+} LitCOperand;
+
+typedef struct {
+	LitCompiler* compiler;
+
+	LitCBuffer declarations; // Globals, constants and prototypes
+	LitCBuffer setup; // Functions and closures, that are created before the top level code runs
+	LitCBuffer functions;
+	LitCBuffer* out;
+
+	LitFunctions declared; // Top level functions
+	LitCSymbols classes; // Top level classes and their vm.global_values index
+	LitCSymbols captured; // Declarations of vars, that lambdas capture
+	LitCSymbols wrapped; // Top level functions, that are used as values
+	LitCSymbols dispatchers; // Classes and methods, that subclasses override
+	LitCVariables variables;
+	LitArray strings; // String constants, k_ + index
+	LitCFunction* function;
+
+	int globals;
+	int lambdas;
+	int scan_function; // Function depth, while looking for captured vars
+	int depth;
+	int indent;
+	bool had_error;
+} LitCEmitter;
+
+static const char* preamble =
+	"// Generated by lit --emit-c\n\n"
+	"#include <math.h>\n"
+	"#include <setjmp.h>\n"
+	"#include <stdio.h>\n"
+	"#include <string.h>\n"
+	"#include <time.h>\n\n"
+	"#include <lit.h>\n"
+	"#include <vm/lit_memory.h>\n"
+	"#include <vm/lit_object.h>\n\n"
+	"#define GLOBAL(index) (vm.global_values.values[index])\n\n"
+	"static LitVm vm;\n"
+	"static jmp_buf error_jump;\n\n"
+	"static void print_number(double value) {\n"
+	"\tprintf(\"%g\\n\", value);\n"
+	"}\n\n"
+	"static void print_bool(bool value) {\n"
+	"\tprintf(\"%s\\n\", value ? \"true\" : \"false\");\n"
+	"}\n\n"
+	"static void print_value(LitValue value) {\n"
+	"\tprintf(\"%s\\n\", lit_to_string(&vm, value));\n"
+	"}\n\n"
+	"static void runtime_error(const char* message) {\n"
+	"\tfflush(stdout);\n"
+	"\tfprintf(stderr, \"Runtime error: %s\\n\", message);\n"
+	"\tlongjmp(error_jump, 1);\n"
+	"}\n\n"
+	"static void error(LitValue message) {\n"
+	"\truntime_error(lit_to_string(&vm, message));\n"
+	"}\n\n"
+	"static inline void safepoint(void) {\n"
+	"\tif (vm.gc_requested) {\n"
+	"\t\tlit_gc_safepoint(&vm);\n"
+	"\t}\n"
+	"}\n\n"
+	"// Frame slots on vm.stack, that the collector updates, when it moves objects\n"
+	"static inline LitValue* enter(int count) {\n"
+	"\tLitValue* frame = vm.stack_top;\n\n"
+	"\tif (frame + count > vm.stack + VM_STACK_MAX) {\n"
+	"\t\truntime_error(\"Stack overflow\");\n"
+	"\t}\n\n"
+	"\tfor (int i = 0; i < count; i++) {\n"
+	"\t\tframe[i] = NIL_VALUE;\n"
+	"\t}\n\n"
+	"\tvm.stack_top = frame + count;\n"
+	"\treturn frame;\n"
+	"}\n\n"
+	"static inline LitValue set_global(int index, LitValue value) {\n"
+	"\tGLOBAL(index) = value;\n"
+	"\tlit_global_barrier(&vm, value);\n\n"
+	"\treturn value;\n"
+	"}\n\n"
+	"static inline LitValue new_cell(LitValue value) {\n"
+	"\tLitUpvalue* cell = lit_new_upvalue(&vm.mem_manager, NULL);\n\n"
+	"\tcell->closed = value;\n"
+	"\tcell->value = &cell->closed;\n\n"
+	"\treturn MAKE_OBJECT_VALUE(cell);\n"
+	"}\n\n"
+	"static inline LitValue set_cell(LitValue* cell, LitValue value) {\n"
+	"\tAS_UPVALUE(*cell)->closed = value;\n"
+	"\tlit_write_barrier(&vm, AS_OBJECT(*cell), value);\n\n"
+	"\treturn value;\n"
+	"}\n\n"
+	"static inline LitValue set_upvalue(LitValue* closure, int index, LitValue value) {\n"
+	"\tLitUpvalue* upvalue = AS_CLOSURE(*closure)->upvalues[index];\n\n"
+	"\tupvalue->closed = value;\n"
+	"\tlit_write_barrier(&vm, (LitObject*) upvalue, value);\n\n"
+	"\treturn value;\n"
+	"}\n\n"
+	"static inline LitFunction* new_function(const char* name, void* entry, int upvalue_count) {\n"
+	"\tLitFunction* function = lit_new_function(&vm.mem_manager);\n\n"
+	"\tfunction->name = lit_copy_string(&vm.mem_manager, name, strlen(name));\n"
+	"\tfunction->aot = entry;\n"
+	"\tfunction->upvalue_count = upvalue_count;\n\n"
+	"\treturn function;\n"
+	"}\n\n"
+	"static inline LitValue capture(LitValue closure, int index, LitValue cell) {\n"
+	"\tAS_CLOSURE(closure)->upvalues[index] = AS_UPVALUE(cell);\n"
+	"\tlit_write_barrier(&vm, AS_OBJECT(closure), cell);\n\n"
+	"\treturn closure;\n"
+	"}\n\n"
+	"// The C code of closures takes them as the first argument, methods have none, since they need this\n"
+	"static inline void* entry_of(LitValue callee) {\n"
+	"\tif (IS_CLOSURE(callee) && AS_CLOSURE(callee)->function->aot != NULL) {\n"
+	"\t\treturn AS_CLOSURE(callee)->function->aot;\n"
+	"\t}\n\n"
+	"\truntime_error(\"Can only call functions and classes\");\n"
+	"\treturn NULL;\n"
+	"}\n\n"
+	"static inline LitClass* new_class(const char* name, LitClass* super, int global) {\n"
+	"\tLitClass* class = lit_new_class(&vm.mem_manager, lit_copy_string(&vm.mem_manager, name, strlen(name)), super);\n"
+	"\tset_global(global, MAKE_OBJECT_VALUE(class));\n\n"
+	"\tif (super != NULL) {\n"
+	"\t\tlit_table_add_all(&vm.mem_manager, &class->methods, &super->methods);\n\n"
+	"\t\t// Sub class instances start with the super class layout\n"
+	"\t\tfor (int i = 0; i < super->field_defaults.count; i++) {\n"
+	"\t\t\tlit_array_write(&vm.mem_manager, &class->field_defaults, super->field_defaults.values[i]);\n"
+	"\t\t}\n\n"
+	"\t\tif (super->object.remembered) {\n"
+	"\t\t\tlit_remember(&vm, (LitObject*) class);\n"
+	"\t\t}\n"
+	"\t}\n\n"
+	"\treturn class;\n"
+	"}\n\n"
+	"static inline void define_field(LitClass* class, int slot, LitValue value) {\n"
+	"\tif (slot == class->field_defaults.count) {\n"
+	"\t\tlit_array_write(&vm.mem_manager, &class->field_defaults, value);\n"
+	"\t} else {\n"
+	"\t\tclass->field_defaults.values[slot] = value;\n"
+	"\t}\n\n"
+	"\tlit_write_barrier(&vm, (LitObject*) class, value);\n"
+	"}\n\n"
+	"static inline void define_method(LitClass* class, const char* name) {\n"
+	"\tLitFunction* function = lit_new_function(&vm.mem_manager);\n"
+	"\tfunction->name = lit_format_string(&vm.mem_manager, \"%.$\", class->name, name);\n\n"
+	"\tLitValue method = MAKE_OBJECT_VALUE(lit_new_closure(&vm.mem_manager, function));\n\n"
+	"\tlit_table_set(&vm.mem_manager, &class->methods, lit_copy_string(&vm.mem_manager, name, strlen(name)), method);\n"
+	"\tlit_write_barrier(&vm, (LitObject*) class, method);\n"
+	"}\n\n"
+	"static inline LitValue new_instance(LitClass* class) {\n"
+	"\treturn MAKE_OBJECT_VALUE(lit_new_instance(&vm.mem_manager, class));\n"
+	"}\n\n"
+	"static inline LitInstance* instance(LitValue value) {\n"
+	"\tif (!IS_INSTANCE(value)) {\n"
+	"\t\truntime_error(\"Only instances have fields\");\n"
+	"\t}\n\n"
+	"\treturn AS_INSTANCE(value);\n"
+	"}\n\n"
+	"static inline LitValue receiver(LitValue value) {\n"
+	"\tif (!IS_INSTANCE(value)) {\n"
+	"\t\truntime_error(\"Only instances and classes have methods\");\n"
+	"\t}\n\n"
+	"\treturn value;\n"
+	"}\n\n"
+	"static inline LitValue set_field(LitInstance* instance, int slot, LitValue value) {\n"
+	"\tinstance->fields[slot] = value;\n"
+	"\tlit_write_barrier(&vm, (LitObject*) instance, value);\n\n"
+	"\treturn value;\n"
+	"}\n\n"
+	"// Like on the VM, getting a method gives the method itself, not bound to the instance\n"
+	"static inline LitValue method_of(LitValue object, LitValue name) {\n"
+	"\treturn *lit_table_get(&instance(object)->type->methods, AS_STRING(name));\n"
+	"}\n\n"
+	"static inline bool instance_of(LitValue value, LitClass* class) {\n"
+	"\tif (IS_INSTANCE(value)) {\n"
+	"\t\tfor (LitClass* type = AS_INSTANCE(value)->type; type != NULL; type = type->super) {\n"
+	"\t\t\tif (type == class) {\n"
+	"\t\t\t\treturn true;\n"
+	"\t\t\t}\n"
+	"\t\t}\n"
+	"\t}\n\n"
+	"\treturn false;\n"
+	"}\n\n";
+
+static void emit_statement(LitCEmitter* emitter, LitStatement* statement);
+static void emit_expression(LitCEmitter* emitter, LitExpression* expression);
+static void scan_statement(LitCEmitter* emitter, LitStatement* statement);
+static void scan_expression(LitCEmitter* emitter, LitExpression* expression);
+
+static void error(LitCEmitter* emitter, LitStatement* statement, LitExpression* expression, const char* format, ...) {
+	fflush(stdout);
+
+	va_list vargs;
+	va_start(vargs, format);
+	fprintf(stderr, "Error on line %ld: ", (long) (statement != NULL ? statement->line : expression->line));
+	vfprintf(stderr, format, vargs);
+	fprintf(stderr, " not supported by the C backend\n");
+	va_end(vargs);
+
+	fflush(stderr);
+	emitter->had_error = true;
+}
+
+static void write_format(LitCEmitter* emitter, LitCBuffer* buffer, const char* format, va_list args) {
+	va_list copy;
+	va_copy(copy, args);
+	int length = vsnprintf(NULL, 0, format, copy);
+	va_end(copy);
+
+	if (buffer->capacity < buffer->count + length + 1) {
+		int old_capacity = buffer->capacity;
+
+		while (buffer->capacity < buffer->count + length + 1) {
+			buffer->capacity = GROW_CAPACITY(buffer->capacity);
+		}
+
+		buffer->chars = GROW_ARRAY((LitMemManager*) emitter->compiler, buffer->chars, char, old_capacity, buffer->capacity);
+	}
+
+	vsnprintf(&buffer->chars[buffer->count], (size_t) length + 1, format, args);
+	buffer->count += length;
+}
+
+static void emit(LitCEmitter* emitter, const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	write_format(emitter, emitter->out, format, args);
+	va_end(args);
+}
+
+static void declare(LitCEmitter* emitter, const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	write_format(emitter, &emitter->declarations, format, args);
+	va_end(args);
+}
+
+static void emit_indent(LitCEmitter* emitter) {
+	for (int i = 0; i < emitter->indent; i++) {
+		emit(emitter, "\t");
+	}
+}
+
+static void append_buffer(LitCEmitter* emitter, LitCBuffer* to, LitCBuffer* from) {
+	if (from->count > 0) {
+		LitCBuffer* out = emitter->out;
+		emitter->out = to;
+		emit(emitter, "%.*s", from->count, from->chars);
+		emitter->out = out;
+	}
+}
+
+static void free_buffer(LitCEmitter* emitter, LitCBuffer* buffer) {
+	FREE_ARRAY((LitMemManager*) emitter->compiler, char, buffer->chars, buffer->capacity);
+}
+
+static LitCType c_type(const char* type) {
+	if (type == NULL || strncmp(type, "Class<", 6) == 0) {
+		return C_UNSUPPORTED;
+	} else if (strcmp(type, "void") == 0) {
+		return C_VOID;
+	} else if (strcmp(type, "int") == 0) {
+		return C_INT;
+	} else if (strcmp(type, "double") == 0) {
+		return C_NUMBER;
+	} else if (strcmp(type, "bool") == 0) {
+		return C_BOOL;
+	}
+
+	// Objects, functions included, and untyped values
+	return C_VALUE;
+}
+
+static const char* c_type_name(LitCType type) {
+	switch (type) {
+		case C_INT: return "int32_t";
+		case C_NUMBER: return "double";
+		case C_BOOL: return "bool";
+		case C_VALUE: return "LitValue";
+		default: return "void";
+	}
+}
+
+static const char* c_default_value(LitCType type) {
+	switch (type) {
+		case C_INT: case C_NUMBER: return "0";
+		case C_BOOL: return "false";
+		default: return "NIL_VALUE";
+	}
+}
+
+static const char* box(LitCType type) {
+	switch (type) {
+		case C_INT: return "MAKE_INT_VALUE(";
+		case C_NUMBER: return "MAKE_NUMBER_VALUE(";
+		case C_BOOL: return "MAKE_BOOL_VALUE(";
+		default: return "(";
+	}
+}
+
+static const char* unbox(LitCType type) {
+	switch (type) {
+		case C_INT: return "AS_INT(";
+		case C_NUMBER: return "AS_NUMBER(";
+		case C_BOOL: return "AS_BOOL(";
+		default: return "(";
+	}
+}
+
+static LitCType expression_type(LitExpression* expression) {
+	switch (expression->type) {
+		case GROUPING_EXPRESSION: return expression_type(((LitGroupingExpression*) expression)->expr);
+		case LOGICAL_EXPRESSION: {
+			LitLogicalExpression* expr = (LitLogicalExpression*) expression;
+
+			// && and || give back one of the operands, that only maps onto C for bools
+			if (expression_type(expr->left) == C_BOOL && expression_type(expr->right) == C_BOOL) {
+				return C_BOOL;
+			}
+
+			return C_VALUE;
+		}
+		default: return c_type(expression->resolved_type);
+	}
+}
+
+static bool is_this(LitExpression* expression) {
+	while (expression->type == GROUPING_EXPRESSION) {
+		expression = ((LitGroupingExpression*) expression)->expr;
+	}
+
+	return expression->type == THIS_EXPRESSION;
+}
+
+static int make_constant(LitCEmitter* emitter, LitValue value) {
+	// Strings are interned, so equal literals share a constant
+	for (int i = 0; i < emitter->strings.count; i++) {
+		if (emitter->strings.values[i] == value) {
+			return i;
+		}
+	}
+
+	lit_array_write((LitMemManager*) emitter->compiler, &emitter->strings, value);
+	declare(emitter, "static LitValue k_%i;\n", emitter->strings.count - 1);
+
+	return emitter->strings.count - 1;
+}
+
+static int make_name_constant(LitCEmitter* emitter, const char* name) {
+	return make_constant(emitter, MAKE_OBJECT_VALUE(lit_copy_string((LitMemManager*) emitter->compiler, name, strlen(name))));
+}
+
+static LitFunctionStatement* find_function(LitCEmitter* emitter, const char* name) {
+	for (int i = emitter->declared.count - 1; i >= 0; i--) {
+		if (strcmp(emitter->declared.values[i]->name, name) == 0) {
+			return emitter->declared.values[i];
+		}
+	}
+
+	return NULL;
+}
+
+static LitCSymbol* find_symbol(LitCSymbols* symbols, const void* key, const char* name) {
+	for (int i = 0; i < symbols->count; i++) {
+		LitCSymbol* symbol = &symbols->values[i];
+
+		if ((key == NULL || symbol->key == key) && (name == NULL || strcmp(symbol->name, name) == 0)) {
+			return symbol;
+		}
+	}
+
+	return NULL;
+}
+
+static LitClassStatement* find_class(LitCEmitter* emitter, const char* name) {
+	LitCSymbol* symbol = name == NULL ? NULL : find_symbol(&emitter->classes, NULL, name);
+	return symbol == NULL ? NULL : (LitClassStatement*) symbol->key;
+}
+
+static LitClassStatement* find_super(LitCEmitter* emitter, LitClassStatement* class) {
+	return class->super == NULL ? NULL : find_class(emitter, class->super->name);
+}
+
+// Looks for the method in the class and then in its super classes, owner is set to the class, that defines it
+static LitMethodStatement* find_method(LitCEmitter* emitter, LitClassStatement* class, const char* name, LitClassStatement** owner) {
+	for (; class != NULL; class = find_super(emitter, class)) {
+		if (class->methods != NULL) {
+			for (int i = 0; i < class->methods->count; i++) {
+				LitMethodStatement* method = class->methods->values[i];
+
+				if (!method->is_static && strcmp(method->name, name) == 0) {
+					*owner = class;
+					return method;
+				}
+			}
+		}
+	}
+
+	return NULL;
+}
+
+static bool is_subclass(LitCEmitter* emitter, LitClassStatement* class, LitClassStatement* super) {
+	for (; class != NULL; class = find_super(emitter, class)) {
+		if (class == super) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static LitCVariable* find_variable(LitCEmitter* emitter, const char* name) {
+	for (int i = emitter->variables.count - 1; i >= 0; i--) {
+		if (strcmp(emitter->variables.values[i].name, name) == 0) {
+			return &emitter->variables.values[i];
+		}
+	}
+
+	return NULL;
+}
+
+static bool is_captured(LitCEmitter* emitter, const void* declaration) {
+	return declaration != NULL && find_symbol(&emitter->captured, declaration, NULL) != NULL;
+}
+
+static int allocate_slot(LitCFunction* function) {
+	if (++function->slots > function->max_slots) {
+		function->max_slots = function->slots;
+	}
+
+	return function->slots - 1;
+}
+
+static int allocate_temp(LitCFunction* function, LitCType type) {
+	int kind = type - C_INT;
+
+	if (++function->temps[kind] > function->max_temps[kind]) {
+		function->max_temps[kind] = function->temps[kind];
+	}
+
+	return function->temps[kind] - 1;
+}
+
+static char temp_prefix(LitCType type) {
+	return type == C_INT ? 'i' : (type == C_NUMBER ? 'd' : 'b');
+}
+
+// Picks the place of a new var, it becomes visible, once it is written to the variables
+static LitCVariable make_variable(LitCEmitter* emitter, const char* name, const void* declaration, LitCType type) {
+	LitCFunction* function = emitter->function;
+	LitCVariable variable = { name, declaration, type, function->depth, -1, -1, function->depth == 0 && emitter->depth == 0, false };
+
+	if (variable.top_level) {
+		if (type == C_VALUE) {
+			variable.global = emitter->globals++;
+		}
+	} else if (is_captured(emitter, declaration)) {
+		variable.captured = true;
+		variable.slot = allocate_slot(function);
+	} else if (type == C_VALUE) {
+		variable.slot = allocate_slot(function);
+	}
+
+	return variable;
+}
+
+static void add_variable(LitCEmitter* emitter, LitCVariable variable) {
+	lit_c_variables_write((LitMemManager*) emitter->compiler, &emitter->variables, variable);
+}
+
+// Lambdas get the vars of the functions around them through their closure, the ones in between pass them on
+static int resolve_upvalue(LitCEmitter* emitter, LitCFunction* function, LitCVariable* variable, LitExpression* expression) {
+	if (!function->lambda || !variable->captured) {
+		error(emitter, NULL, expression, "Capturing %s", variable->name);
+		return -1;
+	}
+
+	for (int i = 0; i < function->upvalue_count; i++) {
+		if (function->upvalues[i] == variable->declaration) {
+			return i;
+		}
+	}
+
+	if (variable->function < function->enclosing->depth && resolve_upvalue(emitter, function->enclosing, variable, expression) == -1) {
+		return -1;
+	}
+
+	if (function->upvalue_count == MAX_UPVALUES) {
+		error(emitter, NULL, expression, "Capturing more than %i vars", MAX_UPVALUES);
+		return -1;
+	}
+
+	function->upvalues[function->upvalue_count] = variable->declaration;
+	return function->upvalue_count++;
+}
+
+// Emits the var in its own type
+static void emit_variable(LitCEmitter* emitter, LitCVariable* variable, LitExpression* expression) {
+	LitCFunction* function = emitter->function;
+
+	if (variable->global != -1) {
+		emit(emitter, "GLOBAL(%i)", variable->global);
+	} else if (variable->top_level || (variable->function == function->depth && !variable->captured)) {
+		if (variable->slot == -1) {
+			emit(emitter, "v_%s", variable->name);
+		} else {
+			emit(emitter, "s[%i]", variable->slot);
+		}
+	} else if (variable->function == function->depth) {
+		emit(emitter, "%sAS_UPVALUE(s[%i])->closed)", unbox(variable->type), variable->slot);
+	} else {
+		int upvalue = resolve_upvalue(emitter, function, variable, expression);
+		emit(emitter, "%sAS_CLOSURE(s[0])->upvalues[%i]->closed)", unbox(variable->type), upvalue);
+	}
+}
+
+// Emits the expression, boxing or unboxing it to the given type
+static void emit_as(LitCEmitter* emitter, LitExpression* expression, LitCType type) {
+	LitCType from = expression_type(expression);
+
+	if (from == type) {
+		emit_expression(emitter, expression);
+		return;
+	}
+
+	const char* conversion = NULL;
+
+	if (type == C_VALUE && from != C_VOID && from != C_UNSUPPORTED) {
+		conversion = box(from);
+	} else if (from == C_VALUE && type != C_VOID && type != C_UNSUPPORTED) {
+		conversion = unbox(type);
+	} else if (from == C_INT && type == C_NUMBER) {
+		// Not the other way round, the resolver doesn't let doubles into ints
+		conversion = "(double) (";
+	}
+
+	if (conversion == NULL) {
+		error(emitter, NULL, expression, "Converting %s to %s", expression->resolved_type, c_type_name(type));
+		return;
+	}
+
+	emit(emitter, conversion);
+	emit_expression(emitter, expression);
+	emit(emitter, ")");
+}
+
+static void emit_condition(LitCEmitter* emitter, LitExpression* expression) {
+	switch (expression_type(expression)) {
+		case C_BOOL: emit_expression(emitter, expression); break;
+		case C_INT:
+		case C_NUMBER: {
+			emit(emitter, "(");
+			emit_expression(emitter, expression);
+			emit(emitter, " != 0)");
+
+			break;
+		}
+		case C_VALUE: {
+			emit(emitter, "!lit_is_false(");
+			emit_expression(emitter, expression);
+			emit(emitter, ")");
+
+			break;
+		}
+		default: error(emitter, NULL, expression, "Using %s as a condition", expression->resolved_type); break;
+	}
+}
+
+// Calls might collect garbage and move objects
+static bool may_collect(LitExpression* expression) {
+	if (expression == NULL) {
+		return false;
+	}
+
+	switch (expression->type) {
+		case CALL_EXPRESSION: return true;
+		case BINARY_EXPRESSION: return may_collect(((LitBinaryExpression*) expression)->left) || may_collect(((LitBinaryExpression*) expression)->right);
+		case UNARY_EXPRESSION: return may_collect(((LitUnaryExpression*) expression)->right);
+		case GROUPING_EXPRESSION: return may_collect(((LitGroupingExpression*) expression)->expr);
+		case ASSIGN_EXPRESSION: return may_collect(((LitAssignExpression*) expression)->value);
+		case LOGICAL_EXPRESSION: return may_collect(((LitLogicalExpression*) expression)->left) || may_collect(((LitLogicalExpression*) expression)->right);
+		case GET_EXPRESSION: return may_collect(((LitGetExpression*) expression)->object);
+		case SET_EXPRESSION: return may_collect(((LitSetExpression*) expression)->object) || may_collect(((LitSetExpression*) expression)->value);
+		case IF_EXPRESSION: {
+			LitIfExpression* expr = (LitIfExpression*) expression;
+
+			if (may_collect(expr->condition) || may_collect(expr->if_branch) || may_collect(expr->else_branch)) {
+				return true;
+			}
+
+			if (expr->else_if_branches != NULL) {
+				for (int i = 0; i < expr->else_if_branches->count; i++) {
+					if (may_collect(expr->else_if_conditions->values[i]) || may_collect(expr->else_if_branches->values[i])) {
+						return true;
+					}
+				}
+			}
+
+			return false;
+		}
+		default: return false;
+	}
+}
+
+// Literals and unboxed C locals, calls can't change them
+static bool is_stable(LitCEmitter* emitter, LitExpression* expression) {
+	if (expression == NULL) {
+		return false;
+	}
+
+	switch (expression->type) {
+		case LITERAL_EXPRESSION: return true;
+		case GROUPING_EXPRESSION: return is_stable(emitter, ((LitGroupingExpression*) expression)->expr);
+		case UNARY_EXPRESSION: return is_stable(emitter, ((LitUnaryExpression*) expression)->right);
+		case BINARY_EXPRESSION: {
+			LitBinaryExpression* expr = (LitBinaryExpression*) expression;
+			return expr->operator != TOKEN_IS && is_stable(emitter, expr->left) && is_stable(emitter, expr->right);
+		}
+		case VAR_EXPRESSION: {
+			LitCVariable* variable = find_variable(emitter, ((LitVarExpression*) expression)->name);
+
+			return variable != NULL && variable->slot == -1 && variable->global == -1 && !variable->top_level
+				&& variable->function == emitter->function->depth;
+		}
+		default: return false;
+	}
+}
+
+// The slot of a value var or this, that belongs to the current function
+static int frame_slot(LitCEmitter* emitter, LitExpression* expression) {
+	while (expression->type == GROUPING_EXPRESSION) {
+		expression = ((LitGroupingExpression*) expression)->expr;
+	}
+
+	LitCVariable* variable = NULL;
+
+	if (expression->type == VAR_EXPRESSION) {
+		variable = find_variable(emitter, ((LitVarExpression*) expression)->name);
+	} else if (expression->type == THIS_EXPRESSION) {
+		variable = find_variable(emitter, "this");
+	}
+
+	if (variable == NULL || variable->slot == -1 || variable->captured || variable->function != emitter->function->depth) {
+		return -1;
+	}
+
+	return variable->slot;
+}
+
+/*
+ * Stores the operands, that have to be evaluated before the last one, that can call something,
+ * into slots and temporaries, and that one too, if other operands are read from the frame.
+ * Returns true, if it opened a comma expression, that the caller closes.
+ */
+static bool spill_operands(LitCEmitter* emitter, LitCOperand* operands, int count) {
+	int last = -1;
+
+	for (int i = 0; i < count; i++) {
+		operands[i].temp = -1;
+
+		if (operands[i].expression != NULL) {
+			operands[i].slot = frame_slot(emitter, operands[i].expression);
+
+			if (may_collect(operands[i].expression)) {
+				last = i;
+			}
+		}
+	}
+
+	bool after_last = false;
+
+	for (int i = last + 1; i < count; i++) {
+		after_last |= !is_stable(emitter, operands[i].expression);
+	}
+
+	bool spilled = false;
+	bool in_frame = false;
+
+	for (int i = 0; i < count; i++) {
+		LitCOperand* operand = &operands[i];
+
+		if (operand->slot != -1) {
+			in_frame = true;
+			continue;
+		}
+
+		bool spill = operand->reused;
+
+		if (i < last) {
+			spill |= !is_stable(emitter, operand->expression);
+		} else if (i == last) {
+			spill |= in_frame || after_last;
+		}
+
+		if (!spill) {
+			continue;
+		}
+
+		emit(emitter, spilled ? "" : "(");
+		spilled = true;
+
+		if (operand->type == C_VALUE) {
+			operand->slot = allocate_slot(emitter->function);
+			in_frame = true;
+
+			emit(emitter, "s[%i] = ", operand->slot);
+		} else {
+			operand->temp = allocate_temp(emitter->function, operand->type);
+			emit(emitter, "%c%i = ", temp_prefix(operand->type), operand->temp);
+		}
+
+		emit_as(emitter, operand->expression, operand->type);
+		emit(emitter, ", ");
+	}
+
+	return spilled;
+}
+
+static void emit_operand(LitCEmitter* emitter, LitCOperand* operand) {
+	if (operand->slot != -1) {
+		emit(emitter, "%ss[%i])", unbox(operand->type), operand->slot);
+	} else if (operand->temp != -1) {
+		emit(emitter, "%c%i", temp_prefix(operand->type), operand->temp);
+	} else {
+		emit_as(emitter, operand->expression, operand->type);
+	}
+}
+
+// Slots and temporaries of spilled operands are free again after the expression
+typedef struct {
+	int slots;
+	int temps[3];
+} LitCTemps;
+
+static LitCTemps save_temps(LitCEmitter* emitter) {
+	LitCTemps temps;
+
+	temps.slots = emitter->function->slots;
+	memcpy(temps.temps, emitter->function->temps, sizeof(temps.temps));
+
+	return temps;
+}
+
+static void restore_temps(LitCEmitter* emitter, LitCTemps temps) {
+	emitter->function->slots = temps.slots;
+	memcpy(emitter->function->temps, temps.temps, sizeof(temps.temps));
+}
+
+static LitCOperand make_operand(LitExpression* expression, LitCType type) {
+	LitCOperand operand = { expression, type, false, -1, -1 };
+	return operand;
+}
+
+// Emits the spilled operands, callee, the rest of the operands in order, separated by commas, and the closing brackets
+static void emit_operands(LitCEmitter* emitter, const char* callee, LitCOperand* operands, int from, int count) {
+	emit(emitter, "%s", callee);
+
+	for (int i = from; i < count; i++) {
+		if (i > from) {
+			emit(emitter, ", ");
+		}
+
+		emit_operand(emitter, &operands[i]);
+	}
+
+	emit(emitter, ")");
+}
+
+static bool check_parameters(LitCEmitter* emitter, LitStatement* statement, LitExpression* expression, LitParameters* parameters) {
+	if (parameters != NULL) {
+		for (int i = 0; i < parameters->count; i++) {
+			LitCType type = c_type(parameters->values[i].type);
+
+			if (type == C_UNSUPPORTED || type == C_VOID) {
+				error(emitter, statement, expression, "Parameter of type %s", parameters->values[i].type);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// Emits a call of a C function with the parameters, the operands before from are already set up
+static void emit_direct_call(LitCEmitter* emitter, LitCallExpression* expression, const char* callee, LitParameters* parameters, LitCOperand* operands, int from) {
+	LitExpressions* args = expression->args;
+	int count = from + args->count;
+
+	if (!check_parameters(emitter, NULL, (LitExpression*) expression, parameters)) {
+		return;
+	}
+
+	for (int i = 0; i < args->count; i++) {
+		operands[from + i] = make_operand(args->values[i], c_type(parameters->values[i].type));
+	}
+
+	LitCTemps temps = save_temps(emitter);
+	bool spilled = spill_operands(emitter, operands, count);
+
+	emit_operands(emitter, callee, operands, 0, count);
+	emit(emitter, spilled ? ")" : "");
+
+	restore_temps(emitter, temps);
+}
+
+// Function<int, double, bool> -> int, double, the return type bool last
+static int signature_types(const char* signature, LitCType* types, int max) {
+	if (signature == NULL || strncmp(signature, "Function<", 9) != 0) {
+		return -1;
+	}
+
+	const char* start = signature + 9;
+	int depth = 0;
+	int count = 0;
+
+	for (const char* c = start;; c++) {
+		if (*c == '<') {
+			depth++;
+		} else if (*c == '\0' || (depth == 0 && (*c == ',' || *c == '>'))) {
+			char type[256];
+
+			while (*start == ' ') {
+				start++;
+			}
+
+			size_t length = (size_t) (c - start);
+
+			if (count == max || length >= sizeof(type)) {
+				return -1;
+			}
+
+			memcpy(type, start, length);
+			type[length] = '\0';
+			types[count++] = c_type(type);
+
+			if (*c != ',') {
+				return count;
+			}
+
+			start = c + 1;
+		} else if (*c == '>') {
+			depth--;
+		}
+	}
+}
+
+// Closures are called through the C function, that their function points to
+static void emit_value_call(LitCEmitter* emitter, LitCallExpression* expression) {
+	LitExpressions* args = expression->args;
+	LitCType types[UINT8_COUNT + 1];
+	int count = signature_types(expression->callee->resolved_type, types, UINT8_COUNT + 1);
+
+	if (count != args->count + 1) {
+		error(emitter, NULL, (LitExpression*) expression, "Calling %s", expression->callee->resolved_type);
+		return;
+	}
+
+	for (int i = 0; i < count; i++) {
+		if (types[i] == C_UNSUPPORTED || (types[i] == C_VOID && i < count - 1)) {
+			error(emitter, NULL, (LitExpression*) expression, "Calling %s", expression->callee->resolved_type);
+			return;
+		}
+	}
+
+	LitCOperand operands[UINT8_COUNT + 1];
+	operands[0] = make_operand(expression->callee, C_VALUE);
+	operands[0].reused = true;
+
+	for (int i = 0; i < args->count; i++) {
+		operands[i + 1] = make_operand(args->values[i], types[i]);
+	}
+
+	LitCTemps temps = save_temps(emitter);
+	bool spilled = spill_operands(emitter, operands, count);
+
+	emit(emitter, "((%s (*)(LitValue", c_type_name(types[count - 1]));
+
+	for (int i = 0; i < args->count; i++) {
+		emit(emitter, ", %s", c_type_name(types[i]));
+	}
+
+	emit(emitter, ")) entry_of(");
+	emit_operand(emitter, &operands[0]);
+	emit_operands(emitter, "))(", operands, 0, count);
+	emit(emitter, spilled ? ")" : "");
+
+	restore_temps(emitter, temps);
+}
+
+static void emit_signature(LitCEmitter* emitter, LitCType return_type, const char* prefix, const char* class, const char* name, const char* first, LitParameters* parameters) {
+	emit(emitter, "static %s %s%s%s%s(", c_type_name(return_type), prefix, class == NULL ? "" : class, class == NULL ? "" : "_", name);
+
+	if (first != NULL) {
+		emit(emitter, "%s", first);
+	} else if (parameters == NULL || parameters->count == 0) {
+		emit(emitter, "void");
+	}
+
+	if (parameters != NULL) {
+		for (int i = 0; i < parameters->count; i++) {
+			LitParameter parameter = parameters->values[i];
+			emit(emitter, i == 0 && first == NULL ? "%s v_%s" : ", %s v_%s", c_type_name(c_type(parameter.type)), parameter.name);
+		}
+	}
+
+	emit(emitter, ")");
+}
+
+static void declare_signature(LitCEmitter* emitter, LitCType return_type, const char* prefix, const char* class, const char* name, const char* first, LitParameters* parameters) {
+	LitCBuffer* out = emitter->out;
+	emitter->out = &emitter->declarations;
+
+	emit_signature(emitter, return_type, prefix, class, name, first, parameters);
+	emit(emitter, ";\n");
+
+	emitter->out = out;
+}
+
+// Calls the C function of a method, the receiver is already in the first operand
+static void emit_call_arguments(LitCEmitter* emitter, LitParameters* parameters) {
+	if (parameters != NULL) {
+		for (int i = 0; i < parameters->count; i++) {
+			emit(emitter, ", v_%s", parameters->values[i].name);
+		}
+	}
+}
+
+// The method of the class, or a dispatcher, that picks the override of the subclass of the instance
+static void method_name(LitCEmitter* emitter, char* name, size_t size, LitClassStatement* class, LitMethodStatement* method, LitClassStatement* owner) {
+	bool overridden = false;
+
+	for (int i = 0; i < emitter->classes.count && !overridden; i++) {
+		LitClassStatement* subclass = (LitClassStatement*) emitter->classes.values[i].key;
+		LitClassStatement* sub_owner;
+
+		if (subclass != class && is_subclass(emitter, subclass, class) && find_method(emitter, subclass, method->name, &sub_owner) != NULL) {
+			overridden = sub_owner != owner;
+		}
+	}
+
+	if (!overridden) {
+		snprintf(name, size, "m_%s_%s(", owner->name, method->name);
+		return;
+	}
+
+	snprintf(name, size, "d_%s_%s(", class->name, method->name);
+
+	if (find_symbol(&emitter->dispatchers, class, method->name) != NULL) {
+		return;
+	}
+
+	LitCSymbol symbol = { class, method->name, -1 };
+	lit_c_symbols_write((LitMemManager*) emitter->compiler, &emitter->dispatchers, symbol);
+
+	LitCType return_type = c_type(method->return_type.type);
+	LitCBuffer* out = emitter->out;
+
+	declare_signature(emitter, return_type, "d_", class->name, method->name, "LitValue v_this", method->parameters);
+	emitter->out = &emitter->functions;
+
+	emit_signature(emitter, return_type, "d_", class->name, method->name, "LitValue v_this", method->parameters);
+	emit(emitter, " {\n\tLitClass* type = AS_INSTANCE(v_this)->type;\n\n");
+
+	for (int i = 0; i < emitter->classes.count; i++) {
+		LitClassStatement* subclass = (LitClassStatement*) emitter->classes.values[i].key;
+		LitClassStatement* sub_owner;
+
+		if (subclass != class && is_subclass(emitter, subclass, class)) {
+			find_method(emitter, subclass, method->name, &sub_owner);
+
+			if (sub_owner != owner) {
+				emit(emitter, "\tif (type == c_%s) {\n\t\t%sm_%s_%s(v_this", subclass->name, return_type == C_VOID ? "" : "return ", sub_owner->name, method->name);
+				emit_call_arguments(emitter, method->parameters);
+				emit(emitter, return_type == C_VOID ? ");\n\t\treturn;\n\t}\n\n" : ");\n\t}\n\n");
+			}
+		}
+	}
+
+	emit(emitter, "\t%sm_%s_%s(v_this", return_type == C_VOID ? "" : "return ", owner->name, method->name);
+	emit_call_arguments(emitter, method->parameters);
+	emit(emitter, ");\n}\n\n");
+
+	emitter->out = out;
+}
+
+static void emit_method_call(LitCEmitter* emitter, LitCallExpression* expression, LitGetExpression* get) {
+	LitClassStatement* class = find_class(emitter, get->object->resolved_type);
+	LitClassStatement* owner;
+	LitMethodStatement* method = class == NULL ? NULL : find_method(emitter, class, get->property, &owner);
+
+	if (method == NULL) {
+		// A field, that holds a function
+		if (get->slot != -1) {
+			emit_value_call(emitter, expression);
+		} else {
+			error(emitter, NULL, (LitExpression*) expression, "Calling %s of %s", get->property, get->object->resolved_type);
+		}
+
+		return;
+	}
+
+	char name[512];
+	method_name(emitter, name, sizeof(name), class, method, owner);
+
+	LitCOperand operands[UINT8_COUNT + 1];
+	operands[0] = make_operand(get->object, C_VALUE);
+
+	if (is_this(get->object)) {
+		emit_direct_call(emitter, expression, name, method->parameters, operands, 1);
+		return;
+	}
+
+	// The receiver gets checked for nil, this never is
+	size_t length = strlen(name);
+	snprintf(&name[length], sizeof(name) - length, "receiver(");
+
+	LitExpressions* args = expression->args;
+	int count = args->count + 1;
+
+	if (!check_parameters(emitter, NULL, (LitExpression*) expression, method->parameters)) {
+		return;
+	}
+
+	for (int i = 0; i < args->count; i++) {
+		operands[i + 1] = make_operand(args->values[i], c_type(method->parameters->values[i].type));
+	}
+
+	LitCTemps temps = save_temps(emitter);
+	bool spilled = spill_operands(emitter, operands, count);
+
+	emit(emitter, "%s", name);
+	emit_operand(emitter, &operands[0]);
+	emit(emitter, ")");
+
+	for (int i = 1; i < count; i++) {
+		emit(emitter, ", ");
+		emit_operand(emitter, &operands[i]);
+	}
+
+	emit(emitter, spilled ? "))" : ")");
+	restore_temps(emitter, temps);
+}
+
+static void emit_call(LitCEmitter* emitter, LitCallExpression* expression) {
+	LitExpressions* args = expression->args;
+	LitExpression* callee = expression->callee;
+	LitCOperand operands[UINT8_COUNT + 1];
+
+	if (callee->type == GET_EXPRESSION) {
+		emit_method_call(emitter, expression, (LitGetExpression*) callee);
+		return;
+	}
+
+	if (callee->type == SUPER_EXPRESSION) {
+		LitClassStatement* class = emitter->function->class;
+		LitClassStatement* owner;
+		LitMethodStatement* method = class == NULL ? NULL : find_method(emitter, find_super(emitter, class), ((LitSuperExpression*) callee)->method, &owner);
+
+		if (method == NULL) {
+			error(emitter, NULL, (LitExpression*) expression, "Calling super methods outside of methods");
+			return;
+		}
+
+		char name[512];
+		snprintf(name, sizeof(name), "m_%s_%s(", owner->name, method->name);
+
+		operands[0] = make_operand(NULL, C_VALUE);
+		operands[0].slot = 0;
+
+		emit_direct_call(emitter, expression, name, method->parameters, operands, 1);
+		return;
+	}
+
+	if (callee->type != VAR_EXPRESSION) {
+		emit_value_call(emitter, expression);
+		return;
+	}
+
+	const char* name = ((LitVarExpression*) callee)->name;
+
+	if (find_variable(emitter, name) != NULL) {
+		emit_value_call(emitter, expression);
+		return;
+	}
+
+	LitFunctionStatement* function = find_function(emitter, name);
+	LitClassStatement* class = find_class(emitter, name);
+	char c_name[512];
+
+	if (function != NULL) {
+		snprintf(c_name, sizeof(c_name), "f_%s(", name);
+		emit_direct_call(emitter, expression, c_name, function->parameters, operands, 0);
+	} else if (class != NULL) {
+		LitClassStatement* owner;
+		LitMethodStatement* init = find_method(emitter, class, "init", &owner);
+
+		snprintf(c_name, sizeof(c_name), "n_%s(", name);
+		emit_direct_call(emitter, expression, c_name, init == NULL ? NULL : init->parameters, operands, 0);
+	} else if (strcmp(name, "print") == 0 && args->count == 1) {
+		LitCType type = expression_type(args->values[0]);
+
+		if (type == C_INT || type == C_NUMBER) {
+			type = C_NUMBER; // The VM prints ints as doubles too
+			emit(emitter, "print_number(");
+		} else {
+			emit(emitter, type == C_BOOL ? "print_bool(" : "print_value(");
+		}
+
+		emit_as(emitter, args->values[0], type == C_UNSUPPORTED ? C_VALUE : type);
+		emit(emitter, ")");
+	} else if (strcmp(name, "time") == 0 && args->count == 0) {
+		emit(emitter, "((double) clock() / CLOCKS_PER_SEC)");
+	} else if (strcmp(name, "error") == 0 && args->count == 1) {
+		emit(emitter, "error(");
+		emit_as(emitter, args->values[0], C_VALUE);
+		emit(emitter, ")");
+	} else {
+		error(emitter, NULL, (LitExpression*) expression, "Calling %s", name);
+	}
+}
+
+// Top level functions, that are used as values, get a closure, that calls them
+static int wrap_function(LitCEmitter* emitter, LitFunctionStatement* function) {
+	LitCSymbol* wrapped = find_symbol(&emitter->wrapped, function, NULL);
+
+	if (wrapped != NULL) {
+		return wrapped->global;
+	}
+
+	LitCSymbol symbol = { function, function->name, emitter->globals++ };
+	lit_c_symbols_write((LitMemManager*) emitter->compiler, &emitter->wrapped, symbol);
+
+	LitCType return_type = c_type(function->return_type.type);
+	LitCBuffer* out = emitter->out;
+
+	declare_signature(emitter, return_type, "w_", NULL, function->name, "LitValue self", function->parameters);
+	emitter->out = &emitter->functions;
+
+	emit_signature(emitter, return_type, "w_", NULL, function->name, "LitValue self", function->parameters);
+	emit(emitter, " {\n\t%sf_%s(", return_type == C_VOID ? "" : "return ", function->name);
+
+	if (function->parameters != NULL) {
+		for (int i = 0; i < function->parameters->count; i++) {
+			emit(emitter, i == 0 ? "v_%s" : ", v_%s", function->parameters->values[i].name);
+		}
+	}
+
+	emit(emitter, ");\n}\n\n");
+
+	emitter->out = &emitter->setup;
+	emit(emitter, "\tset_global(%i, MAKE_OBJECT_VALUE(lit_new_closure(&vm.mem_manager, new_function(\"%s\", (void*) w_%s, 0))));\n",
+		symbol.global, function->name, function->name);
+
+	emitter->out = out;
+	return symbol.global;
+}
+
+static void emit_function_body(LitCEmitter* emitter, LitCFunction* function, const char* prefix, const char* class, const char* name,
+	const char* first, LitParameters* parameters, LitStatement* body);
+
+static void emit_lambda(LitCEmitter* emitter, LitLambdaExpression* expression) {
+	LitCType return_type = c_type(expression->return_type.type);
+
+	if (return_type == C_UNSUPPORTED) {
+		error(emitter, NULL, (LitExpression*) expression, "Returning %s", expression->return_type.type);
+		return;
+	}
+
+	if (!check_parameters(emitter, NULL, (LitExpression*) expression, expression->parameters)) {
+		return;
+	}
+
+	int index = emitter->lambdas++;
+	char name[16];
+	snprintf(name, sizeof(name), "%i", index);
+
+	LitCFunction function;
+	memset(&function, 0, sizeof(LitCFunction));
+
+	function.lambda = true;
+	function.return_type = return_type;
+
+	declare_signature(emitter, return_type, "l_", NULL, name, "LitValue self", expression->parameters);
+	emit_function_body(emitter, &function, "l_", NULL, name, "LitValue self", expression->parameters, expression->body);
+
+	int global = emitter->globals++;
+	LitCBuffer* out = emitter->out;
+
+	declare(emitter, "static LitFunction* p_%i;\n", index);
+	emitter->out = &emitter->setup;
+	emit(emitter, "\tp_%i = new_function(\"lambda\", (void*) l_%i, %i);\n\tset_global(%i, MAKE_OBJECT_VALUE(p_%i));\n", index, index, function.upvalue_count, global, index);
+	emitter->out = out;
+
+	for (int i = 0; i < function.upvalue_count; i++) {
+		emit(emitter, "capture(");
+	}
+
+	emit(emitter, "MAKE_OBJECT_VALUE(lit_new_closure(&vm.mem_manager, p_%i))", index);
+
+	for (int i = 0; i < function.upvalue_count; i++) {
+		LitCVariable* variable = NULL;
+
+		for (int j = emitter->variables.count - 1; j >= 0 && variable == NULL; j--) {
+			if (emitter->variables.values[j].declaration == function.upvalues[i]) {
+				variable = &emitter->variables.values[j];
+			}
+		}
+
+		if (variable->function == emitter->function->depth) {
+			emit(emitter, ", %i, s[%i])", i, variable->slot);
+		} else {
+			int upvalue = resolve_upvalue(emitter, emitter->function, variable, (LitExpression*) expression);
+			emit(emitter, ", %i, MAKE_OBJECT_VALUE(AS_CLOSURE(s[0])->upvalues[%i]))", i, upvalue);
+		}
+	}
+}
+
+static void emit_expression(LitCEmitter* emitter, LitExpression* expression) {
+	switch (expression->type) {
+		case BINARY_EXPRESSION: {
+			LitBinaryExpression* expr = (LitBinaryExpression*) expression;
+			const char* operator = NULL;
+
+			if (expr->operator == TOKEN_IS) {
+				LitClassStatement* class = expr->right->type == VAR_EXPRESSION ? find_class(emitter, ((LitVarExpression*) expr->right)->name) : NULL;
+
+				if (class == NULL) {
+					error(emitter, NULL, expression, "Operator is without a class");
+					return;
+				}
+
+				emit(emitter, "instance_of(");
+				emit_as(emitter, expr->left, C_VALUE);
+				emit(emitter, ", c_%s)", class->name);
+
+				return;
+			}
+
+			switch (expr->operator) {
+				case TOKEN_PLUS: operator = " + "; break;
+				case TOKEN_MINUS: operator = " - "; break;
+				case TOKEN_STAR: operator = " * "; break;
+				case TOKEN_SLASH: operator = " / "; break;
+				case TOKEN_EQUAL_EQUAL: operator = " == "; break;
+				case TOKEN_BANG_EQUAL: operator = " != "; break;
+				case TOKEN_LESS: operator = " < "; break;
+				case TOKEN_LESS_EQUAL: operator = " <= "; break;
+				case TOKEN_GREATER: operator = " > "; break;
+				case TOKEN_GREATER_EQUAL: operator = " >= "; break;
+				case TOKEN_CARET: operator = ", "; break;
+				case TOKEN_CELL: operator = ", 1.0 / "; break;
+				default: {
+					error(emitter, NULL, expression, "Operator");
+					return;
+				}
+			}
+
+			// a ^ b is pow(a, b) and a # b is pow(a, 1 / b)
+			bool power = expr->operator == TOKEN_CARET || expr->operator == TOKEN_CELL;
+			bool ints = expr->operands == INT_OPERANDS && expr->operator != TOKEN_SLASH && !power;
+			// Int + - * wrap around like on the VM, that is only defined for unsigned ints in C
+			bool wraps = ints && expression_type(expression) == C_INT;
+
+			LitCOperand operands[2] = { make_operand(expr->left, ints ? C_INT : C_NUMBER), make_operand(expr->right, ints ? C_INT : C_NUMBER) };
+			LitCTemps temps = save_temps(emitter);
+			bool spilled = spill_operands(emitter, operands, 2);
+
+			emit(emitter, power ? "pow(" : (wraps ? "((int32_t) ((uint32_t) " : "("));
+			emit_operand(emitter, &operands[0]);
+			emit(emitter, wraps ? "%s(uint32_t) " : "%s", operator);
+			emit_operand(emitter, &operands[1]);
+			emit(emitter, wraps ? "))" : ")");
+			emit(emitter, spilled ? ")" : "");
+
+			restore_temps(emitter, temps);
+			break;
+		}
+		case LITERAL_EXPRESSION: {
+			LitValue value = ((LitLiteralExpression*) expression)->value;
+
+			if (IS_INT(value)) {
+				emit(emitter, "%i", AS_INT(value));
+			} else if (IS_NUMBER(value)) {
+				char number[32];
+				snprintf(number, sizeof(number), "%.17g", AS_NUMBER(value));
+
+				// Integral double literals still have to be doubles in C, 1.0 / 2 is not 0
+				emit(emitter, strpbrk(number, ".e") == NULL ? "%s.0" : "%s", number);
+			} else if (IS_BOOL(value)) {
+				emit(emitter, AS_BOOL(value) ? "true" : "false");
+			} else if (IS_STRING(value)) {
+				emit(emitter, "k_%i", make_constant(emitter, value));
+			} else {
+				emit(emitter, "((LitValue) %lluull)", (unsigned long long) value);
+			}
+
+			break;
+		}
+		case UNARY_EXPRESSION: {
+			LitUnaryExpression* expr = (LitUnaryExpression*) expression;
+
+			switch (expr->operator) {
+				case TOKEN_MINUS: {
+					bool ints = expression_type(expr->right) == C_INT;
+
+					emit(emitter, ints ? "((int32_t) (0u - (uint32_t) " : "(-");
+					emit_as(emitter, expr->right, ints ? C_INT : C_NUMBER);
+					emit(emitter, ints ? "))" : ")");
+
+					break;
+				}
+				case TOKEN_BANG: {
+					emit(emitter, "(!");
+					emit_condition(emitter, expr->right);
+					emit(emitter, ")");
+
+					break;
+				}
+				case TOKEN_CELL: {
+					emit(emitter, "sqrt(");
+					emit_as(emitter, expr->right, C_NUMBER);
+					emit(emitter, ")");
+
+					break;
+				}
+			}
+
+			break;
+		}
+		case GROUPING_EXPRESSION: {
+			emit(emitter, "(");
+			emit_expression(emitter, ((LitGroupingExpression*) expression)->expr);
+			emit(emitter, ")");
+
+			break;
+		}
+		case VAR_EXPRESSION: {
+			const char* name = ((LitVarExpression*) expression)->name;
+			LitCVariable* variable = find_variable(emitter, name);
+			LitFunctionStatement* function = variable == NULL ? find_function(emitter, name) : NULL;
+
+			if (variable != NULL) {
+				emit_variable(emitter, variable, expression);
+			} else if (function != NULL) {
+				emit(emitter, "GLOBAL(%i)", wrap_function(emitter, function));
+			} else {
+				error(emitter, NULL, expression, "Using %s as a value", name);
+			}
+
+			break;
+		}
+		case ASSIGN_EXPRESSION: {
+			LitAssignExpression* expr = (LitAssignExpression*) expression;
+			LitCVariable* variable = expr->to->type == VAR_EXPRESSION ? find_variable(emitter, ((LitVarExpression*) expr->to)->name) : NULL;
+
+			if (variable == NULL) {
+				error(emitter, NULL, expression, "Assigning to this");
+				break;
+			}
+
+			LitCFunction* function = emitter->function;
+			LitCType type = variable->type;
+
+			if (variable->global != -1) {
+				emit(emitter, "set_global(%i, ", variable->global);
+			} else if (variable->top_level || (variable->function == function->depth && !variable->captured)) {
+				emit(emitter, "(");
+				emit_variable(emitter, variable, expression);
+				emit(emitter, " = ");
+			} else if (variable->function == function->depth) {
+				emit(emitter, "%sset_cell(&s[%i], %s", unbox(type), variable->slot, box(type));
+			} else {
+				int upvalue = resolve_upvalue(emitter, function, variable, expression);
+				emit(emitter, "%sset_upvalue(&s[0], %i, %s", unbox(type), upvalue, box(type));
+			}
+
+			emit_as(emitter, expr->value, type);
+			emit(emitter, variable->global != -1 || variable->top_level || (variable->function == function->depth && !variable->captured) ? ")" : ")))");
+
+			break;
+		}
+		case LOGICAL_EXPRESSION: {
+			LitLogicalExpression* expr = (LitLogicalExpression*) expression;
+
+			if (expression_type(expression) == C_BOOL) {
+				emit(emitter, "(");
+				emit_expression(emitter, expr->left);
+				emit(emitter, expr->operator == TOKEN_AND ? " && " : " || ");
+				emit_expression(emitter, expr->right);
+				emit(emitter, ")");
+
+				break;
+			}
+
+			// The left operand is the result, if it is false for && or true for ||
+			LitCTemps temps = save_temps(emitter);
+			int slot = allocate_slot(emitter->function);
+
+			emit(emitter, "(s[%i] = ", slot);
+			emit_as(emitter, expr->left, C_VALUE);
+			emit(emitter, expr->operator == TOKEN_AND ? ", lit_is_false(s[%i]) ? s[%i] : " : ", lit_is_false(s[%i]) ? ", slot, slot);
+			emit_as(emitter, expr->right, C_VALUE);
+			emit(emitter, expr->operator == TOKEN_AND ? ")" : " : s[%i])", slot);
+
+			restore_temps(emitter, temps);
+			break;
+		}
+		case CALL_EXPRESSION: emit_call(emitter, (LitCallExpression*) expression); break;
+		case GET_EXPRESSION: {
+			LitGetExpression* expr = (LitGetExpression*) expression;
+			LitClassStatement* class = find_class(emitter, expr->object->resolved_type);
+
+			if (class == NULL) {
+				error(emitter, NULL, expression, "Getting %s of %s", expr->property, expr->object->resolved_type);
+			} else if (expr->slot != -1) {
+				emit(emitter, "%s%s", unbox(expression_type(expression)), is_this(expr->object) ? "AS_INSTANCE(" : "instance(");
+				emit_as(emitter, expr->object, C_VALUE);
+				emit(emitter, ")->fields[%i])", expr->slot);
+			} else {
+				emit(emitter, "method_of(");
+				emit_as(emitter, expr->object, C_VALUE);
+				emit(emitter, ", k_%i)", make_name_constant(emitter, expr->property));
+			}
+
+			break;
+		}
+		case SET_EXPRESSION: {
+			LitSetExpression* expr = (LitSetExpression*) expression;
+			LitCType type = expression_type(expression);
+
+			if (expr->slot == -1 || find_class(emitter, expr->object->resolved_type) == NULL) {
+				error(emitter, NULL, expression, "Setting %s of %s", expr->property, expr->object->resolved_type);
+				break;
+			}
+
+			LitCOperand operands[2] = { make_operand(expr->object, C_VALUE), make_operand(expr->value, type) };
+			LitCTemps temps = save_temps(emitter);
+			bool spilled = spill_operands(emitter, operands, 2);
+
+			emit(emitter, "%sset_field(%s", unbox(type), is_this(expr->object) ? "AS_INSTANCE(" : "instance(");
+			emit_operand(emitter, &operands[0]);
+			emit(emitter, "), %i, %s", expr->slot, box(type));
+			emit_operand(emitter, &operands[1]);
+			emit(emitter, spilled ? "))))" : ")))");
+
+			restore_temps(emitter, temps);
+			break;
+		}
+		case THIS_EXPRESSION: {
+			LitCVariable* variable = find_variable(emitter, "this");
+
+			if (variable == NULL) {
+				error(emitter, NULL, expression, "This outside of methods");
+			} else {
+				emit_variable(emitter, variable, expression);
+			}
+
+			break;
+		}
+		case IF_EXPRESSION: {
+			LitIfExpression* expr = (LitIfExpression*) expression;
+			LitCType type = expression_type(expression);
+
+			if (expr->else_branch == NULL) {
+				error(emitter, NULL, expression, "If expression without else");
+				break;
+			}
+
+			emit(emitter, "(");
+			emit_condition(emitter, expr->condition);
+			emit(emitter, " ? ");
+			emit_as(emitter, expr->if_branch, type);
+
+			if (expr->else_if_branches != NULL) {
+				for (int i = 0; i < expr->else_if_branches->count; i++) {
+					emit(emitter, " : ");
+					emit_condition(emitter, expr->else_if_conditions->values[i]);
+					emit(emitter, " ? ");
+					emit_as(emitter, expr->else_if_branches->values[i], type);
+				}
+			}
+
+			emit(emitter, " : ");
+			emit_as(emitter, expr->else_branch, type);
+			emit(emitter, ")");
+
+			break;
+		}
+		case LAMBDA_EXPRESSION: emit_lambda(emitter, (LitLambdaExpression*) expression); break;
+		default: error(emitter, NULL, expression, "Super method as a value"); break;
+	}
+}
+
+// Emits the statements of a block (or a single statement), one level deeper
+static void emit_body(LitCEmitter* emitter, LitStatement* statement) {
+	int variables = emitter->variables.count;
+	int slots = emitter->function->slots;
+
+	emitter->depth++;
+	emitter->indent++;
+
+	if (statement->type == BLOCK_STATEMENT) {
+		LitStatements* statements = ((LitBlockStatement*) statement)->statements;
+
+		if (statements != NULL) {
+			for (int i = 0; i < statements->count; i++) {
+				emit_statement(emitter, statements->values[i]);
+			}
+		}
+	} else {
+		emit_statement(emitter, statement);
+	}
+
+	emitter->depth--;
+	emitter->indent--;
+
+	emitter->variables.count = variables;
+	emitter->function->slots = slots;
+}
+
+static void emit_return(LitCEmitter* emitter, LitExpression* value) {
+	LitCType type = emitter->function->return_type;
+
+	emit_indent(emitter);
+
+	if (value == NULL || type == C_VOID) {
+		if (value != NULL) {
+			emit_expression(emitter, value);
+			emit(emitter, ";\n");
+			emit_indent(emitter);
+		}
+
+		emit(emitter, "vm.stack_top = s;\n");
+		emit_indent(emitter);
+		emit(emitter, type == C_VOID ? "return;\n" : "return %s;\n", c_default_value(type));
+
+		return;
+	}
+
+	// The frame goes away only after the value is there, it might still read from it
+	emit(emitter, "{\n");
+	emit_indent(emitter);
+	emit(emitter, "\t%s r = ", c_type_name(type));
+	emit_as(emitter, value, type);
+	emit(emitter, ";\n");
+	emit_indent(emitter);
+	emit(emitter, "\tvm.stack_top = s;\n");
+	emit_indent(emitter);
+	emit(emitter, "\treturn r;\n");
+	emit_indent(emitter);
+	emit(emitter, "}\n");
+}
+
+static void write_temps(LitCEmitter* emitter, LitCFunction* function) {
+	static const LitCType types[] = { C_INT, C_NUMBER, C_BOOL };
+
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < function->max_temps[i]; j++) {
+			emit(emitter, j == 0 ? "\t%s %c0" : ", %c%i", j == 0 ? c_type_name(types[i]) : (const char*) (intptr_t) temp_prefix(types[i]), j == 0 ? temp_prefix(types[i]) : j);
+		}
+
+		if (function->max_temps[i] > 0) {
+			emit(emitter, ";\n");
+		}
+	}
+}
+
+/*
+ * Functions, methods and lambdas. The body goes into its own buffer first, since
+ * the frame size is only known after it. Value and captured parameters are moved
+ * into the frame, before the safe point can move them.
+ */
+static void emit_function_body(LitCEmitter* emitter, LitCFunction* function, const char* prefix, const char* class, const char* name,
+	const char* first, LitParameters* parameters, LitStatement* body) {
+
+	function->enclosing = emitter->function;
+	function->depth = function->enclosing->depth + 1;
+
+	LitCBuffer* out = emitter->out;
+	LitCBuffer buffer = { NULL, 0, 0 };
+	int variables = emitter->variables.count;
+	int depth = emitter->depth;
+	int indent = emitter->indent;
+
+	emitter->function = function;
+	emitter->out = &buffer;
+	emitter->depth = 0;
+	emitter->indent = 0;
+
+	if (first != NULL) {
+		allocate_slot(function);
+
+		if (function->class != NULL) {
+			LitCVariable variable = { "this", NULL, C_VALUE, function->depth, 0, -1, false, false };
+
+			add_variable(emitter, variable);
+			emit(emitter, "\ts[0] = v_this;\n");
+		} else {
+			emit(emitter, "\ts[0] = self;\n");
+		}
+	}
+
+	if (parameters != NULL) {
+		for (int i = 0; i < parameters->count; i++) {
+			LitParameter* parameter = &parameters->values[i];
+			LitCType type = c_type(parameter->type);
+			LitCVariable variable = make_variable(emitter, parameter->name, parameter, type);
+
+			if (variable.captured) {
+				emit(emitter, "\ts[%i] = new_cell(%sv_%s));\n", variable.slot, box(type), parameter->name);
+			} else if (variable.slot != -1) {
+				emit(emitter, "\ts[%i] = v_%s;\n", variable.slot, parameter->name);
+			}
+
+			add_variable(emitter, variable);
+		}
+	}
+
+	emit(emitter, "\tsafepoint();\n");
+
+	if (body != NULL) {
+		emit_body(emitter, body);
+	}
+
+	// Falling off the end returns the default value, like on the VM
+	emitter->indent = 1;
+	emit_return(emitter, NULL);
+
+	emitter->out = &emitter->functions;
+	emit_signature(emitter, function->return_type, prefix, class, name, first, parameters);
+
+	if (function->max_slots > 0) {
+		emit(emitter, " {\n\tLitValue* s = enter(%i);\n", function->max_slots);
+	} else {
+		emit(emitter, " {\n\tLitValue* s = vm.stack_top;\n");
+	}
+
+	write_temps(emitter, function);
+	emit(emitter, "\n%.*s}\n\n", buffer.count, buffer.chars);
+
+	free_buffer(emitter, &buffer);
+
+	emitter->function = function->enclosing;
+	emitter->out = out;
+	emitter->variables.count = variables;
+	emitter->depth = depth;
+	emitter->indent = indent;
+}
+
+static void emit_function(LitCEmitter* emitter, LitFunctionStatement* statement) {
+	if (emitter->function->depth > 0 || emitter->depth > 0) {
+		error(emitter, (LitStatement*) statement, NULL, "Nested function %s", statement->name);
+		return;
+	}
+
+	LitCType return_type = c_type(statement->return_type.type);
+
+	if (return_type == C_UNSUPPORTED) {
+		error(emitter, (LitStatement*) statement, NULL, "Returning %s", statement->return_type.type);
+		return;
+	}
+
+	if (!check_parameters(emitter, (LitStatement*) statement, NULL, statement->parameters)) {
+		return;
+	}
+
+	LitCFunction function;
+	memset(&function, 0, sizeof(LitCFunction));
+	function.return_type = return_type;
+
+	emit_function_body(emitter, &function, "f_", NULL, statement->name, NULL, statement->parameters, statement->body);
+}
+
+// The same layout, as the VM builds: fields of the super class first, redefined ones keep their slot
+static int layout_fields(LitCEmitter* emitter, LitClassStatement* class, const char** names, int count) {
+	if (class == NULL) {
+		return count;
+	}
+
+	count = layout_fields(emitter, find_super(emitter, class), names, count);
+
+	if (class->fields != NULL) {
+		for (int i = 0; i < class->fields->count; i++) {
+			LitFieldStatement* field = (LitFieldStatement*) class->fields->values[i];
+			int slot = 0;
+
+			while (slot < count && strcmp(names[slot], field->name) != 0) {
+				slot++;
+			}
+
+			if (slot == count && !field->is_static && count < MAX_FIELDS) {
+				names[count++] = field->name;
+			}
+		}
+	}
+
+	return count;
+}
+
+static void emit_class(LitCEmitter* emitter, LitClassStatement* statement) {
+	LitCSymbol* symbol = find_symbol(&emitter->classes, statement, NULL);
+
+	if (emitter->function->depth > 0 || emitter->depth > 0 || symbol == NULL) {
+		error(emitter, (LitStatement*) statement, NULL, "Nested class %s", statement->name);
+		return;
+	}
+
+	LitClassStatement* super = find_super(emitter, statement);
+
+	emit_indent(emitter);
+	emit(emitter, "c_%s = new_class(\"%s\", ", statement->name, statement->name);
+	emit(emitter, super == NULL ? "NULL%s" : "c_%s", super == NULL ? "" : super->name);
+	emit(emitter, ", %i);\n", symbol->global);
+
+	if (statement->fields != NULL) {
+		const char* names[MAX_FIELDS];
+		int count = layout_fields(emitter, super, names, 0);
+
+		for (int i = 0; i < statement->fields->count; i++) {
+			LitFieldStatement* field = (LitFieldStatement*) statement->fields->values[i];
+			LitCType type = c_type(field->type);
+
+			if (field->is_static || field->getter != NULL || field->setter != NULL) {
+				error(emitter, (LitStatement*) field, NULL, "Static field, getter or setter %s", field->name);
+				continue;
+			}
+
+			if (type == C_UNSUPPORTED || type == C_VOID) {
+				error(emitter, (LitStatement*) field, NULL, "Field of type %s", field->type);
+				continue;
+			}
+
+			int slot = 0;
+
+			while (slot < count && strcmp(names[slot], field->name) != 0) {
+				slot++;
+			}
+
+			if (slot == count && count < MAX_FIELDS) {
+				names[count++] = field->name;
+			}
+
+			emit_indent(emitter);
+			emit(emitter, "define_field(c_%s, %i, %s", statement->name, slot, box(type));
+
+			if (field->init != NULL) {
+				emit_as(emitter, field->init, type);
+			} else {
+				emit(emitter, c_default_value(type));
+			}
+
+			emit(emitter, "));\n");
+		}
+	}
+
+	if (statement->methods != NULL) {
+		for (int i = 0; i < statement->methods->count; i++) {
+			LitMethodStatement* method = statement->methods->values[i];
+			LitCType return_type = c_type(method->return_type.type);
+
+			if (method->is_static) {
+				error(emitter, (LitStatement*) method, NULL, "Static method %s", method->name);
+				continue;
+			}
+
+			if (return_type == C_UNSUPPORTED) {
+				error(emitter, (LitStatement*) method, NULL, "Returning %s", method->return_type.type);
+				continue;
+			}
+
+			if (!check_parameters(emitter, (LitStatement*) method, NULL, method->parameters)) {
+				continue;
+			}
+
+			LitCFunction function;
+			memset(&function, 0, sizeof(LitCFunction));
+
+			function.class = statement;
+			function.return_type = return_type;
+
+			emit_function_body(emitter, &function, "m_", statement->name, method->name, "LitValue v_this", method->parameters, method->body);
+			emit_indent(emitter);
+			emit(emitter, "define_method(c_%s, \"%s\");\n", statement->name, method->name);
+		}
+	}
+
+	// Constructor
+	LitClassStatement* owner;
+	LitMethodStatement* init = find_method(emitter, statement, "init", &owner);
+	LitParameters* parameters = init == NULL ? NULL : init->parameters;
+	LitCBuffer* out = emitter->out;
+
+	emitter->out = &emitter->functions;
+	emit_signature(emitter, C_VALUE, "n_", NULL, statement->name, NULL, parameters);
+	emit(emitter, " {\n\tLitValue* s = enter(1);\n\ts[0] = new_instance(c_%s);\n", statement->name);
+
+	if (init != NULL) {
+		emit(emitter, "\tm_%s_init(s[0]", owner->name);
+		emit_call_arguments(emitter, parameters);
+		emit(emitter, ");\n");
+	}
+
+	emit(emitter, "\n\tvm.stack_top = s;\n\treturn s[0];\n}\n\n");
+	emitter->out = out;
+}
+
+static void emit_statement(LitCEmitter* emitter, LitStatement* statement) {
+	switch (statement->type) {
+		case VAR_STATEMENT: {
+			LitVarStatement* stmt = (LitVarStatement*) statement;
+			// Same as the resolver, a declared type wins over the one of the initializer
+			const char* type_name = stmt->type != NULL ? stmt->type : stmt->init->resolved_type;
+			LitCType type = c_type(type_name);
+
+			if (type == C_UNSUPPORTED || type == C_VOID) {
+				error(emitter, statement, NULL, "Variable of type %s", type_name);
+				break;
+			}
+
+			// Visible only after its initializer
+			LitCVariable variable = make_variable(emitter, stmt->name, stmt, type);
+
+			if (variable.global != -1) {
+				if (stmt->init != NULL) {
+					emit_indent(emitter);
+					emit(emitter, "set_global(%i, ", variable.global);
+					emit_as(emitter, stmt->init, type);
+					emit(emitter, ");\n");
+				}
+			} else if (variable.top_level) {
+				declare(emitter, "static %s v_%s = %s;\n", c_type_name(type), stmt->name, c_default_value(type));
+
+				if (stmt->init != NULL) {
+					emit_indent(emitter);
+					emit(emitter, "v_%s = ", stmt->name);
+					emit_as(emitter, stmt->init, type);
+					emit(emitter, ";\n");
+				}
+			} else {
+				emit_indent(emitter);
+
+				if (variable.captured) {
+					emit(emitter, "s[%i] = new_cell(%s", variable.slot, box(type));
+				} else if (variable.slot != -1) {
+					emit(emitter, "s[%i] = (", variable.slot);
+				} else {
+					emit(emitter, "%s v_%s = (", c_type_name(type), stmt->name);
+				}
+
+				if (stmt->init != NULL) {
+					emit_as(emitter, stmt->init, type);
+				} else {
+					emit(emitter, c_default_value(type));
+				}
+
+				emit(emitter, variable.captured ? "));\n" : ");\n");
+			}
+
+			add_variable(emitter, variable);
+			break;
+		}
+		case EXPRESSION_STATEMENT: {
+			emit_indent(emitter);
+			emit_expression(emitter, ((LitExpressionStatement*) statement)->expr);
+			emit(emitter, ";\n");
+
+			break;
+		}
+		case IF_STATEMENT: {
+			LitIfStatement* stmt = (LitIfStatement*) statement;
+
+			emit_indent(emitter);
+			emit(emitter, "if (");
+			emit_condition(emitter, stmt->condition);
+			emit(emitter, ") {\n");
+			emit_body(emitter, stmt->if_branch);
+
+			if (stmt->else_if_branches != NULL) {
+				for (int i = 0; i < stmt->else_if_branches->count; i++) {
+					emit_indent(emitter);
+					emit(emitter, "} else if (");
+					emit_condition(emitter, stmt->else_if_conditions->values[i]);
+					emit(emitter, ") {\n");
+					emit_body(emitter, stmt->else_if_branches->values[i]);
+				}
+			}
+
+			if (stmt->else_branch != NULL) {
+				emit_indent(emitter);
+				emit(emitter, "} else {\n");
+				emit_body(emitter, stmt->else_branch);
+			}
+
+			emit_indent(emitter);
+			emit(emitter, "}\n");
+
+			break;
+		}
+		case BLOCK_STATEMENT: {
+			emit_indent(emitter);
+			emit(emitter, "{\n");
+			emit_body(emitter, statement);
+			emit_indent(emitter);
+			emit(emitter, "}\n");
+
+			break;
+		}
+		case WHILE_STATEMENT: {
+			LitWhileStatement* stmt = (LitWhileStatement*) statement;
+
+			emit_indent(emitter);
+			emit(emitter, "while (");
+			emit_condition(emitter, stmt->condition);
+			emit(emitter, ") {\n");
+			emit_indent(emitter);
+			emit(emitter, "\tsafepoint();\n");
+			emit_body(emitter, stmt->body);
+			emit_indent(emitter);
+			emit(emitter, "}\n");
+
+			break;
+		}
+		case FUNCTION_STATEMENT: emit_function(emitter, (LitFunctionStatement*) statement); break;
+		case RETURN_STATEMENT: {
+			if (emitter->function->depth == 0) {
+				error(emitter, statement, NULL, "Return outside of a function");
+				break;
+			}
+
+			emit_return(emitter, ((LitReturnStatement*) statement)->value);
+			break;
+		}
+		case CLASS_STATEMENT: emit_class(emitter, (LitClassStatement*) statement); break;
+		case BREAK_STATEMENT: {
+			emit_indent(emitter);
+			emit(emitter, "break;\n");
+
+			break;
+		}
+		case CONTINUE_STATEMENT: {
+			emit_indent(emitter);
+			emit(emitter, "continue;\n");
+
+			break;
+		}
+		case TRY_STATEMENT: error(emitter, statement, NULL, "Try statement"); break;
+		case THROW_STATEMENT: error(emitter, statement, NULL, "Throw statement"); break;
+		default: error(emitter, statement, NULL, "Statement"); break;
+	}
+}
+
+// Only the names, declarations and functions of the vars matter, while looking for captured ones
+static void scan_declare(LitCEmitter* emitter, const char* name, const void* declaration) {
+	LitCVariable variable = { name, declaration, C_VALUE, emitter->scan_function, -1, -1, emitter->scan_function == 0 && emitter->depth == 0, false };
+	add_variable(emitter, variable);
+}
+
+static void scan_variable(LitCEmitter* emitter, const char* name) {
+	LitCVariable* variable = find_variable(emitter, name);
+
+	if (variable != NULL && !variable->top_level && variable->function < emitter->scan_function && !is_captured(emitter, variable->declaration)) {
+		LitCSymbol symbol = { variable->declaration, variable->name, -1 };
+		lit_c_symbols_write((LitMemManager*) emitter->compiler, &emitter->captured, symbol);
+	}
+}
+
+static void scan_function(LitCEmitter* emitter, LitParameters* parameters, LitStatement* body) {
+	int variables = emitter->variables.count;
+	int depth = emitter->depth;
+
+	emitter->scan_function++;
+	emitter->depth = 1;
+
+	if (parameters != NULL) {
+		for (int i = 0; i < parameters->count; i++) {
+			scan_declare(emitter, parameters->values[i].name, &parameters->values[i]);
+		}
+	}
+
+	if (body != NULL) {
+		scan_statement(emitter, body);
+	}
+
+	emitter->scan_function--;
+	emitter->depth = depth;
+	emitter->variables.count = variables;
+}
+
+static void scan_expressions(LitCEmitter* emitter, LitExpressions* expressions) {
+	if (expressions != NULL) {
+		for (int i = 0; i < expressions->count; i++) {
+			scan_expression(emitter, expressions->values[i]);
+		}
+	}
+}
+
+static void scan_expression(LitCEmitter* emitter, LitExpression* expression) {
+	if (expression == NULL) {
+		return;
+	}
+
+	switch (expression->type) {
+		case BINARY_EXPRESSION: {
+			scan_expression(emitter, ((LitBinaryExpression*) expression)->left);
+			scan_expression(emitter, ((LitBinaryExpression*) expression)->right);
+
+			break;
+		}
+		case UNARY_EXPRESSION: scan_expression(emitter, ((LitUnaryExpression*) expression)->right); break;
+		case GROUPING_EXPRESSION: scan_expression(emitter, ((LitGroupingExpression*) expression)->expr); break;
+		case VAR_EXPRESSION: scan_variable(emitter, ((LitVarExpression*) expression)->name); break;
+		case ASSIGN_EXPRESSION: {
+			scan_expression(emitter, ((LitAssignExpression*) expression)->to);
+			scan_expression(emitter, ((LitAssignExpression*) expression)->value);
+
+			break;
+		}
+		case LOGICAL_EXPRESSION: {
+			scan_expression(emitter, ((LitLogicalExpression*) expression)->left);
+			scan_expression(emitter, ((LitLogicalExpression*) expression)->right);
+
+			break;
+		}
+		case CALL_EXPRESSION: {
+			scan_expression(emitter, ((LitCallExpression*) expression)->callee);
+			scan_expressions(emitter, ((LitCallExpression*) expression)->args);
+
+			break;
+		}
+		case LAMBDA_EXPRESSION: {
+			LitLambdaExpression* expr = (LitLambdaExpression*) expression;
+			scan_function(emitter, expr->parameters, expr->body);
+
+			break;
+		}
+		case GET_EXPRESSION: scan_expression(emitter, ((LitGetExpression*) expression)->object); break;
+		case SET_EXPRESSION: {
+			scan_expression(emitter, ((LitSetExpression*) expression)->object);
+			scan_expression(emitter, ((LitSetExpression*) expression)->value);
+
+			break;
+		}
+		case IF_EXPRESSION: {
+			LitIfExpression* expr = (LitIfExpression*) expression;
+
+			scan_expression(emitter, expr->condition);
+			scan_expression(emitter, expr->if_branch);
+			scan_expressions(emitter, expr->else_if_conditions);
+			scan_expressions(emitter, expr->else_if_branches);
+			scan_expression(emitter, expr->else_branch);
+
+			break;
+		}
+		default: break;
+	}
+}
+
+static void scan_block(LitCEmitter* emitter, LitStatement* statement) {
+	if (statement == NULL) {
+		return;
+	}
+
+	int variables = emitter->variables.count;
+	emitter->depth++;
+
+	scan_statement(emitter, statement);
+
+	emitter->depth--;
+	emitter->variables.count = variables;
+}
+
+// Collects the top level functions and classes, and finds the vars, that lambdas capture
+static void scan_statement(LitCEmitter* emitter, LitStatement* statement) {
+	LitMemManager* manager = (LitMemManager*) emitter->compiler;
+
+	switch (statement->type) {
+		case VAR_STATEMENT: {
+			LitVarStatement* stmt = (LitVarStatement*) statement;
+
+			scan_expression(emitter, stmt->init);
+			scan_declare(emitter, stmt->name, stmt);
+
+			break;
+		}
+		case EXPRESSION_STATEMENT: scan_expression(emitter, ((LitExpressionStatement*) statement)->expr); break;
+		case IF_STATEMENT: {
+			LitIfStatement* stmt = (LitIfStatement*) statement;
+
+			scan_expression(emitter, stmt->condition);
+			scan_block(emitter, stmt->if_branch);
+			scan_expressions(emitter, stmt->else_if_conditions);
+
+			if (stmt->else_if_branches != NULL) {
+				for (int i = 0; i < stmt->else_if_branches->count; i++) {
+					scan_block(emitter, stmt->else_if_branches->values[i]);
+				}
+			}
+
+			scan_block(emitter, stmt->else_branch);
+			break;
+		}
+		case BLOCK_STATEMENT: {
+			LitStatements* statements = ((LitBlockStatement*) statement)->statements;
+			int variables = emitter->variables.count;
+
+			emitter->depth++;
+
+			if (statements != NULL) {
+				for (int i = 0; i < statements->count; i++) {
+					scan_statement(emitter, statements->values[i]);
+				}
+			}
+
+			emitter->depth--;
+			emitter->variables.count = variables;
+
+			break;
+		}
+		case WHILE_STATEMENT: {
+			scan_expression(emitter, ((LitWhileStatement*) statement)->condition);
+			scan_block(emitter, ((LitWhileStatement*) statement)->body);
+
+			break;
+		}
+		case FUNCTION_STATEMENT: {
+			LitFunctionStatement* stmt = (LitFunctionStatement*) statement;
+
+			if (emitter->scan_function == 0 && emitter->depth == 0) {
+				lit_functions_write(manager, &emitter->declared, stmt);
+			}
+
+			scan_function(emitter, stmt->parameters, stmt->body);
+			break;
+		}
+		case RETURN_STATEMENT: scan_expression(emitter, ((LitReturnStatement*) statement)->value); break;
+		case CLASS_STATEMENT: {
+			LitClassStatement* stmt = (LitClassStatement*) statement;
+
+			if (emitter->scan_function == 0 && emitter->depth == 0) {
+				LitCSymbol symbol = { stmt, stmt->name, emitter->globals++ };
+				lit_c_symbols_write(manager, &emitter->classes, symbol);
+			}
+
+			if (stmt->fields != NULL) {
+				for (int i = 0; i < stmt->fields->count; i++) {
+					scan_expression(emitter, ((LitFieldStatement*) stmt->fields->values[i])->init);
+				}
+			}
+
+			if (stmt->methods != NULL) {
+				for (int i = 0; i < stmt->methods->count; i++) {
+					scan_function(emitter, stmt->methods->values[i]->parameters, stmt->methods->values[i]->body);
+				}
+			}
+
+			break;
+		}
+		case TRY_STATEMENT: {
+			scan_block(emitter, ((LitTryStatement*) statement)->body);
+			scan_block(emitter, ((LitTryStatement*) statement)->catch_body);
+
+			break;
+		}
+		case THROW_STATEMENT: scan_expression(emitter, ((LitThrowStatement*) statement)->value); break;
+		default: break;
+	}
+}
+
+// Functions, methods and constructors can be called before their definition
+static void declare_prototypes(LitCEmitter* emitter) {
+	for (int i = 0; i < emitter->declared.count; i++) {
+		LitFunctionStatement* function = emitter->declared.values[i];
+		declare_signature(emitter, c_type(function->return_type.type), "f_", NULL, function->name, NULL, function->parameters);
+	}
+
+	for (int i = 0; i < emitter->classes.count; i++) {
+		LitClassStatement* class = (LitClassStatement*) emitter->classes.values[i].key;
+		LitClassStatement* owner;
+		LitMethodStatement* init = find_method(emitter, class, "init", &owner);
+
+		declare(emitter, "static LitClass* c_%s;\n", class->name);
+		declare_signature(emitter, C_VALUE, "n_", NULL, class->name, NULL, init == NULL ? NULL : init->parameters);
+
+		if (class->methods != NULL) {
+			for (int j = 0; j < class->methods->count; j++) {
+				LitMethodStatement* method = class->methods->values[j];
+
+				if (!method->is_static) {
+					declare_signature(emitter, c_type(method->return_type.type), "m_", class->name, method->name, "LitValue v_this", method->parameters);
+				}
+			}
+		}
+	}
+}
+
+static void write_string(FILE* out, LitString* string) {
+	fputc('"', out);
+
+	for (int i = 0; i < string->length; i++) {
+		unsigned char c = (unsigned char) string->chars[i];
+
+		if (c == '"' || c == '\\') {
+			fprintf(out, "\\%c", c);
+		} else if (c < 32 || c > 126) {
+			fprintf(out, "\\%03o", c);
+		} else {
+			fputc(c, out);
+		}
+	}
+
+	fputc('"', out);
+}
+
+bool lit_emit_c(LitCompiler* compiler, LitStatements* statements, FILE* out) {
+	LitCEmitter emitter;
+	memset(&emitter, 0, sizeof(LitCEmitter));
+
+	LitCFunction main;
+	memset(&main, 0, sizeof(LitCFunction));
+
+	LitCBuffer main_code = { NULL, 0, 0 };
+
+	emitter.compiler = compiler;
+	emitter.out = &main_code;
+	emitter.function = &main;
+	emitter.indent = 1;
+
+	lit_init_functions(&emitter.declared);
+	lit_init_c_symbols(&emitter.classes);
+	lit_init_c_symbols(&emitter.captured);
+	lit_init_c_symbols(&emitter.wrapped);
+	lit_init_c_symbols(&emitter.dispatchers);
+	lit_init_c_variables(&emitter.variables);
+	lit_init_array(&emitter.strings);
+
+	for (int i = 0; i < statements->count; i++) {
+		scan_statement(&emitter, statements->values[i]);
+	}
+
+	declare_prototypes(&emitter);
+
+	for (int i = 0; i < statements->count; i++) {
+		emit_statement(&emitter, statements->values[i]);
+	}
+
+	if (!emitter.had_error) {
+		fputs(preamble, out);
+		fwrite(emitter.declarations.chars, 1, (size_t) emitter.declarations.count, out);
+		fputs("\n", out);
+		fwrite(emitter.functions.chars, 1, (size_t) emitter.functions.count, out);
+
+		fputs("int lit_aot_main(void) {\n\tlit_init_vm(&vm);\n\tvm.init_string = lit_copy_string(&vm.mem_manager, \"init\", 4);\n\n", out);
+
+		// Global values are gc roots, top level values, classes and functions come first, the strings after them
+		fprintf(out, "\tfor (int i = 0; i < %i; i++) {\n\t\tlit_array_write(&vm.mem_manager, &vm.global_values, NIL_VALUE);\n\t}\n\n", emitter.globals);
+
+		for (int i = 0; i < emitter.strings.count; i++) {
+			LitString* string = AS_STRING(emitter.strings.values[i]);
+
+			fprintf(out, "\tk_%i = MAKE_OBJECT_VALUE(lit_copy_string(&vm.mem_manager, ", i);
+			write_string(out, string);
+			fprintf(out, ", %i));\n\tlit_array_write(&vm.mem_manager, &vm.global_values, k_%i);\n", string->length, i);
+		}
+
+		fwrite(emitter.setup.chars, 1, (size_t) emitter.setup.count, out);
+		fputs("\n\tif (setjmp(error_jump) != 0) {\n\t\tlit_free_vm(&vm);\n\t\treturn 2;\n\t}\n\n", out);
+
+		if (main.max_slots > 0) {
+			fprintf(out, "\tLitValue* s = enter(%i);\n", main.max_slots);
+		}
+
+		emitter.out = &emitter.functions;
+		emitter.functions.count = 0;
+		write_temps(&emitter, &main);
+
+		fwrite(emitter.functions.chars, 1, (size_t) emitter.functions.count, out);
+		fputs("\n", out);
+		fwrite(main_code.chars, 1, (size_t) main_code.count, out);
+		fputs("\n\tlit_free_vm(&vm);\n\treturn 0;\n}\n\n", out);
+		fputs("#ifndef LIT_AOT_SHARED\nint main(void) {\n\treturn lit_aot_main();\n}\n#endif\n", out);
+	}
+
+	free_buffer(&emitter, &emitter.declarations);
+	free_buffer(&emitter, &emitter.setup);
+	free_buffer(&emitter, &emitter.functions);
+	free_buffer(&emitter, &main_code);
+	lit_free_functions((LitMemManager*) compiler, &emitter.declared);
+	lit_free_c_symbols((LitMemManager*) compiler, &emitter.classes);
+	lit_free_c_symbols((LitMemManager*) compiler, &emitter.captured);
+	lit_free_c_symbols((LitMemManager*) compiler, &emitter.wrapped);
+	lit_free_c_symbols((LitMemManager*) compiler, &emitter.dispatchers);
+	lit_free_c_variables((LitMemManager*) compiler, &emitter.variables);
+	lit_free_array((LitMemManager*) compiler, &emitter.strings);
+
+	return !emitter.had_error;
+}
@@ -4,15 +4,28 @@
 
 #include <compiler/lit_compiler.h>
 #include <compiler/lit_parser.h>
+#include <compiler/lit_optimizer.h>
+#include <compiler/lit_c_emitter.h>
+
+LitCompilerOptions lit_compiler_options = { false };
+
+static const char* phase_names[PHASE_COUNT] = { "lex", "parse", "resolve", "emit" };
 
 void lit_init_compiler(LitCompiler* compiler) {
 	LitMemManager* manager = (LitMemManager*) compiler;
+	compiler->options = lit_compiler_options;
 
 	manager->bytes_allocated = 0;
+	manager->bytes_total = 0;
+	manager->peak_bytes = 0;
 	manager->type = MANAGER_COMPILER;
 	manager->objects = NULL;
 
 	lit_init_table(&manager->strings);
+	lit_init_table(&compiler->globals);
+	lit_init_arena(&compiler->arena);
+	memset(&compiler->stats, 0, sizeof(LitCompileStats));
+	compiler->phase = PHASE_PARSE;
 
 	compiler->init_string = lit_copy_string(manager, "init", 4);
 	compiler->resolver.compiler = compiler;
@@ -27,12 +40,25 @@ void lit_free_compiler(LitCompiler* compiler) {
 		printf("Bytes allocated after before freeing compiler: %ld\n", ((LitMemManager*) compiler)->bytes_allocated);
 	}
 
+	if (compiler->options.time_phases) {
+		fprintf(stderr, "%-8s %10s %8s %8s %12s %12s\n", "Phase", "Time (ms)", "Tokens", "Nodes", "Allocated", "Peak");
+
+		for (int i = 0; i < PHASE_COUNT; i++) {
+			LitPhaseStats* phase = &compiler->stats.phases[i];
+
+			fprintf(stderr, "%-8s %10.3f %8u %8u %12zu %12zu\n", phase_names[i], phase->time / 1e6,
+				phase->tokens, phase->nodes, phase->bytes_allocated, phase->peak_bytes);
+		}
+	}
+
 	lit_free_emitter(&compiler->emitter);
 	lit_free_resolver(&compiler->resolver);
+	lit_free_arena(&compiler->arena);
 }
 
 void lit_free_bytecode_objects(LitCompiler* compiler) {
 	lit_free_table(compiler, &compiler->mem_manager.strings);
+	lit_free_table(compiler, &compiler->globals);
 	lit_free_objects(compiler);
 
 	if (DEBUG_TRACE_MEMORY_LEAKS) {
@@ -40,34 +66,64 @@ void lit_free_bytecode_objects(LitCompiler* compiler) {
 	}
 }
 
+/*
+ * Phases measure the compiler memory and the arena (the arena only grows, until lit_compile() is done)
+ */
+
+typedef struct {
+	uint64_t start;
+	size_t bytes_total;
+	size_t arena_bytes;
+} PhaseStart;
+
+static PhaseStart begin_phase(LitCompiler* compiler, LitCompilePhase phase) {
+	LitMemManager* manager = (LitMemManager*) compiler;
+
+	compiler->phase = phase;
+	manager->peak_bytes = manager->bytes_allocated;
+
+	return (PhaseStart) { lit_time_ns(), manager->bytes_total, compiler->arena.bytes };
+}
+
+static void end_phase(LitCompiler* compiler, PhaseStart start) {
+	LitMemManager* manager = (LitMemManager*) compiler;
+	LitPhaseStats* phase = &compiler->stats.phases[compiler->phase];
+
+	phase->time += lit_time_ns() - start.start;
+	phase->bytes_allocated += manager->bytes_total - start.bytes_total + compiler->arena.bytes - start.arena_bytes;
+	phase->peak_bytes = manager->peak_bytes + compiler->arena.bytes;
+}
+
 /*
  * Splits source code into tokens and converts them to AST tree
  * Then resolves the AST tree (finds non existing vars, etc)
- * And emits it into bytecode
+ * Returns false on errors, the AST is left in the arena either way
  */
 
-LitFunction* lit_compile(LitCompiler* compiler, const char* source_code) {
+static bool parse_and_resolve(LitCompiler* compiler, const char* source_code, LitStatements* statements) {
+	memset(&compiler->stats, 0, sizeof(LitCompileStats));
+
+	PhaseStart start = begin_phase(compiler, PHASE_PARSE);
 	lit_init_lexer(compiler, &compiler->lexer, source_code);
-	LitStatements statements;
+	lit_init_statements(statements);
 
-	lit_init_statements(&statements);
+	bool had_error = lit_parse(compiler, &compiler->lexer, statements);
+	end_phase(compiler, start);
 
-	if (lit_parse(compiler, &compiler->lexer, &statements)) {
-		for (int i = 0; i < statements.count; i++) {
-			lit_free_statement(compiler, statements.values[i]);
-		}
+	// Lexing was timed inside of the parse
+	compiler->stats.phases[PHASE_PARSE].time -= compiler->stats.phases[PHASE_LEX].time;
 
-		lit_free_statements((LitMemManager *) compiler, &statements);
-		return NULL; // Parsing error
+	if (had_error) {
+		return false; // Parsing error
 	}
 
 	if (DEBUG_TRACE_AST) {
 		printf("[\n");
 
-		for (int i = 0; i < statements.count; i++) {
-			lit_trace_statement(compiler, statements.values[i], 1);
+		for (int i = 0; i < statements->count; i++) {
+			lit_trace_statement(compiler, statements->values[i], 1);
 
-			if (i < statements.count - 1) {
+			if (i < statements->count - 1) {
 				printf(",\n");
 			}
 		}
@@ -75,27 +131,53 @@ LitFunction* lit_compile(LitCompiler* compiler, const char* source_code) {
 		printf("\n]\n");
 	}
 
-	if (lit_resolve(compiler, &statements)) {
-		for (int i = 0; i < statements.count; i++) {
-			lit_free_statement(compiler, statements.values[i]);
+	start = begin_phase(compiler, PHASE_RESOLVE);
+	had_error = lit_resolve(compiler, statements);
+	end_phase(compiler, start);
+
+	return !had_error; // Resolving error
+}
+
+/*
+ * Parses, resolves and emits the AST into bytecode
+ */
+
+LitFunction* lit_compile(LitCompiler* compiler, const char* source_code) {
+	LitStatements statements;
+	LitFunction* function = NULL;
+
+	if (parse_and_resolve(compiler, source_code, &statements)) {
+		PhaseStart start = begin_phase(compiler, PHASE_EMIT);
+		function = lit_emit(&compiler->emitter, &statements);
+
+		if (function != NULL) {
+			lit_optimize_function(compiler, function);
 		}
 
-		lit_free_statements((LitMemManager *) compiler, &statements);
-		return NULL; // Resolving error
+		end_phase(compiler, start);
+
+		if (DEBUG_TRACE_CODE && function != NULL) {
+			lit_trace_chunk(compiler, &function->chunk, "$main");
+		}
 	}
 
-	LitFunction* function = lit_emit(&compiler->emitter, &statements);
+	// The AST, the strings in it and the resolver scopes all go at once
+	lit_free_arena(&compiler->arena);
+	return function;
+}
 
-	if (DEBUG_TRACE_CODE) {
-		lit_trace_chunk(compiler, &function->chunk, "$main");
-	}
+bool lit_compile_c(LitCompiler* compiler, const char* source_code, FILE* out) {
+	LitStatements statements;
+	bool success = false;
 
-	for (int i = 0; i < statements.count; i++) {
-		lit_free_statement(compiler, statements.values[i]);
+	if (parse_and_resolve(compiler, source_code, &statements)) {
+		PhaseStart start = begin_phase(compiler, PHASE_EMIT);
+		success = lit_emit_c(compiler, &statements, out);
+		end_phase(compiler, start);
 	}
 
-	lit_free_statements((LitMemManager *) compiler, &statements);
-	return function;
+	lit_free_arena(&compiler->arena);
+	return success;
 }
 
 void lit_compiler_define_native(LitCompiler* compiler, LitNativeRegistry* native) {
@@ -103,8 +185,9 @@ void lit_compiler_define_native(LitCompiler* compiler, LitNativeRegistry* native
 	LitResolverLocal* letal = (LitResolverLocal*) reallocate(compiler, NULL, 0, sizeof(LitResolverLocal));
 
 	size_t len = strlen(native->signature);
-	char* tp = (char*) reallocate(compiler, NULL, 0, len);
+	char* tp = (char*) reallocate(compiler, NULL, 0, len + 1);
 	strncpy(tp, native->signature, len);
+	tp[len] = '\0';
 
 	letal->type = tp;
 	letal->defined = true;
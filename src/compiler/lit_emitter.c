@@ -6,6 +6,7 @@
 #include <lit_debug.h>
 
 #include <compiler/lit_emitter.h>
+#include <compiler/lit_register_emitter.h>
 #include <vm/lit_memory.h>
 
 DEFINE_ARRAY(LitInts, int, ints)
@@ -44,10 +45,64 @@ static uint8_t make_constant(LitEmitter* emitter, LitValue value) {
 	return (uint8_t) constant;
 }
 
+static void emit_field_cache(LitEmitter* emitter, uint64_t line) {
+	// Sites past UINT16_MAX share caches, entries are validated on every hit anyway
+	uint16_t site = (uint16_t) emitter->field_cache_count++;
+	emit_bytes(emitter, (uint8_t) ((site >> 8) & 0xff), (uint8_t) (site & 0xff), line);
+}
+
+int lit_emitter_global(LitEmitter* emitter, const char* name) {
+	LitCompiler* compiler = emitter->compiler;
+	LitString* string = lit_copy_string(compiler, name, strlen(name));
+	LitValue* value = lit_table_get(&compiler->globals, string);
+
+	if (value != NULL) {
+		return AS_INT(*value);
+	}
+
+	int index = compiler->globals.count;
+
+	if (index > UINT16_MAX) {
+		error(emitter, "Too many global variables");
+		return 0;
+	}
+
+	lit_table_set(compiler, &compiler->globals, string, MAKE_INT_VALUE(index));
+	return index;
+}
+
+static void emit_global(LitEmitter* emitter, uint8_t instruction, const char* name, uint64_t line) {
+	int index = lit_emitter_global(emitter, name);
+
+	emit_byte(emitter, instruction, line);
+	emit_bytes(emitter, (uint8_t) ((index >> 8) & 0xff), (uint8_t) (index & 0xff), line);
+}
+
 static void emit_constant(LitEmitter* emitter, LitValue constant, uint64_t line) {
 	emit_bytes(emitter, OP_CONSTANT, make_constant(emitter, constant), line);
 }
 
+// Value of variables and fields without an initializer, int ones have to hold an int too
+static void emit_default(LitEmitter* emitter, const char* type, uint64_t line) {
+	if (type == NULL) {
+		emit_byte(emitter, OP_NIL, line);
+	} else if (strcmp(type, "bool") == 0) {
+		emit_byte(emitter, OP_FALSE, line);
+	} else if (strcmp(type, "int") == 0 || strcmp(type, "double") == 0) {
+		emit_constant(emitter, MAKE_INT_VALUE(0), line);
+	} else if (strcmp(type, "char") == 0) {
+		emit_constant(emitter, MAKE_CHAR_VALUE('\0'), line);
+	} else {
+		emit_byte(emitter, OP_NIL, line);
+	}
+}
+
+// The resolver only checks, that a function has a return, paths without one end up here
+static void emit_default_return(LitEmitter* emitter, const char* type, uint64_t line) {
+	emit_default(emitter, type, line);
+	emit_byte(emitter, OP_RETURN, line);
+}
+
 static uint64_t emit_jump(LitEmitter* emitter, uint8_t instruction, uint64_t line) {
 	emit_byte(emitter, instruction, line);
 	emit_bytes(emitter, 0xff, 0xff, line);
@@ -101,7 +156,7 @@ static int resolve_local(LitEmitterFunction* function, const char* name) {
 static int add_upvalue(LitEmitter* emitter, LitEmitterFunction* function, uint8_t index, bool is_local);
 static int add_local(LitEmitter* emitter, const char* name);
 static void emit_statement(LitEmitter* emitter, LitStatement* statement);
-static bool no_pop;
+static void emit_expression(LitEmitter* emitter, LitExpression* expression);
 
 static int resolve_upvalue(LitEmitter* emitter, LitEmitterFunction* function, char* name) {
 	if (function->enclosing == NULL) {
@@ -124,11 +179,45 @@ static int resolve_upvalue(LitEmitter* emitter, LitEmitterFunction* function, ch
 	return -1;
 }
 
+/*
+ * Emits the condition and a jump over the following code if it is false,
+ * numeric comparisons get fused with the jump into a single instruction
+ */
+static uint64_t emit_condition(LitEmitter* emitter, LitExpression* condition, uint64_t line) {
+	if (condition->type == BINARY_EXPRESSION && ((LitBinaryExpression*) condition)->operands != ANY_OPERANDS) {
+		LitBinaryExpression* expr = (LitBinaryExpression*) condition;
+		bool ints = expr->operands == INT_OPERANDS;
+		uint8_t instruction = 0;
+
+		switch (expr->operator) {
+			case TOKEN_EQUAL_EQUAL: instruction = ints ? OP_EQUAL_INT_JUMP_IF_FALSE : OP_EQUAL_JUMP_IF_FALSE; break;
+			case TOKEN_BANG_EQUAL: instruction = ints ? OP_NOT_EQUAL_INT_JUMP_IF_FALSE : OP_NOT_EQUAL_JUMP_IF_FALSE; break;
+			case TOKEN_LESS: instruction = ints ? OP_LESS_INT_JUMP_IF_FALSE : OP_LESS_JUMP_IF_FALSE; break;
+			case TOKEN_LESS_EQUAL: instruction = ints ? OP_LESS_EQUAL_INT_JUMP_IF_FALSE : OP_LESS_EQUAL_JUMP_IF_FALSE; break;
+			case TOKEN_GREATER: instruction = ints ? OP_GREATER_INT_JUMP_IF_FALSE : OP_GREATER_JUMP_IF_FALSE; break;
+			case TOKEN_GREATER_EQUAL: instruction = ints ? OP_GREATER_EQUAL_INT_JUMP_IF_FALSE : OP_GREATER_EQUAL_JUMP_IF_FALSE; break;
+			default: break;
+		}
+
+		if (instruction != 0) {
+			emit_expression(emitter, expr->left);
+			emit_expression(emitter, expr->right);
+
+			return emit_jump(emitter, instruction, line);
+		}
+	}
+
+	emit_expression(emitter, condition);
+	return emit_jump(emitter, OP_JUMP_IF_FALSE, line);
+}
+
 static void emit_expression(LitEmitter* emitter, LitExpression* expression) {
 	switch (expression->type) {
 		case BINARY_EXPRESSION: {
 			LitBinaryExpression* expr = (LitBinaryExpression*) expression;
 
+			bool ints = expr->operands == INT_OPERANDS;
+
 			emit_expression(emitter, expr->left);
 			emit_expression(emitter, expr->right);
 
@@ -139,9 +228,9 @@ static void emit_expression(LitEmitter* emitter, LitExpression* expression) {
 				case TOKEN_GREATER_EQUAL: emit_byte(emitter, OP_GREATER_EQUAL, expression->line); break;
 				case TOKEN_LESS: emit_byte(emitter, OP_LESS, expression->line); break;
 				case TOKEN_LESS_EQUAL: emit_byte(emitter, OP_LESS_EQUAL, expression->line); break;
-				case TOKEN_PLUS: emit_byte(emitter, OP_ADD, expression->line); break;
-				case TOKEN_MINUS: emit_byte(emitter, OP_SUBTRACT, expression->line); break;
-				case TOKEN_STAR: emit_byte(emitter, OP_MULTIPLY, expression->line); break;
+				case TOKEN_PLUS: emit_byte(emitter, ints ? OP_ADD_INT : OP_ADD, expression->line); break;
+				case TOKEN_MINUS: emit_byte(emitter, ints ? OP_SUBTRACT_INT : OP_SUBTRACT, expression->line); break;
+				case TOKEN_STAR: emit_byte(emitter, ints ? OP_MULTIPLY_INT : OP_MULTIPLY, expression->line); break;
 				case TOKEN_SLASH: emit_byte(emitter, OP_DIVIDE, expression->line); break;
 				case TOKEN_CARET: emit_byte(emitter, OP_POWER, expression->line); break;
 				case TOKEN_CELL: emit_byte(emitter, OP_ROOT, expression->line); break;
@@ -160,7 +249,7 @@ static void emit_expression(LitEmitter* emitter, LitExpression* expression) {
 
 			switch (expr->operator) {
 				case TOKEN_BANG: emit_byte(emitter, OP_NOT, expression->line); break;
-				case TOKEN_MINUS: emit_byte(emitter, OP_NEGATE, expression->line); break;
+				case TOKEN_MINUS: emit_byte(emitter, expr->right->resolved_type != NULL && strcmp(expr->right->resolved_type, "int") == 0 ? OP_NEGATE_INT : OP_NEGATE, expression->line); break;
 				case TOKEN_CELL: emit_byte(emitter, OP_SQUARE, expression->line); break;
 			}
 
@@ -182,7 +271,7 @@ static void emit_expression(LitEmitter* emitter, LitExpression* expression) {
 				if (upvalue != -1) {
 					emit_bytes(emitter, OP_GET_UPVALUE, (uint8_t) upvalue, expression->line);
 				} else {
-					emit_bytes(emitter, OP_GET_GLOBAL, make_constant(emitter, MAKE_OBJECT_VALUE(lit_copy_string(emitter->compiler, expr->name, strlen(expr->name)))), expression->line);
+					emit_global(emitter, OP_GET_GLOBAL, expr->name, expression->line);
 				}
 			}
 
@@ -203,7 +292,7 @@ static void emit_expression(LitEmitter* emitter, LitExpression* expression) {
 				if (upvalue != -1) {
 					emit_bytes(emitter, OP_SET_UPVALUE, (uint8_t) upvalue, expression->line);
 				} else {
-					emit_bytes(emitter, OP_SET_GLOBAL, make_constant(emitter, MAKE_OBJECT_VALUE(lit_copy_string(emitter->compiler, e->name, strlen(e->name)))), expression->line);
+					emit_global(emitter, OP_SET_GLOBAL, e->name, expression->line);
 				}
 			}
 
@@ -277,7 +366,14 @@ static void emit_expression(LitEmitter* emitter, LitExpression* expression) {
 			}
 
 			emit_expression(emitter, expr->object);
+
+			if (expr->slot >= 0 && expr->slot <= UINT8_MAX) {
+				emit_bytes(emitter, OP_GET_FIELD_SLOT, (uint8_t) expr->slot, expression->line);
+				break;
+			}
+
 			emit_bytes(emitter, OP_GET_FIELD, make_constant(emitter, MAKE_OBJECT_VALUE(lit_copy_string(emitter->compiler, expr->property, strlen(expr->property)))), expression->line);
+			emit_field_cache(emitter, expression->line);
 
 			break;
 		}
@@ -291,7 +387,14 @@ static void emit_expression(LitEmitter* emitter, LitExpression* expression) {
 			}
 
 			emit_expression(emitter, expr->value);
+
+			if (expr->slot >= 0 && expr->slot <= UINT8_MAX) {
+				emit_bytes(emitter, OP_SET_FIELD_SLOT, (uint8_t) expr->slot, expression->line);
+				break;
+			}
+
 			emit_bytes(emitter, OP_SET_FIELD, make_constant(emitter, MAKE_OBJECT_VALUE(lit_copy_string(emitter->compiler, expr->property, strlen(expr->property)))), expression->line);
+			emit_field_cache(emitter, expression->line);
 
 			break;
 		}
@@ -302,6 +405,7 @@ static void emit_expression(LitEmitter* emitter, LitExpression* expression) {
 			function.function = lit_new_function(emitter->compiler);
 			function.depth = emitter->function->depth + 1;
 			function.local_count = 0;
+			function.leftovers = 0;
 			function.enclosing = emitter->function;
 			function.function = lit_new_function(emitter->compiler);
 			function.function->name = lit_copy_string(emitter->compiler, "lambda", 6);
@@ -318,6 +422,7 @@ static void emit_expression(LitEmitter* emitter, LitExpression* expression) {
 			}
 
 			emit_statement(emitter, expr->body);
+			emit_default_return(emitter, expr->return_type.type, expression->line);
 
 			if (DEBUG_TRACE_CODE) {
 				lit_trace_chunk(emitter->compiler, &function.function->chunk, "lambda");
@@ -345,9 +450,7 @@ static void emit_expression(LitEmitter* emitter, LitExpression* expression) {
 		}
 		case IF_EXPRESSION: {
 			LitIfExpression* expr = (LitIfExpression*) expression;
-			emit_expression(emitter, expr->condition);
-
-			int else_jump = emit_jump(emitter, OP_JUMP_IF_FALSE, expression->line);
+			int else_jump = emit_condition(emitter, expr->condition, expression->line);
 			emit_expression(emitter, expr->if_branch);
 
 			int end_jump = emit_jump(emitter, OP_JUMP, expression->line);
@@ -356,8 +459,7 @@ static void emit_expression(LitEmitter* emitter, LitExpression* expression) {
 			if (expr->else_if_branches != NULL) {
 				for (int i = 0; i < expr->else_if_branches->count; i++) {
 					patch_jump(emitter, else_jump);
-					emit_expression(emitter, expr->else_if_conditions->values[i]);
-					else_jump = emit_jump(emitter, OP_JUMP_IF_FALSE, expression->line);
+					else_jump = emit_condition(emitter, expr->else_if_conditions->values[i], expression->line);
 					emit_expression(emitter, expr->else_if_branches->values[i]);
 
 					end_jumps[i] = emit_jump(emitter, OP_JUMP, expression->line);
@@ -416,6 +518,19 @@ static int add_upvalue(LitEmitter* emitter, LitEmitterFunction* function, uint8_
 	return function->function->upvalue_count++;
 }
 
+// Pops the locals above count off the stack, so that their slots can be used again
+static void discard_locals(LitEmitter* emitter, int count, uint64_t line) {
+	LitEmitterFunction* function = emitter->function;
+
+	while (function->local_count > count) {
+		if (function->locals[--function->local_count].upvalue) {
+			emit_byte(emitter, OP_CLOSE_UPVALUE, line);
+		}
+
+		emit_byte(emitter, OP_POP, line);
+	}
+}
+
 static int add_local(LitEmitter* emitter, const char* name) {
 	if (emitter->function->local_count == UINT8_COUNT) {
 		error(emitter, "Too many local variables in function");
@@ -451,12 +566,11 @@ static void emit_statement(LitEmitter* emitter, LitStatement* statement) {
 			if (stmt->init != NULL) {
 				emit_expression(emitter, stmt->init);
 			} else {
-				emit_byte(emitter, OP_NIL, statement->line); // TODO: default type! (like bool is false)
+				emit_default(emitter, stmt->type, statement->line);
 			}
 
 			if (emitter->function->depth == 0) {
-				int str = make_constant(emitter, MAKE_OBJECT_VALUE(lit_copy_string(emitter->compiler, stmt->name, strlen(stmt->name))));
-				emit_bytes(emitter, OP_DEFINE_GLOBAL, (uint8_t) str, statement->line);
+				emit_global(emitter, OP_DEFINE_GLOBAL, stmt->name, statement->line);
 			} else {
 				emit_bytes(emitter, OP_SET_LOCAL, (uint8_t) add_local(emitter, stmt->name), statement->line);
 			}
@@ -466,18 +580,21 @@ static void emit_statement(LitEmitter* emitter, LitStatement* statement) {
 		case EXPRESSION_STATEMENT:
 			emit_expression(emitter, ((LitExpressionStatement*) statement)->expr);
 
-			if (!no_pop) {
+			if (!emitter->no_pop) {
 				emit_byte(emitter, OP_POP, statement->line);
 			} else {
-				no_pop = false;
+				emitter->no_pop = false;
+				emitter->function->leftovers++;
 			}
 
 			break;
 		case IF_STATEMENT: {
 			LitIfStatement* stmt = (LitIfStatement*) statement;
-			emit_expression(emitter, stmt->condition);
+			int leftovers = emitter->function->leftovers;
 
-			uint64_t else_jump = emit_jump(emitter, OP_JUMP_IF_FALSE, statement->line);
+			// The condition stays on the stack under every branch
+			emitter->function->leftovers = leftovers + 1;
+			uint64_t else_jump = emit_condition(emitter, stmt->condition, statement->line);
 			emit_statement(emitter, stmt->if_branch);
 
 			uint64_t end_jump = emit_jump(emitter, OP_JUMP, statement->line);
@@ -486,8 +603,7 @@ static void emit_statement(LitEmitter* emitter, LitStatement* statement) {
 			if (stmt->else_if_branches != NULL) {
 				for (int i = 0; i < stmt->else_if_branches->count; i++) {
 					patch_jump(emitter, else_jump);
-					emit_expression(emitter, stmt->else_if_conditions->values[i]);
-					else_jump = emit_jump(emitter, OP_JUMP_IF_FALSE, statement->line);
+					else_jump = emit_condition(emitter, stmt->else_if_conditions->values[i], statement->line);
 					emit_statement(emitter, stmt->else_if_branches->values[i]);
 
 					end_jumps[i] = emit_jump(emitter, OP_JUMP, statement->line);
@@ -507,6 +623,7 @@ static void emit_statement(LitEmitter* emitter, LitStatement* statement) {
 			}
 
 			patch_jump(emitter, end_jump);
+			emitter->function->leftovers = leftovers;
 			break;
 		}
 		case BLOCK_STATEMENT: {
@@ -525,14 +642,15 @@ static void emit_statement(LitEmitter* emitter, LitStatement* statement) {
 			uint64_t loop_start = emitter->function->function->chunk.count;
 			emitter->loop_start = loop_start; // Save for continue statements
 
-			no_pop = true;
-			emit_expression(emitter, stmt->condition);
-			uint64_t exit_jump = emit_jump(emitter, OP_JUMP_IF_FALSE, statement->line);
+			int leftovers = emitter->function->leftovers;
+			emitter->no_pop = true;
+			uint64_t exit_jump = emit_condition(emitter, stmt->condition, statement->line);
 			emit_byte(emitter, OP_POP, statement->line);
 
 			emit_statement(emitter, stmt->body);
 			emit_loop(emitter, loop_start, statement->line);
 			patch_jump(emitter, exit_jump);
+			emitter->function->leftovers = leftovers;
 
 			// Patch breaks
 			for (int i = 0; i < emitter->breaks.count; i++) {
@@ -550,6 +668,7 @@ static void emit_statement(LitEmitter* emitter, LitStatement* statement) {
 			function.function = lit_new_function(emitter->compiler);
 			function.depth = emitter->function->depth + 1;
 			function.local_count = 0;
+			function.leftovers = 0;
 			function.enclosing = emitter->function;
 			function.function = lit_new_function(emitter->compiler);
 			function.function->name = lit_copy_string(emitter->compiler, stmt->name, (int) strlen(stmt->name));
@@ -564,6 +683,11 @@ static void emit_statement(LitEmitter* emitter, LitStatement* statement) {
 			}
 
 			emit_statement(emitter, stmt->body);
+			emit_default_return(emitter, stmt->return_type.type, statement->line);
+
+			if (LIT_MATH_KERNELS) {
+				lit_emit_registers(emitter, function.function, stmt->parameters, stmt->body);
+			}
 
 			if (DEBUG_TRACE_CODE) {
 				lit_trace_chunk(emitter->compiler, &function.function->chunk, stmt->name);
@@ -578,7 +702,7 @@ static void emit_statement(LitEmitter* emitter, LitStatement* statement) {
 			}
 
 			if (emitter->function->depth == 0) {
-				emit_bytes(emitter, OP_DEFINE_GLOBAL, make_constant(emitter, MAKE_OBJECT_VALUE(lit_copy_string(emitter->compiler, stmt->name, strlen(stmt->name)))), statement->line);
+				emit_global(emitter, OP_DEFINE_GLOBAL, stmt->name, statement->line);
 			} else {
 				emit_bytes(emitter, OP_SET_LOCAL, (uint8_t) add_local(emitter, stmt->name), statement->line);
 			}
@@ -615,15 +739,7 @@ static void emit_statement(LitEmitter* emitter, LitStatement* statement) {
 					if (field->init != NULL) {
 						emit_expression(emitter, field->init);
 					} else {
-						if (strcmp(field->type, "bool") == 0) {
-							emit_byte(emitter, OP_FALSE, statement->line);
-						} else if (strcmp(field->type, "int") == 0 || strcmp(field->type, "double") == 0) {
-							emit_constant(emitter, MAKE_NUMBER_VALUE(0), statement->line);
-						} else if (strcmp(field->type, "char") == 0) {
-							emit_constant(emitter, MAKE_CHAR_VALUE('\0'), statement->line);
-						} else {
-							emit_byte(emitter, OP_NIL, statement->line);
-						}
+						emit_default(emitter, field->type, statement->line);
 					}
 
 					emit_bytes(emitter, field->is_static ? OP_DEFINE_STATIC_FIELD : OP_DEFINE_FIELD, make_constant(emitter, MAKE_OBJECT_VALUE(lit_copy_string(emitter->compiler, field->name, strlen(field->name)))), statement->line);
@@ -638,6 +754,7 @@ static void emit_statement(LitEmitter* emitter, LitStatement* statement) {
 					function.function = lit_new_function(emitter->compiler);
 					function.depth = emitter->function->depth + 1;
 					function.local_count = 1;
+					function.leftovers = 0;
 					function.enclosing = emitter->function;
 					function.function = lit_new_function(emitter->compiler);
 
@@ -664,6 +781,7 @@ static void emit_statement(LitEmitter* emitter, LitStatement* statement) {
 
 					if (method->body != NULL) {
 						emit_statement(emitter, method->body);
+						emit_default_return(emitter, method->return_type.type, statement->line);
 					}
 
 					if (DEBUG_TRACE_CODE) {
@@ -682,7 +800,7 @@ static void emit_statement(LitEmitter* emitter, LitStatement* statement) {
 				}
 			}
 
-			emit_bytes(emitter, OP_DEFINE_GLOBAL, make_constant(emitter, MAKE_OBJECT_VALUE(lit_copy_string(emitter->compiler, stmt->name, strlen(stmt->name)))), statement->line);
+			emit_global(emitter, OP_DEFINE_GLOBAL, stmt->name, statement->line);
 			break;
 		}
 		case METHOD_STATEMENT: {
@@ -697,6 +815,57 @@ static void emit_statement(LitEmitter* emitter, LitStatement* statement) {
 			emit_jump_instant(emitter, OP_JUMP, emitter->loop_start, statement->line);
 			break;
 		}
+		case TRY_STATEMENT: {
+			LitTryStatement* stmt = (LitTryStatement*) statement;
+			LitChunk* chunk = &emitter->function->function->chunk;
+			LitStatements* body = ((LitBlockStatement*) stmt->body)->statements;
+			LitStatements* catch_body = ((LitBlockStatement*) stmt->catch_body)->statements;
+
+			/*
+			 * Both blocks go without the pop at their end, and pop their own locals instead
+			 * (the catch block the error too), so that the stack and the local slots
+			 * after the statement are the same, as before it
+			 */
+			bool no_pop = emitter->no_pop;
+			emitter->no_pop = false;
+
+			int local_count = emitter->function->local_count;
+			int depth = local_count + emitter->function->leftovers;
+			uint64_t start = chunk->count;
+
+			if (body != NULL) {
+				emit_statements(emitter, body);
+			}
+
+			uint64_t end = chunk->count;
+
+			discard_locals(emitter, local_count, statement->line);
+			uint64_t end_jump = emit_jump(emitter, OP_JUMP, statement->line);
+
+			lit_chunk_add_handler(emitter->compiler, chunk, (LitHandler) { (uint32_t) start, (uint32_t) end, (uint32_t) chunk->count, (uint32_t) depth });
+			int slot = add_local(emitter, stmt->name == NULL ? "" : stmt->name);
+
+			// The error is pushed on top of the leftovers, the variable takes a slot from them like var does
+			if (slot != -1 && slot != depth) {
+				emit_bytes(emitter, OP_SET_LOCAL, (uint8_t) slot, statement->line);
+			}
+
+			if (catch_body != NULL) {
+				emit_statements(emitter, catch_body);
+			}
+
+			discard_locals(emitter, local_count, statement->line);
+			patch_jump(emitter, end_jump);
+			emitter->no_pop = no_pop;
+
+			break;
+		}
+		case THROW_STATEMENT: {
+			emit_expression(emitter, ((LitThrowStatement*) statement)->value);
+			emit_byte(emitter, OP_THROW, statement->line);
+
+			break;
+		}
 		default: {
 			printf("Unknown statement with id %i!\n", statement->type);
 			UNREACHABLE();
@@ -714,6 +883,8 @@ void lit_init_emitter(LitCompiler* compiler, LitEmitter* emitter) {
 	emitter->compiler = compiler;
 	emitter->function = NULL;
 	emitter->class = NULL;
+	emitter->field_cache_count = 0;
+	emitter->no_pop = false;
 
 	lit_init_ints(&emitter->breaks);
 }
@@ -733,6 +904,7 @@ LitFunction* lit_emit(LitEmitter* emitter, LitStatements* statements) {
 	function.function = fn;
 	function.depth = 0;
 	function.local_count = 0;
+	function.leftovers = 0;
 	function.enclosing = NULL;
 
 	emitter->function = &function;
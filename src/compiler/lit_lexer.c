@@ -136,6 +136,7 @@ static LitTokenType find_identifier_type(LitLexer* lexer) {
 		case 'c': {
 			if (lexer->current_code - lexer->start > 1) {
 				switch (lexer->start[1]) {
+					case 'a': return check_keyword(lexer, 2, 3, "tch", TOKEN_CATCH);
 					case 'l': return check_keyword(lexer, 2, 3, "ass", TOKEN_CLASS);
 					case 'o': return check_keyword(lexer, 2, 6, "ntinue", TOKEN_CONTINUE);
 				}
@@ -191,8 +192,26 @@ static LitTokenType find_identifier_type(LitLexer* lexer) {
 		case 't': {
 			if (lexer->current_code - lexer->start > 1) {
 				switch (lexer->start[1]) {
-					case 'h': return check_keyword(lexer, 2, 2, "is", TOKEN_THIS);
-					case 'r': return check_keyword(lexer, 2, 2, "ue", TOKEN_TRUE);
+					case 'h': {
+						if (lexer->current_code - lexer->start > 2) {
+							switch (lexer->start[2]) {
+								case 'i': return check_keyword(lexer, 3, 1, "s", TOKEN_THIS);
+								case 'r': return check_keyword(lexer, 3, 2, "ow", TOKEN_THROW);
+							}
+						}
+
+						break;
+					}
+					case 'r': {
+						if (lexer->current_code - lexer->start > 2) {
+							switch (lexer->start[2]) {
+								case 'u': return check_keyword(lexer, 3, 1, "e", TOKEN_TRUE);
+								case 'y': return check_keyword(lexer, 3, 0, "", TOKEN_TRY);
+							}
+						}
+
+						break;
+					}
 				}
 			}
 
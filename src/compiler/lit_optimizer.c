@@ -0,0 +1,247 @@
+#include <string.h>
+
+#include <compiler/lit_optimizer.h>
+#include <vm/lit_chunk.h>
+#include <vm/lit_memory.h>
+
+typedef struct {
+	uint8_t first;
+	uint8_t second;
+	uint8_t fused;
+} LitSuperinstruction;
+
+/*
+ * Picked from the most frequent pairs of --opcode-stats
+ * on the tests and benchmarks. The fused instruction takes the operands
+ * of the first instruction, followed by the operands of the second one.
+ */
+static LitSuperinstruction superinstructions[] = {
+	{ OP_GET_LOCAL, OP_GET_LOCAL, OP_GET_LOCAL_2 },
+	{ OP_GET_LOCAL, OP_GET_FIELD_SLOT, OP_GET_LOCAL_FIELD_SLOT },
+	{ OP_SET_LOCAL, OP_POP, OP_SET_LOCAL_POP },
+	{ OP_SET_GLOBAL, OP_POP, OP_SET_GLOBAL_POP },
+	{ OP_CONSTANT, OP_ADD, OP_ADD_CONSTANT },
+	{ OP_CONSTANT, OP_ADD_INT, OP_ADD_INT_CONSTANT },
+	{ OP_CONSTANT, OP_SUBTRACT, OP_SUBTRACT_CONSTANT },
+	{ OP_CONSTANT, OP_SUBTRACT_INT, OP_SUBTRACT_INT_CONSTANT },
+	{ OP_POP, OP_LOOP, OP_POP_LOOP },
+	{ OP_POP, OP_POP, OP_POP_2 },
+	{ OP_JUMP_IF_FALSE, OP_POP, OP_JUMP_IF_FALSE_POP },
+	{ OP_EQUAL_JUMP_IF_FALSE, OP_POP, OP_EQUAL_JUMP_IF_FALSE_POP },
+	{ OP_NOT_EQUAL_JUMP_IF_FALSE, OP_POP, OP_NOT_EQUAL_JUMP_IF_FALSE_POP },
+	{ OP_LESS_JUMP_IF_FALSE, OP_POP, OP_LESS_JUMP_IF_FALSE_POP },
+	{ OP_LESS_EQUAL_JUMP_IF_FALSE, OP_POP, OP_LESS_EQUAL_JUMP_IF_FALSE_POP },
+	{ OP_GREATER_JUMP_IF_FALSE, OP_POP, OP_GREATER_JUMP_IF_FALSE_POP },
+	{ OP_GREATER_EQUAL_JUMP_IF_FALSE, OP_POP, OP_GREATER_EQUAL_JUMP_IF_FALSE_POP },
+	{ OP_EQUAL_INT_JUMP_IF_FALSE, OP_POP, OP_EQUAL_INT_JUMP_IF_FALSE_POP },
+	{ OP_NOT_EQUAL_INT_JUMP_IF_FALSE, OP_POP, OP_NOT_EQUAL_INT_JUMP_IF_FALSE_POP },
+	{ OP_LESS_INT_JUMP_IF_FALSE, OP_POP, OP_LESS_INT_JUMP_IF_FALSE_POP },
+	{ OP_LESS_EQUAL_INT_JUMP_IF_FALSE, OP_POP, OP_LESS_EQUAL_INT_JUMP_IF_FALSE_POP },
+	{ OP_GREATER_INT_JUMP_IF_FALSE, OP_POP, OP_GREATER_INT_JUMP_IF_FALSE_POP },
+	{ OP_GREATER_EQUAL_INT_JUMP_IF_FALSE, OP_POP, OP_GREATER_EQUAL_INT_JUMP_IF_FALSE_POP }
+};
+
+#define SUPERINSTRUCTION_COUNT (sizeof(superinstructions) / sizeof(LitSuperinstruction))
+
+typedef struct {
+	uint64_t operand; // Offset of the jump operand in the new code
+	uint64_t end; // Offset of the end of the new instruction, jumps are relative to it
+	uint64_t target; // Old offset the jump goes to
+	bool backwards;
+} LitJumpPatch;
+
+// Returns 0 for non-jumps, 1 for forward jumps and -1 for OP_LOOP
+static int jump_direction(uint8_t instruction) {
+	switch (instruction) {
+		case OP_JUMP:
+		case OP_JUMP_IF_FALSE:
+		case OP_EQUAL_JUMP_IF_FALSE:
+		case OP_NOT_EQUAL_JUMP_IF_FALSE:
+		case OP_LESS_JUMP_IF_FALSE:
+		case OP_LESS_EQUAL_JUMP_IF_FALSE:
+		case OP_GREATER_JUMP_IF_FALSE:
+		case OP_GREATER_EQUAL_JUMP_IF_FALSE:
+		case OP_EQUAL_INT_JUMP_IF_FALSE:
+		case OP_NOT_EQUAL_INT_JUMP_IF_FALSE:
+		case OP_LESS_INT_JUMP_IF_FALSE:
+		case OP_LESS_EQUAL_INT_JUMP_IF_FALSE:
+		case OP_GREATER_INT_JUMP_IF_FALSE:
+		case OP_GREATER_EQUAL_INT_JUMP_IF_FALSE: return 1;
+		case OP_LOOP: return -1;
+		default: return 0;
+	}
+}
+
+static uint64_t jump_target(LitChunk* chunk, uint64_t offset) {
+	uint16_t jump = (uint16_t) ((chunk->code[offset + 1] << 8) | chunk->code[offset + 2]);
+	return jump_direction(chunk->code[offset]) == -1 ? offset + 3 - jump : offset + 3 + jump;
+}
+
+static int find_superinstruction(uint8_t first, uint8_t second) {
+	for (uint64_t i = 0; i < SUPERINSTRUCTION_COUNT; i++) {
+		if (superinstructions[i].first == first && superinstructions[i].second == second) {
+			return (int) i;
+		}
+	}
+
+	return -1;
+}
+
+// Marks every offset a jump lands on, returns false if a jump goes out of the chunk
+static bool find_jump_targets(LitChunk* chunk, bool* targets) {
+	for (uint64_t offset = 0; offset < chunk->count; offset += lit_chunk_instruction_size(chunk, offset)) {
+		if (jump_direction(chunk->code[offset]) != 0) {
+			uint64_t target = jump_target(chunk, offset);
+
+			if (target > chunk->count) {
+				return false;
+			}
+
+			targets[target] = true;
+		}
+	}
+
+	return true;
+}
+
+static void optimize_chunk(LitCompiler* compiler, LitChunk* chunk) {
+	uint64_t count = chunk->count;
+
+	if (count == 0) {
+		return;
+	}
+
+	bool* targets = ALLOCATE(compiler, bool, count + 1);
+	memset(targets, 0, sizeof(bool) * (count + 1));
+
+	if (!find_jump_targets(chunk, targets)) {
+		// Something is off with this chunk, better leave it alone
+		FREE_ARRAY(compiler, bool, targets, count + 1);
+		return;
+	}
+
+	// Handlers are entered like jump targets, and fused instructions can't stick out of try blocks
+	for (uint64_t i = 0; i < chunk->handler_count; i++) {
+		LitHandler* handler = &chunk->handlers[i];
+
+		targets[handler->start] = true;
+		targets[handler->end] = true;
+		targets[handler->handler] = true;
+	}
+
+	uint64_t* lines = ALLOCATE(compiler, uint64_t, count);
+	uint64_t* offsets = ALLOCATE(compiler, uint64_t, count + 1);
+	LitJumpPatch* patches = ALLOCATE(compiler, LitJumpPatch, count);
+	int patch_count = 0;
+
+	// Expand the run-length encoded lines, so that they can be written again
+	for (uint64_t i = 0, offset = 0; i < chunk->line_count; i += 2) {
+		for (uint64_t j = 0; j < chunk->lines[i] && offset < count; j++) {
+			lines[offset++] = chunk->lines[i + 1];
+		}
+	}
+
+	LitChunk fused;
+	lit_init_chunk(&fused);
+
+	uint64_t offset = 0;
+
+	while (offset < count) {
+		uint8_t instruction = chunk->code[offset];
+		int size = lit_chunk_instruction_size(chunk, offset);
+		uint64_t next = offset + size;
+		int superinstruction = -1;
+		int next_size = 0;
+
+		// Can't fuse with an instruction somebody jumps to
+		if (next < count && !targets[next]) {
+			superinstruction = find_superinstruction(instruction, chunk->code[next]);
+			next_size = superinstruction == -1 ? 0 : lit_chunk_instruction_size(chunk, next);
+		}
+
+		offsets[offset] = fused.count;
+		uint64_t start = fused.count;
+		uint64_t line = lines[offset];
+
+		lit_chunk_write(compiler, &fused, superinstruction == -1 ? instruction : superinstructions[superinstruction].fused, line);
+
+		for (int part = 0; part < (superinstruction == -1 ? 1 : 2); part++) {
+			uint64_t from = part == 0 ? offset : next;
+			int from_size = part == 0 ? size : next_size;
+			int direction = jump_direction(chunk->code[from]);
+
+			if (direction != 0) {
+				patches[patch_count].operand = fused.count;
+				patches[patch_count].target = jump_target(chunk, from);
+				patches[patch_count].backwards = direction == -1;
+				patch_count++;
+			}
+
+			for (int i = 1; i < from_size; i++) {
+				lit_chunk_write(compiler, &fused, chunk->code[from + i], line);
+			}
+		}
+
+		uint64_t end = fused.count;
+
+		for (int i = patch_count - 1; i >= 0 && patches[i].operand >= start; i--) {
+			patches[i].end = end;
+		}
+
+		if (superinstruction != -1) {
+			offsets[next] = start;
+			offset = next + next_size;
+		} else {
+			offset = next;
+		}
+	}
+
+	offsets[count] = fused.count;
+
+	for (int i = 0; i < patch_count; i++) {
+		LitJumpPatch* patch = &patches[i];
+		uint64_t target = offsets[patch->target];
+		uint64_t jump = patch->backwards ? patch->end - target : target - patch->end;
+
+		fused.code[patch->operand] = (uint8_t) ((jump >> 8) & 0xff);
+		fused.code[patch->operand + 1] = (uint8_t) (jump & 0xff);
+	}
+
+	for (uint64_t i = 0; i < chunk->handler_count; i++) {
+		LitHandler* handler = &chunk->handlers[i];
+
+		handler->start = (uint32_t) offsets[handler->start];
+		handler->end = (uint32_t) offsets[handler->end];
+		handler->handler = (uint32_t) offsets[handler->handler];
+	}
+
+	// Keep the constants, swap the code and lines
+	FREE_ARRAY(compiler, uint8_t, chunk->code, chunk->capacity);
+	FREE_ARRAY(compiler, uint64_t, chunk->lines, chunk->line_capacity);
+
+	chunk->code = fused.code;
+	chunk->count = fused.count;
+	chunk->capacity = fused.capacity;
+	chunk->lines = fused.lines;
+	chunk->line_count = fused.line_count;
+	chunk->line_capacity = fused.line_capacity;
+
+	lit_free_array(compiler, &fused.constants);
+
+	FREE_ARRAY(compiler, bool, targets, count + 1);
+	FREE_ARRAY(compiler, uint64_t, lines, count);
+	FREE_ARRAY(compiler, uint64_t, offsets, count + 1);
+	FREE_ARRAY(compiler, LitJumpPatch, patches, count);
+}
+
+void lit_optimize_function(LitCompiler* compiler, LitFunction* function) {
+	LitArray* constants = &function->chunk.constants;
+
+	for (int i = 0; i < constants->count; i++) {
+		if (IS_FUNCTION(constants->values[i])) {
+			lit_optimize_function(compiler, AS_FUNCTION(constants->values[i]));
+		}
+	}
+
+	optimize_chunk(compiler, &function->chunk);
+}
\ No newline at end of file
@@ -13,28 +13,29 @@ static LitStatement* parse_declaration(LitLexer* lexer);
 static LitStatement* parse_var_declaration(LitLexer* lexer, bool final);
 
 static const char* copy_string(LitLexer* lexer, LitToken* name) {
-	char* str = (char*) reallocate(lexer->compiler, NULL, 0, (size_t) name->length + (size_t) 1);
-	strncpy(str, name->start, (size_t) name->length);
-	str[name->length] = '\0';
-
-	return str;
+	return lit_arena_copy_string(&lexer->compiler->arena, name->start, (size_t) name->length);
 }
 
 static const char* copy_string_native(LitLexer* lexer, const char* name, int length) {
-	char* str = (char*) reallocate(lexer->compiler, NULL, 0, (size_t) length + (size_t) 1);
-	strncpy(str, name, (size_t) length);
-	str[length] = '\0';
-
-	return str;
+	return lit_arena_copy_string(&lexer->compiler->arena, name, (size_t) length);
 }
 
 static void error(LitLexer* lexer, LitToken *token, const char* message);
 
 static LitToken advance(LitLexer* lexer) {
+	LitPhaseStats* stats = &lexer->compiler->stats.phases[PHASE_LEX];
 	lexer->previous = lexer->current;
 
 	do {
-		lexer->current = lit_lexer_next_token(lexer);
+		if (lexer->compiler->options.time_phases) {
+			uint64_t start = lit_time_ns();
+			lexer->current = lit_lexer_next_token(lexer);
+			stats->time += lit_time_ns() - start;
+		} else {
+			lexer->current = lit_lexer_next_token(lexer);
+		}
+
+		stats->tokens++;
 
 		if (lexer->current.type == TOKEN_ERROR) {
 			error(lexer, &lexer->current, lexer->current.start);
@@ -70,6 +71,8 @@ static void synchronize(LitLexer* lexer) {
 			case TOKEN_WHILE:
 			case TOKEN_SWITCH:
 			case TOKEN_RETURN:
+			case TOKEN_TRY:
+			case TOKEN_THROW:
 				return;
 		}
 	}
@@ -127,18 +130,18 @@ static LitExpression* parse_if_expression(LitLexer* lexer, bool shrt) {
 				}
 
 				if (else_if_branches == NULL) {
-					else_if_conditions = (LitExpressions*) reallocate(lexer->compiler, NULL, 0, sizeof(LitExpressions));
+					else_if_conditions = ARENA_ALLOCATE(&lexer->compiler->arena, LitExpressions, 1);
 					lit_init_expressions(else_if_conditions);
 
-					else_if_branches = (LitExpressions*) reallocate(lexer->compiler, NULL, 0, sizeof(LitExpressions));
+					else_if_branches = ARENA_ALLOCATE(&lexer->compiler->arena, LitExpressions, 1);
 					lit_init_expressions(else_if_branches);
 				}
 
 				consume(lexer, TOKEN_LEFT_PAREN, "Expected '(' after else if");
-				lit_expressions_write(lexer->compiler, else_if_conditions, parse_expression(lexer));
+				lit_expressions_write(&lexer->compiler->arena, else_if_conditions, parse_expression(lexer));
 				consume(lexer, TOKEN_RIGHT_PAREN, "Expected ')' after else if condition");
 
-				lit_expressions_write(lexer->compiler, else_if_branches, parse_expression(lexer));
+				lit_expressions_write(&lexer->compiler->arena, else_if_branches, parse_expression(lexer));
 			} else {
 				else_branch = parse_expression(lexer);
 			}
@@ -187,7 +190,17 @@ static LitExpression* parse_primary(LitLexer* lexer) {
 	}
 
 	if (match(lexer, TOKEN_NUMBER)) {
-		return (LitExpression*) lit_make_literal_expression(lexer->compiler, MAKE_NUMBER_VALUE(strtod(lexer->previous.start, NULL)));
+		double number = strtod(lexer->previous.start, NULL);
+		LitValue value;
+
+		// 1.0 stays a double, so that it types as one
+		if (memchr(lexer->previous.start, '.', lexer->previous.length) == NULL && number >= INT32_MIN && number <= INT32_MAX) {
+			value = MAKE_INT_VALUE(number);
+		} else {
+			value = MAKE_NUMBER_VALUE(number);
+		}
+
+		return (LitExpression*) lit_make_literal_expression(lexer->compiler, value);
 	}
 
 	if (match(lexer, TOKEN_STRING)) {
@@ -216,12 +229,12 @@ static LitExpression* parse_primary(LitLexer* lexer) {
 }
 
 static LitExpression* finish_call(LitLexer* lexer, LitExpression* callee) {
-	LitExpressions* args = (LitExpressions*) reallocate(lexer->compiler, NULL, 0, sizeof(LitExpressions));
+	LitExpressions* args = ARENA_ALLOCATE(&lexer->compiler->arena, LitExpressions, 1);
 	lit_init_expressions(args);
 
 	if (lexer->current.type != TOKEN_RIGHT_PAREN) {
 		do {
-			lit_expressions_write(lexer->compiler, args, parse_expression(lexer));
+			lit_expressions_write(&lexer->compiler->arena, args, parse_expression(lexer));
 		} while (match(lexer, TOKEN_COMMA));
 	}
 
@@ -336,11 +349,11 @@ static LitExpression* parse_compound_addition(LitLexer* lexer) {
 			bin->ignore_left = true; // Because its already freed from another expression
 			operator = (LitExpression *) bin;
 		} else if (type == TOKEN_PLUS_PLUS) {
-			LitBinaryExpression* bin = lit_make_binary_expression(lexer->compiler, expression, (LitExpression *) lit_make_literal_expression(lexer->compiler, MAKE_NUMBER_VALUE(1)), TOKEN_PLUS);
+			LitBinaryExpression* bin = lit_make_binary_expression(lexer->compiler, expression, (LitExpression *) lit_make_literal_expression(lexer->compiler, MAKE_INT_VALUE(1)), TOKEN_PLUS);
 			bin->ignore_left = true; // Because its already freed from another expression
 			operator = (LitExpression *) bin;
 		} else {
-			LitBinaryExpression* bin = lit_make_binary_expression(lexer->compiler, expression, (LitExpression *) lit_make_literal_expression(lexer->compiler, MAKE_NUMBER_VALUE(1)), TOKEN_MINUS);
+			LitBinaryExpression* bin = lit_make_binary_expression(lexer->compiler, expression, (LitExpression *) lit_make_literal_expression(lexer->compiler, MAKE_INT_VALUE(1)), TOKEN_MINUS);
 			bin->ignore_left = true; // Because its already freed from another expression
 			operator = (LitExpression *) bin;
 		}
@@ -490,18 +503,18 @@ static LitStatement* parse_if_statement(LitLexer* lexer) {
 			}
 
 			if (else_if_branches == NULL) {
-				else_if_conditions = (LitExpressions*) reallocate(lexer->compiler, NULL, 0, sizeof(LitExpressions));
+				else_if_conditions = ARENA_ALLOCATE(&lexer->compiler->arena, LitExpressions, 1);
 				lit_init_expressions(else_if_conditions);
 
-				else_if_branches = (LitStatements*) reallocate(lexer->compiler, NULL, 0, sizeof(LitStatements));
+				else_if_branches = ARENA_ALLOCATE(&lexer->compiler->arena, LitStatements, 1);
 				lit_init_statements(else_if_branches);
 			}
 
 			consume(lexer, TOKEN_LEFT_PAREN, "Expected '(' after else if");
-			lit_expressions_write(lexer->compiler, else_if_conditions, parse_expression(lexer));
+			lit_expressions_write(&lexer->compiler->arena, else_if_conditions, parse_expression(lexer));
 			consume(lexer, TOKEN_RIGHT_PAREN, "Expected ')' after else if condition");
 
-				lit_statements_write(lexer->compiler, else_if_branches, parse_statement(lexer));
+				lit_statements_write(&lexer->compiler->arena, else_if_branches, parse_statement(lexer));
 		} else {
 			else_branch = parse_statement(lexer);
 		}
@@ -550,11 +563,11 @@ static LitStatement* parse_for(LitLexer* lexer) {
 	LitStatement* body = parse_statement(lexer);
 
 	if (increment != NULL) {
-		LitStatements* statements = (LitStatements*) reallocate(lexer->compiler, NULL, 0, sizeof(LitStatements));
+		LitStatements* statements = ARENA_ALLOCATE(&lexer->compiler->arena, LitStatements, 1);
 		lit_init_statements(statements);
 
-		lit_statements_write(lexer->compiler, statements, body);
-		lit_statements_write(lexer->compiler, statements, (LitStatement*) lit_make_expression_statement(lexer->compiler, increment));
+		lit_statements_write(&lexer->compiler->arena, statements, body);
+		lit_statements_write(&lexer->compiler->arena, statements, (LitStatement*) lit_make_expression_statement(lexer->compiler, increment));
 
 		body = (LitStatement*) lit_make_block_statement(lexer->compiler, statements);
 	}
@@ -566,11 +579,11 @@ static LitStatement* parse_for(LitLexer* lexer) {
 	body = (LitStatement*) lit_make_while_statement(lexer->compiler, condition, body);
 
 	if (init != NULL) {
-		LitStatements* statements = (LitStatements*) reallocate(lexer->compiler, NULL, 0, sizeof(LitStatements));
+		LitStatements* statements = ARENA_ALLOCATE(&lexer->compiler->arena, LitStatements, 1);
 		lit_init_statements(statements);
 
-		lit_statements_write(lexer->compiler, statements, init);
-		lit_statements_write(lexer->compiler, statements, body);
+		lit_statements_write(&lexer->compiler->arena, statements, init);
+		lit_statements_write(&lexer->compiler->arena, statements, body);
 
 		body = (LitStatement*) lit_make_block_statement(lexer->compiler, statements);
 	}
@@ -583,7 +596,7 @@ static LitStatement* parse_block_statement(LitLexer* lexer) {
 
 	while (!match(lexer, TOKEN_RIGHT_BRACE)) {
 		if (statements == NULL) {
-			statements = (LitStatements*) reallocate(lexer->compiler, NULL, 0, sizeof(LitStatements));
+			statements = ARENA_ALLOCATE(&lexer->compiler->arena, LitStatements, 1);
 			lit_init_statements(statements);
 		}
 
@@ -592,7 +605,7 @@ static LitStatement* parse_block_statement(LitLexer* lexer) {
 			break;
 		}
 
-		lit_statements_write(lexer->compiler, statements, parse_declaration(lexer));
+		lit_statements_write(&lexer->compiler->arena, statements, parse_declaration(lexer));
 	}
 
 	return (LitStatement*) lit_make_block_statement(lexer->compiler, statements);
@@ -623,14 +636,14 @@ static LitExpression* parse_lambda(LitLexer* lexer) {
 	LitParameters* parameters = NULL;
 
 	if (lexer->current.type != TOKEN_RIGHT_PAREN) {
-		parameters = (LitParameters*) reallocate(lexer->compiler, NULL, 0, sizeof(LitParameters));
+		parameters = ARENA_ALLOCATE(&lexer->compiler->arena, LitParameters, 1);
 		lit_init_parameters(parameters);
 
 		do {
 			char* type = parse_argument_type(lexer);
 			LitToken name = consume(lexer, TOKEN_IDENTIFIER, "Expected argument name");
 
-			lit_parameters_write(lexer->compiler, parameters, (LitParameter) {copy_string_native(lexer, name.start, name.length), type});
+			lit_parameters_write(&lexer->compiler->arena, parameters, (LitParameter) {copy_string_native(lexer, name.start, name.length), type});
 		} while (match(lexer, TOKEN_COMMA));
 	}
 
@@ -655,14 +668,14 @@ static LitStatement* parse_function_statement(LitLexer* lexer) {
 	LitParameters* parameters = NULL;
 
 	if (lexer->current.type != TOKEN_RIGHT_PAREN) {
-		parameters = (LitParameters*) reallocate(lexer->compiler, NULL, 0, sizeof(LitParameters));
+		parameters = ARENA_ALLOCATE(&lexer->compiler->arena, LitParameters, 1);
 		lit_init_parameters(parameters);
 
 		do {
 			char* type = parse_argument_type(lexer);
 			LitToken name = consume(lexer, TOKEN_IDENTIFIER, "Expected argument name");
 
-			lit_parameters_write(lexer->compiler, parameters, (LitParameter) {copy_string_native(lexer, name.start, name.length), type});
+			lit_parameters_write(&lexer->compiler->arena, parameters, (LitParameter) {copy_string_native(lexer, name.start, name.length), type});
 		} while (match(lexer, TOKEN_COMMA));
 	}
 
@@ -680,10 +693,10 @@ static LitStatement* parse_function_statement(LitLexer* lexer) {
 
 	if (match(lexer, TOKEN_EQUAL)) {
 		consume(lexer, TOKEN_GREATER, "Expected '>' after '='");
-		LitStatements* statements = (LitStatements*) reallocate(lexer->compiler, NULL, 0, sizeof(LitStatements));
+		LitStatements* statements = ARENA_ALLOCATE(&lexer->compiler->arena, LitStatements, 1);
 
 		lit_init_statements(statements);
-		lit_statements_write(lexer->compiler, statements, parse_statement(lexer));
+		lit_statements_write(&lexer->compiler->arena, statements, parse_statement(lexer));
 
 		body = lit_make_block_statement(lexer->compiler, statements);
 	} else {
@@ -710,14 +723,14 @@ static LitStatement* parse_method_statement(LitLexer* lexer, bool final, bool ab
 	LitParameters* parameters = NULL;
 
 	if (lexer->current.type != TOKEN_RIGHT_PAREN) {
-		parameters = (LitParameters*) reallocate(lexer->compiler, NULL, 0, sizeof(LitParameters));
+		parameters = ARENA_ALLOCATE(&lexer->compiler->arena, LitParameters, 1);
 		lit_init_parameters(parameters);
 
 		do {
 			char* type = parse_argument_type(lexer);
 			LitToken name = consume(lexer, TOKEN_IDENTIFIER, "Expected argument name");
 
-			lit_parameters_write(lexer->compiler, parameters, (LitParameter) {copy_string_native(lexer, name.start, name.length), type});
+			lit_parameters_write(&lexer->compiler->arena, parameters, (LitParameter) {copy_string_native(lexer, name.start, name.length), type});
 		} while (match(lexer, TOKEN_COMMA));
 	}
 
@@ -745,10 +758,10 @@ static LitStatement* parse_method_statement(LitLexer* lexer, bool final, bool ab
 		if (abstract) {
 			error(lexer, &lexer->previous, "Abstract method can't have body");
 		} else {
-			LitStatements* statements = (LitStatements*) reallocate(lexer->compiler, NULL, 0, sizeof(LitStatements));
+			LitStatements* statements = ARENA_ALLOCATE(&lexer->compiler->arena, LitStatements, 1);
 
 			lit_init_statements(statements);
-			lit_statements_write(lexer->compiler, statements, (LitStatement*) lit_make_return_statement(lexer->compiler, parse_expression(lexer)));
+			lit_statements_write(&lexer->compiler->arena, statements, (LitStatement*) lit_make_return_statement(lexer->compiler, parse_expression(lexer)));
 
 			body = lit_make_block_statement(lexer->compiler, statements);
 		}
@@ -763,6 +776,23 @@ static LitStatement* parse_return_statement(LitLexer* lexer) {
 	return (LitStatement*) lit_make_return_statement(lexer->compiler, (lexer->current.type != TOKEN_RIGHT_BRACE && lexer->current.type != TOKEN_EOF) ? parse_expression(lexer) : NULL);
 }
 
+static LitStatement* parse_try_statement(LitLexer* lexer) {
+	consume(lexer, TOKEN_LEFT_BRACE, "Expected '{' after try");
+	LitStatement* body = parse_block_statement(lexer);
+
+	consume(lexer, TOKEN_CATCH, "Expected catch after try block");
+	const char* name = NULL;
+
+	if (match(lexer, TOKEN_LEFT_PAREN)) {
+		LitToken token = consume(lexer, TOKEN_IDENTIFIER, "Expected error variable name");
+		name = copy_string(lexer, &token);
+		consume(lexer, TOKEN_RIGHT_PAREN, "Expected ')' after error variable name");
+	}
+
+	consume(lexer, TOKEN_LEFT_BRACE, "Expected '{' after catch");
+	return (LitStatement*) lit_make_try_statement(lexer->compiler, body, name, parse_block_statement(lexer));
+}
+
 static LitStatement* parse_statement(LitLexer* lexer) {
 	if (match(lexer, TOKEN_LEFT_BRACE)) {
 		return parse_block_statement(lexer);
@@ -796,6 +826,14 @@ static LitStatement* parse_statement(LitLexer* lexer) {
 		return (LitStatement *) lit_make_continue_statement(lexer->compiler);
 	}
 
+	if (match(lexer, TOKEN_TRY)) {
+		return parse_try_statement(lexer);
+	}
+
+	if (match(lexer, TOKEN_THROW)) {
+		return (LitStatement*) lit_make_throw_statement(lexer->compiler, parse_expression(lexer));
+	}
+
 	return parse_expression_statement(lexer);
 }
 
@@ -947,34 +985,34 @@ static LitStatement* parse_class_declaration(LitLexer* lexer, bool abstract, boo
 
 			if (match(lexer, TOKEN_VAR)) {
 				if (fields == NULL) {
-					fields = (LitStatements*) reallocate(lexer->compiler, NULL, 0, sizeof(LitStatements));
+					fields = ARENA_ALLOCATE(&lexer->compiler->arena, LitStatements, 1);
 					lit_init_statements(fields);
 				}
 
 				LitToken* name = &lexer->previous;
 				advance(lexer);
-				lit_statements_write(lexer->compiler, fields, parse_field_declaration(lexer, final, is_abstract, override, field_is_static, access, NULL, name));
+				lit_statements_write(&lexer->compiler->arena, fields, parse_field_declaration(lexer, final, is_abstract, override, field_is_static, access, NULL, name));
 			} else {
 				consume(lexer, TOKEN_IDENTIFIER, "Expected method name or variable type");
 
 				if (lexer->current.type != TOKEN_IDENTIFIER) {
 					if (methods == NULL) {
-						methods = (LitMethods*) reallocate(lexer->compiler, NULL, 0, sizeof(LitMethods));
+						methods = ARENA_ALLOCATE(&lexer->compiler->arena, LitMethods, 1);
 						lit_init_methods(methods);
 					}
 
-					lit_methods_write(lexer->compiler, methods, (LitMethodStatement*) parse_method_statement(lexer, final, is_abstract, override, field_is_static, access, &lexer->previous));
+					lit_methods_write(&lexer->compiler->arena, methods, (LitMethodStatement*) parse_method_statement(lexer, final, is_abstract, override, field_is_static, access, &lexer->previous));
 				} else {
 					LitToken type = lexer->previous;
 
 					if (fields == NULL) {
-						fields = (LitStatements*) reallocate(lexer->compiler, NULL, 0, sizeof(LitStatements));
+						fields = ARENA_ALLOCATE(&lexer->compiler->arena, LitStatements, 1);
 						lit_init_statements(fields);
 					}
 
 					LitToken* name = &lexer->previous;
 					advance(lexer);
-					lit_statements_write(lexer->compiler, fields, parse_field_declaration(lexer, final, is_abstract, override, field_is_static, access, &type, name));
+					lit_statements_write(&lexer->compiler->arena, fields, parse_field_declaration(lexer, final, is_abstract, override, field_is_static, access, &type, name));
 				}
 			}
 		}
@@ -1064,7 +1102,7 @@ bool lit_parse(LitCompiler* compiler, LitLexer* lexer, LitStatements* statements
 		error(lexer, &lexer->current, "Expected statement but got end of file");
 	} else {
 		while (!is_at_end(lexer)) {
-			lit_statements_write(compiler, statements, parse_declaration(lexer));
+			lit_statements_write(&compiler->arena, statements, parse_declaration(lexer));
 		}
 	}
 
@@ -0,0 +1,500 @@
+#include <string.h>
+
+#include <compiler/lit_register_emitter.h>
+#include <vm/lit_chunk.h>
+#include <vm/lit_memory.h>
+#include <lit_debug.h>
+
+/*
+ * Register layout of a frame: arguments, then one register per distinct
+ * literal (loaded once in the prologue), then locals in the order they are
+ * declared (like in the stack emitter, they are never freed), and temporaries
+ * above them, that are reused by every statement.
+ */
+
+typedef struct {
+	LitEmitter* emitter;
+	LitFunction* function;
+	LitRegisterChunk* chunk;
+
+	const char* locals[UINT8_COUNT];
+	int local_registers[UINT8_COUNT];
+	int local_count;
+
+	LitValue constants[UINT8_COUNT];
+	int constant_count;
+
+	int top; // First register, that is not taken by a local
+	int max_register;
+	bool failed;
+} LitRegisterEmitter;
+
+static void fail(LitRegisterEmitter* emitter) {
+	emitter->failed = true;
+}
+
+static void emit(LitRegisterEmitter* emitter, uint32_t instruction) {
+	lit_register_chunk_write(emitter->emitter->compiler, emitter->chunk, instruction);
+}
+
+static int new_register(LitRegisterEmitter* emitter) {
+	if (emitter->top >= UINT8_COUNT) {
+		fail(emitter);
+		return 0;
+	}
+
+	if (emitter->top > emitter->max_register) {
+		emitter->max_register = emitter->top;
+	}
+
+	return emitter->top++;
+}
+
+static int find_constant(LitRegisterEmitter* emitter, LitValue value) {
+	for (int i = 0; i < emitter->constant_count; i++) {
+		if (emitter->constants[i] == value) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+static int resolve_local(LitRegisterEmitter* emitter, const char* name) {
+	for (int i = emitter->local_count - 1; i >= 0; i--) {
+		if (strcmp(name, emitter->locals[i]) == 0) {
+			return emitter->local_registers[i];
+		}
+	}
+
+	return -1;
+}
+
+static void add_local(LitRegisterEmitter* emitter, const char* name, int reg) {
+	if (emitter->local_count == UINT8_COUNT) {
+		fail(emitter);
+		return;
+	}
+
+	emitter->locals[emitter->local_count] = name;
+	emitter->local_registers[emitter->local_count] = reg;
+	emitter->local_count++;
+}
+
+static uint64_t emit_jump(LitRegisterEmitter* emitter, LitRegisterOpCode instruction, int reg) {
+	emit(emitter, MAKE_REGISTER_ABX(instruction, reg, 0));
+	return emitter->chunk->count - 1;
+}
+
+static void patch_jump_to(LitRegisterEmitter* emitter, uint64_t jump, uint64_t target) {
+	int64_t offset = (int64_t) target - (int64_t) (jump + 1);
+
+	if (offset < INT16_MIN || offset > INT16_MAX) {
+		fail(emitter);
+		return;
+	}
+
+	uint32_t* instruction = &emitter->chunk->code[jump];
+	*instruction = MAKE_REGISTER_ABX(REGISTER_OP(*instruction), REGISTER_A(*instruction), (int16_t) offset);
+}
+
+static void patch_jump(LitRegisterEmitter* emitter, uint64_t jump) {
+	patch_jump_to(emitter, jump, emitter->chunk->count);
+}
+
+/*
+ * The first pass checks, that the function only uses supported
+ * constructs and collects the literals, that get their own registers
+ */
+
+static bool scan_expression(LitRegisterEmitter* emitter, LitExpression* expression);
+
+static bool add_constant(LitRegisterEmitter* emitter, LitValue value) {
+	if (find_constant(emitter, value) == -1) {
+		if (emitter->constant_count == UINT8_COUNT) {
+			return false;
+		}
+
+		emitter->constants[emitter->constant_count++] = value;
+	}
+
+	return true;
+}
+
+static bool scan_expressions(LitRegisterEmitter* emitter, LitExpressions* expressions) {
+	if (expressions != NULL) {
+		for (int i = 0; i < expressions->count; i++) {
+			if (!scan_expression(emitter, expressions->values[i])) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+static bool scan_expression(LitRegisterEmitter* emitter, LitExpression* expression) {
+	switch (expression->type) {
+		case BINARY_EXPRESSION: {
+			LitBinaryExpression* expr = (LitBinaryExpression*) expression;
+
+			switch (expr->operator) {
+				case TOKEN_CARET: case TOKEN_CELL: case TOKEN_IS: return false;
+				default: return scan_expression(emitter, expr->left) && scan_expression(emitter, expr->right);
+			}
+		}
+		case LITERAL_EXPRESSION: return add_constant(emitter, ((LitLiteralExpression*) expression)->value);
+		case UNARY_EXPRESSION: {
+			LitUnaryExpression* expr = (LitUnaryExpression*) expression;
+			return expr->operator != TOKEN_CELL && scan_expression(emitter, expr->right);
+		}
+		case GROUPING_EXPRESSION: return scan_expression(emitter, ((LitGroupingExpression*) expression)->expr);
+		case VAR_EXPRESSION: return true;
+		case ASSIGN_EXPRESSION: {
+			LitAssignExpression* expr = (LitAssignExpression*) expression;
+			return expr->to->type == VAR_EXPRESSION && scan_expression(emitter, expr->value);
+		}
+		case LOGICAL_EXPRESSION: {
+			LitLogicalExpression* expr = (LitLogicalExpression*) expression;
+			return scan_expression(emitter, expr->left) && scan_expression(emitter, expr->right);
+		}
+		default: return false; // Calls, closures and objects stay on the stack VM
+	}
+}
+
+static bool scan_statement(LitRegisterEmitter* emitter, LitStatement* statement) {
+	switch (statement->type) {
+		case VAR_STATEMENT: {
+			LitVarStatement* stmt = (LitVarStatement*) statement;
+
+			if (stmt->init == NULL) {
+				// Numbers start at 0, that needs a register too
+				return stmt->type != NULL && (strcmp(stmt->type, "int") == 0 || strcmp(stmt->type, "double") == 0) && add_constant(emitter, MAKE_INT_VALUE(0));
+			}
+
+			return scan_expression(emitter, stmt->init);
+		}
+		case EXPRESSION_STATEMENT: return scan_expression(emitter, ((LitExpressionStatement*) statement)->expr);
+		case IF_STATEMENT: {
+			LitIfStatement* stmt = (LitIfStatement*) statement;
+
+			if (!scan_expression(emitter, stmt->condition) || !scan_statement(emitter, stmt->if_branch)
+				|| !scan_expressions(emitter, stmt->else_if_conditions)) {
+				return false;
+			}
+
+			if (stmt->else_if_branches != NULL) {
+				for (int i = 0; i < stmt->else_if_branches->count; i++) {
+					if (!scan_statement(emitter, stmt->else_if_branches->values[i])) {
+						return false;
+					}
+				}
+			}
+
+			return stmt->else_branch == NULL || scan_statement(emitter, stmt->else_branch);
+		}
+		case BLOCK_STATEMENT: {
+			LitStatements* statements = ((LitBlockStatement*) statement)->statements;
+
+			if (statements != NULL) {
+				for (int i = 0; i < statements->count; i++) {
+					if (!scan_statement(emitter, statements->values[i])) {
+						return false;
+					}
+				}
+			}
+
+			return true;
+		}
+		case WHILE_STATEMENT: {
+			LitWhileStatement* stmt = (LitWhileStatement*) statement;
+			return scan_expression(emitter, stmt->condition) && scan_statement(emitter, stmt->body);
+		}
+		case RETURN_STATEMENT: {
+			// Empty return gives back the top of the stack on the stack VM, don't try to mimic that
+			LitReturnStatement* stmt = (LitReturnStatement*) statement;
+			return stmt->value != NULL && scan_expression(emitter, stmt->value);
+		}
+		default: return false;
+	}
+}
+
+/*
+ * The second pass emits the code, expressions return the register
+ * with their value, target is the register the value is wanted in, or -1
+ */
+
+static int emit_expression(LitRegisterEmitter* emitter, LitExpression* expression, int target);
+
+static int move_to(LitRegisterEmitter* emitter, int reg, int target) {
+	if (target == -1 || target == reg) {
+		return reg;
+	}
+
+	emit(emitter, MAKE_REGISTER_ABC(OP_R_MOVE, target, reg, 0));
+	return target;
+}
+
+static int emit_expression(LitRegisterEmitter* emitter, LitExpression* expression, int target) {
+	switch (expression->type) {
+		case BINARY_EXPRESSION: {
+			LitBinaryExpression* expr = (LitBinaryExpression*) expression;
+			LitRegisterOpCode instruction;
+			bool ints = expr->operands == INT_OPERANDS;
+
+			switch (expr->operator) {
+				case TOKEN_BANG_EQUAL: instruction = OP_R_NOT_EQUAL; break;
+				case TOKEN_EQUAL_EQUAL: instruction = OP_R_EQUAL; break;
+				case TOKEN_GREATER: instruction = OP_R_GREATER; break;
+				case TOKEN_GREATER_EQUAL: instruction = OP_R_GREATER_EQUAL; break;
+				case TOKEN_LESS: instruction = OP_R_LESS; break;
+				case TOKEN_LESS_EQUAL: instruction = OP_R_LESS_EQUAL; break;
+				case TOKEN_PLUS: instruction = ints ? OP_R_ADD_INT : OP_R_ADD; break;
+				case TOKEN_MINUS: instruction = ints ? OP_R_SUBTRACT_INT : OP_R_SUBTRACT; break;
+				case TOKEN_STAR: instruction = ints ? OP_R_MULTIPLY_INT : OP_R_MULTIPLY; break;
+				case TOKEN_SLASH: instruction = OP_R_DIVIDE; break;
+				default: fail(emitter); return 0;
+			}
+
+			int left = emit_expression(emitter, expr->left, -1);
+			int right = emit_expression(emitter, expr->right, -1);
+			int result = target == -1 ? new_register(emitter) : target;
+
+			emit(emitter, MAKE_REGISTER_ABC(instruction, result, left, right));
+			return result;
+		}
+		case LITERAL_EXPRESSION: {
+			int constant = find_constant(emitter, ((LitLiteralExpression*) expression)->value);
+			return move_to(emitter, emitter->function->arity + constant, target);
+		}
+		case UNARY_EXPRESSION: {
+			LitUnaryExpression* expr = (LitUnaryExpression*) expression;
+			int value = emit_expression(emitter, expr->right, -1);
+			int result = target == -1 ? new_register(emitter) : target;
+
+			LitRegisterOpCode instruction = OP_R_NEGATE;
+
+			if (expr->operator == TOKEN_BANG) {
+				instruction = OP_R_NOT;
+			} else if (expr->right->resolved_type != NULL && strcmp(expr->right->resolved_type, "int") == 0) {
+				instruction = OP_R_NEGATE_INT;
+			}
+
+			emit(emitter, MAKE_REGISTER_ABC(instruction, result, value, 0));
+			return result;
+		}
+		case GROUPING_EXPRESSION: return emit_expression(emitter, ((LitGroupingExpression*) expression)->expr, target);
+		case VAR_EXPRESSION: {
+			LitVarExpression* expr = (LitVarExpression*) expression;
+			int local = resolve_local(emitter, expr->name);
+
+			if (local != -1) {
+				return move_to(emitter, local, target);
+			}
+
+			int result = target == -1 ? new_register(emitter) : target;
+			emit(emitter, MAKE_REGISTER_ABX(OP_R_GET_GLOBAL, result, lit_emitter_global(emitter->emitter, expr->name)));
+
+			return result;
+		}
+		case ASSIGN_EXPRESSION: {
+			LitAssignExpression* expr = (LitAssignExpression*) expression;
+			const char* name = ((LitVarExpression*) expr->to)->name;
+			int local = resolve_local(emitter, name);
+
+			if (local != -1) {
+				emit_expression(emitter, expr->value, local);
+				return move_to(emitter, local, target);
+			}
+
+			int value = emit_expression(emitter, expr->value, target);
+			emit(emitter, MAKE_REGISTER_ABX(OP_R_SET_GLOBAL, value, lit_emitter_global(emitter->emitter, name)));
+
+			return value;
+		}
+		case LOGICAL_EXPRESSION: {
+			LitLogicalExpression* expr = (LitLogicalExpression*) expression;
+
+			// A fresh register, so that the right side still sees the old value, if the target is used in it
+			int result = new_register(emitter);
+
+			emit_expression(emitter, expr->left, result);
+			uint64_t end_jump = emit_jump(emitter, expr->operator == TOKEN_OR ? OP_R_JUMP_IF_TRUE : OP_R_JUMP_IF_FALSE, result);
+
+			emit_expression(emitter, expr->right, result);
+			patch_jump(emitter, end_jump);
+
+			return move_to(emitter, result, target);
+		}
+		default: {
+			fail(emitter);
+			return 0;
+		}
+	}
+}
+
+static void emit_statement(LitRegisterEmitter* emitter, LitStatement* statement);
+
+static void emit_statements(LitRegisterEmitter* emitter, LitStatements* statements) {
+	if (statements != NULL) {
+		for (int i = 0; i < statements->count; i++) {
+			emit_statement(emitter, statements->values[i]);
+		}
+	}
+}
+
+static uint64_t emit_condition(LitRegisterEmitter* emitter, LitExpression* condition) {
+	int top = emitter->top;
+	int value = emit_expression(emitter, condition, -1);
+
+	emitter->top = top;
+	return emit_jump(emitter, OP_R_JUMP_IF_FALSE, value);
+}
+
+static void emit_statement(LitRegisterEmitter* emitter, LitStatement* statement) {
+	int top = emitter->top;
+
+	switch (statement->type) {
+		case VAR_STATEMENT: {
+			LitVarStatement* stmt = (LitVarStatement*) statement;
+			int local = new_register(emitter);
+
+			if (stmt->init == NULL) {
+				move_to(emitter, emitter->function->arity + find_constant(emitter, MAKE_INT_VALUE(0)), local);
+			} else {
+				emit_expression(emitter, stmt->init, local);
+			}
+
+			add_local(emitter, stmt->name, local);
+
+			// The local keeps its register, only the temporaries are freed
+			emitter->top = local + 1;
+			return;
+		}
+		case EXPRESSION_STATEMENT: {
+			emit_expression(emitter, ((LitExpressionStatement*) statement)->expr, -1);
+			break;
+		}
+		case IF_STATEMENT: {
+			LitIfStatement* stmt = (LitIfStatement*) statement;
+			int else_if_count = stmt->else_if_branches == NULL ? 0 : stmt->else_if_branches->count;
+			uint64_t end_jumps[else_if_count + 1];
+
+			uint64_t else_jump = emit_condition(emitter, stmt->condition);
+			emit_statement(emitter, stmt->if_branch);
+			end_jumps[0] = emit_jump(emitter, OP_R_JUMP, 0);
+
+			for (int i = 0; i < else_if_count; i++) {
+				patch_jump(emitter, else_jump);
+				else_jump = emit_condition(emitter, stmt->else_if_conditions->values[i]);
+
+				emit_statement(emitter, stmt->else_if_branches->values[i]);
+				end_jumps[i + 1] = emit_jump(emitter, OP_R_JUMP, 0);
+			}
+
+			patch_jump(emitter, else_jump);
+
+			if (stmt->else_branch != NULL) {
+				emit_statement(emitter, stmt->else_branch);
+			}
+
+			for (int i = 0; i <= else_if_count; i++) {
+				patch_jump(emitter, end_jumps[i]);
+			}
+
+			// Branches might have declared locals
+			return;
+		}
+		case BLOCK_STATEMENT: {
+			emit_statements(emitter, ((LitBlockStatement*) statement)->statements);
+			return;
+		}
+		case WHILE_STATEMENT: {
+			LitWhileStatement* stmt = (LitWhileStatement*) statement;
+			uint64_t loop_start = emitter->chunk->count;
+			uint64_t exit_jump = emit_condition(emitter, stmt->condition);
+
+			emit_statement(emitter, stmt->body);
+			patch_jump_to(emitter, emit_jump(emitter, OP_R_JUMP, 0), loop_start);
+			patch_jump(emitter, exit_jump);
+
+			return;
+		}
+		case RETURN_STATEMENT: {
+			int value = emit_expression(emitter, ((LitReturnStatement*) statement)->value, -1);
+			emit(emitter, MAKE_REGISTER_ABC(OP_R_RETURN, value, 0, 0));
+
+			break;
+		}
+		default: {
+			fail(emitter);
+			break;
+		}
+	}
+
+	emitter->top = top;
+}
+
+bool lit_emit_registers(LitEmitter* emitter, LitFunction* function, LitParameters* parameters, LitStatement* body) {
+	// Captured variables live in upvalues, that the register VM does not know about
+	if (function->upvalue_count > 0 || body->type != BLOCK_STATEMENT) {
+		return false;
+	}
+
+	LitStatements* statements = ((LitBlockStatement*) body)->statements;
+
+	// Falling off the end returns the default value of the return type, only explicit returns are done here
+	if (statements == NULL || statements->count == 0 || statements->values[statements->count - 1]->type != RETURN_STATEMENT) {
+		return false;
+	}
+
+	LitRegisterEmitter register_emitter;
+
+	register_emitter.emitter = emitter;
+	register_emitter.function = function;
+	register_emitter.chunk = &function->registers;
+	register_emitter.local_count = 0;
+	register_emitter.constant_count = 0;
+	register_emitter.failed = false;
+
+	if (!scan_statement(&register_emitter, body)) {
+		return false;
+	}
+
+	for (int i = 0; i < function->arity; i++) {
+		add_local(&register_emitter, parameters->values[i].name, i);
+	}
+
+	register_emitter.top = function->arity + register_emitter.constant_count;
+	register_emitter.max_register = register_emitter.top - 1;
+
+	if (register_emitter.top > UINT8_COUNT) {
+		return false;
+	}
+
+	for (int i = 0; i < register_emitter.constant_count; i++) {
+		int constant = lit_chunk_add_constant(emitter->compiler, &function->chunk, register_emitter.constants[i]);
+
+		if (constant > UINT16_MAX) {
+			register_emitter.failed = true;
+			break;
+		}
+
+		emit(&register_emitter, MAKE_REGISTER_ABX(OP_R_CONSTANT, function->arity + i, constant));
+	}
+
+	emit_statement(&register_emitter, body);
+
+	if (register_emitter.failed) {
+		lit_free_register_chunk(emitter->compiler, &function->registers);
+		return false;
+	}
+
+	function->registers.register_count = register_emitter.max_register + 1;
+
+	if (DEBUG_TRACE_CODE) {
+		lit_trace_register_chunk(emitter->compiler, &function->registers, &function->chunk, function->name->chars);
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -1,6 +1,5 @@
 #include <stdio.h>
 #include <memory.h>
-#include <math.h>
 #include <string.h>
 #include <stdlib.h>
 #include <zconf.h>
@@ -47,15 +46,12 @@ static bool compare_arg(char* needed, char* given) {
 		return true;
 	}
 
-	if ((strcmp(given, "double") == 0 || strcmp(given, "int") == 0) && (strcmp(needed, "double") == 0 || strcmp(needed, "int") == 0)) {
-		return true;
-	}
-
-	return false;
+	// Not the other way round, the int opcodes trust, that int values are ints at runtime
+	return strcmp(given, "int") == 0 && strcmp(needed, "double") == 0;
 }
 
 static void push_scope(LitResolver* resolver) {
-	LitResolverLocals* table = (LitResolverLocals*) reallocate(resolver->compiler, NULL, 0, sizeof(LitResolverLocals));
+	LitResolverLocals* table = ARENA_ALLOCATE(&resolver->compiler->arena, LitResolverLocals, 1);
 	lit_init_resolver_locals(table);
 	lit_scopes_write(resolver->compiler, &resolver->scopes, table);
 
@@ -70,16 +66,8 @@ static void pop_scope(LitResolver* resolver) {
 	resolver->scopes.count --;
 	LitResolverLocals* table = resolver->scopes.values[resolver->scopes.count];
 
-	for (int i = 0; i <= table->capacity_mask; i++) {
-		LitResolverLocal* value = table->entries[i].value;
-
-		if (value != NULL) {
-			reallocate(resolver->compiler, (void*) value, sizeof(LitResolverLocal), 0);
-		}
-	}
-
+	// The table and its locals are in the arena, only the entries are on the heap
 	lit_free_resolver_locals(resolver->compiler, table);
-	reallocate(resolver->compiler, table, sizeof(LitResolverLocals), 0);
 
 	resolver->depth --;
 }
@@ -140,7 +128,7 @@ static void declare(LitResolver* resolver, const char* name) {
 		error(resolver, "Variable %s is already defined in current scope", name);
 	}
 
-	LitResolverLocal* local = (LitResolverLocal*) reallocate(resolver->compiler, NULL, 0, sizeof(LitResolverLocal));
+	LitResolverLocal* local = ARENA_ALLOCATE(&resolver->compiler->arena, LitResolverLocal, 1);
 
 	lit_init_resolver_local(local);
 	lit_resolver_locals_set(resolver->compiler, scope, str, local);
@@ -154,7 +142,7 @@ static void declare_and_define(LitResolver* resolver, const char* name, const ch
 	if (value != NULL) {
 		error(resolver, "Variable %s is already defined in current scope", name);
 	} else {
-		LitResolverLocal* local = (LitResolverLocal*) reallocate(resolver->compiler, NULL, 0, sizeof(LitResolverLocal));
+		LitResolverLocal* local = ARENA_ALLOCATE(&resolver->compiler->arena, LitResolverLocal, 1);
 		lit_init_resolver_local(local);
 
 		local->defined = true;
@@ -171,7 +159,7 @@ static LitResolverLocal* define(LitResolver* resolver, const char* name, const c
 	LitResolverLocal* value = lit_resolver_locals_get(scope, str);
 
 	if (value == NULL) {
-		LitResolverLocal* local = (LitResolverLocal*) reallocate(resolver->compiler, NULL, 0, sizeof(LitResolverLocal));
+		LitResolverLocal* local = ARENA_ALLOCATE(&resolver->compiler->arena, LitResolverLocal, 1);
 
 		lit_init_resolver_local(local);
 
@@ -195,7 +183,13 @@ static const char* resolve_var_statement(LitResolver* resolver, LitVarStatement*
 	const char *type = statement->type == NULL ? "void" : statement->type;
 
 	if (statement->init != NULL) {
-		type = (char*) resolve_expression(resolver, statement->init);
+		const char* given = resolve_expression(resolver, statement->init);
+
+		if (statement->type == NULL) {
+			type = given;
+		} else if (!compare_arg((char*) statement->type, (char*) given)) {
+			error(resolver, "Can't assign %s value to a %s var", given, statement->type);
+		}
 	} else if (statement->final) {
 		error(resolver, "Final variable must be assigned a value in the declaration!");
 	}
@@ -272,11 +266,11 @@ static void resolve_function(LitResolver* resolver, LitParameters* parameters, L
 			LitBlockStatement* block = (LitBlockStatement*) body;
 
 			if (block->statements == NULL) {
-				block->statements = (LitStatements*) reallocate(resolver->compiler, NULL, 0, sizeof(LitStatements));
+				block->statements = ARENA_ALLOCATE(&resolver->compiler->arena, LitStatements, 1);
 				lit_init_statements(block->statements);
 			}
 
-			lit_statements_write(resolver->compiler, block->statements, (LitStatement*) lit_make_return_statement(resolver->compiler, NULL));
+			lit_statements_write(&resolver->compiler->arena, block->statements, (LitStatement*) lit_make_return_statement(resolver->compiler, NULL));
 		}
 	}
 
@@ -326,13 +320,13 @@ static const char* get_function_signature(LitResolver* resolver, LitParameters*
 static void resolve_function_statement(LitResolver* resolver, LitFunctionStatement* statement) {
 	const char* type = get_function_signature(resolver, statement->parameters, &statement->return_type);
 
-	LitFunctionStatement* last = resolver->function;
-	resolver->function = statement;
+	LitParameter* last = resolver->return_type;
+	resolver->return_type = &statement->return_type;
 
 	declare_and_define(resolver, statement->name, type);
 	resolve_function(resolver, statement->parameters, &statement->return_type, statement->body, "Missing return statement in function %s", statement->name);
 
-	resolver->function = last;
+	resolver->return_type = last;
 
 	lit_strings_write(resolver->compiler, &resolver->allocated_strings, (char*) type);
 
@@ -345,10 +339,10 @@ static void resolve_return_statement(LitResolver* resolver, LitReturnStatement*
 	char* type = (char*) (statement->value == NULL ? "void" : resolve_expression(resolver, statement->value));
 	resolver->had_return = true;
 
-	if (resolver->function == NULL) {
+	if (resolver->return_type == NULL) {
 		error(resolver, "Can't return from top-level code!");
-	} else if (!compare_arg((char*) resolver->function->return_type.type, type)) {
-		error(resolver, "Return type mismatch: required %s, but got %s", resolver->function->return_type.type, type);
+	} else if (!compare_arg((char*) resolver->return_type->type, type)) {
+		error(resolver, "Return type mismatch: required %s, but got %s", resolver->return_type->type, type);
 	}
 }
 
@@ -409,11 +403,11 @@ static void resolve_method_statement(LitResolver* resolver, LitMethodStatement*
 	resolve_type(resolver, statement->return_type.type);
 
 	if (statement->body != NULL) {
-		LitFunctionStatement *enclosing = resolver->function;
+		LitParameter* enclosing = resolver->return_type;
 
-		resolver->function = (LitFunctionStatement *) statement;
+		resolver->return_type = &statement->return_type;
 		resolve_statement(resolver, statement->body);
-		resolver->function = enclosing;
+		resolver->return_type = enclosing;
 	}
 
 	if (!resolver->had_return) {
@@ -423,11 +417,11 @@ static void resolve_method_statement(LitResolver* resolver, LitMethodStatement*
 			LitBlockStatement* block = (LitBlockStatement*) statement->body;
 
 			if (block->statements == NULL) {
-				block->statements = (LitStatements*) reallocate(resolver->compiler, NULL, 0, sizeof(LitStatements));
+				block->statements = ARENA_ALLOCATE(&resolver->compiler->arena, LitStatements, 1);
 				lit_init_statements(block->statements);
 			}
 
-			lit_statements_write(resolver->compiler, block->statements, (LitStatement*) lit_make_return_statement(resolver->compiler, NULL));
+			lit_statements_write(&resolver->compiler->arena, block->statements, (LitStatement*) lit_make_return_statement(resolver->compiler, NULL));
 		}
 	}
 
@@ -505,6 +499,7 @@ static void resolve_class_statement(LitResolver* resolver, LitClassStatement* st
 	class->is_static = statement->is_static;
 	class->final = statement->final;
 	class->abstract = statement->abstract;
+	class->field_count = super == NULL ? 0 : super->field_count;
 
 	lit_init_resolver_methods(&class->methods);
 	lit_init_resolver_methods(&class->static_methods);
@@ -553,6 +548,14 @@ static void resolve_class_statement(LitResolver* resolver, LitClassStatement* st
 				}
 			}
 
+			if (field->is_static) {
+				field->slot = -1;
+			} else {
+				// Must match the order, in what OP_DEFINE_FIELD lays out the instance
+				LitResolverField* inherited = lit_resolver_fields_get(&class->fields, name);
+				field->slot = inherited == NULL ? class->field_count++ : inherited->slot;
+			}
+
 			lit_resolver_fields_set(resolver->compiler, field->is_static ? &class->static_fields : &class->fields, name, field);
 		}
 	}
@@ -630,6 +633,27 @@ static void resolve_continue_statement(LitResolver* resolver, LitContinueStateme
 	}
 }
 
+static void resolve_try_statement(LitResolver* resolver, LitTryStatement* statement) {
+	resolve_statement(resolver, statement->body);
+	push_scope(resolver);
+
+	// Runtime errors carry only their message, so that is what gets caught
+	if (statement->name != NULL) {
+		define(resolver, statement->name, "String", false);
+	}
+
+	resolve_statement(resolver, statement->catch_body);
+	pop_scope(resolver);
+}
+
+static void resolve_throw_statement(LitResolver* resolver, LitThrowStatement* statement) {
+	const char* type = resolve_expression(resolver, statement->value);
+
+	if (type != NULL && !compare_arg("String", (char*) type)) {
+		error(resolver, "Can't throw %s value, only String", type);
+	}
+}
+
 static void resolve_statement(LitResolver* resolver, LitStatement* statement) {
 	switch (statement->type) {
 		case VAR_STATEMENT: resolve_var_statement(resolver, (LitVarStatement*) statement); break;
@@ -647,6 +671,8 @@ static void resolve_statement(LitResolver* resolver, LitStatement* statement) {
 		}
 		case BREAK_STATEMENT: resolve_break_statement(resolver, (LitBreakStatement*) statement); break;
 		case CONTINUE_STATEMENT: resolve_continue_statement(resolver, (LitContinueStatement*) statement); break;
+		case TRY_STATEMENT: resolve_try_statement(resolver, (LitTryStatement*) statement); break;
+		case THROW_STATEMENT: resolve_throw_statement(resolver, (LitThrowStatement*) statement); break;
 		default: {
 			printf("Unknown statement with id %i!\n", statement->type);
 			UNREACHABLE();
@@ -693,21 +719,32 @@ static const char* resolve_binary_expression(LitResolver* resolver, LitBinaryExp
 	} else {
 		if (!((strcmp(a, "int") == 0 || strcmp(a, "double") == 0) && (strcmp(b, "int") == 0 || strcmp(b, "double") == 0))) {
 			error(resolver, "Can't perform binary operation on %s and %s", a, b);
+			return a;
 		}
 
-		return a;
+		bool ints = strcmp(a, "int") == 0 && strcmp(b, "int") == 0;
+		expression->operands = ints ? INT_OPERANDS : DOUBLE_OPERANDS;
+
+		switch (expression->operator) {
+			case TOKEN_EQUAL_EQUAL:
+			case TOKEN_BANG_EQUAL:
+			case TOKEN_LESS:
+			case TOKEN_LESS_EQUAL:
+			case TOKEN_GREATER:
+			case TOKEN_GREATER_EQUAL: return "bool";
+			// Only these have int opcodes, the others can give fractions
+			case TOKEN_PLUS:
+			case TOKEN_MINUS:
+			case TOKEN_STAR: return ints ? "int" : "double";
+			default: return "double";
+		}
 	}
 }
 
 static const char* resolve_literal_expression(LitLiteralExpression* expression) {
-	if (IS_NUMBER(expression->value)) {
-		double number = AS_NUMBER(expression->value);
-		double temp;
-
-		if (modf(number, &temp) == 0) {
-			return "int";
-		}
-
+	if (IS_INT(expression->value)) {
+		return "int";
+	} else if (IS_NUMBER(expression->value)) {
 		return "double";
 	} else if (IS_BOOL(expression->value)) {
 		return "bool";
@@ -730,7 +767,11 @@ static const char* resolve_unary_expression(LitResolver* resolver, LitUnaryExpre
 		return "error";
 	}
 
-	return type;
+	switch (expression->operator) {
+		case TOKEN_BANG: return "bool";
+		case TOKEN_CELL: return "double";
+		default: return type;
+	}
 }
 
 static const char* resolve_grouping_expression(LitResolver* resolver, LitGroupingExpression* expression) {
@@ -780,14 +821,12 @@ static const char* resolve_assign_expression(LitResolver* resolver, LitAssignExp
 }
 
 static const char* resolve_logical_expression(LitResolver* resolver, LitLogicalExpression* expression) {
+	resolve_expression(resolver, expression->left);
 	return resolve_expression(resolver, expression->right);
 }
 
-static char* last_string;
-static bool had_template;
-
-static char* tok(char* string) {
-	char* start = string == NULL ? last_string : string;
+static char* tok(LitResolver* resolver, char* string) {
+	char* start = string == NULL ? resolver->last_string : string;
 
 	if (!*start || *start == '>') {
 		return NULL;
@@ -811,10 +850,10 @@ static char* tok(char* string) {
 		}
 	}
 
-	had_template = (*start == '>');
+	resolver->had_template = (*start == '>');
 
 	*start = '\0';
-	last_string = start + 1;
+	resolver->last_string = start + 1;
 
 	return where_started;
 }
@@ -857,6 +896,9 @@ static const char* resolve_call_expression(LitResolver* resolver, LitCallExpress
 			} else if (cl->abstract) {
 				error(resolver, "Can not create an instance of an abstract class %s", cl->name->chars);
 			}
+
+			// Arguments of init are not checked, but still need their types
+			resolve_expressions(resolver, expression->args);
 		} else if (strcmp_ignoring(type, "Function<") != 0) {
 			error(resolver, "Can't call non-function variable %s with type %s", name, type);
 		} else {
@@ -870,18 +912,22 @@ static const char* resolve_call_expression(LitResolver* resolver, LitCallExpress
 			strncpy(tp, type, len);
 			tp[len] = '\0';
 
-			char* arg = tok(&tp[9]);
+			char* arg = tok(resolver, &tp[9]);
 			int i = 0;
 			int cn = expression->args->count;
 
 			while (arg != NULL) {
-				if (!had_template && i >= cn) {
+				if (!resolver->had_template && i >= cn) {
 					error(resolver, "Not enough arguments for %s, expected %i, got %i, for function %s", type, i + 1, cn, name);
 					break;
 				}
 
-				if (!had_template) {
+				if (!resolver->had_template) {
+					// Arguments might be calls too, and they reuse the tokenizer state
+					char* saved_string = resolver->last_string;
 					const char* given_type = resolve_expression(resolver, expression->args->values[i]);
+					resolver->last_string = saved_string;
+					resolver->had_template = false;
 
 					if (given_type == NULL) {
 						error(resolver, "Got null type resolved somehow");
@@ -899,7 +945,7 @@ static const char* resolve_call_expression(LitResolver* resolver, LitCallExpress
 					break;
 				}
 
-				arg = tok(NULL);
+				arg = tok(resolver, NULL);
 				i++;
 
 				if (arg == NULL) {
@@ -976,6 +1022,8 @@ static const char* resolve_get_expression(LitResolver* resolver, LitGetExpressio
 		return method->signature;
 	} else if (should_be_static && !field->is_static) {
 		error(resolver, "Can't access non-static fields from class call");
+	} else if (!should_be_static) {
+		expression->slot = field->slot;
 	}
 
 	return field->type;
@@ -1048,17 +1096,18 @@ static const char* resolve_set_expression(LitResolver* resolver, LitSetExpressio
 			error(resolver, "Field %s is final, can't assign a value to it", expression->property);
 		}
 
+		expression->slot = field->slot;
 		return field->type;
 	}
 }
 
 static const char* resolve_lambda_expression(LitResolver* resolver, LitLambdaExpression* expression) {
 	const char* type = get_function_signature(resolver, expression->parameters, &expression->return_type);
-	LitFunctionStatement* last = resolver->function;
+	LitParameter* last = resolver->return_type;
 
-	resolver->function = (LitFunctionStatement*) expression; // HACKZ
+	resolver->return_type = &expression->return_type;
 	resolve_function(resolver, expression->parameters, &expression->return_type, expression->body, "Missing return statement in lambda", NULL);
-	resolver->function = last;
+	resolver->return_type = last;
 
 	lit_strings_write(resolver->compiler, &resolver->allocated_strings, (char*) type);
 
@@ -1122,7 +1171,7 @@ static const char* resolve_if_expression(LitResolver* resolver, LitIfExpression*
 	return type;
 }
 
-static const char* resolve_expression(LitResolver* resolver, LitExpression* expression) {
+static const char* resolve_expression_type(LitResolver* resolver, LitExpression* expression) {
 	switch (expression->type) {
 		case BINARY_EXPRESSION: return resolve_binary_expression(resolver, (LitBinaryExpression*) expression);
 		case LITERAL_EXPRESSION: return resolve_literal_expression((LitLiteralExpression*) expression);
@@ -1147,6 +1196,13 @@ static const char* resolve_expression(LitResolver* resolver, LitExpression* expr
 	return "error";
 }
 
+static const char* resolve_expression(LitResolver* resolver, LitExpression* expression) {
+	const char* type = resolve_expression_type(resolver, expression);
+	expression->resolved_type = type;
+
+	return type;
+}
+
 static void resolve_expressions(LitResolver* resolver, LitExpressions* expressions) {
 	for (int i = 0; i < expressions->count; i++) {
 		resolve_expression(resolver, expressions->values[i]);
@@ -1162,10 +1218,10 @@ void lit_init_resolver(LitResolver* resolver) {
 	resolver->loop = NULL;
 	resolver->had_error = false;
 	resolver->depth = 0;
-	resolver->function = NULL;
+	resolver->return_type = NULL;
 	resolver->class = NULL;
-
-	push_scope(resolver); // Global scope
+	resolver->last_string = NULL;
+	resolver->had_template = false;
 
 	define_type(resolver, "int");
 	define_type(resolver, "bool");
@@ -1180,13 +1236,11 @@ void lit_init_resolver(LitResolver* resolver) {
 }
 
 void lit_free_resolver(LitResolver* resolver) {
-	pop_scope(resolver);
-
 	for (int i = 0; i <= resolver->externals.capacity_mask; i++) {
 		LitResolverLocal* local = resolver->externals.entries[i].value;
 
 		if (local != NULL) {
-			reallocate(resolver->compiler, (void*) local->type, strlen(local->type), 0);
+			reallocate(resolver->compiler, (void*) local->type, strlen(local->type) + 1, 0);
 			reallocate(resolver->compiler, (void*) local, sizeof(LitResolverLocal), 0);
 		}
 	}
@@ -1201,7 +1255,8 @@ void lit_free_resolver(LitResolver* resolver) {
 				for (int j = 0; j <= type->fields.capacity_mask; j++) {
 					LitResolverField *a = type->fields.entries[j].value;
 
-					if (a != NULL) {
+					// Inherited fields are owned by the super class
+					if (a != NULL && (type->super == NULL || lit_resolver_fields_get(&type->super->fields, type->fields.entries[j].key) != a)) {
 						reallocate(resolver->compiler, (void *) a, sizeof(LitResolverField), 0);
 					}
 				}
@@ -1221,7 +1276,7 @@ void lit_free_resolver(LitResolver* resolver) {
 				for (int j = 0; j <= type->methods.capacity_mask; j++) {
 					LitResolverMethod *a = type->methods.entries[j].value;
 
-					if (a != NULL) {
+					if (a != NULL && (type->super == NULL || lit_resolver_methods_get(&type->super->methods, type->methods.entries[j].key) != a)) {
 						lit_free_resolver_method(resolver->compiler, a);
 					}
 				}
@@ -1237,6 +1292,14 @@ void lit_free_resolver(LitResolver* resolver) {
 				}
 			}
 
+		}
+	}
+
+	// Sub classes check their super tables above, so those are freed separately
+	for (int i = 0; i <= resolver->classes.capacity_mask; i++) {
+		LitType* type = resolver->classes.entries[i].value;
+
+		if (type != NULL) {
 			lit_free_resolver_fields(resolver->compiler, &type->fields);
 			lit_free_resolver_fields(resolver->compiler, &type->static_fields);
 			lit_free_resolver_methods(resolver->compiler, &type->methods);
@@ -1259,7 +1322,10 @@ void lit_free_resolver(LitResolver* resolver) {
 }
 
 bool lit_resolve(LitCompiler* compiler, LitStatements* statements) {
+	push_scope(&compiler->resolver); // Global scope
 	resolve_statements(&compiler->resolver, statements);
+	pop_scope(&compiler->resolver);
+
 	return compiler->resolver.had_error;
 }
 
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <lit_debug.h>
 
@@ -310,6 +311,29 @@ void lit_trace_statement(LitMemManager* manager, LitStatement* statement, int de
 				printf("\"type\" : \"continue\"\n");
 				break;
 			}
+			case TRY_STATEMENT: {
+				LitTryStatement* try_statement = (LitTryStatement*) statement;
+
+				printf("\"type\" : \"try\",\n");
+				printf("\"body\" : ");
+				lit_trace_statement(manager, try_statement->body, depth + 1);
+				printf(",\n");
+
+				printf("\"name\" : \"%s\",\n", try_statement->name == NULL ? "" : try_statement->name);
+				printf("\"catch\" : ");
+				lit_trace_statement(manager, try_statement->catch_body, depth + 1);
+
+				printf("\n");
+				break;
+			}
+			case THROW_STATEMENT: {
+				printf("\"type\" : \"throw\",\n");
+				printf("\"value\" : ");
+				lit_trace_expression(manager, ((LitThrowStatement*) statement)->value, depth + 1);
+
+				printf("\n");
+				break;
+			}
 			default: {
 				printf("Statement with id %i has no pretty-printer!\n", statement->type);
 				UNREACHABLE();
@@ -557,6 +581,18 @@ static int byte_instruction(const char* name, LitChunk* chunk, int offset) {
 	return offset + 2;
 }
 
+static int two_bytes_instruction(const char* name, LitChunk* chunk, int offset) {
+	printf("%-16s %4d %4d\n", name, chunk->code[offset + 1], chunk->code[offset + 2]);
+	return offset + 3;
+}
+
+static int short_instruction(const char* name, LitChunk* chunk, int offset) {
+	uint16_t slot = (uint16_t) (chunk->code[offset + 1] << 8);
+	slot |= chunk->code[offset + 2];
+	printf("%-16s %4d\n", name, slot);
+	return offset + 3;
+}
+
 static int jump_instruction(const char* name, int sign, LitChunk* chunk, int offset) {
 	uint16_t jump = (uint16_t)(chunk->code[offset + 1] << 8);
 	jump |= chunk->code[offset + 2];
@@ -564,6 +600,15 @@ static int jump_instruction(const char* name, int sign, LitChunk* chunk, int off
 	return offset + 3;
 }
 
+static int field_instruction(LitMemManager* manager, const char* name, LitChunk* chunk, int offset) {
+	uint8_t constant = chunk->code[offset + 1];
+	uint16_t site = (uint16_t) (chunk->code[offset + 2] << 8);
+	site |= chunk->code[offset + 3];
+
+	printf("%-16s %4d '%s' @%d\n", name, constant, lit_to_string(manager, chunk->constants.values[constant]), site);
+	return offset + 4;
+}
+
 int lit_disassemble_instruction(LitMemManager* manager, LitChunk* chunk, int offset) {
 	printf("%04d ", offset);
 	uint8_t instruction = chunk->code[offset];
@@ -575,6 +620,40 @@ int lit_disassemble_instruction(LitMemManager* manager, LitChunk* chunk, int off
 		case OP_ROOT: return simple_instruction("OP_ROOT", offset);
 		case OP_SQUARE: return simple_instruction("OP_SQUARE", offset);
 		case OP_IS: return simple_instruction("OP_IS", offset);
+		case OP_ADD_INT: return simple_instruction("OP_ADD_INT", offset);
+		case OP_SUBTRACT_INT: return simple_instruction("OP_SUBTRACT_INT", offset);
+		case OP_MULTIPLY_INT: return simple_instruction("OP_MULTIPLY_INT", offset);
+		case OP_GET_LOCAL_2: return two_bytes_instruction("OP_GET_LOCAL_2", chunk, offset);
+		case OP_GET_LOCAL_FIELD_SLOT: return two_bytes_instruction("OP_GET_LOCAL_FIELD_SLOT", chunk, offset);
+		case OP_SET_LOCAL_POP: return byte_instruction("OP_SET_LOCAL_POP", chunk, offset);
+		case OP_SET_GLOBAL_POP: return short_instruction("OP_SET_GLOBAL_POP", chunk, offset);
+		case OP_ADD_CONSTANT: return constant_instruction(manager, "OP_ADD_CONSTANT", chunk, offset);
+		case OP_SUBTRACT_CONSTANT: return constant_instruction(manager, "OP_SUBTRACT_CONSTANT", chunk, offset);
+		case OP_POP_2: return simple_instruction("OP_POP_2", offset);
+		case OP_THROW: return simple_instruction("OP_THROW", offset);
+		case OP_NEGATE_INT: return simple_instruction("OP_NEGATE_INT", offset);
+		case OP_ADD_INT_CONSTANT: return constant_instruction(manager, "OP_ADD_INT_CONSTANT", chunk, offset);
+		case OP_SUBTRACT_INT_CONSTANT: return constant_instruction(manager, "OP_SUBTRACT_INT_CONSTANT", chunk, offset);
+		case OP_EQUAL_INT_JUMP_IF_FALSE: return jump_instruction("OP_EQUAL_INT_JUMP_IF_FALSE", 1, chunk, offset);
+		case OP_NOT_EQUAL_INT_JUMP_IF_FALSE: return jump_instruction("OP_NOT_EQUAL_INT_JUMP_IF_FALSE", 1, chunk, offset);
+		case OP_LESS_INT_JUMP_IF_FALSE: return jump_instruction("OP_LESS_INT_JUMP_IF_FALSE", 1, chunk, offset);
+		case OP_LESS_EQUAL_INT_JUMP_IF_FALSE: return jump_instruction("OP_LESS_EQUAL_INT_JUMP_IF_FALSE", 1, chunk, offset);
+		case OP_GREATER_INT_JUMP_IF_FALSE: return jump_instruction("OP_GREATER_INT_JUMP_IF_FALSE", 1, chunk, offset);
+		case OP_GREATER_EQUAL_INT_JUMP_IF_FALSE: return jump_instruction("OP_GREATER_EQUAL_INT_JUMP_IF_FALSE", 1, chunk, offset);
+		case OP_EQUAL_INT_JUMP_IF_FALSE_POP: return jump_instruction("OP_EQUAL_INT_JUMP_IF_FALSE_POP", 1, chunk, offset);
+		case OP_NOT_EQUAL_INT_JUMP_IF_FALSE_POP: return jump_instruction("OP_NOT_EQUAL_INT_JUMP_IF_FALSE_POP", 1, chunk, offset);
+		case OP_LESS_INT_JUMP_IF_FALSE_POP: return jump_instruction("OP_LESS_INT_JUMP_IF_FALSE_POP", 1, chunk, offset);
+		case OP_LESS_EQUAL_INT_JUMP_IF_FALSE_POP: return jump_instruction("OP_LESS_EQUAL_INT_JUMP_IF_FALSE_POP", 1, chunk, offset);
+		case OP_GREATER_INT_JUMP_IF_FALSE_POP: return jump_instruction("OP_GREATER_INT_JUMP_IF_FALSE_POP", 1, chunk, offset);
+		case OP_GREATER_EQUAL_INT_JUMP_IF_FALSE_POP: return jump_instruction("OP_GREATER_EQUAL_INT_JUMP_IF_FALSE_POP", 1, chunk, offset);
+		case OP_POP_LOOP: return jump_instruction("OP_POP_LOOP", -1, chunk, offset);
+		case OP_JUMP_IF_FALSE_POP: return jump_instruction("OP_JUMP_IF_FALSE_POP", 1, chunk, offset);
+		case OP_EQUAL_JUMP_IF_FALSE_POP: return jump_instruction("OP_EQUAL_JUMP_IF_FALSE_POP", 1, chunk, offset);
+		case OP_NOT_EQUAL_JUMP_IF_FALSE_POP: return jump_instruction("OP_NOT_EQUAL_JUMP_IF_FALSE_POP", 1, chunk, offset);
+		case OP_LESS_JUMP_IF_FALSE_POP: return jump_instruction("OP_LESS_JUMP_IF_FALSE_POP", 1, chunk, offset);
+		case OP_LESS_EQUAL_JUMP_IF_FALSE_POP: return jump_instruction("OP_LESS_EQUAL_JUMP_IF_FALSE_POP", 1, chunk, offset);
+		case OP_GREATER_JUMP_IF_FALSE_POP: return jump_instruction("OP_GREATER_JUMP_IF_FALSE_POP", 1, chunk, offset);
+		case OP_GREATER_EQUAL_JUMP_IF_FALSE_POP: return jump_instruction("OP_GREATER_EQUAL_JUMP_IF_FALSE_POP", 1, chunk, offset);
 		case OP_SUBTRACT: return simple_instruction("OP_SUBTRACT", offset);
 		case OP_MULTIPLY: return simple_instruction("OP_MULTIPLY", offset);
 		case OP_DIVIDE: return simple_instruction("OP_DIVIDE", offset);
@@ -591,9 +670,9 @@ int lit_disassemble_instruction(LitMemManager* manager, LitChunk* chunk, int off
 		case OP_GREATER_EQUAL: return simple_instruction("OP_GREATER_EQUAL", offset);
 		case OP_LESS_EQUAL: return simple_instruction("OP_LESS_EQUAL", offset);
 		case OP_CALL: return simple_instruction("OP_CALL", offset) + 1;
-		case OP_DEFINE_GLOBAL: return constant_instruction(manager, "OP_DEFINE_GLOBAL", chunk, offset);
-		case OP_GET_GLOBAL: return constant_instruction(manager, "OP_GET_GLOBAL", chunk, offset);
-		case OP_SET_GLOBAL: return constant_instruction(manager, "OP_SET_GLOBAL", chunk, offset);
+		case OP_DEFINE_GLOBAL: return short_instruction("OP_DEFINE_GLOBAL", chunk, offset);
+		case OP_GET_GLOBAL: return short_instruction("OP_GET_GLOBAL", chunk, offset);
+		case OP_SET_GLOBAL: return short_instruction("OP_SET_GLOBAL", chunk, offset);
 		case OP_GET_LOCAL: return byte_instruction("OP_GET_LOCAL", chunk, offset);
 		case OP_SET_LOCAL: return byte_instruction("OP_SET_LOCAL", chunk,offset);
 		case OP_GET_UPVALUE: return byte_instruction("OP_GET_UPVALUE", chunk, offset);
@@ -602,16 +681,24 @@ int lit_disassemble_instruction(LitMemManager* manager, LitChunk* chunk, int off
 		case OP_JUMP: return jump_instruction("OP_JUMP", 1, chunk, offset);
 		case OP_JUMP_IF_FALSE: return jump_instruction("OP_JUMP_IF_FALSE", 1, chunk, offset);
 		case OP_LOOP: return jump_instruction("OP_LOOP", -1, chunk, offset);
+		case OP_EQUAL_JUMP_IF_FALSE: return jump_instruction("OP_EQUAL_JUMP_IF_FALSE", 1, chunk, offset);
+		case OP_NOT_EQUAL_JUMP_IF_FALSE: return jump_instruction("OP_NOT_EQUAL_JUMP_IF_FALSE", 1, chunk, offset);
+		case OP_LESS_JUMP_IF_FALSE: return jump_instruction("OP_LESS_JUMP_IF_FALSE", 1, chunk, offset);
+		case OP_LESS_EQUAL_JUMP_IF_FALSE: return jump_instruction("OP_LESS_EQUAL_JUMP_IF_FALSE", 1, chunk, offset);
+		case OP_GREATER_JUMP_IF_FALSE: return jump_instruction("OP_GREATER_JUMP_IF_FALSE", 1, chunk, offset);
+		case OP_GREATER_EQUAL_JUMP_IF_FALSE: return jump_instruction("OP_GREATER_EQUAL_JUMP_IF_FALSE", 1, chunk, offset);
 		case OP_CLASS: return constant_instruction(manager, "OP_CLASS", chunk, offset);
 		case OP_SUBCLASS: return constant_instruction(manager, "OP_SUBCLASS", chunk, offset);
 		case OP_METHOD: return constant_instruction(manager, "OP_METHOD", chunk, offset);
-		case OP_GET_FIELD: return constant_instruction(manager, "OP_GET_FIELD", chunk, offset);
-		case OP_SET_FIELD: return constant_instruction(manager, "OP_SET_FIELD", chunk, offset);
+		case OP_GET_FIELD: return field_instruction(manager, "OP_GET_FIELD", chunk, offset);
+		case OP_SET_FIELD: return field_instruction(manager, "OP_SET_FIELD", chunk, offset);
+		case OP_GET_FIELD_SLOT: return byte_instruction("OP_GET_FIELD_SLOT", chunk, offset);
+		case OP_SET_FIELD_SLOT: return byte_instruction("OP_SET_FIELD_SLOT", chunk, offset);
 		case OP_DEFINE_FIELD: return constant_instruction(manager, "OP_DEFINE_FIELD", chunk, offset);
 		case OP_DEFINE_METHOD: return constant_instruction(manager, "OP_DEFINE_METHOD", chunk, offset);
 		case OP_DEFINE_STATIC_FIELD: return constant_instruction(manager, "OP_DEFINE_STATIC_FIELD", chunk, offset);
 		case OP_DEFINE_STATIC_METHOD: return constant_instruction(manager, "OP_DEFINE_STATIC_METHOD", chunk, offset);
-		case OP_INVOKE: return constant_instruction(manager, "OP_INVOKE", chunk, offset) + 2;
+		case OP_INVOKE: return byte_instruction("OP_INVOKE", chunk, offset);
 		case OP_SUPER: return constant_instruction(manager, "OP_SUPER", chunk, offset);
 		case OP_CLOSURE: {
 			offset++;
@@ -631,4 +718,225 @@ int lit_disassemble_instruction(LitMemManager* manager, LitChunk* chunk, int off
 		}
 		default: printf("Unknown opcode %i\n", instruction); return offset + 1;
 	}
+}
+
+static const char* opcode_names[OP_TOTAL] = {
+	"OP_RETURN", "OP_CONSTANT", "OP_STATIC_INIT", "OP_NEGATE", "OP_ADD", "OP_SUBTRACT", "OP_MULTIPLY", "OP_DIVIDE",
+	"OP_POP", "OP_NOT", "OP_NIL", "OP_TRUE", "OP_FALSE", "OP_EQUAL", "OP_GREATER", "OP_LESS",
+	"OP_GREATER_EQUAL", "OP_LESS_EQUAL", "OP_NOT_EQUAL", "OP_CLOSE_UPVALUE", "OP_DEFINE_GLOBAL", "OP_GET_GLOBAL", "OP_SET_GLOBAL", "OP_GET_LOCAL",
+	"OP_SET_LOCAL", "OP_GET_UPVALUE", "OP_SET_UPVALUE", "OP_JUMP", "OP_JUMP_IF_FALSE", "OP_LOOP", "OP_CLOSURE", "OP_SUBCLASS",
+	"OP_CLASS", "OP_METHOD", "OP_GET_FIELD", "OP_SET_FIELD", "OP_INVOKE", "OP_CALL", "OP_DEFINE_FIELD", "OP_DEFINE_METHOD",
+	"OP_SUPER", "OP_DEFINE_STATIC_FIELD", "OP_DEFINE_STATIC_METHOD", "OP_POWER", "OP_SQUARE", "OP_ROOT", "OP_IS", "OP_GET_FIELD_SLOT",
+	"OP_SET_FIELD_SLOT", "OP_EQUAL_JUMP_IF_FALSE", "OP_NOT_EQUAL_JUMP_IF_FALSE", "OP_LESS_JUMP_IF_FALSE", "OP_LESS_EQUAL_JUMP_IF_FALSE",
+	"OP_GREATER_JUMP_IF_FALSE", "OP_GREATER_EQUAL_JUMP_IF_FALSE", "OP_ADD_INT", "OP_SUBTRACT_INT", "OP_MULTIPLY_INT",
+	"OP_GET_LOCAL_2", "OP_GET_LOCAL_FIELD_SLOT", "OP_SET_LOCAL_POP", "OP_SET_GLOBAL_POP", "OP_ADD_CONSTANT", "OP_SUBTRACT_CONSTANT",
+	"OP_POP_2", "OP_POP_LOOP", "OP_JUMP_IF_FALSE_POP", "OP_EQUAL_JUMP_IF_FALSE_POP", "OP_NOT_EQUAL_JUMP_IF_FALSE_POP",
+	"OP_LESS_JUMP_IF_FALSE_POP", "OP_LESS_EQUAL_JUMP_IF_FALSE_POP", "OP_GREATER_JUMP_IF_FALSE_POP", "OP_GREATER_EQUAL_JUMP_IF_FALSE_POP",
+	"OP_THROW", "OP_NEGATE_INT", "OP_ADD_INT_CONSTANT", "OP_SUBTRACT_INT_CONSTANT",
+	"OP_EQUAL_INT_JUMP_IF_FALSE", "OP_NOT_EQUAL_INT_JUMP_IF_FALSE", "OP_LESS_INT_JUMP_IF_FALSE",
+	"OP_LESS_EQUAL_INT_JUMP_IF_FALSE", "OP_GREATER_INT_JUMP_IF_FALSE", "OP_GREATER_EQUAL_INT_JUMP_IF_FALSE",
+	"OP_EQUAL_INT_JUMP_IF_FALSE_POP", "OP_NOT_EQUAL_INT_JUMP_IF_FALSE_POP", "OP_LESS_INT_JUMP_IF_FALSE_POP",
+	"OP_LESS_EQUAL_INT_JUMP_IF_FALSE_POP", "OP_GREATER_INT_JUMP_IF_FALSE_POP", "OP_GREATER_EQUAL_INT_JUMP_IF_FALSE_POP"
+};
+
+const char* lit_opcode_name(uint8_t opcode) {
+	return opcode < OP_TOTAL ? opcode_names[opcode] : "OP_UNKNOWN";
+}
+
+void lit_print_opcode_pairs(uint64_t pairs[OP_TOTAL + 1][OP_TOTAL + 1], int count) {
+	uint64_t total = 0;
+
+	for (int a = 0; a < OP_TOTAL; a++) {
+		for (int b = 0; b < OP_TOTAL; b++) {
+			total += pairs[a][b];
+		}
+	}
+
+	if (total == 0) {
+		return;
+	}
+
+	fprintf(stderr, "Most frequent opcode pairs (%lu in total):\n", total);
+
+	// The table is small, so just pick the max again and again (printed pairs get cleared)
+	for (int i = 0; i < count; i++) {
+		uint64_t max = 0;
+		int max_a = -1;
+		int max_b = -1;
+
+		for (int a = 0; a < OP_TOTAL; a++) {
+			for (int b = 0; b < OP_TOTAL; b++) {
+				uint64_t pair = pairs[a][b];
+
+				if (pair > max) {
+					max = pair;
+					max_a = a;
+					max_b = b;
+				}
+			}
+		}
+
+		if (max_a == -1) {
+			break;
+		}
+
+		fprintf(stderr, "%10lu %5.2f%% %s %s\n", max, max * 100.0 / total, lit_opcode_name((uint8_t) max_a), lit_opcode_name((uint8_t) max_b));
+		pairs[max_a][max_b] = 0;
+	}
+}
+
+static const char* register_opcode_names[OP_R_TOTAL] = {
+	"OP_R_RETURN", "OP_R_RETURN_NIL", "OP_R_CONSTANT", "OP_R_MOVE", "OP_R_NIL", "OP_R_GET_GLOBAL", "OP_R_SET_GLOBAL",
+	"OP_R_ADD", "OP_R_SUBTRACT", "OP_R_MULTIPLY", "OP_R_DIVIDE", "OP_R_NEGATE", "OP_R_NOT",
+	"OP_R_EQUAL", "OP_R_NOT_EQUAL", "OP_R_LESS", "OP_R_LESS_EQUAL", "OP_R_GREATER", "OP_R_GREATER_EQUAL",
+	"OP_R_JUMP", "OP_R_JUMP_IF_FALSE", "OP_R_JUMP_IF_TRUE",
+	"OP_R_ADD_INT", "OP_R_SUBTRACT_INT", "OP_R_MULTIPLY_INT", "OP_R_NEGATE_INT"
+};
+
+void lit_trace_register_chunk(LitMemManager* manager, LitRegisterChunk* chunk, LitChunk* constants, const char* name) {
+	printf("== %s (%d registers) ==\n", name, chunk->register_count);
+
+	for (uint64_t i = 0; i < chunk->count; i++) {
+		uint32_t instruction = chunk->code[i];
+		uint8_t op = REGISTER_OP(instruction);
+
+		printf("%04ld %-18s ", i, op < OP_R_TOTAL ? register_opcode_names[op] : "OP_R_UNKNOWN");
+
+		switch (op) {
+			case OP_R_CONSTANT: printf("r%d '%s'\n", REGISTER_A(instruction), lit_to_string(manager, constants->constants.values[REGISTER_BX(instruction)])); break;
+			case OP_R_GET_GLOBAL: case OP_R_SET_GLOBAL: printf("r%d g%d\n", REGISTER_A(instruction), REGISTER_BX(instruction)); break;
+			case OP_R_JUMP: case OP_R_JUMP_IF_FALSE: case OP_R_JUMP_IF_TRUE: printf("r%d -> %ld\n", REGISTER_A(instruction), i + 1 + REGISTER_SBX(instruction)); break;
+			default: printf("r%d r%d r%d\n", REGISTER_A(instruction), REGISTER_B(instruction), REGISTER_C(instruction)); break;
+		}
+	}
+}
+
+typedef struct {
+	int a;
+	int b;
+	uint64_t count;
+} Count;
+
+static int compare_counts(const void* a, const void* b) {
+	uint64_t x = ((const Count*) a)->count;
+	uint64_t y = ((const Count*) b)->count;
+
+	return x < y ? 1 : (x > y ? -1 : 0);
+}
+
+static int compare_executed(const void* a, const void* b) {
+	uint64_t x = (*(LitFunction* const*) a)->executed;
+	uint64_t y = (*(LitFunction* const*) b)->executed;
+
+	return x < y ? 1 : (x > y ? -1 : 0);
+}
+
+// Nested functions are constants of the functions, that define them (like lit_optimize_function() finds them)
+static void collect_functions(LitFunction* function, LitFunction*** functions, int* count, int* capacity) {
+	if (*count == *capacity) {
+		*capacity = *capacity < 8 ? 8 : *capacity * 2;
+		*functions = (LitFunction**) realloc(*functions, sizeof(LitFunction*) * (size_t) *capacity);
+	}
+
+	(*functions)[(*count)++] = function;
+	LitArray* constants = &function->chunk.constants;
+
+	for (int i = 0; i < constants->count; i++) {
+		if (IS_FUNCTION(constants->values[i])) {
+			collect_functions(AS_FUNCTION(constants->values[i]), functions, count, capacity);
+		}
+	}
+}
+
+static void write_json_string(FILE* out, const char* string) {
+	fputc('"', out);
+
+	for (const char* c = string; *c != '\0'; c++) {
+		if (*c == '"' || *c == '\\') {
+			fputc('\\', out);
+		}
+
+		fputc(*c, out);
+	}
+
+	fputc('"', out);
+}
+
+void lit_write_opcode_stats(LitOpcodeStats* stats, FILE* out) {
+	Count* counts = (Count*) malloc(sizeof(Count) * OP_TOTAL * OP_TOTAL);
+	int count = 0;
+	uint64_t total = 0;
+
+	for (int i = 0; i < OP_TOTAL; i++) {
+		if (stats->opcodes[i] > 0) {
+			counts[count++] = (Count) { i, 0, stats->opcodes[i] };
+			total += stats->opcodes[i];
+		}
+	}
+
+	qsort(counts, (size_t) count, sizeof(Count), compare_counts);
+	fprintf(out, "{\n\t\"instructions\": %lu,\n\t\"opcodes\": {", total);
+
+	for (int i = 0; i < count; i++) {
+		fprintf(out, "%s\n\t\t\"%s\": %lu", i == 0 ? "" : ",", lit_opcode_name((uint8_t) counts[i].a), counts[i].count);
+	}
+
+	count = 0;
+
+	for (int a = 0; a < OP_TOTAL; a++) {
+		for (int b = 0; b < OP_TOTAL; b++) {
+			if (stats->pairs[a][b] > 0) {
+				counts[count++] = (Count) { a, b, stats->pairs[a][b] };
+			}
+		}
+	}
+
+	qsort(counts, (size_t) count, sizeof(Count), compare_counts);
+	fprintf(out, "\n\t},\n\t\"pairs\": [");
+
+	for (int i = 0; i < count; i++) {
+		fprintf(out, "%s\n\t\t[\"%s\", \"%s\", %lu]", i == 0 ? "" : ",", lit_opcode_name((uint8_t) counts[i].a),
+			lit_opcode_name((uint8_t) counts[i].b), counts[i].count);
+	}
+
+	free(counts);
+
+	LitFunction** functions = NULL;
+	int capacity = 0;
+	count = 0;
+
+	collect_functions(stats->function, &functions, &count, &capacity);
+	qsort(functions, (size_t) count, sizeof(LitFunction*), compare_executed);
+	fprintf(out, "\n\t],\n\t\"functions\": [");
+
+	for (int i = 0; i < count && functions[i]->executed > 0; i++) {
+		LitFunction* function = functions[i];
+
+		fprintf(out, "%s\n\t\t{ \"name\": ", i == 0 ? "" : ",");
+		write_json_string(out, function->name == NULL ? "?" : function->name->chars);
+		fprintf(out, ", \"line\": %lu, \"instructions\": %lu }", lit_chunk_get_line(&function->chunk, 0), function->executed);
+	}
+
+	fprintf(out, "\n\t]\n}\n");
+	free(functions);
+}
+
+void lit_print_register_opcodes(uint64_t counts[OP_R_TOTAL]) {
+	uint64_t total = 0;
+
+	for (int i = 0; i < OP_R_TOTAL; i++) {
+		total += counts[i];
+	}
+
+	if (total == 0) {
+		return;
+	}
+
+	fprintf(stderr, "Register instructions (%lu in total):\n", total);
+
+	for (int i = 0; i < OP_R_TOTAL; i++) {
+		if (counts[i] > 0) {
+			fprintf(stderr, "%10lu %5.2f%% %s\n", counts[i], counts[i] * 100.0 / total, register_opcode_names[i]);
+		}
+	}
 }
\ No newline at end of file
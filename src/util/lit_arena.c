@@ -0,0 +1,79 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <util/lit_arena.h>
+
+#define ALIGN(size) (((size) + 7) & ~((size_t) 7))
+
+void lit_init_arena(LitArena* arena) {
+	arena->chunks = NULL;
+	arena->top = NULL;
+	arena->end = NULL;
+	arena->last = NULL;
+	arena->bytes = 0;
+}
+
+static void add_chunk(LitArena* arena, size_t size) {
+	if (size < LIT_ARENA_CHUNK_SIZE) {
+		size = LIT_ARENA_CHUNK_SIZE;
+	}
+
+	LitArenaChunk* chunk = (LitArenaChunk*) malloc(sizeof(LitArenaChunk) + size);
+
+	chunk->next = arena->chunks;
+	arena->chunks = chunk;
+	arena->top = chunk->data;
+	arena->end = chunk->data + size;
+}
+
+void* lit_arena_allocate(LitArena* arena, size_t size) {
+	size = ALIGN(size);
+
+	if ((size_t) (arena->end - arena->top) < size) {
+		add_chunk(arena, size);
+	}
+
+	arena->last = arena->top;
+	arena->top += size;
+	arena->bytes += size;
+
+	return arena->last;
+}
+
+void* lit_arena_grow(LitArena* arena, void* previous, size_t old_size, size_t new_size) {
+	if (previous != NULL && previous == arena->last && (size_t) (arena->end - arena->last) >= ALIGN(new_size)) {
+		arena->bytes += ALIGN(new_size) - (size_t) (arena->top - arena->last);
+		arena->top = arena->last + ALIGN(new_size);
+
+		return previous;
+	}
+
+	void* memory = lit_arena_allocate(arena, new_size);
+
+	if (previous != NULL) {
+		memcpy(memory, previous, old_size);
+	}
+
+	return memory;
+}
+
+char* lit_arena_copy_string(LitArena* arena, const char* chars, size_t length) {
+	char* string = (char*) lit_arena_allocate(arena, length + 1);
+
+	memcpy(string, chars, length);
+	string[length] = '\0';
+
+	return string;
+}
+
+void lit_free_arena(LitArena* arena) {
+	LitArenaChunk* chunk = arena->chunks;
+
+	while (chunk != NULL) {
+		LitArenaChunk* next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+
+	lit_init_arena(arena);
+}
\ No newline at end of file
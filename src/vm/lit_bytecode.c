@@ -0,0 +1,669 @@
+// mmap() and fstat() are not part of C99
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <vm/lit_bytecode.h>
+#include <vm/lit_memory.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define LIT_BYTECODE_MMAP
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Layout: header, strings (length + chars, 4 byte aligned), globals,
+ * then the functions. Every function record is 8 byte aligned and followed by
+ * its constants, lines, exception handlers, register code and bytecode, in that order,
+ * so the line table, the handlers and the register code can be used in place.
+ */
+
+#define NO_STRING UINT32_MAX
+
+typedef struct {
+	char magic[4];
+	uint32_t version;
+	uint32_t opcode_count;
+	uint32_t register_opcode_count;
+	uint32_t string_count;
+	uint32_t global_count;
+	uint32_t function_count;
+	uint32_t padding;
+} LitBytecodeHeader;
+
+typedef struct {
+	uint32_t name;
+	uint32_t index;
+} LitBytecodeGlobal;
+
+typedef struct {
+	uint32_t name;
+	uint32_t arity;
+	uint32_t upvalue_count;
+	uint32_t constant_count;
+	uint64_t code_count;
+	uint64_t line_count;
+	uint64_t register_code_count;
+	uint32_t register_count;
+	uint32_t handler_count;
+} LitBytecodeFunction;
+
+typedef enum {
+	CONSTANT_VALUE, // Numbers, bools, chars and nil
+	CONSTANT_STRING,
+	CONSTANT_FUNCTION
+} LitBytecodeConstantType;
+
+typedef struct {
+	uint32_t type;
+	uint32_t index; // Of the string or the function
+	LitValue value;
+} LitBytecodeConstant;
+
+typedef struct {
+	LitMemManager* manager;
+	FILE* out;
+	uint64_t offset;
+
+	LitTable string_indexes;
+	LitArray strings;
+	LitArray functions; // Nested functions come before the ones, that use them
+} LitBytecodeWriter;
+
+static void write_bytes(LitBytecodeWriter* writer, const void* bytes, size_t size) {
+	if (size == 0) {
+		return;
+	}
+
+	fwrite(bytes, 1, size, writer->out);
+	writer->offset += size;
+}
+
+static void write_padding(LitBytecodeWriter* writer, uint64_t alignment) {
+	static const uint8_t zeros[8] = { 0 };
+	uint64_t padding = (alignment - writer->offset % alignment) % alignment;
+
+	write_bytes(writer, zeros, (size_t) padding);
+}
+
+static uint32_t add_string(LitBytecodeWriter* writer, LitString* string) {
+	if (string == NULL) {
+		return NO_STRING;
+	}
+
+	LitValue* index = lit_table_get(&writer->string_indexes, string);
+
+	if (index != NULL) {
+		return (uint32_t) AS_INT(*index);
+	}
+
+	lit_table_set(writer->manager, &writer->string_indexes, string, MAKE_INT_VALUE(writer->strings.count));
+	lit_array_write(writer->manager, &writer->strings, MAKE_OBJECT_VALUE(string));
+
+	return (uint32_t) writer->strings.count - 1;
+}
+
+static uint32_t function_index(LitBytecodeWriter* writer, LitFunction* function) {
+	for (int i = 0; i < writer->functions.count; i++) {
+		if (AS_FUNCTION(writer->functions.values[i]) == function) {
+			return (uint32_t) i;
+		}
+	}
+
+	UNREACHABLE();
+	return 0;
+}
+
+static void collect_function(LitBytecodeWriter* writer, LitFunction* function) {
+	LitArray* constants = &function->chunk.constants;
+
+	for (int i = 0; i < constants->count; i++) {
+		if (IS_FUNCTION(constants->values[i])) {
+			collect_function(writer, AS_FUNCTION(constants->values[i]));
+		} else if (IS_STRING(constants->values[i])) {
+			add_string(writer, AS_STRING(constants->values[i]));
+		}
+	}
+
+	add_string(writer, function->name);
+	lit_array_write(writer->manager, &writer->functions, MAKE_OBJECT_VALUE(function));
+}
+
+static void write_function(LitBytecodeWriter* writer, LitFunction* function) {
+	LitChunk* chunk = &function->chunk;
+	LitBytecodeFunction record;
+
+	memset(&record, 0, sizeof(LitBytecodeFunction));
+
+	record.name = add_string(writer, function->name);
+	record.arity = (uint32_t) function->arity;
+	record.upvalue_count = (uint32_t) function->upvalue_count;
+	record.constant_count = (uint32_t) chunk->constants.count;
+	record.code_count = chunk->count;
+	record.line_count = chunk->line_count;
+	record.register_code_count = function->registers.count;
+	record.register_count = (uint32_t) function->registers.register_count;
+	record.handler_count = (uint32_t) chunk->handler_count;
+
+	write_padding(writer, 8);
+	write_bytes(writer, &record, sizeof(LitBytecodeFunction));
+
+	for (int i = 0; i < chunk->constants.count; i++) {
+		LitValue value = chunk->constants.values[i];
+		LitBytecodeConstant constant;
+
+		memset(&constant, 0, sizeof(LitBytecodeConstant));
+
+		if (IS_FUNCTION(value)) {
+			constant.type = CONSTANT_FUNCTION;
+			constant.index = function_index(writer, AS_FUNCTION(value));
+		} else if (IS_STRING(value)) {
+			constant.type = CONSTANT_STRING;
+			constant.index = add_string(writer, AS_STRING(value));
+		} else {
+			constant.type = CONSTANT_VALUE;
+			constant.value = value;
+		}
+
+		write_bytes(writer, &constant, sizeof(LitBytecodeConstant));
+	}
+
+	write_bytes(writer, chunk->lines, sizeof(uint64_t) * chunk->line_count);
+	write_bytes(writer, chunk->handlers, sizeof(LitHandler) * chunk->handler_count);
+	write_bytes(writer, function->registers.code, sizeof(uint32_t) * function->registers.count);
+	write_bytes(writer, chunk->code, chunk->count);
+}
+
+bool lit_write_bytecode(LitMemManager* manager, LitFunction* function, LitTable* globals, FILE* out) {
+	LitBytecodeWriter writer;
+
+	writer.manager = manager;
+	writer.out = out;
+	writer.offset = 0;
+
+	lit_init_table(&writer.string_indexes);
+	lit_init_array(&writer.strings);
+	lit_init_array(&writer.functions);
+
+	collect_function(&writer, function);
+
+	for (int i = 0; i <= globals->capacity_mask; i++) {
+		if (globals->entries[i].key != NULL) {
+			add_string(&writer, globals->entries[i].key);
+		}
+	}
+
+	LitBytecodeHeader header;
+	memset(&header, 0, sizeof(LitBytecodeHeader));
+
+	memcpy(header.magic, LIT_BYTECODE_MAGIC, 4);
+	header.version = LIT_BYTECODE_VERSION;
+	header.opcode_count = OP_TOTAL;
+	header.register_opcode_count = OP_R_TOTAL;
+	header.string_count = (uint32_t) writer.strings.count;
+	header.global_count = (uint32_t) globals->count;
+	header.function_count = (uint32_t) writer.functions.count;
+
+	write_bytes(&writer, &header, sizeof(LitBytecodeHeader));
+
+	for (int i = 0; i < writer.strings.count; i++) {
+		LitString* string = AS_STRING(writer.strings.values[i]);
+		uint32_t length = (uint32_t) string->length;
+
+		write_bytes(&writer, &length, sizeof(uint32_t));
+		write_bytes(&writer, string->chars, length);
+		write_padding(&writer, 4);
+	}
+
+	for (int i = 0; i <= globals->capacity_mask; i++) {
+		LitTableEntry* entry = &globals->entries[i];
+
+		if (entry->key != NULL) {
+			LitBytecodeGlobal global = { add_string(&writer, entry->key), (uint32_t) AS_INT(entry->value) };
+			write_bytes(&writer, &global, sizeof(LitBytecodeGlobal));
+		}
+	}
+
+	for (int i = 0; i < writer.functions.count; i++) {
+		write_function(&writer, AS_FUNCTION(writer.functions.values[i]));
+	}
+
+	write_padding(&writer, 8);
+
+	lit_free_table(manager, &writer.string_indexes);
+	lit_free_array(manager, &writer.strings);
+	lit_free_array(manager, &writer.functions);
+
+	return !ferror(out);
+}
+
+bool lit_is_bytecode_file(const char* path) {
+	FILE* file = fopen(path, "rb");
+
+	if (file == NULL) {
+		return false;
+	}
+
+	char magic[4];
+	bool is_bytecode = fread(magic, 1, 4, file) == 4 && memcmp(magic, LIT_BYTECODE_MAGIC, 4) == 0;
+
+	fclose(file);
+	return is_bytecode;
+}
+
+typedef struct {
+	uint8_t* start;
+	uint64_t offset;
+	uint64_t size;
+	bool failed;
+} LitBytecodeReader;
+
+// Returns a pointer to the next size bytes in the file, or NULL, if it ends before them
+static void* read_bytes(LitBytecodeReader* reader, uint64_t size, uint64_t alignment) {
+	uint64_t offset = reader->offset + (alignment - reader->offset % alignment) % alignment;
+
+	if (reader->failed || offset > reader->size || size > reader->size - offset) {
+		reader->failed = true;
+		return NULL;
+	}
+
+	reader->offset = offset + size;
+	return reader->start + offset;
+}
+
+static bool map_file(LitBytecode* bytecode, const char* path) {
+#ifdef LIT_BYTECODE_MMAP
+	int file = open(path, O_RDONLY);
+
+	if (file < 0) {
+		return false;
+	}
+
+	struct stat info;
+
+	if (fstat(file, &info) != 0 || info.st_size == 0) {
+		close(file);
+		return false;
+	}
+
+	void* mapping = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+
+	if (mapping == MAP_FAILED) {
+		return false;
+	}
+
+	bytecode->mapping = mapping;
+	bytecode->size = (size_t) info.st_size;
+#else
+	FILE* file = fopen(path, "rb");
+
+	if (file == NULL) {
+		return false;
+	}
+
+	fseek(file, 0L, SEEK_END);
+	size_t size = (size_t) ftell(file);
+	rewind(file);
+
+	// malloc() is aligned enough for the line tables
+	bytecode->mapping = malloc(size);
+	bytecode->size = size;
+
+	if (bytecode->mapping == NULL || fread(bytecode->mapping, 1, size, file) < size) {
+		fclose(file);
+		return false;
+	}
+
+	fclose(file);
+#endif
+
+	return true;
+}
+
+static bool is_constant(LitChunk* chunk, uint8_t index, LitObjectType type) {
+	return index < chunk->constants.count && lit_is_object_type(chunk->constants.values[index], type);
+}
+
+static bool is_jump_target(uint8_t* starts, uint64_t count, int64_t target) {
+	return target >= 0 && (uint64_t) target < count && starts[target];
+}
+
+/*
+ * Goes over every instruction once, so that the interpreter can trust the operands,
+ * it doesn't check them itself. Stack use and field slots depend on the values at runtime
+ * and aren't checked here.
+ */
+static bool check_code(LitMemManager* manager, LitFunction* function, uint32_t global_count) {
+	LitChunk* chunk = &function->chunk;
+	uint8_t* code = chunk->code;
+	uint64_t count = chunk->count;
+
+	// Instruction starts, jumps can't land in the middle of one
+	uint8_t* starts = (uint8_t*) reallocate(manager, NULL, 0, count + 1);
+	memset(starts, 0, count + 1);
+
+	bool valid = count > 0;
+	uint64_t offset = 0;
+
+	while (valid && offset < count) {
+		uint8_t instruction = code[offset];
+
+		if (instruction >= OP_TOTAL || (instruction == OP_CLOSURE && (offset + 1 >= count || !is_constant(chunk, code[offset + 1], OBJECT_FUNCTION)))) {
+			valid = false;
+			break;
+		}
+
+		starts[offset] = 1;
+		offset += lit_chunk_instruction_size(chunk, offset);
+	}
+
+	valid = valid && offset == count;
+
+	for (offset = 0; valid && offset < count; offset += lit_chunk_instruction_size(chunk, offset)) {
+		uint8_t* ip = code + offset;
+		uint16_t operand = offset + 2 < count ? (uint16_t) ((ip[1] << 8) | ip[2]) : 0;
+
+		switch (*ip) {
+			case OP_CONSTANT:
+			case OP_ADD_CONSTANT:
+			case OP_SUBTRACT_CONSTANT:
+			case OP_ADD_INT_CONSTANT:
+			case OP_SUBTRACT_INT_CONSTANT: valid = ip[1] < chunk->constants.count; break;
+
+			case OP_CLASS:
+			case OP_SUBCLASS:
+			case OP_METHOD:
+			case OP_DEFINE_FIELD:
+			case OP_DEFINE_METHOD:
+			case OP_DEFINE_STATIC_FIELD:
+			case OP_DEFINE_STATIC_METHOD:
+			case OP_SUPER:
+			case OP_GET_FIELD:
+			case OP_SET_FIELD: valid = is_constant(chunk, ip[1], OBJECT_STRING); break;
+
+			case OP_DEFINE_GLOBAL:
+			case OP_GET_GLOBAL:
+			case OP_SET_GLOBAL:
+			case OP_SET_GLOBAL_POP: valid = operand < global_count; break;
+
+			case OP_GET_UPVALUE:
+			case OP_SET_UPVALUE: valid = ip[1] < function->upvalue_count; break;
+
+			case OP_JUMP:
+			case OP_JUMP_IF_FALSE:
+			case OP_EQUAL_JUMP_IF_FALSE:
+			case OP_NOT_EQUAL_JUMP_IF_FALSE:
+			case OP_LESS_JUMP_IF_FALSE:
+			case OP_LESS_EQUAL_JUMP_IF_FALSE:
+			case OP_GREATER_JUMP_IF_FALSE:
+			case OP_GREATER_EQUAL_JUMP_IF_FALSE:
+			case OP_JUMP_IF_FALSE_POP:
+			case OP_EQUAL_JUMP_IF_FALSE_POP:
+			case OP_NOT_EQUAL_JUMP_IF_FALSE_POP:
+			case OP_LESS_JUMP_IF_FALSE_POP:
+			case OP_LESS_EQUAL_JUMP_IF_FALSE_POP:
+			case OP_GREATER_JUMP_IF_FALSE_POP:
+			case OP_GREATER_EQUAL_JUMP_IF_FALSE_POP:
+			case OP_EQUAL_INT_JUMP_IF_FALSE:
+			case OP_NOT_EQUAL_INT_JUMP_IF_FALSE:
+			case OP_LESS_INT_JUMP_IF_FALSE:
+			case OP_LESS_EQUAL_INT_JUMP_IF_FALSE:
+			case OP_GREATER_INT_JUMP_IF_FALSE:
+			case OP_GREATER_EQUAL_INT_JUMP_IF_FALSE:
+			case OP_EQUAL_INT_JUMP_IF_FALSE_POP:
+			case OP_NOT_EQUAL_INT_JUMP_IF_FALSE_POP:
+			case OP_LESS_INT_JUMP_IF_FALSE_POP:
+			case OP_LESS_EQUAL_INT_JUMP_IF_FALSE_POP:
+			case OP_GREATER_INT_JUMP_IF_FALSE_POP:
+			case OP_GREATER_EQUAL_INT_JUMP_IF_FALSE_POP: valid = is_jump_target(starts, count, (int64_t) offset + 3 + operand); break;
+
+			case OP_LOOP:
+			case OP_POP_LOOP: valid = is_jump_target(starts, count, (int64_t) offset + 3 - operand); break;
+
+			case OP_CLOSURE: {
+				LitFunction* closure = AS_FUNCTION(chunk->constants.values[ip[1]]);
+
+				for (int i = 0; i < closure->upvalue_count && valid; i++) {
+					uint8_t is_local = ip[2 + i * 2];
+					valid = is_local == 1 || (is_local == 0 && ip[3 + i * 2] < function->upvalue_count);
+				}
+
+				break;
+			}
+
+			default: break;
+		}
+	}
+
+	for (uint64_t i = 0; valid && i < chunk->handler_count; i++) {
+		LitHandler* handler = &chunk->handlers[i];
+		valid = handler->start <= handler->end && handler->end <= count && is_jump_target(starts, count, handler->handler) && handler->depth < UINT8_COUNT;
+	}
+
+	reallocate(manager, starts, count + 1, 0);
+	return valid;
+}
+
+static bool check_registers(LitFunction* function, uint32_t global_count) {
+	LitRegisterChunk* chunk = &function->registers;
+	uint32_t registers = (uint32_t) chunk->register_count;
+
+	for (uint64_t i = 0; i < chunk->count; i++) {
+		uint32_t instruction = chunk->code[i];
+		uint32_t a = REGISTER_A(instruction);
+		bool valid;
+
+		switch (REGISTER_OP(instruction)) {
+			case OP_R_RETURN_NIL: valid = true; break;
+			case OP_R_RETURN:
+			case OP_R_NIL: valid = a < registers; break;
+			case OP_R_CONSTANT: valid = a < registers && REGISTER_BX(instruction) < (uint32_t) function->chunk.constants.count; break;
+			case OP_R_GET_GLOBAL:
+			case OP_R_SET_GLOBAL: valid = a < registers && REGISTER_BX(instruction) < global_count; break;
+			case OP_R_MOVE:
+			case OP_R_NEGATE:
+			case OP_R_NEGATE_INT:
+			case OP_R_NOT: valid = a < registers && REGISTER_B(instruction) < registers; break;
+
+			case OP_R_JUMP:
+			case OP_R_JUMP_IF_FALSE:
+			case OP_R_JUMP_IF_TRUE: {
+				int64_t target = (int64_t) i + 1 + REGISTER_SBX(instruction);
+				valid = a < registers && target >= 0 && (uint64_t) target < chunk->count;
+				break;
+			}
+
+			case OP_R_ADD:
+			case OP_R_SUBTRACT:
+			case OP_R_MULTIPLY:
+			case OP_R_ADD_INT:
+			case OP_R_SUBTRACT_INT:
+			case OP_R_MULTIPLY_INT:
+			case OP_R_DIVIDE:
+			case OP_R_EQUAL:
+			case OP_R_NOT_EQUAL:
+			case OP_R_LESS:
+			case OP_R_LESS_EQUAL:
+			case OP_R_GREATER:
+			case OP_R_GREATER_EQUAL: valid = a < registers && REGISTER_B(instruction) < registers && REGISTER_C(instruction) < registers; break;
+
+			default: valid = false; break;
+		}
+
+		if (!valid) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool load_function(LitBytecode* bytecode, LitBytecodeReader* reader, LitString** strings, uint32_t string_count,
+	uint32_t global_count, LitFunction** functions, uint32_t index) {
+
+	LitMemManager* manager = (LitMemManager*) bytecode;
+	LitBytecodeFunction* record = (LitBytecodeFunction*) read_bytes(reader, sizeof(LitBytecodeFunction), 8);
+
+	if (record == NULL || (record->name != NO_STRING && record->name >= string_count) || record->upvalue_count > UINT8_COUNT) {
+		return false;
+	}
+
+	LitFunction* function = lit_new_function(manager);
+	functions[index] = function;
+
+	function->name = record->name == NO_STRING ? NULL : strings[record->name];
+	function->arity = (int) record->arity;
+	function->upvalue_count = (int) record->upvalue_count;
+
+	LitBytecodeConstant* constants = (LitBytecodeConstant*) read_bytes(reader, sizeof(LitBytecodeConstant) * (uint64_t) record->constant_count, 8);
+
+	if (constants == NULL) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < record->constant_count; i++) {
+		LitBytecodeConstant* constant = &constants[i];
+		LitValue value = constant->value;
+
+		if (constant->type == CONSTANT_STRING && constant->index < string_count) {
+			value = MAKE_OBJECT_VALUE(strings[constant->index]);
+		} else if (constant->type == CONSTANT_FUNCTION && constant->index < index) {
+			value = MAKE_OBJECT_VALUE(functions[constant->index]);
+		} else if (constant->type != CONSTANT_VALUE || IS_OBJECT(value)) {
+			// Objects only come from the string and function tables
+			return false;
+		}
+
+		lit_array_write(manager, &function->chunk.constants, value);
+	}
+
+	// Zero capacity tells lit_free_chunk(), that the arrays belong to the mapping
+	function->chunk.lines = (uint64_t*) read_bytes(reader, sizeof(uint64_t) * record->line_count, 8);
+	function->chunk.line_count = record->line_count;
+	function->chunk.handlers = (LitHandler*) read_bytes(reader, sizeof(LitHandler) * (uint64_t) record->handler_count, 4);
+	function->chunk.handler_count = record->handler_count;
+	function->registers.code = (uint32_t*) read_bytes(reader, sizeof(uint32_t) * record->register_code_count, 4);
+	function->registers.count = record->register_code_count;
+	function->registers.register_count = (int) record->register_count;
+	function->chunk.code = (uint8_t*) read_bytes(reader, record->code_count, 1);
+	function->chunk.count = record->code_count;
+
+	return !reader->failed && check_code(manager, function, global_count) && check_registers(function, global_count);
+}
+
+static bool load(LitBytecode* bytecode) {
+	LitMemManager* manager = (LitMemManager*) bytecode;
+	LitBytecodeReader reader = { (uint8_t*) bytecode->mapping, 0, bytecode->size, false };
+	LitBytecodeHeader* header = (LitBytecodeHeader*) read_bytes(&reader, sizeof(LitBytecodeHeader), 1);
+
+	if (header == NULL || memcmp(header->magic, LIT_BYTECODE_MAGIC, 4) != 0 || header->version != LIT_BYTECODE_VERSION
+		|| header->opcode_count != OP_TOTAL || header->register_opcode_count != OP_R_TOTAL || header->function_count == 0
+		// Every string and function takes space in the file, so broken counts don't get allocated for
+		|| header->string_count > bytecode->size / sizeof(uint32_t) || header->function_count > bytecode->size / sizeof(LitBytecodeFunction)) {
+
+		return false;
+	}
+
+	uint32_t string_count = header->string_count;
+	uint32_t function_count = header->function_count;
+	LitString** strings = (LitString**) reallocate(manager, NULL, 0, sizeof(LitString*) * string_count);
+	LitFunction** functions = (LitFunction**) reallocate(manager, NULL, 0, sizeof(LitFunction*) * function_count);
+	bool success = true;
+
+	for (uint32_t i = 0; i < string_count && success; i++) {
+		uint32_t* length = (uint32_t*) read_bytes(&reader, sizeof(uint32_t), 4);
+		const char* chars = length == NULL ? NULL : (const char*) read_bytes(&reader, *length, 1);
+
+		if (chars == NULL) {
+			success = false;
+		} else {
+			strings[i] = lit_copy_string(manager, chars, *length);
+		}
+	}
+
+	LitBytecodeGlobal* globals = success ? (LitBytecodeGlobal*) read_bytes(&reader, sizeof(LitBytecodeGlobal) * (uint64_t) header->global_count, 4) : NULL;
+
+	if (globals == NULL) {
+		success = false;
+	} else {
+		for (uint32_t i = 0; i < header->global_count; i++) {
+			if (globals[i].name >= string_count || globals[i].index >= header->global_count) {
+				success = false;
+				break;
+			}
+
+			lit_table_set(manager, &bytecode->globals, strings[globals[i].name], MAKE_INT_VALUE(globals[i].index));
+		}
+	}
+
+	for (uint32_t i = 0; i < function_count && success; i++) {
+		success = load_function(bytecode, &reader, strings, string_count, header->global_count, functions, i);
+	}
+
+	if (success) {
+		bytecode->function = functions[function_count - 1];
+	}
+
+	reallocate(manager, strings, sizeof(LitString*) * string_count, 0);
+	reallocate(manager, functions, sizeof(LitFunction*) * function_count, 0);
+
+	return success;
+}
+
+bool lit_load_bytecode(LitBytecode* bytecode, const char* path) {
+	LitMemManager* manager = (LitMemManager*) bytecode;
+
+	manager->bytes_allocated = 0;
+	manager->bytes_total = 0;
+	manager->peak_bytes = 0;
+	manager->type = MANAGER_COMPILER; // Never collected
+	manager->objects = NULL;
+
+	lit_init_table(&manager->strings);
+	lit_init_table(&bytecode->globals);
+
+	bytecode->function = NULL;
+	bytecode->mapping = NULL;
+	bytecode->size = 0;
+
+	if (!map_file(bytecode, path)) {
+		fprintf(stderr, "Could not open file \"%s\"\n", path);
+		lit_free_bytecode(bytecode);
+
+		return false;
+	}
+
+	if (!load(bytecode)) {
+		fprintf(stderr, "File \"%s\" is not valid bytecode for this version of lit\n", path);
+		lit_free_bytecode(bytecode);
+
+		return false;
+	}
+
+	return true;
+}
+
+void lit_free_bytecode(LitBytecode* bytecode) {
+	LitMemManager* manager = (LitMemManager*) bytecode;
+
+	lit_free_table(manager, &manager->strings);
+	lit_free_table(manager, &bytecode->globals);
+	lit_free_objects(manager);
+
+	if (bytecode->mapping != NULL) {
+#ifdef LIT_BYTECODE_MMAP
+		munmap(bytecode->mapping, bytecode->size);
+#else
+		free(bytecode->mapping);
+#endif
+	}
+
+	bytecode->function = NULL;
+	bytecode->mapping = NULL;
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <vm/lit_chunk.h>
 #include <vm/lit_memory.h>
+#include <vm/lit_object.h>
 
 void lit_init_chunk(LitChunk* chunk) {
 	chunk->count = 0;
@@ -10,13 +11,26 @@ void lit_init_chunk(LitChunk* chunk) {
 	chunk->line_count = 0;
 	chunk->line_capacity = 0;
 	chunk->lines = NULL;
+	chunk->handlers = NULL;
+	chunk->handler_count = 0;
+	chunk->handler_capacity = 0;
 
 	lit_init_array(&chunk->constants);
 }
 
 void lit_free_chunk(LitMemManager* manager, LitChunk* chunk) {
-	FREE_ARRAY(manager, uint8_t , chunk->code, chunk->capacity);
-	FREE_ARRAY(manager, uint64_t , chunk->lines, chunk->line_capacity);
+	// Chunks loaded from bytecode files point into the mapping and have no capacity
+	if (chunk->capacity > 0) {
+		FREE_ARRAY(manager, uint8_t , chunk->code, chunk->capacity);
+	}
+
+	if (chunk->line_capacity > 0) {
+		FREE_ARRAY(manager, uint64_t , chunk->lines, chunk->line_capacity);
+	}
+
+	if (chunk->handler_capacity > 0) {
+		FREE_ARRAY(manager, LitHandler, chunk->handlers, chunk->handler_capacity);
+	}
 
 	lit_free_array(manager, &chunk->constants);
 	lit_init_chunk(chunk);
@@ -52,6 +66,16 @@ int lit_chunk_add_constant(LitMemManager* manager, LitChunk* chunk, LitValue con
 	return chunk->constants.count - 1;
 }
 
+void lit_chunk_add_handler(LitMemManager* manager, LitChunk* chunk, LitHandler handler) {
+	if (chunk->handler_capacity < chunk->handler_count + 1) {
+		uint64_t old_capacity = chunk->handler_capacity;
+		chunk->handler_capacity = GROW_CAPACITY(old_capacity);
+		chunk->handlers = GROW_ARRAY(manager, chunk->handlers, LitHandler, old_capacity, chunk->handler_capacity);
+	}
+
+	chunk->handlers[chunk->handler_count++] = handler;
+}
+
 uint64_t lit_chunk_get_line(LitChunk* chunk, uint64_t offset) {
 	uint64_t i = 0;
 	uint64_t total = 0;
@@ -67,4 +91,103 @@ uint64_t lit_chunk_get_line(LitChunk* chunk, uint64_t offset) {
 	}
 
 	return 0;
+}
+
+int lit_chunk_instruction_size(LitChunk* chunk, uint64_t offset) {
+	switch (chunk->code[offset]) {
+		case OP_CONSTANT:
+		case OP_GET_LOCAL:
+		case OP_SET_LOCAL:
+		case OP_GET_UPVALUE:
+		case OP_SET_UPVALUE:
+		case OP_CALL:
+		case OP_INVOKE:
+		case OP_SUBCLASS:
+		case OP_CLASS:
+		case OP_METHOD:
+		case OP_DEFINE_FIELD:
+		case OP_DEFINE_METHOD:
+		case OP_SUPER:
+		case OP_DEFINE_STATIC_FIELD:
+		case OP_DEFINE_STATIC_METHOD:
+		case OP_GET_FIELD_SLOT:
+		case OP_SET_FIELD_SLOT:
+		case OP_SET_LOCAL_POP:
+		case OP_ADD_CONSTANT:
+		case OP_SUBTRACT_CONSTANT:
+		case OP_ADD_INT_CONSTANT:
+		case OP_SUBTRACT_INT_CONSTANT: return 2;
+
+		case OP_DEFINE_GLOBAL:
+		case OP_GET_GLOBAL:
+		case OP_SET_GLOBAL:
+		case OP_JUMP:
+		case OP_JUMP_IF_FALSE:
+		case OP_LOOP:
+		case OP_EQUAL_JUMP_IF_FALSE:
+		case OP_NOT_EQUAL_JUMP_IF_FALSE:
+		case OP_LESS_JUMP_IF_FALSE:
+		case OP_LESS_EQUAL_JUMP_IF_FALSE:
+		case OP_GREATER_JUMP_IF_FALSE:
+		case OP_GREATER_EQUAL_JUMP_IF_FALSE:
+		case OP_GET_LOCAL_2:
+		case OP_GET_LOCAL_FIELD_SLOT:
+		case OP_SET_GLOBAL_POP:
+		case OP_POP_LOOP:
+		case OP_JUMP_IF_FALSE_POP:
+		case OP_EQUAL_JUMP_IF_FALSE_POP:
+		case OP_NOT_EQUAL_JUMP_IF_FALSE_POP:
+		case OP_LESS_JUMP_IF_FALSE_POP:
+		case OP_LESS_EQUAL_JUMP_IF_FALSE_POP:
+		case OP_GREATER_JUMP_IF_FALSE_POP:
+		case OP_GREATER_EQUAL_JUMP_IF_FALSE_POP:
+		case OP_EQUAL_INT_JUMP_IF_FALSE:
+		case OP_NOT_EQUAL_INT_JUMP_IF_FALSE:
+		case OP_LESS_INT_JUMP_IF_FALSE:
+		case OP_LESS_EQUAL_INT_JUMP_IF_FALSE:
+		case OP_GREATER_INT_JUMP_IF_FALSE:
+		case OP_GREATER_EQUAL_INT_JUMP_IF_FALSE:
+		case OP_EQUAL_INT_JUMP_IF_FALSE_POP:
+		case OP_NOT_EQUAL_INT_JUMP_IF_FALSE_POP:
+		case OP_LESS_INT_JUMP_IF_FALSE_POP:
+		case OP_LESS_EQUAL_INT_JUMP_IF_FALSE_POP:
+		case OP_GREATER_INT_JUMP_IF_FALSE_POP:
+		case OP_GREATER_EQUAL_INT_JUMP_IF_FALSE_POP: return 3;
+
+		// Name constant + u16 cache site
+		case OP_GET_FIELD:
+		case OP_SET_FIELD: return 4;
+
+		case OP_CLOSURE: {
+			LitFunction* function = AS_FUNCTION(chunk->constants.values[chunk->code[offset + 1]]);
+			return 2 + function->upvalue_count * 2;
+		}
+
+		default: return 1;
+	}
+}
+
+void lit_init_register_chunk(LitRegisterChunk* chunk) {
+	chunk->count = 0;
+	chunk->capacity = 0;
+	chunk->code = NULL;
+	chunk->register_count = 0;
+}
+
+void lit_free_register_chunk(LitMemManager* manager, LitRegisterChunk* chunk) {
+	if (chunk->capacity > 0) {
+		FREE_ARRAY(manager, uint32_t, chunk->code, chunk->capacity);
+	}
+	lit_init_register_chunk(chunk);
+}
+
+void lit_register_chunk_write(LitMemManager* manager, LitRegisterChunk* chunk, uint32_t instruction) {
+	if (chunk->capacity < chunk->count + 1) {
+		uint64_t old_capacity = chunk->capacity;
+		chunk->capacity = GROW_CAPACITY(old_capacity);
+		chunk->code = GROW_ARRAY(manager, chunk->code, uint32_t, old_capacity, chunk->capacity);
+	}
+
+	chunk->code[chunk->count] = instruction;
+	chunk->count++;
 }
\ No newline at end of file
@@ -0,0 +1,764 @@
+// mmap() flags and sysconf() are not part of C99
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <vm/lit_jit.h>
+#include <vm/lit_object.h>
+
+#if defined(__x86_64__) && defined(__linux__)
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <pthread.h>
+
+typedef enum {
+	RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7,
+	R8 = 8, R9 = 9, R10 = 10, R11 = 11, R12 = 12, R13 = 13, R14 = 14, R15 = 15
+} LitJitRegister;
+
+/*
+ * Registers pinned while the machine code runs, all callee saved,
+ * so the helpers, that the templates call, keep them intact
+ */
+#define VM RBX
+#define SLOTS R12
+#define TOP R13 // vm->stack_top, only written back on exit
+#define CONSTANTS R14
+#define FRAME R15
+#define INT_MASK RBP // QNAN | TAG_INT, both operands are ints if (a & b & INT_MASK) == INT_MASK
+
+typedef enum {
+	CC_O = 0x0,
+	CC_E = 0x4,
+	CC_NE = 0x5,
+	CC_L = 0xc,
+	CC_GE = 0xd,
+	CC_LE = 0xe,
+	CC_G = 0xf,
+	CC_ALWAYS = 0xff
+} LitJitCondition;
+
+// x86 opcodes of the "op r/m, reg" forms
+#define ADD 0x01
+#define OR 0x09
+#define AND 0x21
+#define SUB 0x29
+#define CMP 0x39
+#define MOV 0x89
+#define IMUL 0xaf // Not one of them, emit_int_operation() encodes it as "imul reg, r/m"
+
+#define EXIT_TARGET UINT64_MAX
+
+typedef struct {
+	size_t at; // Offset of the rel32 operand
+	uint64_t target; // Bytecode offset or EXIT_TARGET
+} LitJitPatch;
+
+typedef struct {
+	uint8_t* bytes;
+	size_t count;
+	size_t capacity;
+
+	LitJitPatch* patches;
+	size_t patch_count;
+	size_t patch_capacity;
+
+	LitChunk* chunk;
+	uint32_t* offsets;
+} LitJitAssembler;
+
+static void emit_byte(LitJitAssembler* assembler, uint8_t byte) {
+	if (assembler->count == assembler->capacity) {
+		assembler->capacity = assembler->capacity < 256 ? 256 : assembler->capacity * 2;
+		assembler->bytes = realloc(assembler->bytes, assembler->capacity);
+	}
+
+	assembler->bytes[assembler->count++] = byte;
+}
+
+static void emit_dword(LitJitAssembler* assembler, uint32_t value) {
+	for (int i = 0; i < 4; i++) {
+		emit_byte(assembler, (uint8_t) (value >> (i * 8)));
+	}
+}
+
+static void emit_qword(LitJitAssembler* assembler, uint64_t value) {
+	for (int i = 0; i < 8; i++) {
+		emit_byte(assembler, (uint8_t) (value >> (i * 8)));
+	}
+}
+
+static void emit_rex(LitJitAssembler* assembler, bool wide, int reg, int base) {
+	uint8_t prefix = (uint8_t) (0x40 | (wide ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((base & 8) ? 1 : 0));
+
+	if (prefix != 0x40) {
+		emit_byte(assembler, prefix);
+	}
+}
+
+// [base + disp32]
+static void emit_memory(LitJitAssembler* assembler, int reg, int base, int32_t displacement) {
+	emit_byte(assembler, (uint8_t) (0x80 | ((reg & 7) << 3) | (base & 7)));
+
+	if ((base & 7) == RSP) {
+		emit_byte(assembler, 0x24); // SIB for rsp and r12
+	}
+
+	emit_dword(assembler, (uint32_t) displacement);
+}
+
+static void emit_load(LitJitAssembler* assembler, int to, int base, int32_t displacement) {
+	emit_rex(assembler, true, to, base);
+	emit_byte(assembler, 0x8b);
+	emit_memory(assembler, to, base, displacement);
+}
+
+static void emit_store(LitJitAssembler* assembler, int base, int32_t displacement, int from) {
+	emit_rex(assembler, true, from, base);
+	emit_byte(assembler, MOV);
+	emit_memory(assembler, from, base, displacement);
+}
+
+// mov byte [base + disp32], imm8
+static void emit_store_byte(LitJitAssembler* assembler, int base, int32_t displacement, uint8_t value) {
+	emit_rex(assembler, false, 0, base);
+	emit_byte(assembler, 0xc6);
+	emit_memory(assembler, 0, base, displacement);
+	emit_byte(assembler, value);
+}
+
+static void emit_operation(LitJitAssembler* assembler, uint8_t opcode, int to, int from, bool wide) {
+	emit_rex(assembler, wide, from, to);
+	emit_byte(assembler, opcode);
+	emit_byte(assembler, (uint8_t) (0xc0 | ((from & 7) << 3) | (to & 7)));
+}
+
+static void emit_move_immediate(LitJitAssembler* assembler, int to, uint64_t value) {
+	emit_rex(assembler, true, 0, to);
+	emit_byte(assembler, (uint8_t) (0xb8 | (to & 7)));
+	emit_qword(assembler, value);
+}
+
+// add reg, imm32 (sub is add with a negative value)
+static void emit_add_immediate(LitJitAssembler* assembler, int to, int32_t value, bool wide) {
+	emit_rex(assembler, wide, 0, to);
+	emit_byte(assembler, 0x81);
+	emit_byte(assembler, (uint8_t) (0xc0 | (to & 7)));
+	emit_dword(assembler, (uint32_t) value);
+}
+
+static void emit_push(LitJitAssembler* assembler, int reg) {
+	emit_rex(assembler, false, 0, reg);
+	emit_byte(assembler, (uint8_t) (0x50 | (reg & 7)));
+}
+
+static void emit_pop(LitJitAssembler* assembler, int reg) {
+	emit_rex(assembler, false, 0, reg);
+	emit_byte(assembler, (uint8_t) (0x58 | (reg & 7)));
+}
+
+static void emit_call(LitJitAssembler* assembler, void* function) {
+	emit_move_immediate(assembler, RAX, (uint64_t) (uintptr_t) function);
+	emit_byte(assembler, 0xff);
+	emit_byte(assembler, 0xd0);
+}
+
+// al = condition
+static void emit_set(LitJitAssembler* assembler, LitJitCondition condition) {
+	emit_byte(assembler, 0x0f);
+	emit_byte(assembler, (uint8_t) (0x90 | condition));
+	emit_byte(assembler, 0xc0);
+}
+
+// Returns the offset of the rel32 operand
+static size_t emit_jump(LitJitAssembler* assembler, LitJitCondition condition) {
+	if (condition == CC_ALWAYS) {
+		emit_byte(assembler, 0xe9);
+	} else {
+		emit_byte(assembler, 0x0f);
+		emit_byte(assembler, (uint8_t) (0x80 | condition));
+	}
+
+	emit_dword(assembler, 0);
+	return assembler->count - 4;
+}
+
+static void patch_jump(LitJitAssembler* assembler, size_t at, size_t to) {
+	int32_t offset = (int32_t) (to - (at + 4));
+	memcpy(assembler->bytes + at, &offset, 4);
+}
+
+static void patch_here(LitJitAssembler* assembler, size_t at) {
+	patch_jump(assembler, at, assembler->count);
+}
+
+// Jump to the code of a bytecode offset, patched once all of it is emitted
+static void emit_jump_to(LitJitAssembler* assembler, LitJitCondition condition, uint64_t target) {
+	if (assembler->patch_count == assembler->patch_capacity) {
+		assembler->patch_capacity = assembler->patch_capacity < 16 ? 16 : assembler->patch_capacity * 2;
+		assembler->patches = realloc(assembler->patches, assembler->patch_capacity * sizeof(LitJitPatch));
+	}
+
+	LitJitPatch* patch = &assembler->patches[assembler->patch_count++];
+
+	patch->at = emit_jump(assembler, condition);
+	patch->target = target;
+}
+
+/*
+ * Leaves the machine code with frame->ip pointing at the instruction
+ * at the offset, interpret() picks up from there
+ */
+static void emit_exit(LitJitAssembler* assembler, uint64_t offset) {
+	emit_byte(assembler, 0xb8); // mov eax, imm32
+	emit_dword(assembler, (uint32_t) offset);
+	emit_jump_to(assembler, CC_ALWAYS, EXIT_TARGET);
+}
+
+static void emit_push_rax(LitJitAssembler* assembler) {
+	emit_store(assembler, TOP, 0, RAX);
+	emit_add_immediate(assembler, TOP, sizeof(LitValue), true);
+}
+
+static void emit_pop_values(LitJitAssembler* assembler, int count) {
+	emit_add_immediate(assembler, TOP, -count * (int32_t) sizeof(LitValue), true);
+}
+
+// Jumps to the label, if not both rax and rcx hold ints, uses rdx
+static size_t emit_int_guard(LitJitAssembler* assembler) {
+	emit_operation(assembler, MOV, RDX, RAX, true);
+	emit_operation(assembler, AND, RDX, RCX, true);
+	emit_operation(assembler, AND, RDX, INT_MASK, true);
+	emit_operation(assembler, CMP, RDX, INT_MASK, true);
+
+	return emit_jump(assembler, CC_NE);
+}
+
+static LitValue jit_add(LitValue a, LitValue b) {
+	if (IS_DOUBLE(a) && IS_DOUBLE(b)) {
+		return MAKE_NUMBER_VALUE(lit_value_to_double(a) + lit_value_to_double(b));
+	}
+
+	return lit_number_arithmetic(OP_ADD, a, b);
+}
+
+static LitValue jit_subtract(LitValue a, LitValue b) {
+	if (IS_DOUBLE(a) && IS_DOUBLE(b)) {
+		return MAKE_NUMBER_VALUE(lit_value_to_double(a) - lit_value_to_double(b));
+	}
+
+	return lit_number_arithmetic(OP_SUBTRACT, a, b);
+}
+
+static LitValue jit_multiply(LitValue a, LitValue b) {
+	if (IS_DOUBLE(a) && IS_DOUBLE(b)) {
+		return MAKE_NUMBER_VALUE(lit_value_to_double(a) * lit_value_to_double(b));
+	}
+
+	return lit_number_arithmetic(OP_MULTIPLY, a, b);
+}
+
+static LitValue jit_not(LitValue value) {
+	return MAKE_BOOL_VALUE(lit_is_false(value));
+}
+
+static bool jit_equal(LitValue a, LitValue b) { return AS_NUMBER(a) == AS_NUMBER(b); }
+static bool jit_not_equal(LitValue a, LitValue b) { return AS_NUMBER(a) != AS_NUMBER(b); }
+static bool jit_less(LitValue a, LitValue b) { return AS_NUMBER(a) < AS_NUMBER(b); }
+static bool jit_less_equal(LitValue a, LitValue b) { return AS_NUMBER(a) <= AS_NUMBER(b); }
+static bool jit_greater(LitValue a, LitValue b) { return AS_NUMBER(a) > AS_NUMBER(b); }
+static bool jit_greater_equal(LitValue a, LitValue b) { return AS_NUMBER(a) >= AS_NUMBER(b); }
+
+typedef struct {
+	void* helper;
+	LitJitCondition condition; // Of the int comparison
+} LitJitComparison;
+
+static LitJitComparison comparison(uint8_t instruction) {
+	switch (instruction) {
+		case OP_EQUAL: case OP_EQUAL_JUMP_IF_FALSE: case OP_EQUAL_JUMP_IF_FALSE_POP:
+		case OP_EQUAL_INT_JUMP_IF_FALSE: case OP_EQUAL_INT_JUMP_IF_FALSE_POP: return (LitJitComparison) { jit_equal, CC_E };
+		case OP_NOT_EQUAL: case OP_NOT_EQUAL_JUMP_IF_FALSE: case OP_NOT_EQUAL_JUMP_IF_FALSE_POP:
+		case OP_NOT_EQUAL_INT_JUMP_IF_FALSE: case OP_NOT_EQUAL_INT_JUMP_IF_FALSE_POP: return (LitJitComparison) { jit_not_equal, CC_NE };
+		case OP_LESS: case OP_LESS_JUMP_IF_FALSE: case OP_LESS_JUMP_IF_FALSE_POP:
+		case OP_LESS_INT_JUMP_IF_FALSE: case OP_LESS_INT_JUMP_IF_FALSE_POP: return (LitJitComparison) { jit_less, CC_L };
+		case OP_LESS_EQUAL: case OP_LESS_EQUAL_JUMP_IF_FALSE: case OP_LESS_EQUAL_JUMP_IF_FALSE_POP:
+		case OP_LESS_EQUAL_INT_JUMP_IF_FALSE: case OP_LESS_EQUAL_INT_JUMP_IF_FALSE_POP: return (LitJitComparison) { jit_less_equal, CC_LE };
+		case OP_GREATER: case OP_GREATER_JUMP_IF_FALSE: case OP_GREATER_JUMP_IF_FALSE_POP:
+		case OP_GREATER_INT_JUMP_IF_FALSE: case OP_GREATER_INT_JUMP_IF_FALSE_POP: return (LitJitComparison) { jit_greater, CC_G };
+		default: return (LitJitComparison) { jit_greater_equal, CC_GE };
+	}
+}
+
+// rax = a op b for the two values on the top of the stack, pops b
+static void emit_binary(LitJitAssembler* assembler, void* helper) {
+	emit_load(assembler, RDI, TOP, -16);
+	emit_load(assembler, RSI, TOP, -8);
+	emit_call(assembler, helper);
+	emit_pop_values(assembler, 1);
+	emit_store(assembler, TOP, -8, RAX);
+}
+
+/*
+ * Int add or subtract inline, everything else (including overflows) goes
+ * through the helper. If there is a constant, it is the right operand.
+ */
+static void emit_int_arithmetic(LitJitAssembler* assembler, uint8_t opcode, void* helper, LitValue* constant) {
+	if (constant == NULL) {
+		emit_load(assembler, RAX, TOP, -16);
+		emit_load(assembler, RCX, TOP, -8);
+	} else {
+		emit_load(assembler, RAX, TOP, -8);
+		emit_move_immediate(assembler, RCX, *constant);
+	}
+
+	size_t not_ints = emit_int_guard(assembler);
+
+	emit_operation(assembler, MOV, RDX, RAX, false);
+	emit_operation(assembler, opcode, RDX, RCX, false);
+	size_t overflow = emit_jump(assembler, CC_O);
+
+	// 32 bit operations clear the upper half, just put the tag back
+	emit_operation(assembler, OR, RDX, INT_MASK, true);
+
+	if (constant == NULL) {
+		emit_pop_values(assembler, 1);
+	}
+
+	emit_store(assembler, TOP, -8, RDX);
+	size_t done = emit_jump(assembler, CC_ALWAYS);
+
+	patch_here(assembler, not_ints);
+	patch_here(assembler, overflow);
+
+	emit_operation(assembler, MOV, RDI, RAX, true);
+	emit_operation(assembler, MOV, RSI, RCX, true);
+	emit_call(assembler, helper);
+
+	if (constant == NULL) {
+		emit_pop_values(assembler, 1);
+	}
+
+	emit_store(assembler, TOP, -8, RAX);
+	patch_here(assembler, done);
+}
+
+// For the _INT opcodes, the resolver typed both operands as int, so it is just the 32 bit operation
+static void emit_int_operation(LitJitAssembler* assembler, uint8_t opcode, LitValue* constant) {
+	if (constant == NULL) {
+		emit_load(assembler, RAX, TOP, -16);
+		emit_load(assembler, RCX, TOP, -8);
+	} else {
+		emit_load(assembler, RAX, TOP, -8);
+		emit_move_immediate(assembler, RCX, *constant);
+	}
+
+	if (opcode == IMUL) {
+		emit_rex(assembler, false, RAX, RCX);
+		emit_byte(assembler, 0x0f);
+		emit_byte(assembler, IMUL);
+		emit_byte(assembler, (uint8_t) (0xc0 | ((RAX & 7) << 3) | (RCX & 7)));
+	} else {
+		emit_operation(assembler, opcode, RAX, RCX, false);
+	}
+
+	emit_operation(assembler, OR, RAX, INT_MASK, true);
+
+	if (constant == NULL) {
+		emit_pop_values(assembler, 1);
+	}
+
+	emit_store(assembler, TOP, -8, RAX);
+}
+
+/*
+ * al = a op b for the two values on the top of the stack, ints are compared inline.
+ * If the resolver typed both as int, there is no need for the guard and the helper.
+ */
+static void emit_comparison(LitJitAssembler* assembler, LitJitComparison comparison, bool ints) {
+	emit_load(assembler, RAX, TOP, -16);
+	emit_load(assembler, RCX, TOP, -8);
+
+	if (ints) {
+		emit_operation(assembler, CMP, RAX, RCX, false);
+		emit_set(assembler, comparison.condition);
+		return;
+	}
+
+	size_t not_ints = emit_int_guard(assembler);
+
+	emit_operation(assembler, CMP, RAX, RCX, false);
+	emit_set(assembler, comparison.condition);
+	size_t done = emit_jump(assembler, CC_ALWAYS);
+
+	patch_here(assembler, not_ints);
+	emit_operation(assembler, MOV, RDI, RAX, true);
+	emit_operation(assembler, MOV, RSI, RCX, true);
+	emit_call(assembler, comparison.helper);
+
+	patch_here(assembler, done);
+}
+
+// rax = MAKE_BOOL_VALUE(al)
+static void emit_bool_value(LitJitAssembler* assembler) {
+	emit_byte(assembler, 0x0f); // movzx eax, al
+	emit_byte(assembler, 0xb6);
+	emit_byte(assembler, 0xc0);
+
+	emit_move_immediate(assembler, RCX, FALSE_VALUE);
+	emit_operation(assembler, OR, RAX, RCX, true);
+}
+
+// Jumps to the target, if the value on the top of the stack is false, pops it otherwise, if pop is true
+static void emit_jump_if_false(LitJitAssembler* assembler, uint64_t target, bool pop) {
+	emit_load(assembler, RAX, TOP, -8);
+
+	emit_move_immediate(assembler, RCX, FALSE_VALUE);
+	emit_operation(assembler, CMP, RAX, RCX, true);
+	emit_jump_to(assembler, CC_E, target);
+
+	emit_move_immediate(assembler, RCX, TRUE_VALUE);
+	emit_operation(assembler, CMP, RAX, RCX, true);
+	size_t is_true = emit_jump(assembler, CC_E);
+
+	emit_operation(assembler, MOV, RDI, RAX, true);
+	emit_call(assembler, lit_is_false);
+	emit_byte(assembler, 0x84); // test al, al
+	emit_byte(assembler, 0xc0);
+	emit_jump_to(assembler, CC_NE, target);
+
+	patch_here(assembler, is_true);
+
+	if (pop) {
+		emit_pop_values(assembler, 1);
+	}
+}
+
+static uint16_t read_short(uint8_t* ip) {
+	return (uint16_t) ((ip[1] << 8) | ip[2]);
+}
+
+// Returns false, if the instruction has no template
+static bool emit_instruction(LitJitAssembler* assembler, uint8_t* ip, uint64_t next) {
+	LitValue* constants = assembler->chunk->constants.values;
+	int32_t globals = (int32_t) (offsetof(LitVm, global_values) + offsetof(LitArray, values));
+	uint8_t instruction = *ip;
+
+	switch (instruction) {
+		case OP_CONSTANT: {
+			emit_load(assembler, RAX, CONSTANTS, ip[1] * sizeof(LitValue));
+			emit_push_rax(assembler);
+			break;
+		}
+		case OP_NIL: case OP_TRUE: case OP_FALSE: {
+			emit_move_immediate(assembler, RAX, instruction == OP_NIL ? NIL_VALUE : (instruction == OP_TRUE ? TRUE_VALUE : FALSE_VALUE));
+			emit_push_rax(assembler);
+			break;
+		}
+		case OP_POP: emit_pop_values(assembler, 1); break;
+		case OP_POP_2: emit_pop_values(assembler, 2); break;
+		case OP_GET_LOCAL: {
+			emit_load(assembler, RAX, SLOTS, ip[1] * sizeof(LitValue));
+			emit_push_rax(assembler);
+			break;
+		}
+		case OP_GET_LOCAL_2: {
+			emit_load(assembler, RAX, SLOTS, ip[1] * sizeof(LitValue));
+			emit_push_rax(assembler);
+			emit_load(assembler, RAX, SLOTS, ip[2] * sizeof(LitValue));
+			emit_push_rax(assembler);
+			break;
+		}
+		case OP_SET_LOCAL: case OP_SET_LOCAL_POP: {
+			emit_load(assembler, RAX, TOP, -8);
+			emit_store(assembler, SLOTS, ip[1] * sizeof(LitValue), RAX);
+
+			if (instruction == OP_SET_LOCAL_POP) {
+				emit_pop_values(assembler, 1);
+			}
+
+			break;
+		}
+		case OP_GET_GLOBAL: {
+			emit_load(assembler, RCX, VM, globals);
+			emit_load(assembler, RAX, RCX, read_short(ip) * sizeof(LitValue));
+			emit_push_rax(assembler);
+			break;
+		}
+		case OP_SET_GLOBAL: case OP_SET_GLOBAL_POP: case OP_DEFINE_GLOBAL: {
+			emit_load(assembler, RAX, TOP, -8);
+			emit_load(assembler, RCX, VM, globals);
+			emit_store(assembler, RCX, read_short(ip) * sizeof(LitValue), RAX);
+			// Write barrier without checking the value (see lit_global_barrier())
+			emit_store_byte(assembler, VM, offsetof(LitVm, young_globals), 1);
+
+			if (instruction != OP_SET_GLOBAL) {
+				emit_pop_values(assembler, 1);
+			}
+
+			break;
+		}
+		case OP_ADD: emit_binary(assembler, jit_add); break;
+		case OP_SUBTRACT: emit_binary(assembler, jit_subtract); break;
+		case OP_MULTIPLY: emit_binary(assembler, jit_multiply); break;
+		case OP_DIVIDE: emit_binary(assembler, lit_divide); break;
+		case OP_ADD_INT: emit_int_operation(assembler, ADD, NULL); break;
+		case OP_SUBTRACT_INT: emit_int_operation(assembler, SUB, NULL); break;
+		case OP_MULTIPLY_INT: emit_int_operation(assembler, IMUL, NULL); break;
+		case OP_ADD_INT_CONSTANT: emit_int_operation(assembler, ADD, &constants[ip[1]]); break;
+		case OP_SUBTRACT_INT_CONSTANT: emit_int_operation(assembler, SUB, &constants[ip[1]]); break;
+		case OP_NEGATE_INT: {
+			emit_load(assembler, RAX, TOP, -8);
+			// neg eax
+			emit_byte(assembler, 0xf7);
+			emit_byte(assembler, (uint8_t) (0xc0 | (3 << 3) | (RAX & 7)));
+			emit_operation(assembler, OR, RAX, INT_MASK, true);
+			emit_store(assembler, TOP, -8, RAX);
+			break;
+		}
+		case OP_ADD_CONSTANT: emit_int_arithmetic(assembler, ADD, jit_add, &constants[ip[1]]); break;
+		case OP_SUBTRACT_CONSTANT: emit_int_arithmetic(assembler, SUB, jit_subtract, &constants[ip[1]]); break;
+		case OP_NEGATE: case OP_NOT: {
+			emit_load(assembler, RDI, TOP, -8);
+			emit_call(assembler, instruction == OP_NEGATE ? (void*) lit_negate : (void*) jit_not);
+			emit_store(assembler, TOP, -8, RAX);
+			break;
+		}
+		case OP_EQUAL: case OP_NOT_EQUAL: case OP_LESS: case OP_LESS_EQUAL: case OP_GREATER: case OP_GREATER_EQUAL: {
+			emit_comparison(assembler, comparison(instruction), false);
+			emit_bool_value(assembler);
+			emit_pop_values(assembler, 1);
+			emit_store(assembler, TOP, -8, RAX);
+			break;
+		}
+		case OP_EQUAL_JUMP_IF_FALSE: case OP_NOT_EQUAL_JUMP_IF_FALSE: case OP_LESS_JUMP_IF_FALSE:
+		case OP_LESS_EQUAL_JUMP_IF_FALSE: case OP_GREATER_JUMP_IF_FALSE: case OP_GREATER_EQUAL_JUMP_IF_FALSE:
+		case OP_EQUAL_INT_JUMP_IF_FALSE: case OP_NOT_EQUAL_INT_JUMP_IF_FALSE: case OP_LESS_INT_JUMP_IF_FALSE:
+		case OP_LESS_EQUAL_INT_JUMP_IF_FALSE: case OP_GREATER_INT_JUMP_IF_FALSE: case OP_GREATER_EQUAL_INT_JUMP_IF_FALSE: {
+			emit_comparison(assembler, comparison(instruction), instruction >= OP_EQUAL_INT_JUMP_IF_FALSE);
+			emit_bool_value(assembler);
+			emit_pop_values(assembler, 1);
+			emit_store(assembler, TOP, -8, RAX);
+
+			emit_move_immediate(assembler, RDX, FALSE_VALUE);
+			emit_operation(assembler, CMP, RAX, RDX, true);
+			emit_jump_to(assembler, CC_E, next + read_short(ip));
+			break;
+		}
+		case OP_EQUAL_JUMP_IF_FALSE_POP: case OP_NOT_EQUAL_JUMP_IF_FALSE_POP: case OP_LESS_JUMP_IF_FALSE_POP:
+		case OP_LESS_EQUAL_JUMP_IF_FALSE_POP: case OP_GREATER_JUMP_IF_FALSE_POP: case OP_GREATER_EQUAL_JUMP_IF_FALSE_POP:
+		case OP_EQUAL_INT_JUMP_IF_FALSE_POP: case OP_NOT_EQUAL_INT_JUMP_IF_FALSE_POP: case OP_LESS_INT_JUMP_IF_FALSE_POP:
+		case OP_LESS_EQUAL_INT_JUMP_IF_FALSE_POP: case OP_GREATER_INT_JUMP_IF_FALSE_POP: case OP_GREATER_EQUAL_INT_JUMP_IF_FALSE_POP: {
+			emit_comparison(assembler, comparison(instruction), instruction >= OP_EQUAL_INT_JUMP_IF_FALSE);
+
+			emit_byte(assembler, 0x84); // test al, al
+			emit_byte(assembler, 0xc0);
+			size_t is_false = emit_jump(assembler, CC_E);
+
+			emit_pop_values(assembler, 2);
+			size_t done = emit_jump(assembler, CC_ALWAYS);
+
+			patch_here(assembler, is_false);
+			emit_pop_values(assembler, 1);
+			emit_move_immediate(assembler, RAX, FALSE_VALUE);
+			emit_store(assembler, TOP, -8, RAX);
+			emit_jump_to(assembler, CC_ALWAYS, next + read_short(ip));
+
+			patch_here(assembler, done);
+			break;
+		}
+		case OP_JUMP: emit_jump_to(assembler, CC_ALWAYS, next + read_short(ip)); break;
+		case OP_JUMP_IF_FALSE: emit_jump_if_false(assembler, next + read_short(ip), false); break;
+		case OP_JUMP_IF_FALSE_POP: emit_jump_if_false(assembler, next + read_short(ip), true); break;
+		case OP_LOOP: emit_jump_to(assembler, CC_ALWAYS, next - read_short(ip)); break;
+		case OP_POP_LOOP: {
+			emit_pop_values(assembler, 1);
+			emit_jump_to(assembler, CC_ALWAYS, next - read_short(ip));
+			break;
+		}
+		default: return false;
+	}
+
+	return true;
+}
+
+static void emit_prologue(LitJitAssembler* assembler) {
+	emit_push(assembler, RBP);
+	emit_push(assembler, RBX);
+	emit_push(assembler, R12);
+	emit_push(assembler, R13);
+	emit_push(assembler, R14);
+	emit_push(assembler, R15);
+	emit_add_immediate(assembler, RSP, -8, true); // Keeps the stack 16 byte aligned for the helpers
+
+	emit_operation(assembler, MOV, VM, RDI, true);
+	emit_operation(assembler, MOV, FRAME, RSI, true);
+	emit_load(assembler, SLOTS, FRAME, offsetof(LitFrame, slots));
+	emit_load(assembler, TOP, VM, offsetof(LitVm, stack_top));
+	emit_move_immediate(assembler, CONSTANTS, (uint64_t) (uintptr_t) assembler->chunk->constants.values);
+	emit_move_immediate(assembler, INT_MASK, QNAN | TAG_INT);
+
+	emit_byte(assembler, 0xff); // jmp rdx
+	emit_byte(assembler, 0xe2);
+}
+
+// eax holds the bytecode offset to continue from
+static void emit_epilogue(LitJitAssembler* assembler) {
+	emit_move_immediate(assembler, RCX, (uint64_t) (uintptr_t) assembler->chunk->code);
+	emit_operation(assembler, ADD, RCX, RAX, true);
+	emit_store(assembler, FRAME, offsetof(LitFrame, ip), RCX);
+	emit_store(assembler, VM, offsetof(LitVm, stack_top), TOP);
+
+	emit_add_immediate(assembler, RSP, 8, true);
+	emit_pop(assembler, R15);
+	emit_pop(assembler, R14);
+	emit_pop(assembler, R13);
+	emit_pop(assembler, R12);
+	emit_pop(assembler, RBX);
+	emit_pop(assembler, RBP);
+	emit_byte(assembler, 0xc3); // ret
+}
+
+static size_t page_size(size_t size) {
+	size_t page = (size_t) sysconf(_SC_PAGESIZE);
+	return (size + page - 1) / page * page;
+}
+
+// VMs on other threads might run the same function, they compile one at a time (this also guards the perf map)
+static pthread_mutex_t compile_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Lets perf symbolize the machine code, see tools/perf/Documentation/jit-interface.txt
+static void write_perf_map(LitFunction* function, LitJitCode* jit) {
+	static FILE* perf_map;
+
+	if (perf_map == NULL) {
+		char path[64];
+		snprintf(path, sizeof(path), "/tmp/perf-%d.map", (int) getpid());
+
+		if ((perf_map = fopen(path, "w")) == NULL) {
+			return;
+		}
+	}
+
+	fprintf(perf_map, "%lx %lx lit:%s\n", (unsigned long) (uintptr_t) jit->code, (unsigned long) jit->size,
+		function->name == NULL ? "top-level" : function->name->chars);
+	fflush(perf_map);
+}
+
+static bool compile(LitVm* vm, LitFunction* function) {
+	LitChunk* chunk = &function->chunk;
+	LitJitAssembler assembler;
+
+	memset(&assembler, 0, sizeof(LitJitAssembler));
+	assembler.chunk = chunk;
+	assembler.offsets = calloc(chunk->count + 1, sizeof(uint32_t));
+
+	emit_prologue(&assembler);
+
+	for (uint64_t offset = 0; offset < chunk->count;) {
+		uint64_t next = offset + lit_chunk_instruction_size(chunk, offset);
+		assembler.offsets[offset] = (uint32_t) assembler.count;
+
+		if (!emit_instruction(&assembler, chunk->code + offset, next)) {
+			emit_exit(&assembler, offset);
+		}
+
+		offset = next;
+	}
+
+	// Running off the end of the chunk is left to the interpreter too
+	assembler.offsets[chunk->count] = (uint32_t) assembler.count;
+	emit_exit(&assembler, chunk->count);
+
+	size_t exit = assembler.count;
+	emit_epilogue(&assembler);
+
+	for (size_t i = 0; i < assembler.patch_count; i++) {
+		LitJitPatch* patch = &assembler.patches[i];
+		patch_jump(&assembler, patch->at, patch->target == EXIT_TARGET ? exit : assembler.offsets[patch->target]);
+	}
+
+	free(assembler.patches);
+
+	size_t size = page_size(assembler.count);
+	uint8_t* code = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (code == MAP_FAILED) {
+		free(assembler.bytes);
+		free(assembler.offsets);
+
+		return false;
+	}
+
+	memcpy(code, assembler.bytes, assembler.count);
+	free(assembler.bytes);
+
+	if (mprotect(code, size, PROT_READ | PROT_EXEC) != 0) {
+		munmap(code, size);
+		free(assembler.offsets);
+
+		return false;
+	}
+
+	LitJitCode* jit = malloc(sizeof(LitJitCode));
+
+	jit->code = code;
+	jit->size = assembler.count;
+	jit->offsets = assembler.offsets;
+	jit->entry = (LitJitEntry) code;
+
+	// The code has to be complete, before other threads see it
+	__atomic_store_n(&function->jit, jit, __ATOMIC_RELEASE);
+	write_perf_map(function, jit);
+
+	return true;
+}
+
+bool lit_jit_compile(LitVm* vm, LitFunction* function) {
+	pthread_mutex_lock(&compile_lock);
+
+	// Another thread might have compiled it in the meantime
+	bool success = function->jit != NULL || compile(vm, function);
+
+	pthread_mutex_unlock(&compile_lock);
+	return success;
+}
+
+void lit_jit_run(LitVm* vm, LitFrame* frame) {
+	LitFunction* function = frame->closure->function;
+	LitJitCode* jit = function->jit;
+
+	jit->entry(vm, frame, jit->code + jit->offsets[frame->ip - function->chunk.code]);
+}
+
+void lit_jit_free(LitFunction* function) {
+	LitJitCode* jit = function->jit;
+
+	if (jit != NULL) {
+		munmap(jit->code, page_size(jit->size));
+		free(jit->offsets);
+		free(jit);
+
+		function->jit = NULL;
+	}
+}
+
+#else
+
+bool lit_jit_compile(LitVm* vm, LitFunction* function) {
+	return false;
+}
+
+void lit_jit_run(LitVm* vm, LitFrame* frame) {
+
+}
+
+void lit_jit_free(LitFunction* function) {
+
+}
+
+#endif
\ No newline at end of file
@@ -1,21 +1,68 @@
+#define _DEFAULT_SOURCE
+
 #include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
 #include <string.h>
+#include <time.h>
 
 #include <lit.h>
 #include <lit_debug.h>
 #include <vm/lit_memory.h>
 #include <vm/lit_object.h>
+#include <vm/lit_jit.h>
 
 #define GC_HEAP_GROW_FACTOR 2
+#define GC_SLICE_BYTES (64 * 1024) // Allocated between the slices of an incremental collection
+#define GC_SLICE_CHECK 64 // Objects marked or swept between the clock checks
+
+/*
+ * The VM heap has two generations. Closures, upvalues, bound methods and instances
+ * are bump allocated in the nursery, everything else (and young objects, that don't fit anymore)
+ * goes to the old space: the size class pages (see lit_page.h), or the manager->objects list
+ * for objects, that are too big for them. A minor collection copies the young objects,
+ * that are reachable from the roots or the remembered set, into the old space and empties
+ * the nursery, so it only touches live young objects. Old objects, that get a young value
+ * stored into them, go into the remembered set (see lit_write_barrier()).
+ *
+ * Objects move, so collections can't run in the middle of an allocation, while C code still
+ * holds pointers to them. Allocations only set vm->gc_requested, and the interpreter calls
+ * lit_gc_safepoint() on calls, returns and loop back edges.
+ *
+ * Full collections of the old space are incremental tri-color mark-sweeps (white objects
+ * are not dark, gray ones are dark and on the gray stack, black ones are dark and off it).
+ * With vm->options.gc_pause set, every safe point only marks or sweeps until the pause budget
+ * runs out, otherwise the whole heap is collected at once. The budget only covers these slices,
+ * minor collections and the end of the mark phase are not split up. Marking ignores the nursery,
+ * objects get marked, once they are promoted. While marking, stores into objects gray the
+ * stored value (see lit_write_barrier()), new old objects start gray and the end of the
+ * mark phase scans the roots again. Sweeping takes the object list away, survivors and new
+ * objects go to a new one. Paged objects are marked in the page bitmaps, and the end of marking
+ * moves the unmarked slots of every page to its dead bitmap, that the sweep then frees.
+ *
+ * With vm->options.gc_sweep_thread set, the taken list is swept by a background thread instead,
+ * and the program continues right after marking. The thread only touches the objects of that
+ * list (the mutator never reads the dark flags or the next pointers of old objects outside of
+ * collections) and counts the freed bytes on its own manager. Safe points pick up the survivors,
+ * once it is done, and the next collection can't start before that.
+ */
 
 void* reallocate(LitMemManager* manager, void* previous, size_t old_size, size_t new_size) {
 	manager->bytes_allocated += new_size - old_size;
 
-	if (new_size > old_size && manager->type == MANAGER_VM) {
-		LitVm* vm = (LitVm*) manager;
+	if (new_size > old_size) {
+		if (manager->type == MANAGER_VM) {
+			LitVm* vm = (LitVm*) manager;
 
-		if (manager->bytes_allocated > vm->next_gc) {
-			lit_collect_garbage(vm);
+			if (manager->bytes_allocated > vm->next_gc) {
+				vm->gc_requested = true;
+			}
+		} else {
+			manager->bytes_total += new_size - old_size;
+
+			if (manager->bytes_allocated > manager->peak_bytes) {
+				manager->peak_bytes = manager->bytes_allocated;
+			}
 		}
 	}
 
@@ -28,21 +75,58 @@ void* reallocate(LitMemManager* manager, void* previous, size_t old_size, size_t
 	return realloc(previous, new_size);
 }
 
-void lit_gray_object(LitVm* vm, LitObject* object) {
-	if (object == NULL) {
-		return;
+LitObject* lit_allocate_object(LitMemManager* manager, size_t size) {
+	if (manager->type == MANAGER_VM && size <= LIT_PAGE_MAX_OBJECT) {
+		LitVm* vm = (LitVm*) manager;
+		LitObject* object = (LitObject*) lit_page_allocate(&vm->pages, size);
+
+		if (object != NULL) {
+			manager->bytes_allocated += size;
+
+			if (manager->bytes_allocated > vm->next_gc) {
+				vm->gc_requested = true;
+			}
+
+			object->paged = true;
+			return object;
+		}
 	}
 
-	if (object->dark) {
-		return;
+	LitObject** link = (LitObject**) reallocate(manager, NULL, 0, sizeof(LitObject*) + size);
+	LitObject* object = (LitObject*) (link + 1);
+
+	LIT_OBJECT_NEXT(object) = manager->objects;
+	manager->objects = object;
+	object->paged = false;
+
+	return object;
+}
+
+void* lit_allocate_young(LitVm* vm, size_t size) {
+	size = (size + 7) & ~((size_t) 7);
+
+	if ((size_t) (vm->nursery + LIT_NURSERY_SIZE - vm->nursery_top) < size) {
+		vm->gc_requested = true;
+		return NULL;
 	}
 
-	if (DEBUG_TRACE_GC) {
-		printf("%p gray %s\n", object, lit_to_string(vm, MAKE_OBJECT_VALUE(object)));
+	void* object = vm->nursery_top;
+	vm->nursery_top += size;
+
+	return object;
+}
+
+void lit_remember(LitVm* vm, LitObject* object) {
+	if (vm->remembered_capacity < vm->remembered_count + 1) {
+		vm->remembered_capacity = GROW_CAPACITY(vm->remembered_capacity);
+		vm->remembered = realloc(vm->remembered, sizeof(LitObject*) * vm->remembered_capacity);
 	}
 
-	object->dark = true;
+	object->remembered = true;
+	vm->remembered[vm->remembered_count++] = object;
+}
 
+static void push_gray(LitVm* vm, LitObject* object) {
 	if (vm->gray_capacity < vm->gray_count + 1) {
 		vm->gray_capacity = GROW_CAPACITY(vm->gray_capacity);
 		vm->gray_stack = realloc(vm->gray_stack, sizeof(LitObject*) * vm->gray_capacity);
@@ -51,66 +135,264 @@ void lit_gray_object(LitVm* vm, LitObject* object) {
 	vm->gray_stack[vm->gray_count++] = object;
 }
 
-void lit_gray_value(LitVm* vm, LitValue value) {
+/*
+ * Work stealing deque of a parallel marking thread (Chase and Lev, with the memory orders
+ * from Le et al.). The owner pushes and takes at the bottom, other threads steal from the top.
+ * Buffers, that were outgrown, stay around until marking is done, a thief might still read them.
+ */
+typedef struct {
+	int64_t capacity; // Power of two
+	LitObject** items;
+} MarkBuffer;
+
+typedef struct sMarkWorker {
+	int64_t top;
+	int64_t bottom;
+	MarkBuffer* buffer;
+
+	MarkBuffer** retired;
+	int retired_count;
+
+	struct sMarkShared* shared;
+	uint32_t index;
+	pthread_t thread;
+	bool started;
+} MarkWorker;
+
+typedef struct sMarkShared {
+	LitVm* vm;
+	MarkWorker* workers;
+	uint32_t worker_count;
+	// Workers, that found no work anywhere, marking is done once all are
+	uint32_t idle;
+} MarkShared;
+
+#define STEAL_EMPTY NULL
+#define STEAL_RETRY ((LitObject*) 1)
+
+static MarkBuffer* new_mark_buffer(int64_t capacity) {
+	MarkBuffer* buffer = malloc(sizeof(MarkBuffer));
+
+	buffer->capacity = capacity;
+	buffer->items = malloc(sizeof(LitObject*) * capacity);
+
+	return buffer;
+}
+
+static void free_mark_buffer(MarkBuffer* buffer) {
+	free(buffer->items);
+	free(buffer);
+}
+
+static void deque_push(MarkWorker* worker, LitObject* object) {
+	int64_t bottom = __atomic_load_n(&worker->bottom, __ATOMIC_RELAXED);
+	int64_t top = __atomic_load_n(&worker->top, __ATOMIC_ACQUIRE);
+	MarkBuffer* buffer = __atomic_load_n(&worker->buffer, __ATOMIC_RELAXED);
+
+	if (bottom - top > buffer->capacity - 1) {
+		MarkBuffer* grown = new_mark_buffer(buffer->capacity * 2);
+
+		for (int64_t i = top; i < bottom; i++) {
+			grown->items[i & (grown->capacity - 1)] = __atomic_load_n(&buffer->items[i & (buffer->capacity - 1)], __ATOMIC_RELAXED);
+		}
+
+		worker->retired = realloc(worker->retired, sizeof(MarkBuffer*) * (worker->retired_count + 1));
+		worker->retired[worker->retired_count++] = buffer;
+
+		__atomic_store_n(&worker->buffer, grown, __ATOMIC_RELEASE);
+		buffer = grown;
+	}
+
+	__atomic_store_n(&buffer->items[bottom & (buffer->capacity - 1)], object, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&worker->bottom, bottom + 1, __ATOMIC_RELAXED);
+}
+
+static LitObject* deque_take(MarkWorker* worker) {
+	int64_t bottom = __atomic_load_n(&worker->bottom, __ATOMIC_RELAXED) - 1;
+	MarkBuffer* buffer = __atomic_load_n(&worker->buffer, __ATOMIC_RELAXED);
+
+	__atomic_store_n(&worker->bottom, bottom, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	int64_t top = __atomic_load_n(&worker->top, __ATOMIC_RELAXED);
+
+	if (top > bottom) {
+		__atomic_store_n(&worker->bottom, bottom + 1, __ATOMIC_RELAXED);
+		return NULL;
+	}
+
+	LitObject* object = __atomic_load_n(&buffer->items[bottom & (buffer->capacity - 1)], __ATOMIC_RELAXED);
+
+	if (top == bottom) {
+		// The last one, a thief might be after it too
+		if (!__atomic_compare_exchange_n(&worker->top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+			object = NULL;
+		}
+
+		__atomic_store_n(&worker->bottom, bottom + 1, __ATOMIC_RELAXED);
+	}
+
+	return object;
+}
+
+static LitObject* deque_steal(MarkWorker* worker) {
+	int64_t top = __atomic_load_n(&worker->top, __ATOMIC_ACQUIRE);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	int64_t bottom = __atomic_load_n(&worker->bottom, __ATOMIC_ACQUIRE);
+
+	if (top >= bottom) {
+		return STEAL_EMPTY;
+	}
+
+	MarkBuffer* buffer = __atomic_load_n(&worker->buffer, __ATOMIC_ACQUIRE);
+	LitObject* object = __atomic_load_n(&buffer->items[top & (buffer->capacity - 1)], __ATOMIC_RELAXED);
+
+	if (!__atomic_compare_exchange_n(&worker->top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+		return STEAL_RETRY;
+	}
+
+	return object;
+}
+
+// Sets the mark bit (or the dark flag) of the object, returns false, if it was set already
+static inline bool set_mark(LitObject* object, bool atomic) {
+	if (object->paged) {
+		LitPage* page = lit_page_of(object);
+		uint32_t slot = lit_page_slot(page, object);
+		uint64_t* word = &page->marks[slot / 64];
+		uint64_t bit = 1ull << (slot % 64);
+
+		if (atomic) {
+			return !(__atomic_load_n(word, __ATOMIC_RELAXED) & bit) && !(__atomic_fetch_or(word, bit, __ATOMIC_RELAXED) & bit);
+		}
+
+		if (*word & bit) {
+			return false;
+		}
+
+		*word |= bit;
+		return true;
+	}
+
+	if (atomic) {
+		return !__atomic_load_n(&object->dark, __ATOMIC_RELAXED) && !__atomic_exchange_n(&object->dark, true, __ATOMIC_RELAXED);
+	}
+
+	if (object->dark) {
+		return false;
+	}
+
+	object->dark = true;
+	return true;
+}
+
+/*
+ * Marking with a NULL worker is the serial marker, that pushes onto vm->gray_stack. Parallel
+ * workers set the mark bit atomically, only the thread, that flipped it, traces the object.
+ */
+static inline void mark_object(LitVm* vm, MarkWorker* worker, LitObject* object) {
+	if (object == NULL || object->shared || lit_is_young(vm, object) || !set_mark(object, worker != NULL)) {
+		return;
+	}
+
+	if (worker != NULL) {
+		deque_push(worker, object);
+		return;
+	}
+
+	if (DEBUG_TRACE_GC) {
+		printf("%p gray %s\n", object, lit_to_string(vm, MAKE_OBJECT_VALUE(object)));
+	}
+
+	push_gray(vm, object);
+}
+
+static inline void mark_value(LitVm* vm, MarkWorker* worker, LitValue value) {
 	if (IS_OBJECT(value)) {
-		lit_gray_object(vm, AS_OBJECT(value));
+		mark_object(vm, worker, AS_OBJECT(value));
 	}
 }
 
-static void gray_array(LitVm* vm, LitArray* array) {
+static void mark_array(LitVm* vm, MarkWorker* worker, LitArray* array) {
 	for (int i = 0; i < array->count; i++) {
-		lit_gray_value(vm, array->values[i]);
+		mark_value(vm, worker, array->values[i]);
 	}
 }
 
-static void blacken_object(LitVm* vm, LitObject* object) {
-	if (DEBUG_TRACE_GC) {
+static void mark_table(LitVm* vm, MarkWorker* worker, LitTable* table) {
+	for (int i = 0; i <= table->capacity_mask; i++) {
+		LitTableEntry* entry = &table->entries[i];
+
+		mark_object(vm, worker, (LitObject*) entry->key);
+		mark_value(vm, worker, entry->value);
+	}
+}
+
+void lit_gray_object(LitVm* vm, LitObject* object) {
+	mark_object(vm, NULL, object);
+}
+
+void lit_gray_value(LitVm* vm, LitValue value) {
+	mark_value(vm, NULL, value);
+}
+
+static void gray_array(LitVm* vm, LitArray* array) {
+	mark_array(vm, NULL, array);
+}
+
+static void blacken_object(LitVm* vm, MarkWorker* worker, LitObject* object) {
+	if (DEBUG_TRACE_GC && worker == NULL) {
 		printf("%p blacken %s\n", object, lit_to_string(vm, MAKE_OBJECT_VALUE(object)));
 	}
 
 	switch (object->type) {
 		case OBJECT_FUNCTION: {
 			LitFunction* function = (LitFunction*) object;
-			lit_gray_object(vm, (LitObject*) function->name);
-			gray_array(vm, &function->chunk.constants);
+			mark_object(vm, worker, (LitObject*) function->name);
+			mark_array(vm, worker, &function->chunk.constants);
 
 			break;
 		}
 		case OBJECT_CLOSURE: {
 			LitClosure* closure = (LitClosure*) object;
-			lit_gray_object(vm, (LitObject*) closure->function);
+			mark_object(vm, worker, (LitObject*) closure->function);
 
 			for (int i = 0; i < closure->upvalue_count; i++) {
-				lit_gray_object(vm, (LitObject*) closure->upvalues[i]);
+				mark_object(vm, worker, (LitObject*) closure->upvalues[i]);
 			}
 
 			break;
 		}
-		case OBJECT_UPVALUE: lit_gray_value(vm, ((LitUpvalue*) object)->closed); break;
+		case OBJECT_UPVALUE: mark_value(vm, worker, ((LitUpvalue*) object)->closed); break;
 		case OBJECT_NATIVE: case OBJECT_STRING: break;
 		case OBJECT_CLASS: {
 			LitClass* class = (LitClass*) object;
 
-			lit_gray_object(vm, (LitObject*) class->name);
-			lit_gray_object(vm, (LitObject*) class->super);
-			lit_table_gray(vm, &class->methods);
-			lit_table_gray(vm, &class->fields);
-			lit_table_gray(vm, &class->static_methods);
-			lit_table_gray(vm, &class->static_fields);
+			mark_object(vm, worker, (LitObject*) class->name);
+			mark_object(vm, worker, (LitObject*) class->super);
+			mark_table(vm, worker, &class->methods);
+			mark_table(vm, worker, &class->fields);
+			mark_table(vm, worker, &class->static_methods);
+			mark_table(vm, worker, &class->static_fields);
+			mark_array(vm, worker, &class->field_defaults);
 
 			break;
 		}
 		case OBJECT_INSTANCE: {
 			LitInstance* instance = (LitInstance*) object;
-			lit_gray_object(vm, (LitObject*) instance->type);
-			lit_table_gray(vm, &instance->fields);
+			mark_object(vm, worker, (LitObject*) instance->type);
+
+			for (int i = 0; i < instance->field_count; i++) {
+				mark_value(vm, worker, instance->fields[i]);
+			}
 
 			break;
 		}
 		case OBJECT_BOUND_METHOD: {
 			LitMethod* bound = (LitMethod*) object;
-			lit_gray_value(vm, bound->receiver);
-			lit_gray_object(vm, (LitObject*) bound->method);
+			mark_value(vm, worker, bound->receiver);
+			mark_object(vm, worker, (LitObject*) bound->method);
 
 			break;
 		}
@@ -118,7 +400,143 @@ static void blacken_object(LitVm* vm, LitObject* object) {
 	}
 }
 
-void lit_free_object(LitMemManager* manager, LitObject* object) {
+// Returns true, if another deque has objects left
+static bool any_work_left(MarkShared* shared) {
+	for (uint32_t i = 0; i < shared->worker_count; i++) {
+		MarkWorker* worker = &shared->workers[i];
+
+		if (__atomic_load_n(&worker->top, __ATOMIC_ACQUIRE) < __atomic_load_n(&worker->bottom, __ATOMIC_ACQUIRE)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static LitObject* steal_work(MarkWorker* worker) {
+	MarkShared* shared = worker->shared;
+	bool retry;
+
+	do {
+		retry = false;
+
+		for (uint32_t i = 1; i < shared->worker_count; i++) {
+			LitObject* object = deque_steal(&shared->workers[(worker->index + i) % shared->worker_count]);
+
+			if (object == STEAL_RETRY) {
+				retry = true;
+			} else if (object != STEAL_EMPTY) {
+				return object;
+			}
+		}
+	} while (retry);
+
+	return NULL;
+}
+
+static void* mark_in_parallel(void* data) {
+	MarkWorker* worker = (MarkWorker*) data;
+	MarkShared* shared = worker->shared;
+	LitVm* vm = shared->vm;
+
+	while (true) {
+		LitObject* object;
+
+		while ((object = deque_take(worker)) != NULL || (object = steal_work(worker)) != NULL) {
+			blacken_object(vm, worker, object);
+		}
+
+		// Every deque is only filled by its owner, so once all workers are idle, there is nothing left
+		__atomic_add_fetch(&shared->idle, 1, __ATOMIC_SEQ_CST);
+
+		while (true) {
+			if (__atomic_load_n(&shared->idle, __ATOMIC_SEQ_CST) == shared->worker_count) {
+				return NULL;
+			}
+
+			if (any_work_left(shared)) {
+				__atomic_sub_fetch(&shared->idle, 1, __ATOMIC_SEQ_CST);
+				break;
+			}
+
+			sched_yield();
+		}
+	}
+}
+
+// Drains the gray stack with vm->options.gc_mark_threads threads, the calling one included
+static void mark_parallel(LitVm* vm) {
+	MarkShared shared;
+	uint32_t count = vm->options.gc_mark_threads;
+
+	shared.vm = vm;
+	shared.worker_count = count;
+	shared.idle = 0;
+	shared.workers = calloc(count, sizeof(MarkWorker));
+
+	for (uint32_t i = 0; i < count; i++) {
+		MarkWorker* worker = &shared.workers[i];
+
+		worker->buffer = new_mark_buffer(256);
+		worker->shared = &shared;
+		worker->index = i;
+	}
+
+	// Hand out the gray objects (they are marked already) round robin
+	for (int i = 0; i < vm->gray_count; i++) {
+		deque_push(&shared.workers[i % count], vm->gray_stack[i]);
+	}
+
+	vm->gray_count = 0;
+
+	// Threads, that fail to start, leave their deques to be stolen from
+	for (uint32_t i = 1; i < count; i++) {
+		MarkWorker* worker = &shared.workers[i];
+		worker->started = pthread_create(&worker->thread, NULL, mark_in_parallel, worker) == 0;
+
+		if (!worker->started) {
+			__atomic_add_fetch(&shared.idle, 1, __ATOMIC_SEQ_CST);
+		}
+	}
+
+	mark_in_parallel(&shared.workers[0]);
+
+	for (uint32_t i = 0; i < count; i++) {
+		MarkWorker* worker = &shared.workers[i];
+
+		if (worker->started) {
+			pthread_join(worker->thread, NULL);
+		}
+
+		for (int j = 0; j < worker->retired_count; j++) {
+			free_mark_buffer(worker->retired[j]);
+		}
+
+		free(worker->retired);
+		free_mark_buffer(worker->buffer);
+	}
+
+	free(shared.workers);
+}
+
+static size_t object_size(LitObject* object) {
+	switch (object->type) {
+		case OBJECT_STRING: return sizeof(LitString);
+		case OBJECT_UPVALUE: return sizeof(LitUpvalue);
+		case OBJECT_FUNCTION: return sizeof(LitFunction);
+		case OBJECT_NATIVE: return sizeof(LitNative);
+		case OBJECT_CLOSURE: return sizeof(LitClosure) + sizeof(LitUpvalue*) * ((LitClosure*) object)->upvalue_count;
+		case OBJECT_BOUND_METHOD: return sizeof(LitMethod);
+		case OBJECT_CLASS: return sizeof(LitClass);
+		case OBJECT_INSTANCE: return sizeof(LitInstance) + sizeof(LitValue) * ((LitInstance*) object)->field_count;
+		default: UNREACHABLE();
+	}
+
+	return 0;
+}
+
+// Frees the memory, that the object points to
+static void free_contents(LitMemManager* manager, LitObject* object) {
 	if (DEBUG_TRACE_GC) {
 		printf("free %p\n", object);
 	}
@@ -126,17 +544,7 @@ void lit_free_object(LitMemManager* manager, LitObject* object) {
 	switch (object->type) {
 		case OBJECT_STRING: {
 			LitString* string = (LitString*) object;
-
 			FREE_ARRAY(manager, char, string->chars, string->length + 1);
-			FREE(manager, LitString, object);
-
-			break;
-		}
-		case OBJECT_CLOSURE: {
-			LitClosure* closure = (LitClosure*) object;
-
-			FREE_ARRAY(manager, LitValue, closure->upvalues, closure->upvalue_count);
-			FREE(manager, LitClosure, object);
 
 			break;
 		}
@@ -144,22 +552,11 @@ void lit_free_object(LitMemManager* manager, LitObject* object) {
 			LitFunction* function = (LitFunction*) object;
 
 			lit_free_chunk(manager, &function->chunk);
-			FREE(manager, LitFunction, object);
+			lit_free_register_chunk(manager, &function->registers);
+			lit_jit_free(function);
 
 			break;
 		}
-		case OBJECT_NATIVE: {
-			FREE(manager, LitNative, object);
-			break;
-		}
-		case OBJECT_UPVALUE: {
-			FREE(manager, LitUpvalue, object);
-			break;
-		}
-		case OBJECT_BOUND_METHOD: {
-			FREE(manager, LitMethod, object);
-			break;
-		}
 		case OBJECT_CLASS: {
 			LitClass* class = ((LitClass*) object);
 
@@ -168,28 +565,213 @@ void lit_free_object(LitMemManager* manager, LitObject* object) {
 			lit_free_table(manager, &class->fields);
 			lit_free_table(manager, &class->static_methods);*/
 
-			FREE(manager, LitClass, object);
+			lit_free_array(manager, &class->field_defaults);
+			break;
+		}
+		case OBJECT_UPVALUE: case OBJECT_NATIVE: case OBJECT_CLOSURE: case OBJECT_BOUND_METHOD: case OBJECT_INSTANCE: break;
+		default: UNREACHABLE();
+	}
+}
+
+void lit_free_object(LitMemManager* manager, LitObject* object) {
+	size_t size = object_size(object);
+
+	free_contents(manager, object);
+	reallocate(manager, &LIT_OBJECT_NEXT(object), sizeof(LitObject*) + size, 0);
+}
+
+// The slot itself is given back by lit_page_release()
+static void free_paged_object(LitMemManager* manager, LitObject* object) {
+	manager->bytes_allocated -= object_size(object);
+	free_contents(manager, object);
+}
+
+static void push_promoted(LitVm* vm, LitObject* object) {
+	if (vm->promoted_capacity < vm->promoted_count + 1) {
+		vm->promoted_capacity = GROW_CAPACITY(vm->promoted_capacity);
+		vm->promoted = realloc(vm->promoted, sizeof(LitObject*) * vm->promoted_capacity);
+	}
+
+	vm->promoted[vm->promoted_count++] = object;
+}
+
+// Returns the old space copy of a young object, copies it on the first visit
+static LitObject* promote(LitVm* vm, LitObject* object) {
+	if (object == NULL || !lit_is_young(vm, object)) {
+		return object;
+	}
+
+	// The nursery is always empty during full collections, so dark young objects are the forwarded ones
+	if (object->dark) {
+		return ((LitForwarded*) object)->copy;
+	}
+
+	size_t size = object_size(object);
+	LitObject* copy = lit_allocate_object((LitMemManager*) vm, size);
+	bool paged = copy->paged;
+
+	memcpy(copy, object, size);
+	copy->paged = paged;
+
+	if (object->type == OBJECT_UPVALUE && ((LitUpvalue*) object)->value == &((LitUpvalue*) object)->closed) {
+		((LitUpvalue*) copy)->value = &((LitUpvalue*) copy)->closed;
+	}
+
+	object->dark = true;
+	((LitForwarded*) object)->copy = copy;
+
+	push_promoted(vm, copy);
+	lit_color_new_object(vm, copy);
+
+	return copy;
+}
+
+static inline LitValue promote_value(LitVm* vm, LitValue value) {
+	if (IS_OBJECT(value)) {
+		return MAKE_OBJECT_VALUE(promote(vm, AS_OBJECT(value)));
+	}
+
+	return value;
+}
+
+static void promote_array(LitVm* vm, LitArray* array) {
+	for (int i = 0; i < array->count; i++) {
+		array->values[i] = promote_value(vm, array->values[i]);
+	}
+}
+
+static void promote_table(LitVm* vm, LitTable* table) {
+	for (int i = 0; i <= table->capacity_mask; i++) {
+		table->entries[i].value = promote_value(vm, table->entries[i].value);
+	}
+}
+
+// Same traversal as blacken_object(), but for the kinds of objects, that can point into the nursery
+static void promote_fields(LitVm* vm, LitObject* object) {
+	switch (object->type) {
+		case OBJECT_CLOSURE: {
+			LitClosure* closure = (LitClosure*) object;
+
+			for (int i = 0; i < closure->upvalue_count; i++) {
+				closure->upvalues[i] = (LitUpvalue*) promote(vm, (LitObject*) closure->upvalues[i]);
+			}
+
+			break;
+		}
+		// Open upvalues are walked with the roots, next is stale in closed ones
+		case OBJECT_UPVALUE: ((LitUpvalue*) object)->closed = promote_value(vm, ((LitUpvalue*) object)->closed); break;
+		case OBJECT_CLASS: {
+			LitClass* class = (LitClass*) object;
+
+			promote_table(vm, &class->methods);
+			promote_table(vm, &class->static_methods);
+			promote_table(vm, &class->static_fields);
+			promote_array(vm, &class->field_defaults);
+
 			break;
 		}
 		case OBJECT_INSTANCE: {
-			LitInstance* instance = ((LitInstance*) object);
+			LitInstance* instance = (LitInstance*) object;
+
+			for (int i = 0; i < instance->field_count; i++) {
+				instance->fields[i] = promote_value(vm, instance->fields[i]);
+			}
+
+			break;
+		}
+		case OBJECT_BOUND_METHOD: {
+			LitMethod* bound = (LitMethod*) object;
 
-			// lit_free_table(manager, &instance->fields);
-			FREE(manager, LitInstance, object);
+			bound->receiver = promote_value(vm, bound->receiver);
+			bound->method = (LitClosure*) promote(vm, (LitObject*) bound->method);
 
 			break;
 		}
+		case OBJECT_FUNCTION: case OBJECT_NATIVE: case OBJECT_STRING: break;
 		default: UNREACHABLE();
 	}
 }
 
-void lit_collect_garbage(LitVm* vm) {
-	size_t before = ((LitMemManager*) vm)->bytes_allocated;
+static void count_pause(uint64_t* longest, uint64_t* total, uint64_t start) {
+	uint64_t pause = lit_time_ns() - start;
+
+	*total += pause;
+
+	if (pause > *longest) {
+		*longest = pause;
+	}
+}
+
+void lit_collect_young(LitVm* vm) {
+	LitMemManager* manager = (LitMemManager*) vm;
+	uint64_t start = lit_time_ns();
+	size_t before = manager->bytes_allocated;
+	size_t used = (size_t) (vm->nursery_top - vm->nursery);
 
 	if (DEBUG_TRACE_GC) {
-		printf("-- gc begin\n");
+		printf("-- minor gc begin\n");
+	}
+
+	for (LitValue* slot = vm->stack; slot < vm->stack_top; slot++) {
+		*slot = promote_value(vm, *slot);
 	}
 
+	for (int i = 0; i < vm->frame_count; i++) {
+		vm->frames[i].closure = (LitClosure*) promote(vm, (LitObject*) vm->frames[i].closure);
+	}
+
+	if (vm->batch != NULL) {
+		LitBatch* batch = vm->batch;
+
+		for (size_t i = 0; i < batch->count * batch->arg_count; i++) {
+			batch->args[i] = promote_value(vm, batch->args[i]);
+		}
+
+		for (size_t i = 0; i < batch->done; i++) {
+			batch->results[i] = promote_value(vm, batch->results[i]);
+		}
+	}
+
+	for (LitUpvalue** upvalue = &vm->open_upvalues; *upvalue != NULL; upvalue = &(*upvalue)->next) {
+		*upvalue = (LitUpvalue*) promote(vm, (LitObject*) *upvalue);
+	}
+
+	if (vm->young_globals) {
+		promote_array(vm, &vm->global_values);
+		vm->young_globals = false;
+	}
+
+	for (int i = 0; i < vm->remembered_count; i++) {
+		LitObject* object = vm->remembered[i];
+
+		object->remembered = false;
+		promote_fields(vm, object);
+	}
+
+	vm->remembered_count = 0;
+
+	// The fields of the copies still point into the nursery, scan them until no new copies show up
+	while (vm->promoted_count > 0) {
+		promote_fields(vm, vm->promoted[--vm->promoted_count]);
+	}
+
+	vm->nursery_top = vm->nursery;
+	vm->gc_stats.minor_collections++;
+	count_pause(&vm->gc_stats.longest_minor, &vm->gc_stats.total_minor, start);
+
+	if (DEBUG_TRACE_GC) {
+		printf("-- minor gc promoted %ld of %ld young bytes\n", manager->bytes_allocated - before, used);
+	}
+}
+
+uint64_t lit_time_ns() {
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return (uint64_t) time.tv_sec * 1000000000u + (uint64_t) time.tv_nsec;
+}
+
+static void gray_roots(LitVm* vm) {
 	for (LitValue* slot = vm->stack; slot < vm->stack_top; slot++) {
 		lit_gray_value(vm, *slot);
 	}
@@ -198,53 +780,361 @@ void lit_collect_garbage(LitVm* vm) {
 		lit_gray_object(vm, (LitObject*) vm->frames[i].closure);
 	}
 
+	if (vm->batch != NULL) {
+		LitBatch* batch = vm->batch;
+
+		for (size_t i = 0; i < batch->count * batch->arg_count; i++) {
+			lit_gray_value(vm, batch->args[i]);
+		}
+
+		for (size_t i = 0; i < batch->done; i++) {
+			lit_gray_value(vm, batch->results[i]);
+		}
+	}
+
 	for (LitUpvalue* upvalue = vm->open_upvalues; upvalue != NULL; upvalue = upvalue->next) {
 		lit_gray_object(vm, (LitObject*) upvalue);
 	}
 
 	lit_table_gray(vm, &vm->globals);
+	gray_array(vm, &vm->global_values);
 	lit_gray_object(vm, (LitObject*) vm->init_string);
+}
+
+// Returns true, once the gray stack is empty
+static bool mark_slice(LitVm* vm, uint64_t deadline) {
+	// Without a deadline the program waits anyway, so other cores can help
+	if (deadline == UINT64_MAX && vm->options.gc_mark_threads > 1 && vm->gray_count > 0) {
+		mark_parallel(vm);
+		return true;
+	}
+
+	/*
+	 * Promotions and the write barrier gray objects between the slices. Marking at least
+	 * twice as many makes sure marking ends, however short the slices are
+	 */
+	int quota = 2 * (vm->gray_count - vm->gray_left);
+	int work = 0;
 
 	while (vm->gray_count > 0) {
-		LitObject* object = vm->gray_stack[--vm->gray_count];
-		blacken_object(vm, object);
+		blacken_object(vm, NULL, vm->gray_stack[--vm->gray_count]);
+
+		if (++work % GC_SLICE_CHECK == 0 && work >= quota && lit_time_ns() > deadline) {
+			vm->gray_left = vm->gray_count;
+			return false;
+		}
 	}
 
+	vm->gray_left = 0;
+	return true;
+}
+
+/*
+ * Atomic end of the mark phase. Young objects are promoted (and come out gray), and the roots
+ * are scanned again, since stack and global stores have no marking barriers.
+ */
+static void finish_marking(LitVm* vm) {
 	LitMemManager* manager = (LitMemManager*) vm;
 
+	if (vm->nursery_top != vm->nursery) {
+		lit_collect_young(vm);
+	}
+
+	uint64_t start = lit_time_ns();
+
+	gray_roots(vm);
+	mark_slice(vm, UINT64_MAX);
+
 	lit_table_remove_white(vm, &manager->strings);
-	LitObject** object = &manager->objects;
+	count_pause(&vm->gc_stats.longest_final_mark, &vm->gc_stats.total_final_mark, start);
+
+	// Freed class addresses might be reused, so cached slots can't be trusted anymore
+	if (vm->field_caches != NULL) {
+		memset(vm->field_caches, 0, sizeof(LitFieldCache) * vm->field_cache_capacity);
+	}
+
+	// Objects allocated from now on go to a new list (or to slots, that are not dead), white
+	vm->sweeping = manager->objects;
+	manager->objects = NULL;
+	lit_pages_start_sweep(&vm->pages);
+	vm->gc_state = GC_SWEEP;
+}
+
+// Frees the dead slots of the pages, that were there at the end of marking, returns true once done
+static bool sweep_pages(LitPageHeap* heap, LitMemManager* manager, uint64_t deadline) {
+	while (heap->sweep_class < LIT_PAGE_CLASSES) {
+		LitPage* page = heap->sweep_page;
+
+		if (page == NULL) {
+			if (++heap->sweep_class < LIT_PAGE_CLASSES) {
+				heap->sweep_page = heap->sweeping[heap->sweep_class];
+			}
 
-	while (*object != NULL) {
-		if (!((*object)->dark)) {
-			LitObject* unreached = *object;
-			*object = unreached->next;
+			continue;
+		}
+
+		for (int i = 0; i < LIT_PAGE_WORDS; i++) {
+			uint64_t dead = page->dead[i];
+
+			if (dead == 0) {
+				continue;
+			}
+
+			for (uint64_t bits = dead; bits != 0; bits &= bits - 1) {
+				free_paged_object(manager, (LitObject*) (page->slots + (size_t) (i * 64 + __builtin_ctzll(bits)) * page->object_size));
+			}
+
+			lit_page_release(page, i, dead);
+		}
+
+		heap->sweep_page = page->next;
+
+		if (deadline != UINT64_MAX && lit_time_ns() > deadline) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Returns true, once every object of the old list and every page was visited
+static bool sweep_slice(LitVm* vm, uint64_t deadline) {
+	LitMemManager* manager = (LitMemManager*) vm;
+	int work = 0;
+
+	while (vm->sweeping != NULL) {
+		LitObject* object = vm->sweeping;
+		vm->sweeping = LIT_OBJECT_NEXT(object);
+
+		if (object->dark) {
+			object->dark = false;
+			LIT_OBJECT_NEXT(object) = manager->objects;
+			manager->objects = object;
+		} else {
+			lit_free_object(manager, object);
+		}
+
+		if (++work % GC_SLICE_CHECK == 0 && lit_time_ns() > deadline) {
+			return false;
+		}
+	}
+
+	return sweep_pages(&vm->pages, manager, deadline);
+}
+
+static void* sweep_in_background(void* data) {
+	LitVm* vm = (LitVm*) data;
+	// lit_free_object() only needs a manager to count the freed bytes on
+	LitMemManager manager = { 0 };
+	manager.type = MANAGER_COMPILER;
 
-			lit_free_object(vm, unreached);
+	LitObject* object = vm->sweeping;
+	LitObject* survivors = NULL;
+	LitObject* tail = NULL;
+
+	while (object != NULL) {
+		LitObject* next = LIT_OBJECT_NEXT(object);
+
+		if (object->dark) {
+			object->dark = false;
+			LIT_OBJECT_NEXT(object) = survivors;
+
+			if (survivors == NULL) {
+				tail = object;
+			}
+
+			survivors = object;
 		} else {
-			(*object)->dark = false;
-			object = &(*object)->next;
+			lit_free_object(&manager, object);
+		}
+
+		object = next;
+	}
+
+	sweep_pages(&vm->pages, &manager, UINT64_MAX);
+
+	vm->swept = survivors;
+	vm->swept_tail = tail;
+	// Wraps around to the amount freed
+	vm->swept_bytes = manager.bytes_allocated;
+
+	__atomic_store_n(&vm->sweeper_done, true, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+// If the thread can't be created, the list gets swept on the mutator, like without the option
+static void start_sweeper(LitVm* vm) {
+	vm->sweeper_done = false;
+	vm->sweeper_running = pthread_create(&vm->sweeper, NULL, sweep_in_background, vm) == 0;
+}
+
+// Returns true, once the sweeper is done, and its survivors are back on the object list
+static bool join_sweeper(LitVm* vm, bool wait) {
+	LitMemManager* manager = (LitMemManager*) vm;
+
+	if (!wait && !__atomic_load_n(&vm->sweeper_done, __ATOMIC_ACQUIRE)) {
+		return false;
+	}
+
+	pthread_join(vm->sweeper, NULL);
+	vm->sweeper_running = false;
+	vm->sweeping = NULL;
+
+	if (vm->swept != NULL) {
+		LIT_OBJECT_NEXT(vm->swept_tail) = manager->objects;
+		manager->objects = vm->swept;
+	}
+
+	manager->bytes_allocated += vm->swept_bytes;
+	return true;
+}
+
+// Does as much of the current collection, as it can until the deadline
+static void collect_slice(LitVm* vm, uint64_t deadline) {
+	LitMemManager* manager = (LitMemManager*) vm;
+
+	if (vm->gc_state == GC_MARK && mark_slice(vm, deadline)) {
+		finish_marking(vm);
+
+		if (vm->options.gc_sweep_thread) {
+			start_sweeper(vm);
 		}
 	}
 
-	size_t bytes = ((LitMemManager*) vm)->bytes_allocated;
-	vm->next_gc = bytes * GC_HEAP_GROW_FACTOR;
+	if (vm->gc_state == GC_SWEEP) {
+		bool swept = vm->sweeper_running ? join_sweeper(vm, false) : sweep_slice(vm, deadline);
+
+		if (!swept) {
+			return;
+		}
+
+		lit_release_empty_pages(&vm->pages);
+
+		vm->gc_state = GC_IDLE;
+		vm->next_gc = manager->bytes_allocated * GC_HEAP_GROW_FACTOR;
+		vm->gc_stats.full_collections++;
 
+		if (DEBUG_TRACE_GC) {
+			printf("-- gc done, %ld bytes left, next at %ld\n", manager->bytes_allocated, vm->next_gc);
+		}
+	}
+}
+
+static void start_collection(LitVm* vm) {
 	if (DEBUG_TRACE_GC) {
-		printf("-- gc collected %ld bytes (from %ld to %ld) next at %ld\n", before - bytes, before, bytes, vm->next_gc);
+		printf("-- gc begin\n");
+	}
+
+	vm->gc_state = GC_MARK;
+	vm->gray_left = 0;
+	gray_roots(vm);
+}
+
+void lit_color_new_object(LitVm* vm, LitObject* object) {
+	// Its fields come from values, that marking might not have seen yet
+	if (vm->gc_state == GC_MARK) {
+		set_mark(object, false);
+		push_gray(vm, object);
+	}
+}
+
+void lit_gc_safepoint(LitVm* vm) {
+	LitMemManager* manager = (LitMemManager*) vm;
+	uint64_t start = lit_time_ns();
+	uint64_t deadline = vm->options.gc_pause == 0 ? UINT64_MAX : start + vm->options.gc_pause * 1000u;
+
+	vm->gc_requested = false;
+
+	if (vm->nursery_top != vm->nursery) {
+		lit_collect_young(vm);
+	}
+
+	if (vm->gc_state == GC_IDLE && manager->bytes_allocated > vm->next_gc) {
+		start_collection(vm);
+	}
+
+	if (vm->gc_state != GC_IDLE) {
+		collect_slice(vm, deadline);
+
+		if (vm->gc_state != GC_IDLE) {
+			// The next slice runs after a bit more allocation (or once the nursery is full)
+			vm->next_gc = manager->bytes_allocated + GC_SLICE_BYTES;
+		}
+	}
+
+	vm->gc_stats.pauses++;
+	count_pause(&vm->gc_stats.longest_pause, &vm->gc_stats.total_pause, start);
+}
+
+void lit_collect_garbage(LitVm* vm) {
+	if (vm->nursery_top != vm->nursery) {
+		lit_collect_young(vm);
+	}
+
+	if (vm->gc_state == GC_IDLE) {
+		start_collection(vm);
+	}
+
+	while (vm->gc_state != GC_IDLE) {
+		collect_slice(vm, UINT64_MAX);
+
+		if (vm->sweeper_running) {
+			join_sweeper(vm, true);
+		}
+	}
+}
+
+/*
+ * The objects of a compiler or bytecode are only read by the VMs, that run them, so they are
+ * flagged instead of marked: marking would write into objects, that other VMs might read
+ * at the same time, and the VM string tables would drop the strings, that it didn't mark
+ */
+void lit_share_objects(LitMemManager* manager) {
+	for (LitObject* object = manager->objects; object != NULL; object = LIT_OBJECT_NEXT(object)) {
+		object->shared = true;
 	}
 }
 
 void lit_free_objects(LitMemManager* manager) {
+	if (manager->type == MANAGER_VM && ((LitVm*) manager)->sweeper_running) {
+		join_sweeper((LitVm*) manager, true);
+	}
+
 	LitObject* object = manager->objects;
 
 	while (object != NULL) {
-		LitObject* next = object->next;
+		LitObject* next = LIT_OBJECT_NEXT(object);
 		lit_free_object(manager, object);
 		object = next;
 	}
 
 	if (manager->type == MANAGER_VM) {
-		free(((LitVm*) manager)->gray_stack);
+		LitVm* vm = (LitVm*) manager;
+
+		// The VM might be freed in the middle of a sweep
+		while (vm->sweeping != NULL) {
+			LitObject* next = LIT_OBJECT_NEXT(vm->sweeping);
+			lit_free_object(manager, vm->sweeping);
+			vm->sweeping = next;
+		}
+
+		// Dead slots, that were not swept yet, are still used
+		for (int class = 0; class < LIT_PAGE_CLASSES; class++) {
+			for (LitPage* page = vm->pages.pages[class]; page != NULL; page = page->next) {
+				for (int i = 0; i < LIT_PAGE_WORDS; i++) {
+					for (uint64_t bits = page->used[i] & lit_page_slot_bits(page, i); bits != 0; bits &= bits - 1) {
+						free_paged_object(manager, (LitObject*) (page->slots + (size_t) (i * 64 + __builtin_ctzll(bits)) * page->object_size));
+					}
+				}
+			}
+		}
+
+		lit_free_pages(&vm->pages);
+
+		// Young objects don't own any memory, the nursery goes away as a whole
+		free(vm->gray_stack);
+		free(vm->remembered);
+		free(vm->promoted);
+		free(vm->nursery);
 	}
 }
\ No newline at end of file
@@ -9,21 +9,54 @@
 
 #define ALLOCATE_OBJECT(manager, type, object_type) \
     (type*) allocate_object(manager, sizeof(type), object_type)
+#define ALLOCATE_YOUNG_OBJECT(manager, type, object_type) \
+    (type*) allocate_young_object(manager, sizeof(type), object_type)
 
 static LitObject* allocate_object(LitMemManager* manager, size_t size, LitObjectType type) {
-	LitObject* object = (LitObject*) reallocate(manager, NULL, 0, size);
+	LitObject* object = lit_allocate_object(manager, size);
 
 	object->type = type;
 	object->dark = false;
-	object->next = manager->objects;
+	object->remembered = false;
+	object->shared = false;
 
-	manager->objects = object;
+	if (manager->type == MANAGER_VM) {
+		lit_color_new_object((LitVm*) manager, object);
+	}
+
+	return object;
+}
+
+/*
+ * Short lived kinds of objects go to the nursery of the VM, while it has space.
+ * Otherwise they are allocated old and remembered, since they get their young fields right away.
+ */
+static LitObject* allocate_young_object(LitMemManager* manager, size_t size, LitObjectType type) {
+	if (manager->type != MANAGER_VM) {
+		return allocate_object(manager, size, type);
+	}
+
+	LitVm* vm = (LitVm*) manager;
+	LitObject* object = (LitObject*) lit_allocate_young(vm, size);
+
+	if (object == NULL) {
+		object = allocate_object(manager, size, type);
+		lit_remember(vm, object);
+
+		return object;
+	}
+
+	object->type = type;
+	object->dark = false;
+	object->remembered = false;
+	object->paged = false;
+	object->shared = false;
 
 	return object;
 }
 
 LitUpvalue* lit_new_upvalue(LitMemManager* manager, LitValue* slot) {
-	LitUpvalue* upvalue = ALLOCATE_OBJECT(manager, LitUpvalue, OBJECT_UPVALUE);
+	LitUpvalue* upvalue = ALLOCATE_YOUNG_OBJECT(manager, LitUpvalue, OBJECT_UPVALUE);
 
 	upvalue->closed = NIL_VALUE;
 	upvalue->value = slot;
@@ -33,18 +66,15 @@ LitUpvalue* lit_new_upvalue(LitMemManager* manager, LitValue* slot) {
 }
 
 LitClosure* lit_new_closure(LitMemManager* manager, LitFunction* function) {
-	LitUpvalue** upvalues = ALLOCATE(manager, LitUpvalue*, function->upvalue_count);
-
-	for (int i = 0; i < function->upvalue_count; i++) {
-		upvalues[i] = NULL;
-	}
-
-	LitClosure* closure = ALLOCATE_OBJECT(manager, LitClosure, OBJECT_CLOSURE);
+	LitClosure* closure = (LitClosure*) allocate_young_object(manager, sizeof(LitClosure) + sizeof(LitUpvalue*) * function->upvalue_count, OBJECT_CLOSURE);
 
 	closure->function = function;
-	closure->upvalues = upvalues;
 	closure->upvalue_count = function->upvalue_count;
 
+	for (int i = 0; i < function->upvalue_count; i++) {
+		closure->upvalues[i] = NULL;
+	}
+
 	return closure;
 }
 
@@ -54,8 +84,13 @@ LitFunction* lit_new_function(LitMemManager* manager) {
 	function->arity = 0;
 	function->upvalue_count = 0;
 	function->name = NULL;
+	function->hotness = 0;
+	function->jit = NULL;
+	function->executed = 0;
+	function->aot = NULL;
 
 	lit_init_chunk(&function->chunk);
+	lit_init_register_chunk(&function->registers);
 
 	return function;
 }
@@ -68,7 +103,7 @@ LitNative* lit_new_native(LitMemManager* manager, LitNativeFn function) {
 }
 
 LitMethod* lit_new_bound_method(LitMemManager* manager, LitValue receiver, LitClosure* method) {
-	LitMethod* bound = ALLOCATE_OBJECT(manager, LitMethod, OBJECT_BOUND_METHOD);
+	LitMethod* bound = ALLOCATE_YOUNG_OBJECT(manager, LitMethod, OBJECT_BOUND_METHOD);
 
 	bound->receiver = receiver;
 	bound->method = method;
@@ -86,17 +121,21 @@ LitClass* lit_new_class(LitMemManager* manager, LitString* name, LitClass* super
 	lit_init_table(&class->static_methods);
 	lit_init_table(&class->fields);
 	lit_init_table(&class->static_fields);
+	lit_init_array(&class->field_defaults);
 
 	return class;
 }
 
 LitInstance* lit_new_instance(LitMemManager* manager, LitClass* class) {
-	LitInstance* instance = ALLOCATE_OBJECT(manager, LitInstance, OBJECT_INSTANCE);
+	int field_count = class->field_defaults.count;
+	LitInstance* instance = (LitInstance*) allocate_young_object(manager, sizeof(LitInstance) + sizeof(LitValue) * field_count, OBJECT_INSTANCE);
 
 	instance->type = class;
+	instance->field_count = field_count;
 
-	lit_init_table(&instance->fields);
-	lit_table_add_all(manager, &instance->fields, &class->fields);
+	if (field_count > 0) {
+		memcpy(instance->fields, class->field_defaults.values, sizeof(LitValue) * field_count);
+	}
 
 	return instance;
 }
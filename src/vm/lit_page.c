@@ -0,0 +1,158 @@
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <vm/lit_page.h>
+
+void lit_init_pages(LitPageHeap* heap) {
+	memset(heap, 0, sizeof(LitPageHeap));
+}
+
+static int size_class(size_t size) {
+	return (int) ((size + LIT_PAGE_GRANULE - 1) / LIT_PAGE_GRANULE) - 1;
+}
+
+uint64_t lit_page_slot_bits(LitPage* page, int word) {
+	uint32_t first = (uint32_t) word * 64;
+
+	if (first + 64 <= page->capacity) {
+		return ~0ull;
+	}
+
+	return first >= page->capacity ? 0 : (1ull << (page->capacity - first)) - 1;
+}
+
+static LitPage* new_page(uint32_t object_size) {
+	LitPage* page;
+
+	if (posix_memalign((void**) &page, LIT_PAGE_SIZE, LIT_PAGE_SIZE) != 0) {
+		return NULL;
+	}
+
+	size_t header = (sizeof(LitPage) + LIT_PAGE_GRANULE - 1) & ~((size_t) LIT_PAGE_GRANULE - 1);
+
+	page->next = NULL;
+	page->object_size = object_size;
+	page->capacity = (uint32_t) ((LIT_PAGE_SIZE - header) / object_size);
+	page->inverse = ((1ull << 32) + object_size - 1) / object_size;
+	page->live = 0;
+	page->cursor = 0;
+	page->slots = (uint8_t*) page + header;
+
+	memset(page->marks, 0, sizeof(page->marks));
+	memset(page->dead, 0, sizeof(page->dead));
+
+	// Slots past the end of the page are never free
+	for (int i = 0; i < LIT_PAGE_WORDS; i++) {
+		page->used[i] = ~lit_page_slot_bits(page, i);
+	}
+
+	return page;
+}
+
+static bool has_room(LitPage* page) {
+	return __atomic_load_n(&page->live, __ATOMIC_RELAXED) < page->capacity;
+}
+
+void* lit_page_allocate(LitPageHeap* heap, size_t size) {
+	int class = size_class(size);
+	LitPage* page = heap->current[class];
+
+	if (page == NULL || !has_room(page)) {
+		page = heap->pages[class];
+
+		while (page != NULL && !has_room(page)) {
+			page = page->next;
+		}
+
+		if (page == NULL) {
+			page = new_page((uint32_t) (class + 1) * LIT_PAGE_GRANULE);
+
+			if (page == NULL) {
+				return NULL;
+			}
+
+			page->next = heap->pages[class];
+			heap->pages[class] = page;
+		}
+
+		heap->current[class] = page;
+	}
+
+	// There is a free bit somewhere, since live is below the capacity
+	while (true) {
+		// Pairs with the release in lit_page_release(), the sweeper is done with freed slots
+		uint64_t free = ~__atomic_load_n(&page->used[page->cursor], __ATOMIC_ACQUIRE);
+
+		if (free != 0) {
+			int bit = __builtin_ctzll(free);
+
+			__atomic_fetch_or(&page->used[page->cursor], 1ull << bit, __ATOMIC_RELAXED);
+			__atomic_add_fetch(&page->live, 1, __ATOMIC_RELAXED);
+
+			void* slot = page->slots + (size_t) (page->cursor * 64 + bit) * page->object_size;
+			memset(slot, 0, page->object_size);
+
+			return slot;
+		}
+
+		page->cursor = (page->cursor + 1) % LIT_PAGE_WORDS;
+	}
+}
+
+void lit_pages_start_sweep(LitPageHeap* heap) {
+	for (int class = 0; class < LIT_PAGE_CLASSES; class++) {
+		for (LitPage* page = heap->pages[class]; page != NULL; page = page->next) {
+			for (int i = 0; i < LIT_PAGE_WORDS; i++) {
+				page->dead[i] = page->used[i] & ~page->marks[i] & lit_page_slot_bits(page, i);
+				page->marks[i] = 0;
+			}
+		}
+
+		heap->sweeping[class] = heap->pages[class];
+	}
+
+	heap->sweep_class = 0;
+	heap->sweep_page = heap->sweeping[0];
+}
+
+void lit_page_release(LitPage* page, int word, uint64_t bits) {
+	page->dead[word] &= ~bits;
+
+	__atomic_fetch_and(&page->used[word], ~bits, __ATOMIC_RELEASE);
+	__atomic_sub_fetch(&page->live, (uint32_t) __builtin_popcountll(bits), __ATOMIC_RELAXED);
+}
+
+void lit_release_empty_pages(LitPageHeap* heap) {
+	for (int class = 0; class < LIT_PAGE_CLASSES; class++) {
+		LitPage** link = &heap->pages[class];
+
+		while (*link != NULL) {
+			LitPage* page = *link;
+
+			if (page->live == 0 && page != heap->current[class]) {
+				*link = page->next;
+				free(page);
+			} else {
+				link = &page->next;
+			}
+		}
+
+		heap->sweeping[class] = NULL;
+	}
+}
+
+void lit_free_pages(LitPageHeap* heap) {
+	for (int class = 0; class < LIT_PAGE_CLASSES; class++) {
+		LitPage* page = heap->pages[class];
+
+		while (page != NULL) {
+			LitPage* next = page->next;
+			free(page);
+			page = next;
+		}
+	}
+
+	lit_init_pages(heap);
+}
\ No newline at end of file
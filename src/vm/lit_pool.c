@@ -0,0 +1,142 @@
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <vm/lit_pool.h>
+#include <vm/lit_memory.h>
+
+static bool run_once(LitVmPool* pool) {
+	LitVm vm;
+
+	lit_init_vm(&vm);
+	vm.options = pool->options;
+	lit_vm_load_program(&vm, pool->owner, pool->globals);
+	lit_execute(&vm, pool->function);
+
+	bool failed = vm.abort;
+	lit_free_vm(&vm);
+
+	return failed;
+}
+
+static void* work(void* data) {
+	LitVmPool* pool = (LitVmPool*) data;
+
+	pthread_mutex_lock(&pool->lock);
+
+	while (true) {
+		while (pool->queued == 0 && !pool->stopping) {
+			pthread_cond_wait(&pool->wake, &pool->lock);
+		}
+
+		// Stopping, but the queued runs are still done first
+		if (pool->queued == 0) {
+			break;
+		}
+
+		pool->queued--;
+		pool->running++;
+		pthread_mutex_unlock(&pool->lock);
+
+		bool failed = run_once(pool);
+
+		pthread_mutex_lock(&pool->lock);
+		pool->running--;
+
+		if (failed) {
+			pool->failed++;
+		}
+
+		if (pool->queued == 0 && pool->running == 0) {
+			pthread_cond_broadcast(&pool->idle);
+		}
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
+
+bool lit_init_vm_pool(LitVmPool* pool, LitMemManager* owner, LitTable* globals, LitFunction* function, int thread_count) {
+	if (thread_count <= 0) {
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		thread_count = cores > 0 ? (int) cores : 1;
+	}
+
+	pool->owner = owner;
+	pool->globals = globals;
+	pool->function = function;
+	pool->options = lit_vm_options;
+	pool->options.opcode_stats = NULL;
+	pool->options.profile = false;
+	pool->queued = 0;
+	pool->running = 0;
+	pool->failed = 0;
+	pool->stopping = false;
+
+	// Before any VM can see the program
+	lit_share_objects(owner);
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+	pthread_cond_init(&pool->idle, NULL);
+
+	pool->threads = (pthread_t*) malloc(sizeof(pthread_t) * thread_count);
+	pool->thread_count = 0;
+
+	if (pool->threads == NULL) {
+		lit_free_vm_pool(pool);
+		return false;
+	}
+
+	for (int i = 0; i < thread_count; i++) {
+		if (pthread_create(&pool->threads[i], NULL, work, pool) != 0) {
+			lit_free_vm_pool(pool);
+			return false;
+		}
+
+		pool->thread_count++;
+	}
+
+	return true;
+}
+
+void lit_vm_pool_run(LitVmPool* pool, uint64_t count) {
+	pthread_mutex_lock(&pool->lock);
+	pool->queued += count;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+uint64_t lit_wait_vm_pool(LitVmPool* pool) {
+	pthread_mutex_lock(&pool->lock);
+
+	while (pool->queued > 0 || pool->running > 0) {
+		pthread_cond_wait(&pool->idle, &pool->lock);
+	}
+
+	uint64_t failed = pool->failed;
+	pool->failed = 0;
+
+	pthread_mutex_unlock(&pool->lock);
+	return failed;
+}
+
+void lit_free_vm_pool(LitVmPool* pool) {
+	pthread_mutex_lock(&pool->lock);
+	pool->stopping = true;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (int i = 0; i < pool->thread_count; i++) {
+		pthread_join(pool->threads[i], NULL);
+	}
+
+	free(pool->threads);
+	pool->threads = NULL;
+	pool->thread_count = 0;
+
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->wake);
+	pthread_cond_destroy(&pool->idle);
+}
\ No newline at end of file
@@ -0,0 +1,422 @@
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#include <vm/lit_profiler.h>
+#include <vm/lit_vm.h>
+#include <vm/lit_chunk.h>
+
+// The signal handler has no other way of finding the VM
+static LitProfiler* active_profiler;
+static struct sigaction previous_action;
+
+void lit_init_profiler(LitProfiler* profiler) {
+	memset(profiler, 0, sizeof(LitProfiler));
+}
+
+/*
+ * Everything below up to lit_start_profiler() runs inside of the signal handler,
+ * it only reads the frames and writes into the tables, allocated up front
+ */
+
+static LitFunction* function_of(LitVm* vm, LitFrame* frame) {
+	LitObject* closure = (LitObject*) frame->closure;
+
+	if (closure == NULL) {
+		return NULL;
+	}
+
+	// The minor GC might be copying the closure right now, the copy is complete once it is forwarded
+	if (lit_is_young(vm, closure) && closure->dark) {
+		closure = ((LitForwarded*) closure)->copy;
+	}
+
+	if (closure->type != OBJECT_CLOSURE) {
+		return NULL;
+	}
+
+	LitFunction* function = ((LitClosure*) closure)->function;
+
+	if (function == NULL || function->object.type != OBJECT_FUNCTION) {
+		return NULL;
+	}
+
+	return function;
+}
+
+static uint32_t child_node(LitProfiler* profiler, uint32_t parent, LitFunction* function) {
+	LitProfileNode* nodes = profiler->nodes;
+
+	for (uint32_t node = nodes[parent].child; node != 0; node = nodes[node].sibling) {
+		if (nodes[node].function == function) {
+			return node;
+		}
+	}
+
+	if (profiler->node_count == LIT_PROFILER_NODES) {
+		return 0;
+	}
+
+	uint32_t node = profiler->node_count++;
+
+	nodes[node].function = function;
+	nodes[node].parent = parent;
+	nodes[node].child = 0;
+	nodes[node].samples = 0;
+	nodes[node].sibling = nodes[parent].child;
+	nodes[parent].child = node;
+
+	return node;
+}
+
+static bool add_site(LitProfiler* profiler, LitFunction* function, uint32_t offset) {
+	// Stays below 3/4 full, so probing always ends
+	if (profiler->site_count >= LIT_PROFILER_SITES / 4 * 3) {
+		return false;
+	}
+
+	uint32_t index = (uint32_t) (((uintptr_t) function >> 3) * 31 + offset) * 2654435761u & (LIT_PROFILER_SITES - 1);
+
+	while (true) {
+		LitProfileSite* site = &profiler->sites[index];
+
+		if (site->function == function && site->offset == offset) {
+			site->samples++;
+			return true;
+		}
+
+		if (site->function == NULL) {
+			site->function = function;
+			site->offset = offset;
+			site->samples = 1;
+			profiler->site_count++;
+
+			return true;
+		}
+
+		index = (index + 1) & (LIT_PROFILER_SITES - 1);
+	}
+}
+
+static void take_sample(LitProfiler* profiler) {
+	LitVm* vm = profiler->vm;
+	uint32_t node = 0;
+	LitFunction* function = NULL;
+	LitFrame* top = NULL;
+
+	for (int i = 0; i < vm->frame_count; i++) {
+		LitFunction* frame_function = function_of(vm, &vm->frames[i]);
+
+		if (frame_function == NULL) {
+			profiler->dropped++;
+			return;
+		}
+
+		function = frame_function;
+		top = &vm->frames[i];
+		node = child_node(profiler, node, function);
+
+		if (node == 0) {
+			profiler->dropped++;
+			return;
+		}
+	}
+
+	if (function == NULL) {
+		profiler->dropped++;
+		return;
+	}
+
+	profiler->nodes[node].samples++;
+	profiler->samples++;
+
+	// The ip is already past the instruction, that is running
+	uint8_t* code = function->chunk.code;
+
+	if (top->ip > code && top->ip <= code + function->chunk.count) {
+		add_site(profiler, function, (uint32_t) (top->ip - code - 1));
+	}
+}
+
+static void handle_signal(int signal) {
+	LitProfiler* profiler = active_profiler;
+
+	if (profiler == NULL || !profiler->running) {
+		return;
+	}
+
+	if (!pthread_equal(pthread_self(), profiler->thread)) {
+		profiler->other_threads++;
+		return;
+	}
+
+	take_sample(profiler);
+}
+
+static bool set_timer(uint32_t interval) {
+	struct itimerval timer;
+
+	timer.it_interval.tv_sec = interval / 1000000;
+	timer.it_interval.tv_usec = interval % 1000000;
+	timer.it_value = timer.it_interval;
+
+	return setitimer(ITIMER_PROF, &timer, NULL) == 0;
+}
+
+bool lit_start_profiler(LitProfiler* profiler, LitVm* vm, uint32_t interval) {
+	if (active_profiler != NULL && active_profiler != profiler) {
+		fprintf(stderr, "Only one VM can be profiled at a time\n");
+		return false;
+	}
+
+	if (profiler->nodes == NULL) {
+		profiler->nodes = (LitProfileNode*) calloc(LIT_PROFILER_NODES, sizeof(LitProfileNode));
+		profiler->sites = (LitProfileSite*) calloc(LIT_PROFILER_SITES, sizeof(LitProfileSite));
+		profiler->node_count = 1;
+
+		if (profiler->nodes == NULL || profiler->sites == NULL) {
+			lit_free_profiler(profiler);
+			return false;
+		}
+	}
+
+	profiler->vm = vm;
+	profiler->thread = pthread_self();
+	active_profiler = profiler;
+
+	struct sigaction action;
+
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = handle_signal;
+	action.sa_flags = SA_RESTART;
+	sigemptyset(&action.sa_mask);
+
+	if (sigaction(SIGPROF, &action, &previous_action) != 0) {
+		active_profiler = NULL;
+		return false;
+	}
+
+	profiler->running = true;
+
+	if (!set_timer(interval == 0 ? LIT_PROFILER_INTERVAL : interval)) {
+		lit_stop_profiler(profiler);
+		return false;
+	}
+
+	return true;
+}
+
+void lit_stop_profiler(LitProfiler* profiler) {
+	if (active_profiler != profiler) {
+		return;
+	}
+
+	set_timer(0);
+	profiler->running = false;
+	sigaction(SIGPROF, &previous_action, NULL);
+
+	active_profiler = NULL;
+}
+
+/*
+ * Reports
+ */
+
+static const char* function_name(LitFunction* function) {
+	return function->name == NULL ? "?" : function->name->chars;
+}
+
+static void write_stack(LitProfiler* profiler, FILE* out, uint32_t node) {
+	if (node == 0) {
+		return;
+	}
+
+	write_stack(profiler, out, profiler->nodes[node].parent);
+
+	if (profiler->nodes[node].parent != 0) {
+		fputc(';', out);
+	}
+
+	fputs(function_name(profiler->nodes[node].function), out);
+}
+
+void lit_write_folded_stacks(LitProfiler* profiler, FILE* out) {
+	for (uint32_t node = 1; node < profiler->node_count; node++) {
+		if (profiler->nodes[node].samples > 0) {
+			write_stack(profiler, out, node);
+			fprintf(out, " %lu\n", (unsigned long) profiler->nodes[node].samples);
+		}
+	}
+
+	if (profiler->other_threads > 0) {
+		fprintf(out, "[gc thread] %lu\n", (unsigned long) profiler->other_threads);
+	}
+}
+
+typedef struct {
+	LitFunction* function;
+	uint64_t line;
+	uint64_t self;
+	uint64_t total;
+} Entry;
+
+static int compare_lines(const void* a, const void* b) {
+	const Entry* x = (const Entry*) a;
+	const Entry* y = (const Entry*) b;
+
+	if (x->function != y->function) {
+		return (uintptr_t) x->function < (uintptr_t) y->function ? -1 : 1;
+	}
+
+	return x->line < y->line ? -1 : (x->line > y->line ? 1 : 0);
+}
+
+static int compare_self(const void* a, const void* b) {
+	const Entry* x = (const Entry*) a;
+	const Entry* y = (const Entry*) b;
+
+	return x->self < y->self ? 1 : (x->self > y->self ? -1 : 0);
+}
+
+static int compare_total(const void* a, const void* b) {
+	const Entry* x = (const Entry*) a;
+	const Entry* y = (const Entry*) b;
+
+	if (x->total != y->total) {
+		return x->total < y->total ? 1 : -1;
+	}
+
+	return compare_self(a, b);
+}
+
+static Entry* find_function(Entry* entries, int* count, LitFunction* function) {
+	for (int i = 0; i < *count; i++) {
+		if (entries[i].function == function) {
+			return &entries[i];
+		}
+	}
+
+	Entry* entry = &entries[(*count)++];
+
+	entry->function = function;
+	entry->line = 0;
+	entry->self = 0;
+	entry->total = 0;
+
+	return entry;
+}
+
+static void write_functions(LitProfiler* profiler, FILE* out, int count) {
+	Entry* entries = (Entry*) malloc(sizeof(Entry) * profiler->node_count);
+	int entry_count = 0;
+
+	for (uint32_t node = 1; node < profiler->node_count; node++) {
+		uint64_t samples = profiler->nodes[node].samples;
+
+		if (samples == 0) {
+			continue;
+		}
+
+		find_function(entries, &entry_count, profiler->nodes[node].function)->self += samples;
+
+		// Recursive functions only count once per stack
+		LitFunction* seen[FRAMES_MAX];
+		int seen_count = 0;
+
+		for (uint32_t parent = node; parent != 0; parent = profiler->nodes[parent].parent) {
+			LitFunction* function = profiler->nodes[parent].function;
+			bool counted = false;
+
+			for (int i = 0; i < seen_count && !counted; i++) {
+				counted = seen[i] == function;
+			}
+
+			if (!counted) {
+				seen[seen_count++] = function;
+				find_function(entries, &entry_count, function)->total += samples;
+			}
+		}
+	}
+
+	qsort(entries, (size_t) entry_count, sizeof(Entry), compare_total);
+	fprintf(out, "%8s %8s %7s  %s\n", "Self", "Total", "Total%", "Function");
+
+	for (int i = 0; i < entry_count && i < count; i++) {
+		fprintf(out, "%8lu %8lu %6.1f%%  %s\n", (unsigned long) entries[i].self, (unsigned long) entries[i].total,
+			entries[i].total * 100.0 / profiler->samples, function_name(entries[i].function));
+	}
+
+	free(entries);
+}
+
+static void write_lines(LitProfiler* profiler, FILE* out, int count) {
+	Entry* entries = (Entry*) malloc(sizeof(Entry) * (profiler->site_count + 1));
+	int entry_count = 0;
+
+	for (uint32_t i = 0; i < LIT_PROFILER_SITES; i++) {
+		LitProfileSite* site = &profiler->sites[i];
+
+		if (site->function != NULL) {
+			Entry* entry = &entries[entry_count++];
+
+			entry->function = site->function;
+			entry->line = lit_chunk_get_line(&site->function->chunk, site->offset);
+			entry->self = site->samples;
+		}
+	}
+
+	// Sites of the same line get merged
+	qsort(entries, (size_t) entry_count, sizeof(Entry), compare_lines);
+	int merged = 0;
+
+	for (int i = 0; i < entry_count; i++) {
+		if (merged > 0 && compare_lines(&entries[merged - 1], &entries[i]) == 0) {
+			entries[merged - 1].self += entries[i].self;
+		} else {
+			entries[merged++] = entries[i];
+		}
+	}
+
+	qsort(entries, (size_t) merged, sizeof(Entry), compare_self);
+	fprintf(out, "%8s %7s  %s\n", "Self", "Self%", "Line");
+
+	for (int i = 0; i < merged && i < count; i++) {
+		fprintf(out, "%8lu %6.1f%%  %s:%lu\n", (unsigned long) entries[i].self, entries[i].self * 100.0 / profiler->samples,
+			function_name(entries[i].function), (unsigned long) entries[i].line);
+	}
+
+	free(entries);
+}
+
+void lit_write_profile_report(LitProfiler* profiler, FILE* out, int count) {
+	fprintf(out, "Profile: %lu samples", (unsigned long) profiler->samples);
+
+	if (profiler->other_threads > 0) {
+		fprintf(out, ", %lu on GC threads", (unsigned long) profiler->other_threads);
+	}
+
+	if (profiler->dropped > 0) {
+		fprintf(out, ", %lu dropped", (unsigned long) profiler->dropped);
+	}
+
+	fprintf(out, "\n");
+
+	if (profiler->samples == 0 || profiler->nodes == NULL) {
+		return;
+	}
+
+	write_functions(profiler, out, count);
+	write_lines(profiler, out, count);
+}
+
+void lit_free_profiler(LitProfiler* profiler) {
+	lit_stop_profiler(profiler);
+
+	free(profiler->nodes);
+	free(profiler->sites);
+
+	lit_init_profiler(profiler);
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include <vm/lit_script.h>
+#include <vm/lit_memory.h>
+
+static LitMemManager* owner_of(LitScript* script) {
+	return script->bytecode ? (LitMemManager*) &script->as.file : (LitMemManager*) &script->as.compiler;
+}
+
+static LitTable* globals_of(LitScript* script) {
+	return script->bytecode ? &script->as.file.globals : &script->as.compiler.globals;
+}
+
+bool lit_compile_script(LitScript* script, const char* source_code) {
+	LitCompiler* compiler = &script->as.compiler;
+
+	script->bytecode = false;
+	lit_init_compiler(compiler);
+	lit_compiler_define_natives(compiler, lit_std_natives);
+
+	script->function = lit_compile(compiler, source_code);
+	lit_free_compiler(compiler);
+
+	if (script->function == NULL) {
+		lit_free_bytecode_objects(compiler);
+		return false;
+	}
+
+	lit_share_objects((LitMemManager*) compiler);
+	return true;
+}
+
+bool lit_read_script(LitScript* script, const char* path) {
+	script->bytecode = true;
+
+	if (!lit_load_bytecode(&script->as.file, path)) {
+		return false;
+	}
+
+	script->function = script->as.file.function;
+	lit_share_objects((LitMemManager*) &script->as.file);
+
+	return true;
+}
+
+void lit_free_script(LitScript* script) {
+	if (script->bytecode) {
+		lit_free_bytecode(&script->as.file);
+	} else {
+		lit_free_bytecode_objects(&script->as.compiler);
+	}
+
+	script->function = NULL;
+}
+
+bool lit_load_script(LitVm* vm, LitScript* script) {
+	lit_init_vm(vm);
+	lit_vm_load_program(vm, owner_of(script), globals_of(script));
+	lit_execute(vm, script->function);
+
+	return !vm->abort;
+}
\ No newline at end of file
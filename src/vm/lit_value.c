@@ -6,9 +6,8 @@
 #include <vm/lit_object.h>
 #include <lit.h>
 
-// FIXME: move to non global
-static char output[21];
-static DoubleUnion data;
+// Numbers and chars are printed into it, so every thread running a VM needs its own
+static __thread char output[21];
 
 char *lit_to_string(LitVm* vm, LitValue value) {
 	if (IS_BOOL(value)) {
@@ -21,6 +20,7 @@ char *lit_to_string(LitVm* vm, LitValue value) {
 	} else if (IS_NIL(value)) {
 		return "nil";
 	} else if (IS_CHAR(value)) {
+		DoubleUnion data;
 		data.bits64 = value;
 
 		snprintf(output, 2, "%c", data.bits16[0]);
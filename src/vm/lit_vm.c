@@ -8,12 +8,17 @@
 #include <vm/lit_vm.h>
 #include <vm/lit_memory.h>
 #include <vm/lit_object.h>
+#include <vm/lit_jit.h>
+#include <vm/lit_bytecode.h>
+#include <vm/lit_pool.h>
 #include <compiler/lit_parser.h>
 #include <compiler/lit_resolver.h>
 #include <compiler/lit_emitter.h>
 #include <lit.h>
 #include <lit_debug.h>
 
+LitVmOptions lit_vm_options = { 0, false, true, 1, false, 0, NULL, NULL };
+
 static inline void reset_stack(LitVm *vm) {
 	vm->stack_top = vm->stack;
 	vm->open_upvalues = NULL;
@@ -36,8 +41,53 @@ LitValue lit_peek(LitVm* vm, int depth) {
 	return vm->stack_top[-1 - depth];
 }
 
+/*
+ * Looks for the innermost try block around the instruction, that every frame is at, from the top one down.
+ * Only raising an error searches the handler tables, running code doesn't do anything for them.
+ */
+static bool find_handler(LitVm* vm) {
+	for (int i = vm->frame_count - 1; i >= 0; i--) {
+		LitFrame* frame = &vm->frames[i];
+		LitChunk* chunk = &frame->closure->function->chunk;
+		uint32_t offset = (uint32_t) (frame->ip - chunk->code - 1);
+
+		for (uint64_t j = 0; j < chunk->handler_count; j++) {
+			LitHandler* handler = &chunk->handlers[j];
+
+			if (offset >= handler->start && offset < handler->end) {
+				vm->handler = handler;
+				vm->handler_frame = i;
+
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
 static void runtime_error(LitVm* vm, const char* format, ...) {
 	va_list args;
+
+	// Caught errors are only the message, nothing gets printed
+	if (find_handler(vm)) {
+		va_start(args, format);
+		int length = vsnprintf(NULL, 0, format, args);
+		va_end(args);
+
+		char message[length + 1];
+
+		va_start(args, format);
+		vsnprintf(message, (size_t) length + 1, format, args);
+		va_end(args);
+
+		// Collections only run at safe points, there are none until the handler takes it
+		vm->caught = MAKE_OBJECT_VALUE(lit_copy_string((LitMemManager*) vm, message, length));
+		vm->abort = true;
+
+		return;
+	}
+
 	va_start(args, format);
 	fprintf(stderr, "Runtime error: ");
 	vfprintf(stderr, format, args);
@@ -55,18 +105,38 @@ static void runtime_error(LitVm* vm, const char* format, ...) {
 	// reset_stack(vm);
 }
 
+// Raises the value of throw and error(), try blocks catch the string itself
+static void throw_error(LitVm* vm, LitValue error) {
+	if (find_handler(vm)) {
+		vm->caught = error;
+		vm->abort = true;
+	} else {
+		runtime_error(vm, "%s", lit_to_string(vm, error));
+	}
+}
+
+static bool run_registers(LitVm* vm, LitFrame* frame);
+
 static bool call(LitVm* vm, LitClosure* closure, int arg_count) {
 	if (vm->frame_count == FRAMES_MAX) {
 		runtime_error(vm, "Stack overflow");
 		return false;
 	}
 
-	LitFrame* frame = &vm->frames[vm->frame_count++];
+	LitFrame* frame = &vm->frames[vm->frame_count];
 
 	frame->closure = closure;
 	frame->ip = closure->function->chunk.code;
 	frame->slots = vm->stack_top - arg_count;
 
+	// The profiler reads the frames from a signal handler, so it can't see this one, until it is filled in
+	__atomic_signal_fence(__ATOMIC_SEQ_CST);
+	vm->frame_count++;
+
+	if (LIT_MATH_KERNELS && closure->function->registers.count > 0) {
+		return run_registers(vm, frame);
+	}
+
 	if (DEBUG_TRACE_EXECUTION) {
 		printf("== %s ==\n", frame->closure->function->name == NULL ? "top-level" : frame->closure->function->name->chars);
 	}
@@ -109,17 +179,14 @@ static bool invoke(LitVm* vm, int arg_count) {
 	return invoke_simple(vm, arg_count, lit_peek(vm, arg_count + 1), lit_peek(vm, arg_count));
 }
 
-static bool last_native;
-static bool last_init;
-
 static bool call_value(LitVm* vm, LitValue callee, int arg_count, bool static_init) {
-	last_native = false;
+	vm->last_native = false;
 
 	if (IS_OBJECT(callee)) {
 		switch (OBJECT_TYPE(callee)) {
 			case OBJECT_CLOSURE: return call(vm, AS_CLOSURE(callee), arg_count);
 			case OBJECT_NATIVE: {
-				last_native = true;
+				vm->last_native = true;
 				int count = AS_NATIVE(callee)(vm, vm->stack_top - arg_count - 1, arg_count);
 
 				if (count == 0) {
@@ -144,7 +211,8 @@ static bool call_value(LitVm* vm, LitValue callee, int arg_count, bool static_in
 					lit_push(vm, values[i]);
 				}
 
-				return true;
+				// Natives report errors with runtime_error(), like error() does
+				return !vm->abort;
 			}
 			case OBJECT_BOUND_METHOD: {
 				LitMethod* bound = AS_METHOD(callee);
@@ -174,12 +242,12 @@ static bool call_value(LitVm* vm, LitValue callee, int arg_count, bool static_in
 						lit_push(vm, values[i]);
 					}
 
-					last_init = true;
+					vm->last_init = true;
 
 					return invoke_simple(vm, arg_count, lit_peek(vm, arg_count + 1), *initializer);
 				}
 
-				last_native = true;
+				vm->last_native = true;
 				return true;
 			}
 		}
@@ -195,6 +263,7 @@ static void close_upvalues(LitVm* vm, LitValue* last) {
 
 		upvalue->closed = *upvalue->value;
 		upvalue->value = &upvalue->closed;
+		lit_write_barrier(vm, (LitObject*) upvalue, upvalue->closed);
 		vm->open_upvalues = upvalue->next;
 	}
 }
@@ -238,6 +307,16 @@ static void create_class(LitVm* vm, LitString* name, LitClass* super) {
 		lit_table_add_all(vm, &class->methods, &super->methods);
 		lit_table_add_all(vm, &class->static_fields, &super->static_fields);
 		lit_table_add_all(vm, &class->fields, &super->fields);
+
+		// Sub class instances start with the super class layout
+		for (int i = 0; i < super->field_defaults.count; i++) {
+			lit_array_write(vm, &class->field_defaults, super->field_defaults.values[i]);
+		}
+
+		// Got all the values of the super class
+		if (super->object.remembered) {
+			lit_remember(vm, (LitObject*) class);
+		}
 	}
 }
 
@@ -246,70 +325,462 @@ static void define_method(LitVm* vm, LitString* name) {
 	LitClass* class = AS_CLASS(lit_peek(vm, 1));
 
 	lit_table_set(vm, &class->methods, name, method);
+	lit_write_barrier(vm, (LitObject*) class, method);
 	lit_pop(vm);
 }
 
 static void *functions[OP_TOTAL + 1]; // 1 for unknown
+// Every opcode leads to op_count first, interpret() dispatches through it with opcode stats on
+static void *counting_functions[OP_TOTAL + 1];
 static bool inited_functions;
+static pthread_mutex_t functions_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Looks up the property in the site cache,
+ * table hits are only trusted if the slot still holds the same key
+ */
+static inline LitValue* cached_property(LitVm* vm, uint16_t site, LitValue from, LitClass* class, LitString* name, bool is_static, bool is_set) {
+	if (site >= vm->field_cache_capacity) {
+		return NULL;
+	}
 
-static bool interpret(LitVm* vm) {
-	if (!inited_functions) {
-		// FIXME: shorten (take example of macros from wren)
-		inited_functions = true;
-
-		functions[OP_RETURN] = &&op_return;
-		functions[OP_CONSTANT] = &&op_constant;
-		functions[OP_STATIC_INIT] = &&op_static_init;
-		functions[OP_NEGATE] = &&op_negate;
-		functions[OP_ADD] = &&op_add;
-		functions[OP_SUBTRACT] = &&op_subtract;
-		functions[OP_MULTIPLY] = &&op_multiply;
-		functions[OP_DIVIDE] = &&op_divide;
-		functions[OP_POP] = &&op_pop;
-		functions[OP_NOT] = &&op_not;
-		functions[OP_NIL] = &&op_nil;
-		functions[OP_TRUE] = &&op_true;
-		functions[OP_FALSE] = &&op_false;
-		functions[OP_EQUAL] = &&op_equal;
-		functions[OP_GREATER] = &&op_greater;
-		functions[OP_LESS] = &&op_less;
-		functions[OP_GREATER_EQUAL] = &&op_greater_equal;
-		functions[OP_LESS_EQUAL] = &&op_less_equal;
-		functions[OP_NOT_EQUAL] = &&op_not_equal;
-		functions[OP_CLOSE_UPVALUE] = &&op_close_upvalue;
-		functions[OP_DEFINE_GLOBAL] = &&op_define_global;
-		functions[OP_GET_GLOBAL] = &&op_get_global;
-		functions[OP_SET_GLOBAL] = &&op_set_global;
-		functions[OP_GET_LOCAL] = &&op_get_local;
-		functions[OP_SET_LOCAL] = &&op_set_local;
-		functions[OP_GET_UPVALUE] = &&op_get_upvalue;
-		functions[OP_SET_UPVALUE] = &&op_set_upvalue;
-		functions[OP_JUMP] = &&op_jump;
-		functions[OP_JUMP_IF_FALSE] = &&op_jump_if_false;
-		functions[OP_LOOP] = &&op_loop;
-		functions[OP_CLOSURE] = &&op_closure;
-		functions[OP_CALL] = &&op_call;
-		functions[OP_SUBCLASS] = &&op_subclass;
-		functions[OP_CLASS] = &&op_class;
-		functions[OP_METHOD] = &&op_method;
-		functions[OP_GET_FIELD] = &&op_get_field;
-		functions[OP_SET_FIELD] = &&op_set_field;
-		functions[OP_INVOKE] = &&op_invoke;
-		functions[OP_DEFINE_FIELD] = &&op_define_field;
-		functions[OP_DEFINE_METHOD] = &&op_define_method;
-		functions[OP_SUPER] = &&op_super;
-		functions[OP_DEFINE_STATIC_FIELD] = &&op_define_static_field;
-		functions[OP_DEFINE_STATIC_METHOD] = &&op_define_static_method;
-		functions[OP_POWER] = &&op_power;
-		functions[OP_SQUARE] = &&op_square;
-		functions[OP_ROOT] = &&op_root;
-		functions[OP_IS] = &&op_is;
-		functions[OP_TOTAL] = &&op_unknown;
+	LitFieldCache* cache = &vm->field_caches[site];
+
+	for (uint8_t i = 0; i < cache->count; i++) {
+		LitFieldCacheEntry* entry = &cache->entries[i];
+
+		if (entry->class != class || entry->name != name) {
+			continue;
+		}
+
+		LitTable* table;
+
+		switch (entry->kind) {
+			case CACHE_FIELD:
+				if (is_static) {
+					return NULL;
+				}
+
+				return &AS_INSTANCE(from)->fields[entry->index];
+			case CACHE_METHOD: table = &class->methods; break;
+			case CACHE_STATIC_FIELD: table = &class->static_fields; break;
+			case CACHE_STATIC_METHOD: table = &class->static_methods; break;
+			default: return NULL;
+		}
+
+		bool static_kind = entry->kind != CACHE_METHOD;
+
+		if (static_kind != is_static || (is_set && entry->kind != CACHE_STATIC_FIELD)) {
+			return NULL;
+		}
+
+		if (entry->index > table->capacity_mask || table->entries[entry->index].key != name) {
+			return NULL;
+		}
+
+		return &table->entries[entry->index].value;
+	}
+
+	return NULL;
+}
+
+static void update_field_cache(LitVm* vm, uint16_t site, LitClass* class, LitString* name, LitFieldCacheKind kind, int index) {
+	if (site >= vm->field_cache_capacity) {
+		int old_capacity = vm->field_cache_capacity;
+		int capacity = GROW_CAPACITY(old_capacity);
+
+		while (capacity <= site) {
+			capacity = GROW_CAPACITY(capacity);
+		}
+
+		vm->field_caches = GROW_ARRAY(vm, vm->field_caches, LitFieldCache, old_capacity, capacity);
+		memset(vm->field_caches + old_capacity, 0, sizeof(LitFieldCache) * (capacity - old_capacity));
+		vm->field_cache_capacity = capacity;
+	}
+
+	LitFieldCache* cache = &vm->field_caches[site];
+	LitFieldCacheEntry* entry = NULL;
+
+	for (uint8_t i = 0; i < cache->count; i++) {
+		if (cache->entries[i].class == class && cache->entries[i].name == name) {
+			entry = &cache->entries[i];
+			break;
+		}
+	}
+
+	if (entry == NULL) {
+		if (cache->count < FIELD_CACHE_WAYS) {
+			entry = &cache->entries[cache->count++];
+		} else {
+			// Megamorphic site, keep cycling through the entries
+			entry = &cache->entries[cache->next];
+			cache->next = (uint8_t) ((cache->next + 1) % FIELD_CACHE_WAYS);
+		}
+	}
+
+	entry->class = class;
+	entry->name = name;
+	entry->kind = kind;
+	entry->index = index;
+}
+
+static inline int table_index(LitTable* table, LitValue* value) {
+	return (int) (((LitTableEntry*) ((char*) value - offsetof(LitTableEntry, value))) - table->entries);
+}
+
+/*
+ * Slow path for +, - and *, results of int operations stay ints while they fit
+ * (the product of two int32 is exact in a double in that range, -0 is not an int)
+ */
+__attribute__((noinline)) LitValue lit_number_arithmetic(LitOpCode instruction, LitValue a, LitValue b) {
+	double x = AS_NUMBER(a);
+	double y = AS_NUMBER(b);
+	double result;
+
+	switch (instruction) {
+		case OP_ADD: result = x + y; break;
+		case OP_SUBTRACT: result = x - y; break;
+		default: result = x * y; break;
+	}
+
+	if (ARE_INTS(a, b) && result >= INT32_MIN && result <= INT32_MAX && !(result == 0 && signbit(result))) {
+		return MAKE_INT_VALUE(result);
+	}
+
+	return MAKE_NUMBER_VALUE(result);
+}
+
+LitValue lit_negate(LitValue value) {
+	// -0 has to stay a double
+	if (IS_INT(value) && AS_INT(value) != 0 && AS_INT(value) != INT32_MIN) {
+		return MAKE_INT_VALUE(-AS_INT(value));
+	}
+
+	return MAKE_NUMBER_VALUE(-AS_NUMBER(value));
+}
+
+// Only exact int divisions give an int back
+LitValue lit_divide(LitValue a, LitValue b) {
+	if (ARE_INTS(a, b) && AS_INT(b) != 0) {
+		int64_t x = AS_INT(a);
+		int64_t y = AS_INT(b);
+
+		if (x % y == 0 && !(x == 0 && y < 0)) {
+			return lit_int_to_value(x / y);
+		}
+	}
+
+	return MAKE_NUMBER_VALUE(AS_NUMBER(a) / AS_NUMBER(b));
+}
+
+/*
+ * Runs a function, that got register code (see lit_register_emitter.c),
+ * its registers are the frame slots, starting with the arguments.
+ * Pops the frame and leaves the result on the stack, like OP_RETURN does.
+ */
+static bool run_registers(LitVm* vm, LitFrame* frame) {
+	static void* instructions[OP_R_TOTAL] = {
+		&&op_r_return, &&op_r_return_nil, &&op_r_constant, &&op_r_move, &&op_r_nil, &&op_r_get_global, &&op_r_set_global,
+		&&op_r_add, &&op_r_subtract, &&op_r_multiply, &&op_r_divide, &&op_r_negate, &&op_r_not,
+		&&op_r_equal, &&op_r_not_equal, &&op_r_less, &&op_r_less_equal, &&op_r_greater, &&op_r_greater_equal,
+		&&op_r_jump, &&op_r_jump_if_false, &&op_r_jump_if_true,
+		&&op_r_add_int, &&op_r_subtract_int, &&op_r_multiply_int, &&op_r_negate_int
+	};
+
+	LitFunction* function = frame->closure->function;
+	register LitValue* registers = frame->slots;
+
+	if (registers + function->registers.register_count > vm->stack + VM_STACK_MAX) {
+		runtime_error(vm, "Stack overflow");
+		return false;
+	}
+
+	// Keep the locals visible to the GC
+	vm->stack_top = registers + function->registers.register_count;
+
+	register uint32_t* ip = function->registers.code;
+	register uint32_t instruction;
+	LitValue result;
+
+#define DISPATCH() { \
+		instruction = *ip++; \
+		if (DEBUG_COUNT_REGISTER_OPCODES) { \
+			vm->register_opcodes[REGISTER_OP(instruction)]++; \
+		} \
+		goto *instructions[REGISTER_OP(instruction)]; \
+	}
+#define RA registers[REGISTER_A(instruction)]
+#define RB registers[REGISTER_B(instruction)]
+#define RC registers[REGISTER_C(instruction)]
+#define REGISTER_ARITHMETIC(op, opcode, builtin, can_be_zero) { \
+		LitValue a = RB; \
+		LitValue b = RC; \
+		int32_t int_result; \
+		if (ARE_INTS(a, b) && !builtin(AS_INT(a), AS_INT(b), &int_result) && (can_be_zero || int_result != 0)) { \
+			RA = MAKE_INT_VALUE(int_result); \
+		} else if (IS_DOUBLE(a) && IS_DOUBLE(b)) { \
+			RA = MAKE_NUMBER_VALUE(lit_value_to_double(a) op lit_value_to_double(b)); \
+		} else { \
+			RA = lit_number_arithmetic(opcode, a, b); \
+		} \
+		DISPATCH(); \
+	}
+#define REGISTER_INT_ARITHMETIC(op) { \
+		RA = MAKE_INT_VALUE((uint32_t) AS_INT(RB) op (uint32_t) AS_INT(RC)); \
+		DISPATCH(); \
+	}
+#define REGISTER_COMPARE(op) { \
+		RA = MAKE_BOOL_VALUE(AS_NUMBER(RB) op AS_NUMBER(RC)); \
+		DISPATCH(); \
+	}
+
+	DISPATCH();
+
+	op_r_return: result = RA; goto done;
+	op_r_return_nil: result = NIL_VALUE; goto done;
+	op_r_constant: RA = function->chunk.constants.values[REGISTER_BX(instruction)]; DISPATCH();
+	op_r_move: RA = RB; DISPATCH();
+	op_r_nil: RA = NIL_VALUE; DISPATCH();
+	op_r_get_global: RA = vm->global_values.values[REGISTER_BX(instruction)]; DISPATCH();
+	op_r_set_global: lit_global_barrier(vm, RA); vm->global_values.values[REGISTER_BX(instruction)] = RA; DISPATCH();
+	op_r_add: REGISTER_ARITHMETIC(+, OP_ADD, __builtin_add_overflow, true);
+	op_r_subtract: REGISTER_ARITHMETIC(-, OP_SUBTRACT, __builtin_sub_overflow, true);
+	op_r_multiply: REGISTER_ARITHMETIC(*, OP_MULTIPLY, __builtin_mul_overflow, false);
+	op_r_divide: RA = lit_divide(RB, RC); DISPATCH();
+	op_r_negate: RA = lit_negate(RB); DISPATCH();
+	op_r_add_int: REGISTER_INT_ARITHMETIC(+);
+	op_r_subtract_int: REGISTER_INT_ARITHMETIC(-);
+	op_r_multiply_int: REGISTER_INT_ARITHMETIC(*);
+	op_r_negate_int: RA = MAKE_INT_VALUE(0u - (uint32_t) AS_INT(RB)); DISPATCH();
+	op_r_not: RA = MAKE_BOOL_VALUE(lit_is_false(RB)); DISPATCH();
+	op_r_equal: REGISTER_COMPARE(==);
+	op_r_not_equal: REGISTER_COMPARE(!=);
+	op_r_less: REGISTER_COMPARE(<);
+	op_r_less_equal: REGISTER_COMPARE(<=);
+	op_r_greater: REGISTER_COMPARE(>);
+	op_r_greater_equal: REGISTER_COMPARE(>=);
+	op_r_jump: ip += REGISTER_SBX(instruction); DISPATCH();
+
+	op_r_jump_if_false: {
+		if (lit_is_false(RA)) {
+			ip += REGISTER_SBX(instruction);
+		}
+
+		DISPATCH();
+	}
+
+	op_r_jump_if_true: {
+		if (!lit_is_false(RA)) {
+			ip += REGISTER_SBX(instruction);
+		}
+
+		DISPATCH();
+	}
+
+	done:
+	vm->frame_count--;
+	vm->stack_top = frame->slots - 1;
+	lit_push(vm, result);
+
+	return true;
+
+#undef DISPATCH
+#undef RA
+#undef RB
+#undef RC
+#undef REGISTER_ARITHMETIC
+#undef REGISTER_INT_ARITHMETIC
+#undef REGISTER_COMPARE
+}
+
+/*
+ * Counts calls and loop back edges of the function, that runs in the frame (if count is true),
+ * compiles it, once it gets hot, and runs its machine code from the current instruction
+ */
+static inline void run_jit(LitVm* vm, LitFrame* frame, bool count) {
+	LitFunction* function = frame->closure->function;
+
+	if (__atomic_load_n(&function->jit, __ATOMIC_ACQUIRE) == NULL) {
+		if (!count) {
+			return;
+		}
+
+		// VMs on other threads might count the same function, losing some of their counts doesn't matter
+		uint32_t hotness = __atomic_load_n(&function->hotness, __ATOMIC_RELAXED) + 1;
+		__atomic_store_n(&function->hotness, hotness < LIT_JIT_THRESHOLD ? hotness : 0, __ATOMIC_RELAXED);
+
+		if (hotness < LIT_JIT_THRESHOLD || !lit_jit_compile(vm, function)) {
+			return; // A failed compile tries again later
+		}
+	}
+
+	lit_jit_run(vm, frame);
+}
+
+/*
+ * Takes the result of the first frame for the running batch and enters the same function
+ * again with the next record, returns false once all of them are done
+ */
+static bool next_batch_call(LitVm* vm, LitFrame* frame) {
+	LitBatch* batch = vm->batch;
+	batch->results[batch->done++] = lit_pop(vm);
+
+	if (batch->done == batch->count) {
+		return false;
+	}
+
+	LitValue* args = batch->args + batch->done * batch->arg_count;
+
+	// Collections only run at safe points, so the closure didn't move since the return
+	lit_push(vm, MAKE_OBJECT_VALUE(frame->closure));
+
+	for (int i = 0; i < batch->arg_count; i++) {
+		lit_push(vm, args[i]);
+	}
+
+	frame->ip = frame->closure->function->chunk.code;
+	vm->frame_count = 1;
+
+	return true;
+}
+
+/*
+ * Drops the frames above the one, that caught the error, closing their upvalues like returns do,
+ * and continues at the handler with the error in the slot of the catch variable
+ */
+static void unwind(LitVm* vm) {
+	LitFrame* frame = &vm->frames[vm->handler_frame];
+	LitValue* depth = frame->slots + vm->handler->depth;
+
+	close_upvalues(vm, depth);
+
+	// The error might come before the try block set all of its locals
+	while (vm->stack_top < depth) {
+		*vm->stack_top++ = NIL_VALUE;
+	}
+
+	vm->stack_top = depth;
+	lit_push(vm, vm->caught);
+
+	frame->ip = frame->closure->function->chunk.code + vm->handler->handler;
+	vm->frame_count = vm->handler_frame + 1;
+	vm->abort = false;
+	vm->last_init = false;
+	vm->handler = NULL;
+}
+
+static bool run_frames(LitVm* vm) {
+	// VMs on other threads might get here at the same time, the first one fills the tables in
+	if (!__atomic_load_n(&inited_functions, __ATOMIC_ACQUIRE)) {
+		pthread_mutex_lock(&functions_lock);
+
+		if (!inited_functions) {
+			// FIXME: shorten (take example of macros from wren)
+			functions[OP_RETURN] = &&op_return;
+			functions[OP_CONSTANT] = &&op_constant;
+			functions[OP_STATIC_INIT] = &&op_static_init;
+			functions[OP_NEGATE] = &&op_negate;
+			functions[OP_ADD] = &&op_add;
+			functions[OP_SUBTRACT] = &&op_subtract;
+			functions[OP_MULTIPLY] = &&op_multiply;
+			functions[OP_DIVIDE] = &&op_divide;
+			functions[OP_POP] = &&op_pop;
+			functions[OP_NOT] = &&op_not;
+			functions[OP_NIL] = &&op_nil;
+			functions[OP_TRUE] = &&op_true;
+			functions[OP_FALSE] = &&op_false;
+			functions[OP_EQUAL] = &&op_equal;
+			functions[OP_GREATER] = &&op_greater;
+			functions[OP_LESS] = &&op_less;
+			functions[OP_GREATER_EQUAL] = &&op_greater_equal;
+			functions[OP_LESS_EQUAL] = &&op_less_equal;
+			functions[OP_NOT_EQUAL] = &&op_not_equal;
+			functions[OP_CLOSE_UPVALUE] = &&op_close_upvalue;
+			functions[OP_DEFINE_GLOBAL] = &&op_define_global;
+			functions[OP_GET_GLOBAL] = &&op_get_global;
+			functions[OP_SET_GLOBAL] = &&op_set_global;
+			functions[OP_GET_LOCAL] = &&op_get_local;
+			functions[OP_SET_LOCAL] = &&op_set_local;
+			functions[OP_GET_UPVALUE] = &&op_get_upvalue;
+			functions[OP_SET_UPVALUE] = &&op_set_upvalue;
+			functions[OP_JUMP] = &&op_jump;
+			functions[OP_JUMP_IF_FALSE] = &&op_jump_if_false;
+			functions[OP_LOOP] = &&op_loop;
+			functions[OP_CLOSURE] = &&op_closure;
+			functions[OP_CALL] = &&op_call;
+			functions[OP_SUBCLASS] = &&op_subclass;
+			functions[OP_CLASS] = &&op_class;
+			functions[OP_METHOD] = &&op_method;
+			functions[OP_GET_FIELD] = &&op_get_field;
+			functions[OP_SET_FIELD] = &&op_set_field;
+			functions[OP_GET_FIELD_SLOT] = &&op_get_field_slot;
+			functions[OP_SET_FIELD_SLOT] = &&op_set_field_slot;
+			functions[OP_INVOKE] = &&op_invoke;
+			functions[OP_DEFINE_FIELD] = &&op_define_field;
+			functions[OP_DEFINE_METHOD] = &&op_define_method;
+			functions[OP_SUPER] = &&op_super;
+			functions[OP_DEFINE_STATIC_FIELD] = &&op_define_static_field;
+			functions[OP_DEFINE_STATIC_METHOD] = &&op_define_static_method;
+			functions[OP_POWER] = &&op_power;
+			functions[OP_SQUARE] = &&op_square;
+			functions[OP_ROOT] = &&op_root;
+			functions[OP_IS] = &&op_is;
+			functions[OP_EQUAL_JUMP_IF_FALSE] = &&op_equal_jump_if_false;
+			functions[OP_NOT_EQUAL_JUMP_IF_FALSE] = &&op_not_equal_jump_if_false;
+			functions[OP_LESS_JUMP_IF_FALSE] = &&op_less_jump_if_false;
+			functions[OP_LESS_EQUAL_JUMP_IF_FALSE] = &&op_less_equal_jump_if_false;
+			functions[OP_GREATER_JUMP_IF_FALSE] = &&op_greater_jump_if_false;
+			functions[OP_GREATER_EQUAL_JUMP_IF_FALSE] = &&op_greater_equal_jump_if_false;
+			functions[OP_ADD_INT] = &&op_add_int;
+			functions[OP_SUBTRACT_INT] = &&op_subtract_int;
+			functions[OP_MULTIPLY_INT] = &&op_multiply_int;
+			functions[OP_GET_LOCAL_2] = &&op_get_local_2;
+			functions[OP_GET_LOCAL_FIELD_SLOT] = &&op_get_local_field_slot;
+			functions[OP_SET_LOCAL_POP] = &&op_set_local_pop;
+			functions[OP_SET_GLOBAL_POP] = &&op_set_global_pop;
+			functions[OP_ADD_CONSTANT] = &&op_add_constant;
+			functions[OP_SUBTRACT_CONSTANT] = &&op_subtract_constant;
+			functions[OP_POP_2] = &&op_pop_2;
+			functions[OP_POP_LOOP] = &&op_pop_loop;
+			functions[OP_JUMP_IF_FALSE_POP] = &&op_jump_if_false_pop;
+			functions[OP_EQUAL_JUMP_IF_FALSE_POP] = &&op_equal_jump_if_false_pop;
+			functions[OP_NOT_EQUAL_JUMP_IF_FALSE_POP] = &&op_not_equal_jump_if_false_pop;
+			functions[OP_LESS_JUMP_IF_FALSE_POP] = &&op_less_jump_if_false_pop;
+			functions[OP_LESS_EQUAL_JUMP_IF_FALSE_POP] = &&op_less_equal_jump_if_false_pop;
+			functions[OP_GREATER_JUMP_IF_FALSE_POP] = &&op_greater_jump_if_false_pop;
+			functions[OP_GREATER_EQUAL_JUMP_IF_FALSE_POP] = &&op_greater_equal_jump_if_false_pop;
+			functions[OP_THROW] = &&op_throw;
+			functions[OP_NEGATE_INT] = &&op_negate_int;
+			functions[OP_ADD_INT_CONSTANT] = &&op_add_int_constant;
+			functions[OP_SUBTRACT_INT_CONSTANT] = &&op_subtract_int_constant;
+			functions[OP_EQUAL_INT_JUMP_IF_FALSE] = &&op_equal_int_jump_if_false;
+			functions[OP_NOT_EQUAL_INT_JUMP_IF_FALSE] = &&op_not_equal_int_jump_if_false;
+			functions[OP_LESS_INT_JUMP_IF_FALSE] = &&op_less_int_jump_if_false;
+			functions[OP_LESS_EQUAL_INT_JUMP_IF_FALSE] = &&op_less_equal_int_jump_if_false;
+			functions[OP_GREATER_INT_JUMP_IF_FALSE] = &&op_greater_int_jump_if_false;
+			functions[OP_GREATER_EQUAL_INT_JUMP_IF_FALSE] = &&op_greater_equal_int_jump_if_false;
+			functions[OP_EQUAL_INT_JUMP_IF_FALSE_POP] = &&op_equal_int_jump_if_false_pop;
+			functions[OP_NOT_EQUAL_INT_JUMP_IF_FALSE_POP] = &&op_not_equal_int_jump_if_false_pop;
+			functions[OP_LESS_INT_JUMP_IF_FALSE_POP] = &&op_less_int_jump_if_false_pop;
+			functions[OP_LESS_EQUAL_INT_JUMP_IF_FALSE_POP] = &&op_less_equal_int_jump_if_false_pop;
+			functions[OP_GREATER_INT_JUMP_IF_FALSE_POP] = &&op_greater_int_jump_if_false_pop;
+			functions[OP_GREATER_EQUAL_INT_JUMP_IF_FALSE_POP] = &&op_greater_equal_int_jump_if_false_pop;
+			functions[OP_TOTAL] = &&op_unknown;
+
+			for (int i = 0; i <= OP_TOTAL; i++) {
+				counting_functions[i] = &&op_count;
+			}
+
+			__atomic_store_n(&inited_functions, true, __ATOMIC_RELEASE);
+		}
+
+		pthread_mutex_unlock(&functions_lock);
 	}
 
 	// FIXME: optimize the dispatch
 	register LitFrame* frame = &vm->frames[vm->frame_count - 1];
 	register LitValue* stack = vm->stack;
+	void** dispatch = vm->opcode_stats == NULL ? functions : counting_functions;
 
 #define READ_BYTE() (*frame->ip++)
 #define READ_CONSTANT() (frame->closure->function->chunk.constants.values[READ_BYTE()])
@@ -318,18 +789,83 @@ static bool interpret(LitVm* vm) {
 #define PUSH(value) { *vm->stack_top = value; vm->stack_top++; }
 #define POP() ({ assert(vm->stack_top > stack); vm->stack_top--; *vm->stack_top; })
 #define PEEK(depth) (vm->stack_top[-1 - depth])
+// Every live object is on the stack, in the frames or in the globals here, so the GC can move them
+#define SAFEPOINT() if (vm->gc_requested) { lit_gc_safepoint(vm); }
+// The resolver typed both operands as int, so there is nothing to check, the math wraps around in uint32_t
+#define INT_ARITHMETIC(op, operand) { \
+		LitValue b = operand; \
+		LitValue a = vm->stack_top[-1]; \
+		vm->stack_top[-1] = MAKE_INT_VALUE((uint32_t) AS_INT(a) op (uint32_t) AS_INT(b)); \
+		continue; \
+	}
+#define ARITHMETIC(op, instruction) { \
+		LitValue b = POP(); \
+		LitValue a = vm->stack_top[-1]; \
+		if (IS_DOUBLE(a) && IS_DOUBLE(b)) { \
+			vm->stack_top[-1] = MAKE_NUMBER_VALUE(lit_value_to_double(a) op lit_value_to_double(b)); \
+		} else { \
+			vm->stack_top[-1] = lit_number_arithmetic(instruction, a, b); \
+		} \
+		continue; \
+	}
+#define CONSTANT_ARITHMETIC(op, instruction, builtin) { \
+		LitValue b = READ_CONSTANT(); \
+		LitValue a = vm->stack_top[-1]; \
+		int32_t result; \
+		if (ARE_INTS(a, b) && !builtin(AS_INT(a), AS_INT(b), &result)) { \
+			vm->stack_top[-1] = MAKE_INT_VALUE(result); \
+		} else if (IS_DOUBLE(a) && IS_DOUBLE(b)) { \
+			vm->stack_top[-1] = MAKE_NUMBER_VALUE(lit_value_to_double(a) op lit_value_to_double(b)); \
+		} else { \
+			vm->stack_top[-1] = lit_number_arithmetic(instruction, a, b); \
+		} \
+		continue; \
+	}
+// as is AS_INT for the _INT variants, their operands are typed int
+#define COMPARE_JUMP(as, op) { \
+		LitValue b = POP(); \
+		LitValue a = vm->stack_top[-1]; \
+		bool result = as(a) op as(b); \
+		uint16_t offset = READ_SHORT(); \
+		vm->stack_top[-1] = MAKE_BOOL_VALUE(result); \
+		if (!result) { \
+			frame->ip += offset; \
+		} \
+		continue; \
+	}
+#define COMPARE_JUMP_POP(as, op) { \
+		LitValue b = POP(); \
+		LitValue a = vm->stack_top[-1]; \
+		uint16_t offset = READ_SHORT(); \
+		if (as(a) op as(b)) { \
+			vm->stack_top--; \
+		} else { \
+			vm->stack_top[-1] = FALSE_VALUE; \
+			frame->ip += offset; \
+		} \
+		continue; \
+	}
 
+	// Every instruction, that fails, returns false itself, so dispatching doesn't check vm->abort
 	while (true) {
-		if (vm->abort) {
-			return false;
-		}
-
 		if (DEBUG_TRACE_EXECUTION) {
 			trace_stack(vm);
 			lit_disassemble_instruction(vm, &frame->closure->function->chunk, (int) (frame->ip - frame->closure->function->chunk.code));
 		}
 
-		goto *functions[*frame->ip++];
+		goto *dispatch[*frame->ip++];
+
+		op_count: {
+			LitOpcodeStats* stats = vm->opcode_stats;
+			uint8_t opcode = frame->ip[-1];
+
+			stats->opcodes[opcode]++;
+			stats->pairs[stats->last_opcode][opcode]++;
+			stats->last_opcode = opcode;
+			frame->closure->function->executed++;
+
+			goto *functions[opcode];
+		};
 
 		op_unknown: {
 			runtime_error(vm, "Unknown opcode %i!", *(frame->ip - 1));
@@ -342,28 +878,37 @@ static bool interpret(LitVm* vm) {
 		};
 
 		op_return: {
-			if (last_init) {
-				last_init = false;
+			SAFEPOINT();
+
+			// The first frame returns its result to lit_execute() or lit_call() the same way
+			if (vm->last_init) {
+				vm->last_init = false;
 				close_upvalues(vm, frame->slots);
 				vm->frame_count--;
+				vm->stack_top = frame->slots;
 
 				if (vm->frame_count == 0) {
 					return false;
 				}
-
-				vm->stack_top = frame->slots;
 			} else {
 				LitValue result = POP();
 				close_upvalues(vm, frame->slots);
 
 				vm->frame_count--;
+				vm->stack_top = frame->slots - 1;
+				PUSH(result);
 
 				if (vm->frame_count == 0) {
-					return false;
-				}
+					if (vm->batch == NULL || !next_batch_call(vm, frame)) {
+						return false;
+					}
 
-				vm->stack_top = frame->slots - 1;
-				PUSH(result);
+					if (LIT_JIT) {
+						run_jit(vm, frame, true);
+					}
+
+					continue;
+				}
 			}
 
 			frame = &vm->frames[vm->frame_count - 1];
@@ -372,10 +917,16 @@ static bool interpret(LitVm* vm) {
 				printf("== %s ==\n", frame->closure->function->name == NULL ? "top-level" : frame->closure->function->name->chars);
 			}
 
+			if (LIT_JIT) {
+				run_jit(vm, frame, false);
+			}
+
 			continue;
 		};
 
 		op_static_init: {
+			SAFEPOINT();
+
 			if (!call_value(vm, PEEK(0), 0, true)) {
 				return false;
 			}
@@ -385,32 +936,27 @@ static bool interpret(LitVm* vm) {
 		};
 
 		op_negate: {
-			vm->stack_top[-1] = MAKE_NUMBER_VALUE(-AS_NUMBER(vm->stack_top[-1]));
-			continue;
-		};
-
-		op_add: {
-			PUSH(MAKE_NUMBER_VALUE(AS_NUMBER(POP()) + AS_NUMBER(POP())));
-			continue;
-		};
-
-		op_subtract: {
-			LitValue b = POP();
-			PUSH(MAKE_NUMBER_VALUE(AS_NUMBER(POP()) - AS_NUMBER(b)));
-
+			vm->stack_top[-1] = lit_negate(vm->stack_top[-1]);
 			continue;
 		};
 
-		op_multiply: {
-			LitValue b = POP();
-			PUSH(MAKE_NUMBER_VALUE(AS_NUMBER(POP()) * AS_NUMBER(b)));
-
+		op_add: ARITHMETIC(+, OP_ADD);
+		op_subtract: ARITHMETIC(-, OP_SUBTRACT);
+		op_multiply: ARITHMETIC(*, OP_MULTIPLY);
+		op_add_int: INT_ARITHMETIC(+, POP());
+		op_subtract_int: INT_ARITHMETIC(-, POP());
+		op_multiply_int: INT_ARITHMETIC(*, POP());
+		op_add_int_constant: INT_ARITHMETIC(+, READ_CONSTANT());
+		op_subtract_int_constant: INT_ARITHMETIC(-, READ_CONSTANT());
+
+		op_negate_int: {
+			vm->stack_top[-1] = MAKE_INT_VALUE(0u - (uint32_t) AS_INT(vm->stack_top[-1]));
 			continue;
 		};
 
 		op_divide: {
 			LitValue b = POP();
-			PUSH(MAKE_NUMBER_VALUE(AS_NUMBER(POP()) / AS_NUMBER(b)));
+			vm->stack_top[-1] = lit_divide(vm->stack_top[-1], b);
 
 			continue;
 		};
@@ -503,22 +1049,21 @@ static bool interpret(LitVm* vm) {
 		};
 
 		op_define_global: {
-			lit_table_set(vm, &vm->globals, READ_STRING(), vm->stack_top[-1]);
-			POP();
+			lit_global_barrier(vm, PEEK(0));
+			vm->global_values.values[READ_SHORT()] = POP();
 
 			continue;
 		};
 
 		op_get_global: {
-			LitString* name = READ_STRING();
-			LitValue *value = lit_table_get(&vm->globals, name);
-			PUSH(*value);
-
+			PUSH(vm->global_values.values[READ_SHORT()]);
 			continue;
 		};
 
 		op_set_global: {
-			lit_table_set(vm, &vm->globals, READ_STRING(), PEEK(0));
+			lit_global_barrier(vm, PEEK(0));
+			vm->global_values.values[READ_SHORT()] = PEEK(0);
+
 			continue;
 		};
 
@@ -538,7 +1083,11 @@ static bool interpret(LitVm* vm) {
 		};
 
 		op_set_upvalue: {
-			*frame->closure->upvalues[READ_BYTE()]->value = vm->stack_top[-1];
+			LitUpvalue* upvalue = frame->closure->upvalues[READ_BYTE()];
+
+			*upvalue->value = vm->stack_top[-1];
+			lit_write_barrier(vm, (LitObject*) upvalue, vm->stack_top[-1]);
+
 			continue;
 		};
 
@@ -559,9 +1108,109 @@ static bool interpret(LitVm* vm) {
 
 		op_loop: {
 			frame->ip -= READ_SHORT();
+			SAFEPOINT();
+
+			if (LIT_JIT) {
+				run_jit(vm, frame, true);
+			}
+
+			continue;
+		};
+
+		op_equal_jump_if_false: COMPARE_JUMP(AS_NUMBER, ==);
+		op_not_equal_jump_if_false: COMPARE_JUMP(AS_NUMBER, !=);
+		op_less_jump_if_false: COMPARE_JUMP(AS_NUMBER, <);
+		op_less_equal_jump_if_false: COMPARE_JUMP(AS_NUMBER, <=);
+		op_greater_jump_if_false: COMPARE_JUMP(AS_NUMBER, >);
+		op_greater_equal_jump_if_false: COMPARE_JUMP(AS_NUMBER, >=);
+		op_equal_int_jump_if_false: COMPARE_JUMP(AS_INT, ==);
+		op_not_equal_int_jump_if_false: COMPARE_JUMP(AS_INT, !=);
+		op_less_int_jump_if_false: COMPARE_JUMP(AS_INT, <);
+		op_less_equal_int_jump_if_false: COMPARE_JUMP(AS_INT, <=);
+		op_greater_int_jump_if_false: COMPARE_JUMP(AS_INT, >);
+		op_greater_equal_int_jump_if_false: COMPARE_JUMP(AS_INT, >=);
+
+		op_get_local_2: {
+			uint8_t a = READ_BYTE();
+			PUSH(frame->slots[a]);
+			PUSH(frame->slots[READ_BYTE()]);
+
 			continue;
 		};
 
+		op_get_local_field_slot: {
+			LitValue from = frame->slots[READ_BYTE()];
+
+			if (!IS_INSTANCE(from)) {
+				runtime_error(vm, "Only instances have fields");
+				return false;
+			}
+
+			PUSH(AS_INSTANCE(from)->fields[READ_BYTE()]);
+			continue;
+		};
+
+		op_set_local_pop: {
+			frame->slots[READ_BYTE()] = POP();
+			continue;
+		};
+
+		op_set_global_pop: {
+			lit_global_barrier(vm, PEEK(0));
+			vm->global_values.values[READ_SHORT()] = POP();
+
+			continue;
+		};
+
+		op_add_constant: CONSTANT_ARITHMETIC(+, OP_ADD, __builtin_add_overflow);
+		op_subtract_constant: CONSTANT_ARITHMETIC(-, OP_SUBTRACT, __builtin_sub_overflow);
+
+		op_pop_2: {
+			POP();
+			POP();
+
+			continue;
+		};
+
+		op_pop_loop: {
+			POP();
+
+			uint16_t offset = READ_SHORT();
+			frame->ip -= offset;
+			SAFEPOINT();
+
+			if (LIT_JIT) {
+				run_jit(vm, frame, true);
+			}
+
+			continue;
+		};
+
+		op_jump_if_false_pop: {
+			uint16_t offset = READ_SHORT();
+
+			if (lit_is_false(PEEK(0))) {
+				frame->ip += offset;
+			} else {
+				POP();
+			}
+
+			continue;
+		};
+
+		op_equal_jump_if_false_pop: COMPARE_JUMP_POP(AS_NUMBER, ==);
+		op_not_equal_jump_if_false_pop: COMPARE_JUMP_POP(AS_NUMBER, !=);
+		op_less_jump_if_false_pop: COMPARE_JUMP_POP(AS_NUMBER, <);
+		op_less_equal_jump_if_false_pop: COMPARE_JUMP_POP(AS_NUMBER, <=);
+		op_greater_jump_if_false_pop: COMPARE_JUMP_POP(AS_NUMBER, >);
+		op_greater_equal_jump_if_false_pop: COMPARE_JUMP_POP(AS_NUMBER, >=);
+		op_equal_int_jump_if_false_pop: COMPARE_JUMP_POP(AS_INT, ==);
+		op_not_equal_int_jump_if_false_pop: COMPARE_JUMP_POP(AS_INT, !=);
+		op_less_int_jump_if_false_pop: COMPARE_JUMP_POP(AS_INT, <);
+		op_less_equal_int_jump_if_false_pop: COMPARE_JUMP_POP(AS_INT, <=);
+		op_greater_int_jump_if_false_pop: COMPARE_JUMP_POP(AS_INT, >);
+		op_greater_equal_int_jump_if_false_pop: COMPARE_JUMP_POP(AS_INT, >=);
+
 		op_closure: {
 			LitFunction* function = AS_FUNCTION(READ_CONSTANT());
 
@@ -583,16 +1232,24 @@ static bool interpret(LitVm* vm) {
 		};
 
 		op_call: {
+			SAFEPOINT();
+
 			int arg_count = READ_BYTE();
+			int frame_count = vm->frame_count;
 
 			if (!call_value(vm, PEEK(arg_count), arg_count, false)) {
 				return false;
 			}
 
-			if (!last_native) {
+			if (!vm->last_native) {
 				frame = &vm->frames[vm->frame_count - 1];
 			}
 
+			if (LIT_JIT) {
+				// Either entered the callee or carries on after a native call
+				run_jit(vm, frame, vm->frame_count > frame_count);
+			}
+
 			continue;
 		};
 
@@ -620,43 +1277,59 @@ static bool interpret(LitVm* vm) {
 
 		op_get_field: {
 			LitValue from = PEEK(0);
+			LitString* name = READ_STRING();
+			uint16_t site = READ_SHORT();
 
 			if (IS_INSTANCE(from)) {
-				LitInstance *instance = AS_INSTANCE(from);
-				LitString *name = READ_STRING();
-				LitValue *field = lit_table_get(&instance->fields, name);
+				LitInstance* instance = AS_INSTANCE(from);
+				LitClass* class = instance->type;
+				LitValue* value = cached_property(vm, site, from, class, name, false, false);
 
-				if (field != NULL) {
-					POP();
-					PUSH(*field);
-				} else {
-					LitValue *method = lit_table_get(&instance->type->methods, name);
+				if (value == NULL) {
+					LitValue* slot = lit_table_get(&class->fields, name);
 
-					if (method != NULL) {
-						POP();
-						PUSH(*method);
+					if (slot != NULL) {
+						int index = AS_INT(*slot);
+
+						value = &instance->fields[index];
+						update_field_cache(vm, site, class, name, CACHE_FIELD, index);
 					} else {
-						runtime_error(vm, "Class %s has no field or method %s", instance->type->name->chars, name->chars);
+						value = lit_table_get(&class->methods, name);
+
+						if (value == NULL) {
+							runtime_error(vm, "Class %s has no field or method %s", class->name->chars, name->chars);
+							return false;
+						}
+
+						update_field_cache(vm, site, class, name, CACHE_METHOD, table_index(&class->methods, value));
 					}
 				}
+
+				POP();
+				PUSH(*value);
 			} else if (IS_CLASS(from)) {
-				LitString *name = READ_STRING();
 				LitClass* class = AS_CLASS(from);
-				LitValue *field = lit_table_get(&class->static_fields, name);
+				LitValue* value = cached_property(vm, site, from, class, name, true, false);
 
-				if (field != NULL) {
-					POP();
-					PUSH(*field);
-				} else {
-					LitValue *method = lit_table_get(&class->static_methods, name);
+				if (value == NULL) {
+					value = lit_table_get(&class->static_fields, name);
 
-					if (method != NULL) {
-						POP();
-						PUSH(*method);
+					if (value != NULL) {
+						update_field_cache(vm, site, class, name, CACHE_STATIC_FIELD, table_index(&class->static_fields, value));
 					} else {
-						runtime_error(vm, "Class %s has no static field or method %s", class->name->chars, name->chars);
+						value = lit_table_get(&class->static_methods, name);
+
+						if (value == NULL) {
+							runtime_error(vm, "Class %s has no static field or method %s", class->name->chars, name->chars);
+							return false;
+						}
+
+						update_field_cache(vm, site, class, name, CACHE_STATIC_METHOD, table_index(&class->static_methods, value));
 					}
 				}
+
+				POP();
+				PUSH(*value);
 			} else {
 				runtime_error(vm, "Only instances and classes have properties");
 				return false;
@@ -667,31 +1340,87 @@ static bool interpret(LitVm* vm) {
 
 		op_set_field: {
 			LitValue from = PEEK(1);
+			LitString* name = READ_STRING();
+			uint16_t site = READ_SHORT();
 
 			if (IS_CLASS(from)) {
-				LitValue value = POP();
-				lit_table_set(vm, &AS_CLASS(from)->static_fields, READ_STRING(), value);
+				LitClass* class = AS_CLASS(from);
+				LitValue value = PEEK(0);
+				LitValue* field = cached_property(vm, site, from, class, name, true, true);
 
-				POP();
-				PUSH(value);
+				if (field != NULL) {
+					*field = value;
+				} else {
+					lit_table_set(vm, &class->static_fields, name, value);
+					update_field_cache(vm, site, class, name, CACHE_STATIC_FIELD, table_index(&class->static_fields, lit_table_get(&class->static_fields, name)));
+				}
 			} else if (IS_INSTANCE(from)) {
-				LitInstance* instance = AS_INSTANCE(PEEK(1));
-				LitValue value = POP();
+				LitInstance* instance = AS_INSTANCE(from);
+				LitClass* class = instance->type;
+				LitValue* field = cached_property(vm, site, from, class, name, false, true);
 
-				lit_table_set(vm, &instance->fields, READ_STRING(), value);
+				if (field == NULL) {
+					LitValue* slot = lit_table_get(&class->fields, name);
 
-				POP();
-				PUSH(value);
+					if (slot == NULL) {
+						runtime_error(vm, "Class %s has no field %s", class->name->chars, name->chars);
+						return false;
+					}
+
+					int index = AS_INT(*slot);
+
+					field = &instance->fields[index];
+					update_field_cache(vm, site, class, name, CACHE_FIELD, index);
+				}
+
+				*field = PEEK(0);
 			} else {
-				printf("%s\n", "test");
 				runtime_error(vm, "Only instances and classes have fields");
 				return false;
 			}
 
+			lit_write_barrier(vm, AS_OBJECT(from), PEEK(0));
+
+			LitValue value = POP();
+
+			POP();
+			PUSH(value);
+
+			continue;
+		};
+
+		op_get_field_slot: {
+			LitValue from = PEEK(0);
+
+			if (!IS_INSTANCE(from)) {
+				runtime_error(vm, "Only instances have fields");
+				return false;
+			}
+
+			PEEK(0) = AS_INSTANCE(from)->fields[READ_BYTE()];
+			continue;
+		};
+
+		op_set_field_slot: {
+			LitValue from = PEEK(1);
+
+			if (!IS_INSTANCE(from)) {
+				runtime_error(vm, "Only instances have fields");
+				return false;
+			}
+
+			LitValue value = POP();
+
+			AS_INSTANCE(from)->fields[READ_BYTE()] = value;
+			lit_write_barrier(vm, AS_OBJECT(from), value);
+			PEEK(0) = value;
+
 			continue;
 		};
 
 		op_invoke: {
+			SAFEPOINT();
+
 			int arg_count = READ_BYTE();
 
 			if (!invoke(vm, arg_count)) {
@@ -699,6 +1428,11 @@ static bool interpret(LitVm* vm) {
 			}
 
 			frame = &vm->frames[vm->frame_count - 1];
+
+			if (LIT_JIT) {
+				run_jit(vm, frame, true);
+			}
+
 			continue;
 		};
 
@@ -709,8 +1443,19 @@ static bool interpret(LitVm* vm) {
 			}
 
 			LitClass* class = AS_CLASS(PEEK(1));
-			lit_table_set(vm, &class->fields, READ_STRING(), POP());
+			LitString* name = READ_STRING();
+			LitValue* slot = lit_table_get(&class->fields, name);
+
+			if (slot != NULL) {
+				// Redefined field keeps the slot, that the super class gave it
+				class->field_defaults.values[AS_INT(*slot)] = PEEK(0);
+			} else {
+				lit_table_set(vm, &class->fields, name, MAKE_INT_VALUE(class->field_defaults.count));
+				lit_array_write(vm, &class->field_defaults, PEEK(0));
+			}
 
+			lit_write_barrier(vm, (LitObject*) class, PEEK(0));
+			POP();
 			continue;
 		};
 
@@ -720,6 +1465,8 @@ static bool interpret(LitVm* vm) {
 			LitClass* class = AS_CLASS(PEEK(0));
 
 			lit_table_set(vm, &class->methods, name, method);
+			lit_write_barrier(vm, (LitObject*) class, method);
+
 			continue;
 		};
 
@@ -746,6 +1493,8 @@ static bool interpret(LitVm* vm) {
 			}
 
 			LitClass* class = AS_CLASS(PEEK(1));
+
+			lit_write_barrier(vm, (LitObject*) class, PEEK(0));
 			lit_table_set(vm, &class->static_fields, READ_STRING(), POP());
 
 			continue;
@@ -757,6 +1506,8 @@ static bool interpret(LitVm* vm) {
 			LitClass* class = AS_CLASS(PEEK(0));
 
 			lit_table_set(vm, &class->static_methods, name, method);
+			lit_write_barrier(vm, (LitObject*) class, method);
+
 			continue;
 		};
 
@@ -782,6 +1533,11 @@ static bool interpret(LitVm* vm) {
 
 			continue;
 		};
+
+		op_throw: {
+			throw_error(vm, POP());
+			return false;
+		};
 	}
 
 #undef READ_BYTE
@@ -791,14 +1547,39 @@ static bool interpret(LitVm* vm) {
 #undef PUSH
 #undef POP
 #undef PEEK
+#undef SAFEPOINT
+#undef INT_ARITHMETIC
+#undef ARITHMETIC
+#undef COMPARE_JUMP
+#undef COMPARE_JUMP_POP
+#undef CONSTANT_ARITHMETIC
 
 	return true;
 }
 
+/*
+ * Caught errors leave run_frames() like any other error, and it is entered again at the handler,
+ * so that the dispatch loop doesn't check for them
+ */
+static bool interpret(LitVm* vm) {
+	while (true) {
+		bool result = run_frames(vm);
+
+		if (!vm->abort || vm->handler == NULL) {
+			return result;
+		}
+
+		unwind(vm);
+	}
+}
+
 void lit_init_vm(LitVm* vm) {
 	LitMemManager* manager = (LitMemManager*) vm;
 
+	vm->options = lit_vm_options;
 	manager->bytes_allocated = 0;
+	manager->bytes_total = 0;
+	manager->peak_bytes = 0;
 	manager->type = MANAGER_VM;
 	manager->objects = NULL;
 
@@ -807,10 +1588,37 @@ void lit_init_vm(LitVm* vm) {
 	reset_stack(vm);
 
 	lit_init_table(&vm->globals);
-
+	lit_init_array(&vm->global_values);
+
+	vm->abort = false;
+	vm->last_native = false;
+	vm->last_init = false;
+	vm->batch = NULL;
+	vm->handler = NULL;
+	vm->field_caches = NULL;
+	vm->field_cache_capacity = 0;
 	vm->next_gc = 1024 * 1024;
+	vm->gc_requested = false;
+	vm->nursery = malloc(LIT_NURSERY_SIZE);
+	vm->nursery_top = vm->nursery;
+	vm->remembered = NULL;
+	vm->remembered_count = 0;
+	vm->remembered_capacity = 0;
+	vm->young_globals = false;
+	lit_init_pages(&vm->pages);
+	vm->promoted = NULL;
+	vm->promoted_count = 0;
+	vm->promoted_capacity = 0;
+	vm->gc_state = GC_IDLE;
+	vm->sweeping = NULL;
+	vm->sweeper_running = false;
+	memset(&vm->gc_stats, 0, sizeof(LitGcStats));
+	lit_init_profiler(&vm->profiler);
+	vm->opcode_stats = NULL;
+	memset(vm->register_opcodes, 0, sizeof(vm->register_opcodes));
 	vm->gray_capacity = 0;
 	vm->gray_count = 0;
+	vm->gray_left = 0;
 	vm->gray_stack = NULL;
 
 	// vm->init_string = lit_copy_string(vm, "init", 4);
@@ -823,8 +1631,57 @@ void lit_free_vm(LitVm* vm) {
 		printf("Bytes allocated before freeing vm: %ld\n", ((LitMemManager*) vm)->bytes_allocated);
 	}
 
+	if (DEBUG_COUNT_REGISTER_OPCODES) {
+		lit_print_register_opcodes(vm->register_opcodes);
+	}
+
+	if (vm->opcode_stats != NULL) {
+		FILE* out = fopen(vm->options.opcode_stats, "w");
+
+		if (out == NULL) {
+			fprintf(stderr, "Could not open file \"%s\"\n", vm->options.opcode_stats);
+		} else {
+			lit_write_opcode_stats(vm->opcode_stats, out);
+			fclose(out);
+		}
+
+		lit_print_opcode_pairs(vm->opcode_stats->pairs, 32);
+
+		free(vm->opcode_stats);
+		vm->opcode_stats = NULL;
+	}
+
+	if (vm->options.gc_stats) {
+		LitGcStats* stats = &vm->gc_stats;
+
+		fprintf(stderr, "GC: %u minor and %u full collections in %u pauses, longest pause %.3f ms, total %.3f ms\n",
+			stats->minor_collections, stats->full_collections, stats->pauses, stats->longest_pause / 1e6, stats->total_pause / 1e6);
+		fprintf(stderr, "GC: longest minor collection %.3f ms, total %.3f ms, longest end of marking %.3f ms, total %.3f ms\n",
+			stats->longest_minor / 1e6, stats->total_minor / 1e6, stats->longest_final_mark / 1e6, stats->total_final_mark / 1e6);
+	}
+
+	if (vm->options.profile) {
+		lit_stop_profiler(&vm->profiler);
+		lit_write_profile_report(&vm->profiler, stderr, 20);
+
+		if (vm->options.profile_output != NULL) {
+			FILE* out = fopen(vm->options.profile_output, "w");
+
+			if (out == NULL) {
+				fprintf(stderr, "Could not open file \"%s\"\n", vm->options.profile_output);
+			} else {
+				lit_write_folded_stacks(&vm->profiler, out);
+				fclose(out);
+			}
+		}
+	}
+
+	lit_free_profiler(&vm->profiler);
+
 	lit_free_table(vm, &manager->strings);
 	lit_free_table(vm, &vm->globals);
+	lit_free_array(vm, &vm->global_values);
+	FREE_ARRAY(vm, LitFieldCache, vm->field_caches, vm->field_cache_capacity);
 	lit_free_objects(vm);
 
 	vm->init_string = NULL;
@@ -836,13 +1693,154 @@ void lit_free_vm(LitVm* vm) {
 
 bool lit_execute(LitVm* vm, LitFunction* function) {
 	if (!DEBUG_NO_EXECUTE) {
-		call_value(vm, MAKE_OBJECT_VALUE(lit_new_closure(vm, function)), 0, false);
-		return interpret(vm);
+		// Below the frame like any other callee, its return leaves the result there
+		LitValue closure = MAKE_OBJECT_VALUE(lit_new_closure(vm, function));
+
+		lit_push(vm, closure);
+		call_value(vm, closure, 0, false);
+
+		if (vm->options.opcode_stats != NULL && vm->opcode_stats == NULL) {
+			vm->opcode_stats = (LitOpcodeStats*) calloc(1, sizeof(LitOpcodeStats));
+			vm->opcode_stats->function = function;
+		}
+
+		if (vm->options.profile) {
+			lit_start_profiler(&vm->profiler, vm, vm->options.profile_interval);
+		}
+
+		bool result = interpret(vm);
+		lit_stop_profiler(&vm->profiler);
+
+		if (!vm->abort) {
+			lit_pop(vm);
+		}
+
+		return result;
+	}
+
+	return true;
+}
+
+bool lit_get_global(LitVm* vm, const char* name, LitValue* value) {
+	LitString* string = lit_copy_string(vm, name, (int) strlen(name));
+	LitValue* index = lit_table_get(&vm->globals, string);
+
+	if (index == NULL) {
+		return false;
+	}
+
+	*value = vm->global_values.values[AS_INT(*index)];
+
+	// Young objects move, once old they stay, where they are, so the embedder can hold on to them
+	if (IS_OBJECT(*value) && lit_is_young(vm, AS_OBJECT(*value))) {
+		lit_collect_young(vm);
+		*value = vm->global_values.values[AS_INT(*index)];
+	}
+
+	return true;
+}
+
+// Pushes the callee and its arguments for lit_call() and lit_call_batch()
+static bool push_call(LitVm* vm, LitValue callee, LitValue* args, int arg_count) {
+	if (vm->stack_top + arg_count + 1 > vm->stack + VM_STACK_MAX) {
+		runtime_error(vm, "Stack overflow");
+		vm->abort = false;
+
+		return false;
+	}
+
+	lit_push(vm, callee);
+
+	for (int i = 0; i < arg_count; i++) {
+		lit_push(vm, args[i]);
+	}
+
+	return true;
+}
+
+// The frames of a failed call are gone, the VM can run the next one
+static void recover(LitVm* vm, LitValue* base) {
+	vm->abort = false;
+	vm->last_init = false;
+	vm->handler = NULL;
+	vm->frame_count = 0;
+	vm->stack_top = base;
+	close_upvalues(vm, base);
+}
+
+bool lit_call(LitVm* vm, LitValue callee, LitValue* args, int arg_count, LitValue* result) {
+	LitValue* base = vm->stack_top;
+
+	if (!push_call(vm, callee, args, arg_count)) {
+		return false;
+	}
+
+	// Natives and register functions are done, once call_value() returns
+	if (call_value(vm, callee, arg_count, false) && vm->frame_count > 0) {
+		interpret(vm);
+	}
+
+	if (vm->abort) {
+		recover(vm, base);
+		return false;
 	}
 
+	// Young objects move, the embedder holds the result outside of the roots
+	LitValue value = lit_peek(vm, 0);
+
+	if (IS_OBJECT(value) && lit_is_young(vm, AS_OBJECT(value))) {
+		lit_collect_young(vm);
+	}
+
+	*result = lit_pop(vm);
+	vm->stack_top = base;
+
 	return true;
 }
 
+size_t lit_call_batch(LitVm* vm, LitValue callee, LitValue* args, int arg_count, size_t count, LitValue* results) {
+	// Only closures leave a frame behind, that can be run again
+	if (!IS_CLOSURE(callee) || (LIT_MATH_KERNELS && AS_CLOSURE(callee)->function->registers.count > 0)) {
+		for (size_t i = 0; i < count; i++) {
+			if (!lit_call(vm, callee, args + i * arg_count, arg_count, &results[i])) {
+				return i;
+			}
+		}
+
+		return count;
+	}
+
+	LitValue* base = vm->stack_top;
+
+	if (count == 0 || !push_call(vm, callee, args, arg_count)) {
+		return 0;
+	}
+
+	LitBatch batch = { args, arg_count, count, 0, results };
+	vm->batch = &batch;
+
+	if (call(vm, AS_CLOSURE(callee), arg_count)) {
+		interpret(vm);
+	}
+
+	// The results stop being roots with the batch, promote them, while they still are
+	for (size_t i = 0; i < batch.done; i++) {
+		if (IS_OBJECT(results[i]) && lit_is_young(vm, AS_OBJECT(results[i]))) {
+			lit_collect_young(vm);
+			break;
+		}
+	}
+
+	vm->batch = NULL;
+
+	if (vm->abort) {
+		recover(vm, base);
+	}
+
+	vm->stack_top = base;
+	return batch.done;
+}
+
 static int time_function(LitVm* vm, LitValue* args, int count) {
 	lit_push(vm, MAKE_NUMBER_VALUE((double) clock() / CLOCKS_PER_SEC));
 	return 1;
@@ -854,22 +1852,66 @@ static int print_function(LitVm* vm, LitValue* args, int count) {
 }
 
 static int error_function(LitVm* vm, LitValue* args, int count) {
-	runtime_error(vm, lit_to_string(vm, args[1]));
+	throw_error(vm, args[1]);
 	return 0;
 }
 
-static LitNativeRegistry std[] = {
+LitNativeRegistry lit_std_natives[] = {
 	{ time_function, "time", "Function<double>" },
 	{ print_function, "print", "Function<any, void>" },
 	{ error_function, "error", "Function<String, void>" },
 	{ NULL, NULL, NULL } // Null terminator
 };
 
+void lit_vm_load_program(LitVm* vm, LitMemManager* owner, LitTable* globals) {
+	lit_table_add_all(vm, &vm->mem_manager.strings, &owner->strings);
+	lit_vm_link_globals(vm, globals);
+	vm->init_string = lit_copy_string(vm, "init", 4);
+
+	lit_vm_define_natives(vm, lit_std_natives);
+}
+
+/*
+ * Runs the top level function, strings and globals come from whatever owns it,
+ * more than one run go to a pool, that runs them in parallel
+ */
+static bool run(LitMemManager* owner, LitTable* globals, LitFunction* function, uint64_t runs, int threads) {
+	if (runs > 1) {
+		LitVmPool pool;
+
+		if (!lit_init_vm_pool(&pool, owner, globals, function, threads)) {
+			fprintf(stderr, "Could not start the worker threads\n");
+			return true;
+		}
+
+		lit_vm_pool_run(&pool, runs);
+		uint64_t failed = lit_wait_vm_pool(&pool);
+		lit_free_vm_pool(&pool);
+
+		return failed > 0;
+	}
+
+	LitVm vm;
+
+	lit_share_objects(owner);
+	lit_init_vm(&vm);
+	lit_vm_load_program(&vm, owner, globals);
+
+	bool had_error = lit_execute(&vm, function);
+
+	lit_free_vm(&vm);
+	return had_error;
+}
+
 bool lit_eval(const char* source_code) {
+	return lit_eval_parallel(source_code, 1, 0);
+}
+
+bool lit_eval_parallel(const char* source_code, uint64_t runs, int threads) {
 	LitCompiler compiler;
 
 	lit_init_compiler(&compiler);
-	lit_compiler_define_natives(&compiler, std);
+	lit_compiler_define_natives(&compiler, lit_std_natives);
 
 	LitFunction* function = lit_compile(&compiler, source_code);
 
@@ -879,24 +1921,98 @@ bool lit_eval(const char* source_code) {
 		return false;
 	}
 
-	LitVm vm;
-	lit_init_vm(&vm);
-	lit_table_add_all(&vm, &vm.mem_manager.strings, &compiler.mem_manager.strings);
-	vm.init_string = lit_copy_string(&vm, "init", 4);
+	bool had_error = run((LitMemManager*) &compiler, &compiler.globals, function, runs, threads);
+	lit_free_bytecode_objects(&compiler);
 
-	lit_vm_define_natives(&vm, std);
+	return !had_error;
+}
 
-	bool had_error = lit_execute(&vm, function);
+bool lit_eval_bytecode(const char* path) {
+	return lit_eval_bytecode_parallel(path, 1, 0);
+}
 
-	lit_free_vm(&vm);
-	lit_free_bytecode_objects(&compiler);
+bool lit_eval_bytecode_parallel(const char* path, uint64_t runs, int threads) {
+	LitBytecode bytecode;
+
+	if (!lit_load_bytecode(&bytecode, path)) {
+		return false;
+	}
+
+	bool had_error = run((LitMemManager*) &bytecode, &bytecode.globals, bytecode.function, runs, threads);
+	lit_free_bytecode(&bytecode);
 
 	return !had_error;
 }
 
+bool lit_eval_to_bytecode(const char* source_code, FILE* out) {
+	LitCompiler compiler;
+
+	lit_init_compiler(&compiler);
+	lit_compiler_define_natives(&compiler, lit_std_natives);
+
+	LitFunction* function = lit_compile(&compiler, source_code);
+
+	lit_free_compiler(&compiler);
+
+	bool success = function != NULL && lit_write_bytecode((LitMemManager*) &compiler, function, &compiler.globals, out);
+	lit_free_bytecode_objects(&compiler);
+
+	return success;
+}
+
+bool lit_eval_to_c(const char* source_code, FILE* out) {
+	LitCompiler compiler;
+
+	lit_init_compiler(&compiler);
+	lit_compiler_define_natives(&compiler, lit_std_natives);
+
+	bool success = lit_compile_c(&compiler, source_code, out);
+
+	lit_free_compiler(&compiler);
+	lit_free_bytecode_objects(&compiler);
+
+	return success;
+}
+
+static int define_global(LitVm* vm, LitString* name) {
+	LitValue* index = lit_table_get(&vm->globals, name);
+
+	if (index != NULL) {
+		return AS_INT(*index);
+	}
+
+	int global = vm->globals.count;
+	lit_table_set(vm, &vm->globals, name, MAKE_INT_VALUE(global));
+
+	while (vm->global_values.count <= global) {
+		lit_array_write(vm, &vm->global_values, NIL_VALUE);
+	}
+
+	return global;
+}
+
+void lit_vm_link_globals(LitVm* vm, LitTable* globals) {
+	for (int i = 0; i <= globals->capacity_mask; i++) {
+		LitTableEntry* entry = &globals->entries[i];
+
+		if (entry->key != NULL) {
+			lit_table_set(vm, &vm->globals, entry->key, entry->value);
+		}
+	}
+
+	while (vm->global_values.count < vm->globals.count) {
+		lit_array_write(vm, &vm->global_values, NIL_VALUE);
+	}
+}
+
 void lit_vm_define_native(LitVm* vm, LitNativeRegistry* native) {
-	LitString* str = lit_copy_string(vm, native->name, (int) strlen(native->name));
-	lit_table_set(vm, &vm->globals, AS_STRING(MAKE_OBJECT_VALUE(str)), MAKE_OBJECT_VALUE(lit_new_native(vm, native->function)));
+	LitString* name = lit_copy_string(vm, native->name, (int) strlen(native->name));
+	lit_push(vm, MAKE_OBJECT_VALUE(name));
+
+	int global = define_global(vm, name);
+	vm->global_values.values[global] = MAKE_OBJECT_VALUE(lit_new_native(vm, native->function));
+
+	lit_pop(vm);
 }
 
 void lit_vm_define_natives(LitVm* vm, LitNativeRegistry* natives) {
@@ -7,6 +7,7 @@ from os import listdir
 from os.path import abspath, basename, dirname, isdir, isfile, join, realpath, relpath, splitext
 import re
 from subprocess import Popen, PIPE
+from tempfile import mkstemp
 import sys
 import os
 
@@ -32,24 +33,44 @@ filter_path = None
 INTERPRETERS = {}
 C_SUITES = []
 
+LIT = "/home/egor/lit/lit"
+TEST_DIRS = ['test/expression', 'test/statement', 'test/gc', 'test/error']
+
 class Interpreter:
-  def __init__(self, name, language, args, tests):
+  def __init__(self, name, language, args, tests, dirs, bytecode, aot):
     self.name = name
     self.language = language
     self.args = args
     self.tests = tests
+    self.dirs = dirs
+    # Compile every test with -c first and run the .litc file
+    self.bytecode = bytecode
+    # Translate every test with --emit-c, build it against liblit.a and run it
+    self.aot = aot
 
 
-def c_interpreter(name, tests):
-  path = name
-
-  INTERPRETERS[name] = Interpreter(name, 'c', [path], tests)
+def c_interpreter(name, tests, flags=[], dirs=TEST_DIRS, bytecode=False, aot=False):
+  INTERPRETERS[name] = Interpreter(name, 'c', [LIT] + flags, tests, dirs, bytecode, aot)
   C_SUITES.append(name)
 
 c_interpreter('lit', {
   'test': 'pass'
 })
 
+c_interpreter('lit bytecode', {
+  'test': 'pass'
+}, bytecode=True)
+
+# Incremental marking, the background sweeper and the parallel marker
+c_interpreter('lit incremental gc', {
+  'test': 'pass'
+}, flags=['--gc-pause', '20', '--gc-mark-threads', '4'], dirs=['test/gc'])
+
+# Tests, that use something the C backend doesn't support, count as skipped
+c_interpreter('lit aot', {
+  'test': 'pass'
+}, aot=True)
+
 class Test:
   def __init__(self, path):
     self.path = path
@@ -140,12 +161,63 @@ class Test:
 
   def run(self):
     # Invoke the interpreter and run the test.
-    args = ["/home/egor/lit/lit", self.path]
-    proc = Popen(args, stdin=PIPE, stdout=PIPE, stderr=PIPE)
+    if interpreter.aot:
+      return self.run_aot()
+
+    if interpreter.bytecode:
+      handle, compiled = mkstemp(suffix='.litc')
+      os.close(handle)
+
+      proc = Popen(interpreter.args + ['-c', self.path, '-o', compiled], stdin=PIPE, stdout=PIPE, stderr=PIPE)
+      out, err = proc.communicate()
+
+      # Compile errors are checked like the ones from running the source
+      if proc.returncode == 0:
+        proc = Popen(interpreter.args + [compiled], stdin=PIPE, stdout=PIPE, stderr=PIPE)
+        out, err = proc.communicate()
+
+      os.remove(compiled)
+    else:
+      proc = Popen(interpreter.args + [self.path], stdin=PIPE, stdout=PIPE, stderr=PIPE)
+      out, err = proc.communicate()
+
+    self.validate(proc.returncode, out, err)
+    return True
 
+
+  def run_aot(self):
+    # Translated programs don't know the lines of runtime errors
+    if self.runtime_error_message:
+      return False
+
+    handle, source = mkstemp(suffix='.c')
+    os.close(handle)
+    binary = splitext(source)[0]
+
+    proc = Popen(interpreter.args + ['--emit-c', self.path, '-o', source], stdin=PIPE, stdout=PIPE, stderr=PIPE)
     out, err = proc.communicate()
+
+    # Failed translations leave no file behind
+    if proc.returncode != 0 and b'not supported by the C backend' in err:
+      return False
+
+    # Compile errors are checked like the ones from running the source
+    if proc.returncode == 0:
+      proc = Popen(['cc', '-w', '-O1', '-I' + join(REPO_DIR, 'include'), source,
+          join(dirname(LIT), 'liblit.a'), '-lm', '-lpthread', '-o', binary], stdin=PIPE, stdout=PIPE, stderr=PIPE)
+      out, err = proc.communicate()
+
+      if proc.returncode == 0:
+        proc = Popen([binary], stdin=PIPE, stdout=PIPE, stderr=PIPE)
+        out, err = proc.communicate()
+        os.remove(binary)
+
+      os.remove(source)
+
     self.validate(proc.returncode, out, err)
 
+    return True
+
 
   def validate(self, exit_code, out, err):
     if self.compile_errors and self.runtime_error_message:
@@ -353,7 +425,9 @@ def run_script(path):
     # It's a skipped or non-test file.
     return
 
-  test.run()
+  if not test.run():
+    num_skipped += 1
+    return
 
   # Display the results.
   if len(test.failures) == 0:
@@ -381,9 +455,10 @@ def run_suite(name):
   num_skipped = 0
   expectations = 0
 
-  walk(join(REPO_DIR, 'test/expression'), run_script)
-  walk(join(REPO_DIR, 'test/statement'), run_script)
-  walk(join(REPO_DIR, 'test/error'), run_script)
+  for dir in interpreter.dirs:
+    if isdir(join(REPO_DIR, dir)):
+      walk(join(REPO_DIR, dir), run_script)
+
   print_line()
 
   if failed == 0:
@@ -0,0 +1,149 @@
+/*
+ * Embeds the VM like lit_script.h shows and checks lit_call() and lit_call_batch(),
+ * exits with the number of failed checks
+ */
+
+#include <stdio.h>
+
+#include <vm/lit_script.h>
+
+static const char* source_code =
+	"class Box {\n"
+	"	public int value = 0\n"
+	"}\n"
+	"fun box(int value) > Box {\n"
+	"	var made = Box()\n"
+	"	made.value = value\n"
+	"	return made\n"
+	"}\n"
+	"fun unbox(Box box) > int {\n"
+	"	return box.value\n"
+	"}\n"
+	"// Fills the nursery a few times over, so the young objects move\n"
+	"fun churn(int count) > int {\n"
+	"	var i = 0\n"
+	"	while (i < count) {\n"
+	"		box(i)\n"
+	"		i = i + 1\n"
+	"	}\n"
+	"	return i\n"
+	"}\n"
+	"fun square(int value) > int {\n"
+	"	return value * value\n"
+	"}\n"
+	"fun fail(int value) > int {\n"
+	"	if (value == 3) {\n"
+	"		error(\"Expected error\")\n"
+	"	}\n"
+	"	return value\n"
+	"}\n";
+
+static int failed = 0;
+
+static void check(bool condition, const char* what) {
+	if (!condition) {
+		printf("Failed: %s\n", what);
+		failed++;
+	}
+}
+
+static LitValue global(LitVm* vm, const char* name) {
+	LitValue value = NIL_VALUE;
+	check(lit_get_global(vm, name, &value), name);
+
+	return value;
+}
+
+static int call_int(LitVm* vm, LitValue callee, LitValue arg) {
+	LitValue result = NIL_VALUE;
+
+	if (!lit_call(vm, callee, &arg, 1, &result) || !IS_INT(result)) {
+		return -1;
+	}
+
+	return AS_INT(result);
+}
+
+static void test_call(LitVm* vm) {
+	LitValue box = global(vm, "box");
+	LitValue unbox = global(vm, "unbox");
+	LitValue churn = global(vm, "churn");
+	LitValue fail = global(vm, "fail");
+	LitValue result;
+
+	LitValue arg = MAKE_INT_VALUE(42);
+	check(lit_call(vm, box, &arg, 1, &result) && IS_INSTANCE(result), "box(42) returns an instance");
+	check(call_int(vm, churn, MAKE_INT_VALUE(20000)) == 20000, "churn(20000)");
+	check(call_int(vm, unbox, result) == 42, "the result of lit_call() survives minor collections");
+
+	check(call_int(vm, fail, MAKE_INT_VALUE(3)) == -1, "a runtime error returns false");
+	check(vm->frame_count == 0, "a runtime error leaves no frames behind");
+	check(call_int(vm, fail, MAKE_INT_VALUE(4)) == 4, "the VM is usable after an error");
+	check(call_int(vm, unbox, result) == 42, "the result survives the error");
+}
+
+static void test_batch(LitVm* vm) {
+	LitValue args[64];
+	LitValue results[64];
+
+	for (int i = 0; i < 64; i++) {
+		args[i] = MAKE_INT_VALUE(i);
+	}
+
+	// Register functions go through lit_call() too, a closure runs its frame again for every record
+	check(!LIT_MATH_KERNELS || AS_CLOSURE(global(vm, "square"))->function->registers.count > 0, "square() runs on the register VM");
+	check(lit_call_batch(vm, global(vm, "square"), args, 1, 64, results) == 64, "square() over 64 records");
+
+	for (int i = 0; i < 64; i++) {
+		check(IS_INT(results[i]) && AS_INT(results[i]) == i * i, "square() result");
+	}
+
+	check(lit_call_batch(vm, global(vm, "box"), args, 1, 64, results) == 64, "box() over 64 records");
+	check(call_int(vm, global(vm, "churn"), MAKE_INT_VALUE(20000)) == 20000, "churn(20000)");
+
+	for (int i = 0; i < 64; i++) {
+		check(call_int(vm, global(vm, "unbox"), results[i]) == i, "batch results survive minor collections");
+	}
+
+	// Records after the failing one are not run
+	results[3] = results[4] = NIL_VALUE;
+	check(lit_call_batch(vm, global(vm, "fail"), args, 1, 64, results) == 3, "fail() stops at the third record");
+	check(AS_INT(results[2]) == 2 && results[3] == NIL_VALUE && results[4] == NIL_VALUE, "fail() results");
+	check(vm->frame_count == 0 && vm->batch == NULL, "a failed batch leaves nothing behind");
+
+	// Natives have no frame, they go through lit_call() one by one
+	check(lit_call_batch(vm, global(vm, "time"), NULL, 0, 8, results) == 8, "time() over 8 records");
+	check(IS_NUMBER(results[7]), "time() result");
+	check(lit_call_batch(vm, global(vm, "error"), args, 1, 8, results) == 0, "error() stops at the first record");
+
+	check(lit_call_batch(vm, global(vm, "square"), args, 1, 64, results) == 64, "the VM is usable after a failed batch");
+	check(AS_INT(results[63]) == 63 * 63, "square(63)");
+}
+
+int main(int argc, char** argv) {
+	LitScript script;
+
+	if (!lit_compile_script(&script, source_code)) {
+		printf("Failed: the script does not compile\n");
+		return 1;
+	}
+
+	// Every VM loads the script on its own, the second one starts from scratch
+	for (int i = 0; i < 2; i++) {
+		LitVm vm;
+
+		check(lit_load_script(&vm, &script), "lit_load_script()");
+		test_call(&vm);
+		test_batch(&vm);
+
+		lit_free_vm(&vm);
+	}
+
+	lit_free_script(&script);
+
+	if (failed == 0) {
+		printf("All checks passed\n");
+	}
+
+	return failed;
+}